@@ -17,6 +17,7 @@ vs_fs_interface{"vec3", "world_normal"}
 vs_uniform{"mat4", "projection", "proj"}
 vs_uniform{"mat4", "view"}
 vs_uniform{"mat4", "model"}
+vs_uniform{"vec4", "uv_transform"}
 
 fs_uniform{"vec3", "light_pos"}
 fs_uniform{"sampler2D", "diffuse", "dif"}
@@ -28,7 +29,7 @@ void main()
   world_pos = model * vec4(vertex, 1.0);
   gl_Position = proj * view * world_pos;
 
-  uv = uv_in;
+  uv = uv_in * uv_transform.xy + uv_transform.zw;
 
   // Calculate the vertex normal.
   world_normal = vec3(model * vec4(normal_in, 0.0));
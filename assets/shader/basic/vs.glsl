@@ -10,6 +10,8 @@ out vec3 world_normal;
 uniform mat4 proj;
 uniform mat4 view;
 uniform mat4 model;
+// Where the texture is on its atlas page.
+uniform vec4 uv_transform;
 
 void main()
 {
@@ -17,7 +19,7 @@ void main()
   world_pos = model * vec4(vertex, 1.0);
   gl_Position = proj * view * world_pos;
 
-  uv = uv_in;
+  uv = uv_in * uv_transform.xy + uv_transform.zw;
 
   // Calculate the vertex normal.
   world_normal = vec3(model * vec4(normal_in, 0.0));
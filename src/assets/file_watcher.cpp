@@ -0,0 +1,411 @@
+/*
+ * Copyright (C) 2016 Luke San Antonio
+ * All rights reserved.
+ */
+#include "file_watcher.h"
+
+#include <algorithm>
+
+#include <boost/filesystem.hpp>
+
+#include "../common/log.h"
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace redc { namespace assets
+{
+  namespace fs = boost::filesystem;
+
+  namespace
+  {
+    // How long a directory has to be quiet before its changes go out.
+    constexpr std::chrono::milliseconds COALESCE_TIME(50);
+
+#ifdef __linux__
+    constexpr uint32_t INOTIFY_EVENTS = IN_CLOSE_WRITE | IN_MOVED_TO |
+                                        IN_CREATE;
+#endif
+  }
+
+  struct File_Watcher::Change
+  {
+    std::string dir;
+    std::vector<std::string> names;
+
+    Change* next;
+  };
+
+  File_Watcher::File_Watcher(std::chrono::milliseconds poll_interval,
+                             bool force_polling)
+    : poll_interval_(poll_interval), force_polling_(force_polling),
+      changes_(nullptr), running_(true) {}
+  File_Watcher::~File_Watcher()
+  {
+    if(thread_.joinable())
+    {
+      {
+        std::lock_guard<std::mutex> lock(wake_mut_);
+        running_ = false;
+      }
+      wake_cv_.notify_all();
+
+#ifdef __linux__
+      if(wake_fds_[1] != -1)
+      {
+        char c = 0;
+        if(write(wake_fds_[1], &c, 1) == -1) {}
+      }
+#endif
+
+      thread_.join();
+    }
+
+#ifdef __linux__
+    if(inotify_fd_ != -1) close(inotify_fd_);
+    if(wake_fds_[0] != -1) close(wake_fds_[0]);
+    if(wake_fds_[1] != -1) close(wake_fds_[1]);
+#endif
+
+    Change* change = changes_.exchange(nullptr);
+    while(change)
+    {
+      Change* next = change->next;
+      delete change;
+      change = next;
+    }
+  }
+
+  void File_Watcher::start_()
+  {
+#ifdef __linux__
+    if(!force_polling_)
+    {
+      inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+      if(inotify_fd_ == -1 || pipe2(wake_fds_, O_CLOEXEC) == -1)
+      {
+        log_w("Failed to start inotify, falling back to polling files");
+        if(inotify_fd_ != -1) close(inotify_fd_);
+        inotify_fd_ = -1;
+      }
+    }
+#endif
+
+    thread_ = std::thread([this]() { run_(); });
+  }
+
+  File_Watcher::watch_id File_Watcher::watch(std::string const& filename,
+                                             callback_t cb)
+  {
+    // Only the main thread watches, so nobody races us to start it.
+    if(!thread_.joinable()) start_();
+
+    fs::path path = fs::absolute(filename);
+
+    Subscriber sub;
+    sub.filename = filename;
+    sub.dir = path.parent_path().string();
+    sub.name = path.filename().string();
+    sub.cb = std::move(cb);
+
+    {
+      std::lock_guard<std::mutex> lock(dirs_mut_);
+
+      auto dir_it = dirs_.find(sub.dir);
+      if(dir_it == dirs_.end())
+      {
+        Watched_Dir dir;
+#ifdef __linux__
+        if(inotify_fd_ != -1)
+        {
+          dir.wd = inotify_add_watch(inotify_fd_, sub.dir.c_str(),
+                                     INOTIFY_EVENTS);
+          if(dir.wd == -1)
+          {
+            log_w("Failed to watch '%' with inotify, polling it instead",
+                  sub.dir);
+          }
+          else
+          {
+            dirs_by_wd_[dir.wd] = sub.dir;
+          }
+        }
+#endif
+        dir_it = dirs_.emplace(sub.dir, std::move(dir)).first;
+      }
+
+      Watched_File& file = dir_it->second.files[sub.name];
+      if(file.refs++ == 0)
+      {
+        // So the first poll doesn't think it changed.
+        boost::system::error_code err;
+        file.exists = fs::exists(path, err);
+        if(file.exists)
+        {
+          file.write_time = fs::last_write_time(path, err);
+          file.size = fs::file_size(path, err);
+        }
+      }
+    }
+
+    watch_id id = next_id_++;
+    subs_.emplace(id, std::move(sub));
+    return id;
+  }
+
+  void File_Watcher::unwatch(watch_id id)
+  {
+    auto sub_it = subs_.find(id);
+    if(sub_it == subs_.end()) return;
+
+    std::lock_guard<std::mutex> lock(dirs_mut_);
+
+    auto dir_it = dirs_.find(sub_it->second.dir);
+    if(dir_it != dirs_.end())
+    {
+      Watched_Dir& dir = dir_it->second;
+
+      auto file_it = dir.files.find(sub_it->second.name);
+      if(file_it != dir.files.end() && --file_it->second.refs == 0)
+      {
+        dir.files.erase(file_it);
+      }
+
+      if(dir.files.empty())
+      {
+#ifdef __linux__
+        if(dir.wd != -1)
+        {
+          inotify_rm_watch(inotify_fd_, dir.wd);
+          dirs_by_wd_.erase(dir.wd);
+        }
+#endif
+        dirs_.erase(dir_it);
+      }
+    }
+
+    subs_.erase(sub_it);
+  }
+
+  std::size_t File_Watcher::dispatch()
+  {
+    // Take everything at once, there's no ABA problem this way since the
+    // watcher thread only ever pushes.
+    Change* change = changes_.exchange(nullptr, std::memory_order_acquire);
+
+    // It's a stack, put the oldest first.
+    Change* ordered = nullptr;
+    while(change)
+    {
+      Change* next = change->next;
+      change->next = ordered;
+      ordered = change;
+      change = next;
+    }
+
+    // Find everybody first, callbacks may watch or unwatch files.
+    std::vector<watch_id> to_call;
+    for(change = ordered; change; change = change->next)
+    {
+      for(auto const& sub_pair : subs_)
+      {
+        Subscriber const& sub = sub_pair.second;
+        if(sub.dir != change->dir) continue;
+
+        for(auto const& name : change->names)
+        {
+          if(sub.name == name)
+          {
+            to_call.push_back(sub_pair.first);
+            break;
+          }
+        }
+      }
+    }
+    while(ordered)
+    {
+      Change* next = ordered->next;
+      delete ordered;
+      ordered = next;
+    }
+
+    // The same file may have changed more than once since last time.
+    std::sort(to_call.begin(), to_call.end());
+    to_call.erase(std::unique(to_call.begin(), to_call.end()), to_call.end());
+
+    std::size_t called = 0;
+    for(watch_id id : to_call)
+    {
+      auto sub_it = subs_.find(id);
+      if(sub_it == subs_.end()) continue;
+
+      // Copy it, the callback may unwatch itself.
+      auto cb = sub_it->second.cb;
+      cb(sub_it->second.filename);
+      ++called;
+    }
+    return called;
+  }
+
+  void File_Watcher::publish_(std::string const& dir,
+                              std::vector<std::string> names)
+  {
+    auto change = new Change{dir, std::move(names), nullptr};
+
+    change->next = changes_.load(std::memory_order_relaxed);
+    while(!changes_.compare_exchange_weak(change->next, change,
+                                          std::memory_order_release,
+                                          std::memory_order_relaxed)) {}
+  }
+
+  void File_Watcher::wait_(std::chrono::milliseconds timeout)
+  {
+#ifdef __linux__
+    if(inotify_fd_ != -1)
+    {
+      pollfd fds[2];
+      fds[0].fd = inotify_fd_;
+      fds[0].events = POLLIN;
+      fds[1].fd = wake_fds_[0];
+      fds[1].events = POLLIN;
+      poll(fds, 2, timeout.count());
+      return;
+    }
+#endif
+    std::unique_lock<std::mutex> lock(wake_mut_);
+    wake_cv_.wait_for(lock, timeout, [this]() { return !running_; });
+  }
+
+  void File_Watcher::read_inotify_(pending_t& pending,
+                                  std::chrono::steady_clock::time_point now)
+  {
+#ifdef __linux__
+    alignas(inotify_event) char buf[4096];
+    while(true)
+    {
+      auto len = read(inotify_fd_, buf, sizeof(buf));
+      if(len <= 0) break;
+
+      std::lock_guard<std::mutex> lock(dirs_mut_);
+      for(char* ptr = buf; ptr < buf + len; )
+      {
+        auto event = reinterpret_cast<inotify_event*>(ptr);
+        ptr += sizeof(inotify_event) + event->len;
+
+        if(event->len == 0) continue;
+
+        auto dir_name = dirs_by_wd_.find(event->wd);
+        if(dir_name == dirs_by_wd_.end()) continue;
+
+        // We get told about everything in the directory, only keep what we
+        // care about.
+        Watched_Dir const& dir = dirs_.at(dir_name->second);
+        std::string name = event->name;
+        if(!dir.files.count(name)) continue;
+
+        Pending_Dir& pending_dir = pending[dir_name->second];
+        pending_dir.names.insert(std::move(name));
+        pending_dir.last_event = now;
+      }
+    }
+#else
+    (void) pending;
+    (void) now;
+#endif
+  }
+
+  void File_Watcher::poll_files_()
+  {
+    std::lock_guard<std::mutex> lock(dirs_mut_);
+    for(auto& dir_pair : dirs_)
+    {
+      if(dir_pair.second.wd != -1) continue;
+
+      std::vector<std::string> changed;
+      for(auto& file_pair : dir_pair.second.files)
+      {
+        Watched_File& file = file_pair.second;
+        fs::path path = fs::path(dir_pair.first) / file_pair.first;
+
+        boost::system::error_code err;
+        bool exists = fs::exists(path, err);
+        std::time_t write_time = 0;
+        uintmax_t size = 0;
+        if(exists)
+        {
+          write_time = fs::last_write_time(path, err);
+          size = fs::file_size(path, err);
+        }
+
+        // Write times are only as good as a second, the size catches most of
+        // what happens within one.
+        if(exists != file.exists || write_time != file.write_time ||
+           size != file.size)
+        {
+          file.exists = exists;
+          file.write_time = write_time;
+          file.size = size;
+
+          // Deleting a file isn't something anybody wants to reload.
+          if(exists) changed.push_back(file_pair.first);
+        }
+      }
+
+      if(!changed.empty()) publish_(dir_pair.first, std::move(changed));
+    }
+  }
+
+  void File_Watcher::run_()
+  {
+    using clock_t = std::chrono::steady_clock;
+
+    pending_t pending;
+    auto next_poll = clock_t::now() + poll_interval_;
+
+    while(running_)
+    {
+      // Wake up in time for whichever directory settles down first.
+      auto timeout = poll_interval_;
+      auto now = clock_t::now();
+      for(auto const& dir_pair : pending)
+      {
+        auto until_quiet = std::chrono::duration_cast<
+          std::chrono::milliseconds>(dir_pair.second.last_event +
+                                     COALESCE_TIME - now);
+        timeout = std::max(std::chrono::milliseconds(1),
+                           std::min(timeout, until_quiet));
+      }
+      wait_(timeout);
+
+      now = clock_t::now();
+      if(inotify_fd_ != -1) read_inotify_(pending, now);
+
+      // Each directory goes out on its own once it's settled down, one
+      // that's always busy doesn't hold back the rest.
+      for(auto it = pending.begin(); it != pending.end();)
+      {
+        if(now - it->second.last_event < COALESCE_TIME)
+        {
+          ++it;
+          continue;
+        }
+
+        std::vector<std::string> names(it->second.names.begin(),
+                                       it->second.names.end());
+        publish_(it->first, std::move(names));
+        it = pending.erase(it);
+      }
+
+      // Directories inotify couldn't watch, or everything without inotify.
+      if(now >= next_poll)
+      {
+        poll_files_();
+        next_poll = now + poll_interval_;
+      }
+    }
+  }
+} }
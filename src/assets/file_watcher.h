@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2016 Luke San Antonio
+ * All rights reserved.
+ */
+#ifndef REDC_ASSETS_FILE_WATCHER_H
+#define REDC_ASSETS_FILE_WATCHER_H
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <ctime>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+namespace redc { namespace assets
+{
+  /*!
+   * \brief Watches files for changes on a thread of its own.
+   *
+   * Directories with a watched file in them are watched with inotify on
+   * Linux. Elsewhere, or for any directory inotify can't watch, the files are
+   * stat'd every poll interval instead. Changes are collected per directory
+   * until it's been quiet for a little while, so an editor writing a file a
+   * few times in a row is one change, and then handed to the main thread.
+   * Callbacks are only ever called from dispatch.
+   *
+   * The thread isn't started until the first file is watched, so it's free
+   * to have one around just in case.
+   */
+  struct File_Watcher
+  {
+    using watch_id = uint32_t;
+    using callback_t = std::function<void (std::string const& filename)>;
+
+    explicit File_Watcher(std::chrono::milliseconds poll_interval =
+                            std::chrono::milliseconds(500),
+                          bool force_polling = false);
+    ~File_Watcher();
+
+    File_Watcher(File_Watcher const&) = delete;
+    File_Watcher& operator=(File_Watcher const&) = delete;
+
+    // The file doesn't have to exist yet, but its directory does if this is
+    // going to use inotify. The callback gets the filename as given.
+    watch_id watch(std::string const& filename, callback_t cb);
+    void unwatch(watch_id id);
+
+    // Calls the callback of every file that changed since the last dispatch.
+    // Call this once a frame, returns how many callbacks were called.
+    std::size_t dispatch();
+
+    // Only means anything once a file is being watched.
+    bool polling() const { return inotify_fd_ == -1; }
+
+  private:
+    struct Change;
+
+    struct Subscriber
+    {
+      std::string filename;
+      std::string dir;
+      std::string name;
+      callback_t cb;
+    };
+
+    struct Watched_File
+    {
+      unsigned int refs = 0;
+
+      // For polling, whatever the file looked like last time.
+      bool exists = false;
+      std::time_t write_time = 0;
+      uintmax_t size = 0;
+    };
+    struct Watched_Dir
+    {
+      // The inotify watch, otherwise we poll the files in it.
+      int wd = -1;
+      std::unordered_map<std::string, Watched_File> files;
+    };
+
+    struct Pending_Dir
+    {
+      std::unordered_set<std::string> names;
+      // It goes out once nothing has happened in it for a while.
+      std::chrono::steady_clock::time_point last_event;
+    };
+    using pending_t = std::unordered_map<std::string, Pending_Dir>;
+
+    void start_();
+    void run_();
+    void wait_(std::chrono::milliseconds timeout);
+    void read_inotify_(pending_t& pending,
+                       std::chrono::steady_clock::time_point now);
+    void poll_files_();
+
+    void publish_(std::string const& dir, std::vector<std::string> names);
+
+    std::chrono::milliseconds poll_interval_;
+    bool force_polling_;
+
+    // Only touched by the main thread.
+    watch_id next_id_ = 0;
+    std::unordered_map<watch_id, Subscriber> subs_;
+
+    // Shared with the watcher thread.
+    std::mutex dirs_mut_;
+    std::unordered_map<std::string, Watched_Dir> dirs_;
+    std::unordered_map<int, std::string> dirs_by_wd_;
+
+    // Changes go on a lock-free stack, dispatch takes the whole thing at once.
+    std::atomic<Change*> changes_;
+
+    int inotify_fd_ = -1;
+    // Written to wake the thread up when we're shutting down.
+    int wake_fds_[2] = {-1, -1};
+
+    std::atomic<bool> running_;
+    std::mutex wake_mut_;
+    std::condition_variable wake_cv_;
+    std::thread thread_;
+  };
+} }
+#endif
@@ -3,10 +3,17 @@
  * All rights reserved.
  */
 #pragma once
+#include <cstdint>
+#include <cstring>
+#include <memory>
 #include <string>
 #include "../common/debugging.h"
+#include "../common/hash.h"
+#include "../common/log.h"
 #include "../gfx/mesh_data.h"
+#include "mapped_file.h"
 #include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
 namespace redc { namespace assets
 {
   namespace fs = boost::filesystem;
@@ -15,11 +22,47 @@ namespace redc { namespace assets
   {
     fs::path dir;
     std::string ext;
+    // Files are mapped as-is now, so there is no text mode translation either
+    // way, this is kept for documentation's sake.
     bool load_bin;
   };
 
+  // Every cache file starts with this. It's written and read as is, so it's
+  // only portable between machines with the same endianness, but it's a
+  // cache so who cares.
+  struct Cache_Header
+  {
+    char magic[4];
+    uint32_t header_version;
+
+    // Hash of the source file's contents, seeded with the importer version.
+    uint64_t source_hash;
+    uint32_t importer_version;
+    uint32_t reserved;
+
+    uint64_t payload_size;
+  };
+
+  constexpr char CACHE_MAGIC[4] = {'R', 'C', 'C', 'H'};
+  constexpr uint32_t CACHE_HEADER_VERSION = 1;
+
+  // Whatever comes after the header. The file stays mapped as long as
+  // somebody holds on to the file pointer.
+  struct Cache_Payload
+  {
+    std::shared_ptr<Mapped_File> file;
+
+    uint8_t const* data;
+    std::size_t size;
+  };
+
   /*!
    * \brief Uses a file cache to speed up loading a given asset type.
+   *
+   * A cache entry is only used when its header matches a hash of the current
+   * source file and importer version, so touching a file doesn't force a
+   * rebuild but changing the importer does. Cache entries are memory mapped
+   * rather than read.
    */
   template <class T>
   struct Fs_Cache
@@ -27,31 +70,84 @@ namespace redc { namespace assets
     /*!
      * \param source_fd Information about the source file type.
      * \param cache_fd Information about the cache file type.
+     * \param importer_version Bump this whenever the cached data would change
+     * for the same source file.
      */
-    Fs_Cache(File_Desc source_fd, File_Desc cache_fd);
+    Fs_Cache(File_Desc source_fd, File_Desc cache_fd,
+             uint32_t importer_version);
 
     virtual ~Fs_Cache() {}
 
-    // Loading from the cache gives the client code a stream to read from.
+    // Returns false if the source couldn't be loaded, then t is left alone
+    // and nothing is cached.
+    bool load(std::string filename, T& t);
+    // A default constructed T on failure.
     T load(std::string filename);
   private:
-    virtual T load_from_source_stream(std::istream& st) = 0;
-    virtual T load_from_cache_stream(std::istream& st) = 0;
+    // The source file's contents, these are only valid for the duration of
+    // the call. The path is there for error messages. Return false if the
+    // source is invalid, it isn't cached so it'll be tried again next time.
+    virtual bool load_from_source(fs::path const& path, uint8_t const* data,
+                                  std::size_t size, T& t) = 0;
+    // Return false if the payload is invalid for whatever reason, the source
+    // will be used and the cache rewritten.
+    virtual bool load_from_cache(Cache_Payload const& payload, T& t) = 0;
     virtual void write_cache(T const& t, std::ostream& fp) = 0;
 
+    bool load_cache_file_(fs::path const& path, uint64_t hash, T& t);
+
     File_Desc source_fd_;
     File_Desc cache_fd_;
+
+    uint32_t importer_version_;
   };
 
   template <class T>
-  Fs_Cache<T>::Fs_Cache(File_Desc source_fd, File_Desc cache_fd)
-                  : source_fd_(source_fd), cache_fd_(cache_fd)
+  Fs_Cache<T>::Fs_Cache(File_Desc source_fd, File_Desc cache_fd,
+                        uint32_t importer_version)
+                  : source_fd_(source_fd), cache_fd_(cache_fd),
+                    importer_version_(importer_version)
   {
     create_directory(cache_fd_.dir);
   }
 
+  template <class T>
+  bool Fs_Cache<T>::load_cache_file_(fs::path const& path, uint64_t hash, T& t)
+  {
+    auto file = std::make_shared<Mapped_File>();
+    if(!file->open(path.string())) return false;
+
+    if(file->size() < sizeof(Cache_Header)) return false;
+
+    Cache_Header header;
+    std::memcpy(&header, file->data(), sizeof(header));
+
+    if(std::memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 ||
+       header.header_version != CACHE_HEADER_VERSION ||
+       header.importer_version != importer_version_ ||
+       header.source_hash != hash ||
+       header.payload_size > file->size() - sizeof(Cache_Header))
+    {
+      return false;
+    }
+
+    Cache_Payload payload;
+    payload.data = file->data() + sizeof(Cache_Header);
+    payload.size = header.payload_size;
+    payload.file = std::move(file);
+
+    return load_from_cache(payload, t);
+  }
+
   template <class T>
   T Fs_Cache<T>::load(std::string filename)
+  {
+    T t;
+    load(std::move(filename), t);
+    return t;
+  }
+  template <class T>
+  bool Fs_Cache<T>::load(std::string filename, T& t_out)
   {
     REDC_ASSERT_MSG(!filename.empty(), "Cannot load file with no name");
 
@@ -67,36 +163,77 @@ namespace redc { namespace assets
     REDC_ASSERT_MSG(exists(source_path), "Source / asset file % doesn't exist",
                     source_path.string());
 
-    // If the cache file exists and is newer than the source load it and
-    // delegate to our implementation
-    if(exists(cache_path) &&
-       last_write_time(source_path) < last_write_time(cache_path))
+    // We need the source contents to check the cache anyway, so map it once.
+    Mapped_File source;
+    bool source_mapped = source.open(source_path.string());
+
+    uint64_t hash = 0;
+    if(source_mapped)
     {
-      std::ios_base::openmode flags = std::ios_base::in;
-      if(cache_fd_.load_bin) flags |= std::ios_base::binary;
+      hash = xxhash64(source.data(), source.size(), importer_version_);
+    }
 
-      std::ifstream stream(cache_path.string(), flags);
-      return load_from_cache_stream(stream);
+    // If there is a cache entry for exactly this source, use it.
+    T t;
+    if(source_mapped && exists(cache_path) &&
+       load_cache_file_(cache_path, hash, t))
+    {
+      t_out = std::move(t);
+      return true;
     }
 
-    // Otherwise we need to load the source and rewrite to the cache
-    // Load the source
-    std::ios_base::openmode flags = std::ios_base::in;
-    if(source_fd_.load_bin) flags = flags | std::ios_base::binary;
-    std::ifstream stream(source_path.string(), flags);
-    auto t = load_from_source_stream(stream);
+    // Otherwise we need to load the source and rewrite to the cache. Empty
+    // files can't be mapped so in that case the loader gets nothing.
+    if(!load_from_source(source_path, source.data(), source.size(), t))
+    {
+      return false;
+    }
 
     // Tell the implementation that they should write to the cache now
     {
       // Make sure a directory for cache path exists.
       fs::create_directories(cache_path.parent_path());
 
-      // Open in binary mode?
-      std::ios_base::openmode flags = std::ios_base::out;
-      if(cache_fd_.load_bin) flags |= std::ios_base::binary;
-      std::ofstream cache_stream(cache_path.string(), flags);
+      // Write somewhere else first and move it into place after, somebody may
+      // still have the old cache file mapped and truncating it from under
+      // them would be bad.
+      fs::path temp_path = cache_path;
+      temp_path += ".tmp";
+
+      fs::ofstream cache_stream(temp_path, std::ios_base::out |
+                                           std::ios_base::binary);
+
+      Cache_Header header;
+      std::memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+      header.header_version = CACHE_HEADER_VERSION;
+      header.source_hash = hash;
+      header.importer_version = importer_version_;
+      header.reserved = 0;
+      header.payload_size = 0;
+
+      // Write the header first but we only know the payload size afterwards.
+      cache_stream.write(reinterpret_cast<char const*>(&header),
+                         sizeof(header));
       write_cache(t, cache_stream);
+
+      header.payload_size =
+        static_cast<uint64_t>(cache_stream.tellp()) - sizeof(header);
+      cache_stream.seekp(0);
+      cache_stream.write(reinterpret_cast<char const*>(&header),
+                         sizeof(header));
+
+      bool good = cache_stream.good();
+      cache_stream.close();
+
+      boost::system::error_code err;
+      if(good) fs::rename(temp_path, cache_path, err);
+      if(!good || err)
+      {
+        log_w("Failed to write cache file '%'", cache_path.string());
+        fs::remove(temp_path, err);
+      }
     }
-    return t;
+    t_out = std::move(t);
+    return true;
   }
 } }
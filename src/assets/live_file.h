@@ -5,28 +5,27 @@
  * This file is released under the 3-clause BSD License. The full license text
  * can be found in LICENSE in the top-level directory.
  */
-#include <mutex>
-#include <thread>
+#pragma once
 #include <string>
-#include <cstdlib>
 #include <fstream>
-#include <uv.h>
+#include "file_watcher.h"
 namespace redc
 {
   struct Live_File
   {
-    explicit Live_File(std::string const& filename);
+    // The watcher has to outlive us. Changes are only noticed when it
+    // dispatches.
+    Live_File(assets::File_Watcher& watcher, std::string const& filename);
+    ~Live_File();
 
-    Live_File(Live_File&) = default;
-    Live_File& operator=(Live_File&&) = default;
-
-    Live_File(Live_File&&) = delete;
+    Live_File(Live_File const&) = delete;
     Live_File& operator=(Live_File const&) = delete;
 
-    // Has the file changed since we last opened it?
-    bool changed_on_disk() const;
+    // Has the file changed since we last opened it? This is true until the
+    // first time it's opened.
+    bool changed_on_disk() const { return changed_on_disk_; }
 
-    // Atomically open the stream and reset updated the flag.
+    // Open the stream and reset the updated flag.
     std::ifstream open_ifstream();
 
     // Return the filename of the watched file.
@@ -34,15 +33,9 @@ namespace redc
   private:
     const std::string filename_;
 
-    mutable uv_loop_t loop_;
-    uv_fs_poll_t handle_;
-
-    mutable std::mutex lock_;
-    bool changed_on_disk_;
+    assets::File_Watcher* watcher_;
+    assets::File_Watcher::watch_id watch_;
 
-    friend void poll_cb(uv_fs_poll_t* handle,
-                        int status,
-                        uv_stat_t const* prev,
-                        uv_stat_t const* next);
+    bool changed_on_disk_ = true;
   };
 }
@@ -0,0 +1,32 @@
+/*
+ * Copyright (C) 2016 Luke San Antonio
+ * All rights reserved.
+ */
+#include "mapped_file.h"
+#include <boost/interprocess/exceptions.hpp>
+#include "../common/log.h"
+namespace redc { namespace assets
+{
+  namespace ipc = boost::interprocess;
+
+  bool Mapped_File::open(std::string const& filename)
+  {
+    try
+    {
+      ipc::file_mapping mapping(filename.c_str(), ipc::read_only);
+      ipc::mapped_region region(mapping, ipc::read_only);
+
+      // We read these front to back, let the kernel know.
+      region.advise(ipc::mapped_region::advice_sequential);
+
+      mapping_.swap(mapping);
+      region_.swap(region);
+    }
+    catch(ipc::interprocess_exception& e)
+    {
+      log_d("Failed to map '%': %", filename, e.what());
+      return false;
+    }
+    return true;
+  }
+} }
@@ -0,0 +1,33 @@
+/*
+ * Copyright (C) 2016 Luke San Antonio
+ * All rights reserved.
+ */
+#ifndef REDC_ASSETS_MAPPED_FILE_H
+#define REDC_ASSETS_MAPPED_FILE_H
+#include <cstdint>
+#include <string>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+namespace redc { namespace assets
+{
+  // A read-only memory mapping of an entire file.
+  struct Mapped_File
+  {
+    // Returns false and leaves the mapping empty if the file can't be opened
+    // or mapped. Empty files can't be mapped either.
+    bool open(std::string const& filename);
+
+    bool is_open() const { return region_.get_address() != nullptr; }
+
+    uint8_t const* data() const
+    {
+      return static_cast<uint8_t const*>(region_.get_address());
+    }
+    std::size_t size() const { return region_.get_size(); }
+
+  private:
+    boost::interprocess::file_mapping mapping_;
+    boost::interprocess::mapped_region region_;
+  };
+} }
+#endif
@@ -38,6 +38,27 @@ namespace redc
 
     return true;
   }
+  bool load_gltf_string(tinygltf::Scene& scene, std::string const& source,
+                        std::string const& base_dir, std::string const& name)
+  {
+    std::string err;
+
+    tinygltf::TinyGLTFLoader loader;
+
+    if(!loader.LoadASCIIFromString(&scene, &err, source.data(),
+                                   static_cast<unsigned int>(source.size()),
+                                   base_dir, tinygltf::NO_REQUIRE))
+    {
+      log_e("Error in '%': %", name, err);
+      return false;
+    }
+    else if(err.size() > 0)
+    {
+      log_i("Information loading '%': %", name, err);
+    }
+
+    return true;
+  }
   boost::optional<tinygltf::Scene> load_gltf_file(std::string const& name)
   {
     boost::optional<tinygltf::Scene> scene = tinygltf::Scene{};
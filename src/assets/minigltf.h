@@ -16,6 +16,12 @@ namespace redc
   bool load_gltf_file(tinygltf::Scene& scene, std::string const& filename);
   boost::optional<tinygltf::Scene> load_gltf_file(std::string const& name);
 
+  // Parse a glTF document that has already been read into memory. External
+  // buffers and images are still loaded relative to base_dir. The name is only
+  // used for logging.
+  bool load_gltf_string(tinygltf::Scene& scene, std::string const& source,
+                        std::string const& base_dir, std::string const& name);
+
   bool resolve_gltf_accessor_data(tinygltf::Scene const& scene,
                                   std::string const& accessor,
                                   std::vector<uint8_t>& data,
@@ -0,0 +1,179 @@
+/*
+ * Copyright (C) 2017 Luke San Antonio
+ * All rights reserved.
+ */
+#ifndef REDC_COMMON_BIT_STREAM_H
+#define REDC_COMMON_BIT_STREAM_H
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+#include <vector>
+#include "debugging.h"
+namespace redc
+{
+  // How many bits it takes to store anything from zero to max_value.
+  inline unsigned int bits_needed(uint32_t max_value) noexcept
+  {
+    unsigned int bits = 0;
+    while(max_value)
+    {
+      ++bits;
+      max_value >>= 1;
+    }
+    return bits;
+  }
+
+  // Packs values into exactly as many bits as they are given, least
+  // significant bit first.
+  struct Bit_Writer
+  {
+    Bit_Writer() noexcept {}
+    // Carries on after whatever is already in bytes, which lets a buffer be
+    // reused without copying what gets written into it.
+    explicit Bit_Writer(std::vector<uint8_t> bytes) noexcept
+      : bytes_(std::move(bytes)), bit_size_(bytes_.size() * 8) {}
+
+    void write(uint32_t value, unsigned int bits) noexcept
+    {
+      REDC_ASSERT(bits <= 32);
+      while(bits)
+      {
+        unsigned int byte_bit = bit_size_ % 8;
+        if(byte_bit == 0) bytes_.push_back(0);
+
+        unsigned int n = std::min(8 - byte_bit, bits);
+        uint32_t mask = (1u << n) - 1;
+        bytes_.back() |= static_cast<uint8_t>((value & mask) << byte_bit);
+
+        value >>= n;
+        bits -= n;
+        bit_size_ += n;
+      }
+    }
+    void write_bool(bool value) noexcept { write(value ? 1 : 0, 1); }
+
+    // The last byte is padded with zeros.
+    std::vector<uint8_t> const& bytes() const noexcept { return bytes_; }
+    std::size_t bit_size() const noexcept { return bit_size_; }
+
+    // Gives the bytes back, the writer is empty afterwards.
+    std::vector<uint8_t> take() noexcept
+    {
+      auto ret = std::move(bytes_);
+      bytes_.clear();
+      bit_size_ = 0;
+      return ret;
+    }
+
+  private:
+    std::vector<uint8_t> bytes_;
+    std::size_t bit_size_ = 0;
+  };
+
+  // Like Bit_Writer but into a buffer we're given, writing past the end of
+  // it makes the writer bad rather than growing anything.
+  struct Bit_Span_Writer
+  {
+    Bit_Span_Writer(uint8_t* data, std::size_t size) noexcept
+      : data_(data), size_(size)
+    {
+      std::fill(data_, data_ + size_, 0);
+    }
+
+    void write(uint32_t value, unsigned int bits) noexcept
+    {
+      REDC_ASSERT(bits <= 32);
+      if(bit_pos_ + bits > size_ * 8)
+      {
+        good_ = false;
+        return;
+      }
+
+      while(bits)
+      {
+        unsigned int byte_bit = bit_pos_ % 8;
+        unsigned int n = std::min(8 - byte_bit, bits);
+        uint32_t mask = (1u << n) - 1;
+        data_[bit_pos_ / 8] |= static_cast<uint8_t>((value & mask) << byte_bit);
+
+        value >>= n;
+        bits -= n;
+        bit_pos_ += n;
+      }
+    }
+    void write_bool(bool value) noexcept { write(value ? 1 : 0, 1); }
+
+    bool good() const noexcept { return good_; }
+    std::size_t bit_size() const noexcept { return bit_pos_; }
+
+  private:
+    uint8_t* data_;
+    std::size_t size_;
+    std::size_t bit_pos_ = 0;
+    bool good_ = true;
+  };
+
+  // Only counts what would be written, to size a buffer beforehand.
+  struct Bit_Counter
+  {
+    void write(uint32_t, unsigned int bits) noexcept { bit_size_ += bits; }
+    void write_bool(bool) noexcept { ++bit_size_; }
+
+    std::size_t bit_size() const noexcept { return bit_size_; }
+
+  private:
+    std::size_t bit_size_ = 0;
+  };
+
+  // Reading past the end gives zeros and makes the reader bad, so a whole
+  // message can be read before checking.
+  struct Bit_Reader
+  {
+    Bit_Reader(uint8_t const* data, std::size_t size) noexcept
+      : data_(data), size_(size) {}
+
+    uint32_t read(unsigned int bits) noexcept
+    {
+      REDC_ASSERT(bits <= 32);
+      if(bit_pos_ + bits > size_ * 8)
+      {
+        good_ = false;
+        bit_pos_ = size_ * 8;
+        return 0;
+      }
+
+      uint32_t value = 0;
+      unsigned int done = 0;
+      while(done < bits)
+      {
+        unsigned int byte_bit = bit_pos_ % 8;
+        unsigned int n = std::min(8 - byte_bit, bits - done);
+        uint32_t chunk = (data_[bit_pos_ / 8] >> byte_bit) & ((1u << n) - 1);
+        value |= chunk << done;
+
+        done += n;
+        bit_pos_ += n;
+      }
+      return value;
+    }
+    bool read_bool() noexcept { return read(1) != 0; }
+
+    // For when what we read makes no sense, acts like we ran out of data.
+    void fail() noexcept
+    {
+      good_ = false;
+      bit_pos_ = size_ * 8;
+    }
+
+    bool good() const noexcept { return good_; }
+    std::size_t bits_left() const noexcept { return size_ * 8 - bit_pos_; }
+
+  private:
+    uint8_t const* data_;
+    std::size_t size_;
+    std::size_t bit_pos_ = 0;
+    bool good_ = true;
+  };
+}
+#endif
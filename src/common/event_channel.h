@@ -0,0 +1,266 @@
+/*
+ * Copyright (C) 2017 Luke San Antonio
+ * All rights reserved.
+ */
+#ifndef REDC_COMMON_EVENT_CHANNEL_H
+#define REDC_COMMON_EVENT_CHANNEL_H
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include "reactor.h"
+namespace redc
+{
+  namespace detail
+  {
+    // What each side writes is padded onto its own cache line so the
+    // producer and consumer don't keep stealing it from each other. Padding
+    // rather than alignas, new doesn't have to respect over-alignment.
+    constexpr std::size_t CACHE_LINE_SIZE = 64;
+
+    // Rounded up to a power of two so indices can wrap with a mask.
+    inline std::size_t channel_capacity(std::size_t capacity) noexcept
+    {
+      std::size_t ret = 2;
+      while(ret < capacity) ret <<= 1;
+      return ret;
+    }
+  }
+
+  /*!
+   * \brief A bounded ring buffer of events from one thread to another.
+   *
+   * One thread pushes and one thread polls, which can be the same thread.
+   * Neither side locks or allocates after construction. Pushing to a full
+   * channel fails instead of waiting, so the capacity should comfortably
+   * cover what piles up between polls.
+   */
+  template <class T>
+  struct SPSC_Channel
+  {
+    using event_t = T;
+
+    explicit SPSC_Channel(std::size_t capacity = 1024);
+
+    SPSC_Channel(SPSC_Channel const&) = delete;
+    SPSC_Channel& operator=(SPSC_Channel const&) = delete;
+
+    // False when it's full, the event is dropped.
+    bool push_outgoing_event(event_t event);
+    bool push(event_t event) { return push_outgoing_event(std::move(event)); }
+
+    bool poll_event(event_t& event);
+    // Moves up to max events out at once and returns how many there were.
+    std::size_t poll_events(event_t* events, std::size_t max);
+    // Gives the sink every event that's there.
+    std::size_t poll_events(Event_Sink<event_t>& sink);
+
+    std::size_t capacity() const noexcept { return mask_ + 1; }
+
+  private:
+    std::unique_ptr<event_t[]> events_;
+    std::size_t mask_;
+
+    // The consumer's. It only looks at the real tail when it runs out.
+    char head_pad_[detail::CACHE_LINE_SIZE];
+    std::atomic<std::size_t> head_;
+    std::size_t cached_tail_ = 0;
+
+    // The producer's. It only looks at the real head when it seems full.
+    char tail_pad_[detail::CACHE_LINE_SIZE];
+    std::atomic<std::size_t> tail_;
+    std::size_t cached_head_ = 0;
+  };
+
+  template <class T>
+  SPSC_Channel<T>::SPSC_Channel(std::size_t capacity)
+    : events_(new event_t[detail::channel_capacity(capacity)]),
+      mask_(detail::channel_capacity(capacity) - 1), head_(0), tail_(0) {}
+
+  template <class T>
+  bool SPSC_Channel<T>::push_outgoing_event(event_t event)
+  {
+    std::size_t tail = tail_.load(std::memory_order_relaxed);
+    if(tail - cached_head_ == capacity())
+    {
+      cached_head_ = head_.load(std::memory_order_acquire);
+      if(tail - cached_head_ == capacity()) return false;
+    }
+
+    events_[tail & mask_] = std::move(event);
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  template <class T>
+  bool SPSC_Channel<T>::poll_event(event_t& event)
+  {
+    return poll_events(&event, 1) == 1;
+  }
+  template <class T>
+  std::size_t SPSC_Channel<T>::poll_events(event_t* events, std::size_t max)
+  {
+    std::size_t head = head_.load(std::memory_order_relaxed);
+    if(cached_tail_ - head < max)
+    {
+      cached_tail_ = tail_.load(std::memory_order_acquire);
+    }
+
+    std::size_t count = std::min(max, cached_tail_ - head);
+    for(std::size_t i = 0; i < count; ++i)
+    {
+      events[i] = std::move(events_[(head + i) & mask_]);
+    }
+
+    // Hand the slots back all at once.
+    head_.store(head + count, std::memory_order_release);
+    return count;
+  }
+  template <class T>
+  std::size_t SPSC_Channel<T>::poll_events(Event_Sink<event_t>& sink)
+  {
+    std::size_t head = head_.load(std::memory_order_relaxed);
+    cached_tail_ = tail_.load(std::memory_order_acquire);
+
+    // No need to move them out, they stay put until we give the slots back.
+    std::size_t count = cached_tail_ - head;
+    for(std::size_t i = 0; i < count; ++i)
+    {
+      sink.process_event(events_[(head + i) & mask_]);
+    }
+
+    head_.store(head + count, std::memory_order_release);
+    return count;
+  }
+
+  /*!
+   * \brief A bounded ring buffer of events from any number of threads to one.
+   *
+   * Producers claim a slot with a compare and swap on the tail, and every
+   * slot has a sequence number saying whether it's been written or read
+   * yet, so the consumer never touches anything the producers contend on.
+   * Otherwise it's just like SPSC_Channel.
+   */
+  template <class T>
+  struct MPSC_Channel
+  {
+    using event_t = T;
+
+    explicit MPSC_Channel(std::size_t capacity = 1024);
+
+    MPSC_Channel(MPSC_Channel const&) = delete;
+    MPSC_Channel& operator=(MPSC_Channel const&) = delete;
+
+    // False when it's full, the event is dropped.
+    bool push_outgoing_event(event_t event);
+    bool push(event_t event) { return push_outgoing_event(std::move(event)); }
+
+    // Only ever from one thread at a time.
+    bool poll_event(event_t& event);
+    std::size_t poll_events(event_t* events, std::size_t max);
+    std::size_t poll_events(Event_Sink<event_t>& sink);
+
+    std::size_t capacity() const noexcept { return mask_ + 1; }
+
+  private:
+    struct Slot
+    {
+      // Equal to the index it'll be written at when it's free, one more
+      // than that when there's an event in it.
+      std::atomic<std::size_t> seq;
+      event_t event;
+    };
+
+    std::unique_ptr<Slot[]> slots_;
+    std::size_t mask_;
+
+    char head_pad_[detail::CACHE_LINE_SIZE];
+    std::size_t head_ = 0;
+
+    char tail_pad_[detail::CACHE_LINE_SIZE];
+    std::atomic<std::size_t> tail_;
+  };
+
+  template <class T>
+  MPSC_Channel<T>::MPSC_Channel(std::size_t capacity)
+    : slots_(new Slot[detail::channel_capacity(capacity)]),
+      mask_(detail::channel_capacity(capacity) - 1), tail_(0)
+  {
+    for(std::size_t i = 0; i <= mask_; ++i)
+    {
+      slots_[i].seq.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  template <class T>
+  bool MPSC_Channel<T>::push_outgoing_event(event_t event)
+  {
+    std::size_t tail = tail_.load(std::memory_order_relaxed);
+    Slot* slot;
+    while(true)
+    {
+      slot = &slots_[tail & mask_];
+      std::size_t seq = slot->seq.load(std::memory_order_acquire);
+      auto diff = static_cast<std::intptr_t>(seq - tail);
+      if(diff == 0)
+      {
+        // It's free, try to take it.
+        if(tail_.compare_exchange_weak(tail, tail + 1,
+                                       std::memory_order_relaxed))
+        {
+          break;
+        }
+      }
+      // Still holding an event from the last time around, we're full.
+      else if(diff < 0) return false;
+      // Somebody else took it.
+      else tail = tail_.load(std::memory_order_relaxed);
+    }
+
+    slot->event = std::move(event);
+    slot->seq.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  template <class T>
+  bool MPSC_Channel<T>::poll_event(event_t& event)
+  {
+    return poll_events(&event, 1) == 1;
+  }
+  template <class T>
+  std::size_t MPSC_Channel<T>::poll_events(event_t* events, std::size_t max)
+  {
+    std::size_t count = 0;
+    while(count < max)
+    {
+      Slot& slot = slots_[head_ & mask_];
+      if(slot.seq.load(std::memory_order_acquire) != head_ + 1) break;
+
+      events[count++] = std::move(slot.event);
+
+      // Free for the next time around.
+      slot.seq.store(head_ + mask_ + 1, std::memory_order_release);
+      ++head_;
+    }
+    return count;
+  }
+  template <class T>
+  std::size_t MPSC_Channel<T>::poll_events(Event_Sink<event_t>& sink)
+  {
+    std::size_t count = 0;
+    while(true)
+    {
+      Slot& slot = slots_[head_ & mask_];
+      if(slot.seq.load(std::memory_order_acquire) != head_ + 1) break;
+
+      sink.process_event(slot.event);
+      ++count;
+
+      slot.seq.store(head_ + mask_ + 1, std::memory_order_release);
+      ++head_;
+    }
+    return count;
+  }
+}
+#endif
@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2017 Luke San Antonio
+ * All rights reserved.
+ */
+#include "fixed_tick.h"
+#include <algorithm>
+#include "debugging.h"
+#include "log.h"
+namespace redc
+{
+  namespace
+  {
+    using ms_t = std::chrono::duration<double, std::milli>;
+  }
+
+  double Tick_Stats::avg_duration_ms() const noexcept
+  {
+    if(ticks == 0) return 0.0;
+    return ms_t(total_duration).count() / ticks;
+  }
+  double Tick_Stats::avg_jitter_ms() const noexcept
+  {
+    if(ticks == 0) return 0.0;
+    return ms_t(total_jitter).count() / ticks;
+  }
+
+  Fixed_Tick::Fixed_Tick(unsigned int tickrate,
+                         unsigned int max_catch_up) noexcept
+    : tickrate_(tickrate), max_catch_up_(max_catch_up)
+  {
+    REDC_ASSERT_MSG(tickrate > 0, "Tickrate must be positive");
+    interval_ = std::chrono::duration_cast<tick_clock_t::duration>(
+      std::chrono::seconds(1)) / tickrate_;
+  }
+
+  bool Fixed_Tick::begin(tick_clock_t::time_point now) noexcept
+  {
+    if(!started_)
+    {
+      started_ = true;
+      base_ = now;
+      scheduled_ = 0;
+    }
+
+    auto next = next_();
+    if(now < next) return false;
+
+    // Way behind, give up on the ticks we missed and start again from now.
+    auto late = now - next;
+    if(late > interval_ * max_catch_up_)
+    {
+      auto missed = static_cast<uint64_t>(late / interval_);
+      stats_.skipped += missed;
+      tick_ += static_cast<uint32_t>(missed);
+
+      base_ = now;
+      scheduled_ = 0;
+      next = now;
+      late = tick_clock_t::duration::zero();
+    }
+
+    stats_.total_jitter += late;
+    stats_.max_jitter = std::max(stats_.max_jitter, late);
+
+    tick_start_ = now;
+    return true;
+  }
+  void Fixed_Tick::end(tick_clock_t::time_point now) noexcept
+  {
+    auto duration = now - tick_start_;
+    stats_.last_duration = duration;
+    stats_.total_duration += duration;
+    stats_.max_duration = std::max(stats_.max_duration, duration);
+    if(duration > interval_) ++stats_.overruns;
+    ++stats_.ticks;
+
+    ++tick_;
+    ++scheduled_;
+  }
+
+  tick_clock_t::duration Fixed_Tick::until_next(tick_clock_t::time_point now)
+    const noexcept
+  {
+    if(!started_) return tick_clock_t::duration::zero();
+
+    auto next = next_();
+    if(now >= next) return tick_clock_t::duration::zero();
+    return next - now;
+  }
+
+  void Fixed_Tick::log_stats(char const* name) const noexcept
+  {
+    log_i("% ticks at %hz: % run, % overran, % skipped; took %ms avg, "
+          "%ms max; started %ms late avg, %ms max", name, tickrate_,
+          stats_.ticks, stats_.overruns, stats_.skipped,
+          stats_.avg_duration_ms(), ms_t(stats_.max_duration).count(),
+          stats_.avg_jitter_ms(), ms_t(stats_.max_jitter).count());
+  }
+
+  tick_clock_t::time_point Fixed_Tick::next_() const noexcept
+  {
+    // Work it out from the start every time so rounding doesn't add up.
+    return base_ + std::chrono::duration_cast<tick_clock_t::duration>(
+      std::chrono::seconds(scheduled_)) / tickrate_;
+  }
+}
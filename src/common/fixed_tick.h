@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2017 Luke San Antonio
+ * All rights reserved.
+ */
+#ifndef REDC_COMMON_FIXED_TICK_H
+#define REDC_COMMON_FIXED_TICK_H
+#include <cstdint>
+#include <chrono>
+namespace redc
+{
+  using tick_clock_t = std::chrono::steady_clock;
+
+  struct Tick_Stats
+  {
+    uint64_t ticks = 0;
+    // Ticks that took longer than the tick interval.
+    uint64_t overruns = 0;
+    // Ticks we dropped because we fell too far behind to catch up.
+    uint64_t skipped = 0;
+
+    tick_clock_t::duration last_duration{};
+    tick_clock_t::duration max_duration{};
+    tick_clock_t::duration total_duration{};
+
+    // How late ticks started compared to when they were scheduled.
+    tick_clock_t::duration max_jitter{};
+    tick_clock_t::duration total_jitter{};
+
+    double avg_duration_ms() const noexcept;
+    double avg_jitter_ms() const noexcept;
+  };
+
+  /*!
+   * \brief Schedules ticks at a fixed rate, regardless of the frame rate.
+   *
+   * Call begin until it returns false, with end after each tick:
+   *
+   *   while(ticker.begin(tick_clock_t::now()))
+   *   {
+   *     step(ticker.dt());
+   *     ticker.end(tick_clock_t::now());
+   *   }
+   *
+   * Ticks that are late run back to back until we catch up, but if we fall
+   * more than max_catch_up ticks behind those are skipped, otherwise a long
+   * stall would be followed by a burst of ticks.
+   */
+  struct Fixed_Tick
+  {
+    explicit Fixed_Tick(unsigned int tickrate,
+                        unsigned int max_catch_up = 5) noexcept;
+
+    bool begin(tick_clock_t::time_point now) noexcept;
+    void end(tick_clock_t::time_point now) noexcept;
+
+    // How long until the next tick should start, zero if it's due already.
+    tick_clock_t::duration until_next(tick_clock_t::time_point now)
+      const noexcept;
+
+    // The tick that will run next, or is running.
+    uint32_t tick() const noexcept { return tick_; }
+    unsigned int tickrate() const noexcept { return tickrate_; }
+    tick_clock_t::duration interval() const noexcept { return interval_; }
+    float dt() const noexcept { return 1.0f / tickrate_; }
+
+    Tick_Stats const& stats() const noexcept { return stats_; }
+    void reset_stats() noexcept { stats_ = Tick_Stats{}; }
+    void log_stats(char const* name) const noexcept;
+
+  private:
+    unsigned int tickrate_;
+    unsigned int max_catch_up_;
+    tick_clock_t::duration interval_;
+
+    bool started_ = false;
+    // Ticks are scheduled relative to when we started, or since we last
+    // skipped ahead.
+    tick_clock_t::time_point base_;
+    int64_t scheduled_ = 0;
+    tick_clock_t::time_point tick_start_;
+
+    tick_clock_t::time_point next_() const noexcept;
+
+    uint32_t tick_ = 0;
+    Tick_Stats stats_;
+  };
+}
+#endif
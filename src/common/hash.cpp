@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2016 Luke San Antonio
+ * All rights reserved.
+ */
+#include "hash.h"
+#include <cstring>
+namespace redc
+{
+  namespace
+  {
+    constexpr uint64_t PRIME_1 = 11400714785074694791ULL;
+    constexpr uint64_t PRIME_2 = 14029467366897019727ULL;
+    constexpr uint64_t PRIME_3 = 1609587929392839161ULL;
+    constexpr uint64_t PRIME_4 = 9650029242287828579ULL;
+    constexpr uint64_t PRIME_5 = 2870177450012600261ULL;
+
+    inline uint64_t rotl(uint64_t x, int r)
+    {
+      return (x << r) | (x >> (64 - r));
+    }
+
+    // Unaligned reads, memcpy gets turned into a plain load.
+    inline uint64_t read64(uint8_t const* p)
+    {
+      uint64_t val;
+      std::memcpy(&val, p, sizeof(val));
+      return val;
+    }
+    inline uint32_t read32(uint8_t const* p)
+    {
+      uint32_t val;
+      std::memcpy(&val, p, sizeof(val));
+      return val;
+    }
+
+    inline uint64_t round(uint64_t acc, uint64_t input)
+    {
+      acc += input * PRIME_2;
+      acc = rotl(acc, 31);
+      return acc * PRIME_1;
+    }
+    inline uint64_t merge_round(uint64_t acc, uint64_t val)
+    {
+      acc ^= round(0, val);
+      return acc * PRIME_1 + PRIME_4;
+    }
+  }
+
+  // This assumes a little-endian machine, which is everything we run on.
+  uint64_t xxhash64(void const* data, std::size_t size, uint64_t seed)
+  {
+    uint8_t const* p = static_cast<uint8_t const*>(data);
+    uint8_t const* const end = p + size;
+
+    uint64_t hash;
+    if(size >= 32)
+    {
+      uint8_t const* const limit = end - 32;
+
+      uint64_t v1 = seed + PRIME_1 + PRIME_2;
+      uint64_t v2 = seed + PRIME_2;
+      uint64_t v3 = seed;
+      uint64_t v4 = seed - PRIME_1;
+
+      do
+      {
+        v1 = round(v1, read64(p)); p += 8;
+        v2 = round(v2, read64(p)); p += 8;
+        v3 = round(v3, read64(p)); p += 8;
+        v4 = round(v4, read64(p)); p += 8;
+      } while(p <= limit);
+
+      hash = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+      hash = merge_round(hash, v1);
+      hash = merge_round(hash, v2);
+      hash = merge_round(hash, v3);
+      hash = merge_round(hash, v4);
+    }
+    else
+    {
+      hash = seed + PRIME_5;
+    }
+
+    hash += static_cast<uint64_t>(size);
+
+    // Whatever is left over
+    for(; p + 8 <= end; p += 8)
+    {
+      hash ^= round(0, read64(p));
+      hash = rotl(hash, 27) * PRIME_1 + PRIME_4;
+    }
+    if(p + 4 <= end)
+    {
+      hash ^= static_cast<uint64_t>(read32(p)) * PRIME_1;
+      hash = rotl(hash, 23) * PRIME_2 + PRIME_3;
+      p += 4;
+    }
+    for(; p < end; ++p)
+    {
+      hash ^= (*p) * PRIME_5;
+      hash = rotl(hash, 11) * PRIME_1;
+    }
+
+    // Avalanche
+    hash ^= hash >> 33;
+    hash *= PRIME_2;
+    hash ^= hash >> 29;
+    hash *= PRIME_3;
+    hash ^= hash >> 32;
+
+    return hash;
+  }
+}
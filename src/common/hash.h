@@ -0,0 +1,15 @@
+/*
+ * Copyright (C) 2016 Luke San Antonio
+ * All rights reserved.
+ */
+#ifndef REDC_COMMON_HASH_H
+#define REDC_COMMON_HASH_H
+#include <cstdint>
+#include <cstddef>
+namespace redc
+{
+  // XXH64, it's fast enough to hash every asset we load every time we load it
+  // which is what we use it for. Not for anything security related!
+  uint64_t xxhash64(void const* data, std::size_t size, uint64_t seed = 0);
+}
+#endif
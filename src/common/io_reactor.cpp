@@ -0,0 +1,166 @@
+/*
+ * Copyright (C) 2017 Luke San Antonio
+ * All rights reserved.
+ */
+#include "io_reactor.h"
+#include <condition_variable>
+#include <mutex>
+#include "thread_local.h"
+namespace redc
+{
+  namespace
+  {
+    // The reactor whose thread this is.
+    REDC_THREAD_LOCAL IO_Reactor* current_ = nullptr;
+    REDC_THREAD_LOCAL uv_loop_t* current_loop_ = nullptr;
+
+    std::mutex reactor_mut_;
+    unsigned int reactor_refs_ = 0;
+    std::atomic<IO_Reactor*> reactor_(nullptr);
+  }
+
+  struct IO_Reactor::Task
+  {
+    io_task_t fn;
+    Task* next;
+  };
+
+  IO_Reactor::IO_Reactor() : tasks_(nullptr), stopping_(false)
+  {
+    uv_loop_init(&loop_);
+
+    // The async handle keeps the loop alive when there's nothing else.
+    uv_async_init(&loop_, &wake_, [](uv_async_t* async)
+    {
+      IO_Reactor* self = (IO_Reactor*) async->data;
+      self->run_tasks_();
+
+      // Whatever was posted before we started stopping has been run now.
+      if(self->stopping_.load(std::memory_order_acquire))
+      {
+        self->run_tasks_();
+        uv_close((uv_handle_t*) async, NULL);
+      }
+    });
+    wake_.data = this;
+
+    thread_ = std::thread([this]() { run_(); });
+  }
+  IO_Reactor::~IO_Reactor()
+  {
+    stopping_.store(true, std::memory_order_release);
+    uv_async_send(&wake_);
+    thread_.join();
+
+    uv_loop_close(&loop_);
+  }
+
+  void IO_Reactor::post(io_task_t task) noexcept
+  {
+    Task* node = new Task{std::move(task), nullptr};
+    node->next = tasks_.load(std::memory_order_relaxed);
+    while(!tasks_.compare_exchange_weak(node->next, node,
+                                        std::memory_order_release,
+                                        std::memory_order_relaxed)) {}
+
+    // Wake ups get coalesced, it takes everything anyway.
+    uv_async_send(&wake_);
+  }
+
+  void IO_Reactor::call(io_task_t task) noexcept
+  {
+    if(on_io_thread())
+    {
+      task(&loop_);
+      return;
+    }
+
+    std::mutex done_mut;
+    std::condition_variable done_cv;
+    bool done = false;
+    post([&](uv_loop_t* loop)
+    {
+      task(loop);
+
+      std::lock_guard<std::mutex> lock(done_mut);
+      done = true;
+      done_cv.notify_one();
+    });
+
+    std::unique_lock<std::mutex> lock(done_mut);
+    done_cv.wait(lock, [&]() { return done; });
+  }
+
+  bool IO_Reactor::on_io_thread() const noexcept
+  {
+    return current_ == this;
+  }
+
+  void IO_Reactor::run_()
+  {
+    current_ = this;
+    current_loop_ = &loop_;
+    uv_run(&loop_, UV_RUN_DEFAULT);
+    current_loop_ = nullptr;
+    current_ = nullptr;
+  }
+
+  void IO_Reactor::run_tasks_()
+  {
+    Task* task = tasks_.exchange(nullptr, std::memory_order_acquire);
+
+    // It's a stack, put the oldest first.
+    Task* ordered = nullptr;
+    while(task)
+    {
+      Task* next = task->next;
+      task->next = ordered;
+      ordered = task;
+      task = next;
+    }
+
+    while(ordered)
+    {
+      Task* next = ordered->next;
+      ordered->fn(&loop_);
+      delete ordered;
+      ordered = next;
+    }
+  }
+
+  void start_io_reactor() noexcept
+  {
+    std::lock_guard<std::mutex> lock(reactor_mut_);
+    if(reactor_refs_++ == 0)
+    {
+      reactor_.store(new IO_Reactor, std::memory_order_release);
+    }
+  }
+  void stop_io_reactor() noexcept
+  {
+    std::lock_guard<std::mutex> lock(reactor_mut_);
+    if(reactor_refs_ == 0 || --reactor_refs_ > 0) return;
+
+    IO_Reactor* reactor = reactor_.exchange(nullptr);
+    delete reactor;
+  }
+
+  IO_Reactor* io_reactor() noexcept
+  {
+    return reactor_.load(std::memory_order_acquire);
+  }
+  bool post_if_running(io_task_t task) noexcept
+  {
+    // Holding the lock keeps the last stop from deleting it under us.
+    std::lock_guard<std::mutex> lock(reactor_mut_);
+    IO_Reactor* reactor = reactor_.load(std::memory_order_acquire);
+    if(!reactor) return false;
+
+    reactor->post(std::move(task));
+    return true;
+  }
+  uv_loop_t* current_io_loop() noexcept
+  {
+    return current_loop_;
+  }
+}
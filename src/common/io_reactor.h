@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2017 Luke San Antonio
+ * All rights reserved.
+ */
+#ifndef REDC_COMMON_IO_REACTOR_H
+#define REDC_COMMON_IO_REACTOR_H
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <uv.h>
+namespace redc
+{
+  using io_task_t = std::function<void (uv_loop_t*)>;
+
+  /*!
+   * \brief Runs one libuv loop on a thread of its own, for all the engine's
+   * I/O.
+   *
+   * Nothing else touches the loop. Other threads post tasks, which run on
+   * the I/O thread in the order they were posted, and any handles are made
+   * and closed in those tasks. Tasks go on a lock-free stack and the I/O
+   * thread takes the whole thing each time it's woken up, so posting never
+   * waits on I/O.
+   *
+   * There's one for the whole process. See start_io_reactor.
+   */
+  struct IO_Reactor
+  {
+    IO_Reactor();
+    // Runs anything still posted and waits for outstanding requests, any
+    // handles should be closed by now.
+    ~IO_Reactor();
+
+    IO_Reactor(IO_Reactor const&) = delete;
+    IO_Reactor& operator=(IO_Reactor const&) = delete;
+
+    void post(io_task_t task) noexcept;
+
+    // Posts the task and waits for it to run, on the I/O thread it just
+    // runs it.
+    void call(io_task_t task) noexcept;
+
+    bool on_io_thread() const noexcept;
+
+  private:
+    struct Task;
+
+    void run_();
+    void run_tasks_();
+
+    uv_loop_t loop_;
+    uv_async_t wake_;
+
+    std::atomic<Task*> tasks_;
+    std::atomic<bool> stopping_;
+
+    std::thread thread_;
+  };
+
+  // Ref-counted, the first start makes the reactor and the last stop gets rid
+  // of it. Anything that posts should hold a reference.
+  void start_io_reactor() noexcept;
+  void stop_io_reactor() noexcept;
+
+  // Null when it isn't running.
+  IO_Reactor* io_reactor() noexcept;
+
+  // For threads without a reference, posts the task only if somebody else is
+  // keeping the reactor running. Returns false and drops it otherwise.
+  bool post_if_running(io_task_t task) noexcept;
+
+  // The loop of the reactor running this thread, which is only the case in
+  // its tasks and callbacks, otherwise null. Unlike io_reactor() this stays
+  // good while the reactor runs what was left on shutdown.
+  uv_loop_t* current_io_loop() noexcept;
+}
+#endif
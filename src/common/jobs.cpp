@@ -0,0 +1,264 @@
+/*
+ * Copyright (C) 2016 Luke San Antonio
+ * All rights reserved.
+ */
+#include "jobs.h"
+#include "thread_local.h"
+#include "log.h"
+namespace redc
+{
+  using job_clock_t = std::chrono::high_resolution_clock;
+
+  namespace
+  {
+    // Which system and worker the current thread belongs to, if any. This is
+    // how a job that queues more jobs gets them put on its own deque.
+    REDC_THREAD_LOCAL Job_System* cur_system_ = nullptr;
+    REDC_THREAD_LOCAL std::size_t cur_worker_ = 0;
+  }
+
+  Job_System::Job_System(unsigned int num_workers)
+    : queued_(0), running_(true), next_worker_(0)
+  {
+    if(num_workers == 0)
+    {
+      unsigned int hw_threads = std::thread::hardware_concurrency();
+      num_workers = hw_threads > 1 ? hw_threads - 1 : 1;
+    }
+
+    stats_start_ = job_clock_t::now();
+
+    // Make every worker before starting any of them since they go looking
+    // through each other's deques.
+    for(unsigned int i = 0; i < num_workers; ++i)
+    {
+      auto worker = std::make_unique<Worker>();
+      worker->jobs_run = 0;
+      worker->jobs_stolen = 0;
+      worker->busy_ns = 0;
+      workers_.push_back(std::move(worker));
+    }
+    for(std::size_t i = 0; i < workers_.size(); ++i)
+    {
+      workers_[i]->thread = std::thread([this, i]() { run_worker_(i); });
+    }
+  }
+  Job_System::~Job_System()
+  {
+    {
+      std::lock_guard<std::mutex> lock(sleep_mut_);
+      running_ = false;
+    }
+    sleep_cond_.notify_all();
+
+    // Jobs that haven't started yet are dropped.
+    for(auto& worker : workers_)
+    {
+      worker->thread.join();
+    }
+  }
+
+  void Job_System::run(job_t job, Job_Counter* counter)
+  {
+    if(counter) ++counter->value_;
+    push_(Queued_Job{std::move(job), counter});
+  }
+
+  void Job_System::run_after(Job_Counter& dependency, job_t job,
+                             Job_Counter* counter)
+  {
+    if(counter) ++counter->value_;
+
+    {
+      // The last job of the dependency takes this same lock before it looks
+      // at the waiting jobs, so we can't miss it.
+      std::lock_guard<std::mutex> lock(dependency.waiting_mut_);
+      if(dependency.value_.load() != 0)
+      {
+        dependency.waiting_.push_back({std::move(job), counter});
+        return;
+      }
+    }
+
+    push_(Queued_Job{std::move(job), counter});
+  }
+
+  void Job_System::wait(Job_Counter& counter)
+  {
+    while(!counter.done())
+    {
+      if(!try_run_one_()) std::this_thread::yield();
+    }
+
+    // The counter hits zero while the last job still holds the lock, make sure
+    // it's let go before our caller destroys the counter.
+    std::lock_guard<std::mutex> lock(counter.waiting_mut_);
+  }
+
+  unsigned int Job_System::num_workers() const
+  {
+    return workers_.size();
+  }
+
+  std::vector<Worker_Stats> Job_System::stats() const
+  {
+    using sec_t = std::chrono::duration<double, std::chrono::seconds::period>;
+    double total = sec_t(job_clock_t::now() - stats_start_).count();
+
+    std::vector<Worker_Stats> ret;
+    for(auto const& worker : workers_)
+    {
+      Worker_Stats stats;
+      stats.jobs_run = worker->jobs_run.load();
+      stats.jobs_stolen = worker->jobs_stolen.load();
+      stats.busy_seconds = worker->busy_ns.load() / 1.0e9;
+      stats.total_seconds = total;
+      ret.push_back(stats);
+    }
+    return ret;
+  }
+  void Job_System::reset_stats()
+  {
+    for(auto& worker : workers_)
+    {
+      worker->jobs_run = 0;
+      worker->jobs_stolen = 0;
+      worker->busy_ns = 0;
+    }
+    stats_start_ = job_clock_t::now();
+  }
+  void Job_System::log_stats() const
+  {
+    std::vector<Worker_Stats> all_stats = stats();
+    for(std::size_t i = 0; i < all_stats.size(); ++i)
+    {
+      Worker_Stats const& stats = all_stats[i];
+      log_i("Job worker %: % jobs run (% stolen), busy % percent", i,
+            stats.jobs_run, stats.jobs_stolen, stats.utilisation() * 100.0);
+    }
+  }
+
+  void Job_System::run_worker_(std::size_t index)
+  {
+    cur_system_ = this;
+    cur_worker_ = index;
+
+    while(running_)
+    {
+      if(try_run_one_()) continue;
+
+      std::unique_lock<std::mutex> lock(sleep_mut_);
+      sleep_cond_.wait(lock, [this]()
+      {
+        return queued_.load() > 0 || !running_;
+      });
+    }
+  }
+
+  void Job_System::push_(Queued_Job job)
+  {
+    // Workers keep their own jobs, anyone else spreads them around.
+    std::size_t index;
+    if(cur_system_ == this) index = cur_worker_;
+    else index = next_worker_++ % workers_.size();
+
+    Worker& worker = *workers_[index];
+    {
+      std::lock_guard<std::mutex> lock(worker.deque_mut);
+      worker.deque.push_back(std::move(job));
+      ++queued_;
+    }
+
+    // Take the lock so a worker can't check queued_ and then go to sleep
+    // right before we notify it.
+    {
+      std::lock_guard<std::mutex> lock(sleep_mut_);
+    }
+    sleep_cond_.notify_one();
+  }
+  bool Job_System::pop_(std::size_t index, Queued_Job& job)
+  {
+    Worker& worker = *workers_[index];
+
+    std::lock_guard<std::mutex> lock(worker.deque_mut);
+    if(worker.deque.empty()) return false;
+
+    job = std::move(worker.deque.back());
+    worker.deque.pop_back();
+    --queued_;
+    return true;
+  }
+  bool Job_System::steal_(std::size_t thief, Queued_Job& job)
+  {
+    // Start with whoever is after us so everyone doesn't gang up on the first
+    // worker.
+    for(std::size_t i = 1; i <= workers_.size(); ++i)
+    {
+      Worker& victim = *workers_[(thief + i) % workers_.size()];
+
+      std::lock_guard<std::mutex> lock(victim.deque_mut);
+      if(victim.deque.empty()) continue;
+
+      job = std::move(victim.deque.front());
+      victim.deque.pop_front();
+      --queued_;
+      return true;
+    }
+    return false;
+  }
+  bool Job_System::try_run_one_()
+  {
+    Queued_Job job;
+    if(cur_system_ == this)
+    {
+      if(!pop_(cur_worker_, job))
+      {
+        if(!steal_(cur_worker_, job)) return false;
+        ++workers_[cur_worker_]->jobs_stolen;
+      }
+    }
+    else
+    {
+      // Some other thread helping out while it waits.
+      if(!steal_(next_worker_.load() % workers_.size(), job)) return false;
+    }
+
+    execute_(job);
+    return true;
+  }
+  void Job_System::execute_(Queued_Job& job)
+  {
+    if(cur_system_ == this)
+    {
+      auto before = job_clock_t::now();
+      job.fn();
+      auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        job_clock_t::now() - before
+      );
+
+      Worker& worker = *workers_[cur_worker_];
+      worker.busy_ns += ns.count();
+      ++worker.jobs_run;
+    }
+    else
+    {
+      job.fn();
+    }
+
+    if(job.counter) finish_(*job.counter);
+  }
+  void Job_System::finish_(Job_Counter& counter)
+  {
+    std::vector<Job_Counter::Waiting_Job> ready;
+    {
+      std::lock_guard<std::mutex> lock(counter.waiting_mut_);
+      if(--counter.value_ == 0) ready.swap(counter.waiting_);
+    }
+
+    // Their counters were already incremented in run_after.
+    for(auto& waiting : ready)
+    {
+      push_(Queued_Job{std::move(waiting.fn), waiting.counter});
+    }
+  }
+}
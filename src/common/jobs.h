@@ -0,0 +1,165 @@
+/*
+ * Copyright (C) 2016 Luke San Antonio
+ * All rights reserved.
+ */
+#ifndef REDC_COMMON_JOBS_H
+#define REDC_COMMON_JOBS_H
+#include <cstdint>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+namespace redc
+{
+  struct Job_System;
+
+  using job_t = std::function<void ()>;
+
+  // Counts unfinished jobs. Every job run with a counter increments it when
+  // it's queued and decrements it once it's done, so it reaches zero when the
+  // whole group is done. Jobs can be made to wait on a counter with
+  // Job_System::run_after.
+  struct Job_Counter
+  {
+    Job_Counter() : value_(0) {}
+    Job_Counter(Job_Counter const&) = delete;
+    Job_Counter& operator=(Job_Counter const&) = delete;
+
+    bool done() const { return value_.load() == 0; }
+    int value() const { return value_.load(); }
+
+  private:
+    friend struct Job_System;
+
+    struct Waiting_Job
+    {
+      job_t fn;
+      Job_Counter* counter;
+    };
+
+    std::atomic<int> value_;
+
+    // Jobs that are waiting on this counter to reach zero.
+    std::mutex waiting_mut_;
+    std::vector<Waiting_Job> waiting_;
+  };
+
+  struct Worker_Stats
+  {
+    // Jobs this worker ran, including the ones it had to steal.
+    uint64_t jobs_run;
+    uint64_t jobs_stolen;
+
+    // Time spent running jobs and the time since the stats were last reset.
+    double busy_seconds;
+    double total_seconds;
+
+    double utilisation() const
+    {
+      return total_seconds > 0.0 ? busy_seconds / total_seconds : 0.0;
+    }
+  };
+
+  // A work-stealing thread pool. Every worker has its own deque, it pushes and
+  // pops jobs at the back (so it works on whatever is hottest in cache) and
+  // when it runs out it steals from the front of somebody else's.
+  struct Job_System
+  {
+    // Zero workers means one less than the amount of hardware threads, since
+    // the main thread helps out when it waits.
+    explicit Job_System(unsigned int num_workers = 0);
+    ~Job_System();
+
+    Job_System(Job_System const&) = delete;
+    Job_System& operator=(Job_System const&) = delete;
+
+    // Queue a job. If a counter is given it is incremented now and
+    // decremented once the job has run.
+    void run(job_t job, Job_Counter* counter = nullptr);
+
+    // Queue a job once dependency reaches zero, right away if it already has.
+    void run_after(Job_Counter& dependency, job_t job,
+                   Job_Counter* counter = nullptr);
+
+    // Block until the counter reaches zero. The calling thread runs jobs in
+    // the meantime, so it's fine to wait from inside a job.
+    void wait(Job_Counter& counter);
+
+    // Calls fn(i) for every i in [begin, end), grain indices per job, and
+    // waits for all of it to finish.
+    template <class Fn>
+    void parallel_for(std::size_t begin, std::size_t end, std::size_t grain,
+                      Fn fn);
+
+    unsigned int num_workers() const;
+
+    std::vector<Worker_Stats> stats() const;
+    void reset_stats();
+    void log_stats() const;
+
+  private:
+    struct Queued_Job
+    {
+      job_t fn;
+      Job_Counter* counter;
+    };
+
+    struct Worker
+    {
+      std::mutex deque_mut;
+      std::deque<Queued_Job> deque;
+
+      std::atomic<uint64_t> jobs_run;
+      std::atomic<uint64_t> jobs_stolen;
+      std::atomic<uint64_t> busy_ns;
+
+      std::thread thread;
+    };
+
+    void run_worker_(std::size_t index);
+
+    void push_(Queued_Job job);
+    bool pop_(std::size_t worker, Queued_Job& job);
+    bool steal_(std::size_t thief, Queued_Job& job);
+    bool try_run_one_();
+    void execute_(Queued_Job& job);
+    void finish_(Job_Counter& counter);
+
+    std::vector<std::unique_ptr<Worker> > workers_;
+
+    // Roughly the number of queued jobs, sleeping workers wait on this.
+    std::atomic<int> queued_;
+    std::atomic<bool> running_;
+    std::atomic<unsigned int> next_worker_;
+
+    std::mutex sleep_mut_;
+    std::condition_variable sleep_cond_;
+
+    std::chrono::high_resolution_clock::time_point stats_start_;
+  };
+
+  template <class Fn>
+  void Job_System::parallel_for(std::size_t begin, std::size_t end,
+                                std::size_t grain, Fn fn)
+  {
+    if(grain == 0) grain = 1;
+
+    Job_Counter counter;
+    for(std::size_t chunk = begin; chunk < end; chunk += grain)
+    {
+      std::size_t chunk_end = std::min(chunk + grain, end);
+      run([chunk, chunk_end, &fn]()
+      {
+        for(std::size_t i = chunk; i < chunk_end; ++i) fn(i);
+      }, &counter);
+    }
+    wait(counter);
+  }
+}
+#endif
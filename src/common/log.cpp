@@ -3,10 +3,14 @@
  * All rights reserved.
  */
 #include "log.h"
+#include <atomic>
+#include <chrono>
 #include <string>
 #include <ctime>
 #include <cstring>
+#include <thread>
 #include <uv.h>
+#include "io_reactor.h"
 #include "thread_local.h"
 
 // For O_WRONLY, O_APPEND, S_IRUSR, S_IWUSR, etc
@@ -36,33 +40,47 @@ namespace redc
     uninit_log();
   }
 
-  REDC_THREAD_LOCAL uv_loop_t* loop_ = nullptr;
+  // Whether this thread holds a reference to the I/O reactor, which does
+  // the writing. Threads that don't can only log while another one does.
+  REDC_THREAD_LOCAL bool log_init_ = false;
   Log_Severity out_level_ = Log_Severity::Debug;
   Log_Severity file_level_ = Log_Severity::Debug;
+
+  // Only touched on the I/O thread.
   bool good_file_ = false;
   uv_file file_;
 
+  // Writes that have been logged but aren't finished.
+  std::atomic<unsigned int> pending_writes_(0);
+
   void init_log() noexcept
   {
-    if(loop_) return;
+    if(log_init_) return;
 
-    loop_ = new uv_loop_t;
-    uv_loop_init(loop_);
+    start_io_reactor();
+    log_init_ = true;
   }
   void uninit_log() noexcept
   {
-    if(!loop_) return;
+    if(!log_init_) return;
 
-    uv_loop_close(loop_);
-    delete loop_;
+    log_init_ = false;
+    stop_io_reactor();
   }
   void flush_log() noexcept
   {
-    uv_run(loop_, UV_RUN_NOWAIT);
+    // The I/O thread writes messages as they come, there's nothing to pump.
   }
   void flush_log_full() noexcept
   {
-    uv_run(loop_, UV_RUN_DEFAULT);
+    // Waiting on the I/O thread from the I/O thread would never end.
+    IO_Reactor* reactor = io_reactor();
+    if(!log_init_ || !reactor || reactor->on_io_thread()) return;
+
+    while(pending_writes_.load() > 0)
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
   }
 
   void set_out_log_level(Log_Severity level) noexcept
@@ -78,26 +96,36 @@ namespace redc
   }
   void set_log_file(std::string fn) noexcept
   {
-    // This only attempts to initialize loop_, but won't do anything if we call
-    // it multiple times.
+    // This only attempts to initialize the log, but won't do anything if we
+    // call it multiple times.
     init_log();
 
-    uv_fs_t fs_req;
-    int err = uv_fs_open(loop_, &fs_req, fn.c_str(),
-                         O_WRONLY | O_APPEND | O_CREAT,
-                         REDC_LOG_FILE_MODE, NULL);
-    // I still don't really get the usage of uv_fs_open in synchroneous mode.
-    // It seems like the return value is the result in fs_res but also an error
-    // code if it's negative.
+    int err = 0;
+    io_reactor()->call([&](uv_loop_t* loop)
+    {
+      uv_fs_t fs_req;
+      err = uv_fs_open(loop, &fs_req, fn.c_str(),
+                       O_WRONLY | O_APPEND | O_CREAT,
+                       REDC_LOG_FILE_MODE, NULL);
+      uv_fs_req_cleanup(&fs_req);
+      // I still don't really get the usage of uv_fs_open in synchroneous
+      // mode. It seems like the return value is the result in fs_res but
+      // also an error code if it's negative.
+      if(err < 0)
+      {
+        good_file_ = false;
+      }
+      else
+      {
+        file_ = err;
+        good_file_ = true;
+      }
+    });
+
+    // Out here, where the log has been initialized.
     if(err < 0)
     {
       log_e("Error opening log file: %", uv_strerror(err));
-      good_file_ = false;
-    }
-    else
-    {
-      file_ = fs_req.result;
-      good_file_ = true;
     }
   }
 
@@ -107,9 +135,16 @@ namespace redc
     std::string time;
     time.resize(25);
 
+    // Any thread can log, std::localtime shares its result between them.
     std::time_t t = std::time(NULL);
+    std::tm local;
+#if defined(_WIN32)
+    localtime_s(&local, &t);
+#else
+    localtime_r(&t, &local);
+#endif
     std::size_t count = std::strftime(&time[0], time.size(),
-                                      format.c_str(), std::localtime(&t));
+                                      format.c_str(), &local);
     if(count == 0)
     {
       time = "badtime";
@@ -178,33 +213,57 @@ namespace redc
 
     // Deallocate request subclass.
     delete req;
+
+    --pending_writes_;
   }
 
-  void log_out(char* msg, std::size_t size) noexcept
+  // On the I/O thread.
+  void start_write(uv_loop_t* loop, bool to_file, char* msg,
+                   std::size_t size) noexcept
   {
-    if(!loop_)
+    // Bad file descriptor
+    if(to_file && !good_file_)
     {
       delete[] msg;
+      --pending_writes_;
       return;
     }
 
     // Make the request.
     write_req_t* req = new write_req_t;
     req->buf = uv_buf_init(msg, size);
-    uv_fs_write(loop_, &req->req, 1, &req->buf, 1, -1, after_log);
+    uv_fs_write(loop, &req->req, to_file ? file_ : 1, &req->buf, 1, -1,
+                after_log);
   }
-  void log_file(char* msg, std::size_t size) noexcept
+
+  void log_write(bool to_file, char* msg, std::size_t size) noexcept
   {
-    // Bad file descriptor or bad loop
-    if(!loop_ || !good_file_)
+    // Reactor tasks never init the log, but the reactor is obviously there
+    // while they run, so they can write straight away.
+    if(uv_loop_t* loop = current_io_loop())
     {
-      delete[] msg;
+      ++pending_writes_;
+      start_write(loop, to_file, msg, size);
       return;
     }
 
-    write_req_t* req = new write_req_t;
-    req->buf = uv_buf_init(msg, size);
-    uv_fs_write(loop_, &req->req, file_, &req->buf, 1, -1, after_log);
+    ++pending_writes_;
+    auto write = [=](uv_loop_t* loop)
+    {
+      start_write(loop, to_file, msg, size);
+    };
+
+    if(log_init_)
+    {
+      io_reactor()->post(write);
+    }
+    // Worker threads and the like never init the log, they go through the
+    // reactor as long as somebody else has it running.
+    else if(!post_if_running(write))
+    {
+      delete[] msg;
+      --pending_writes_;
+    }
   }
   void log(Log_Severity severity, std::string msg) noexcept
   {
@@ -217,7 +276,7 @@ namespace redc
     {
       char* msg_buf = new char[msg_file.size()];
       std::memcpy(msg_buf, msg_file.data(), msg_file.size());
-      log_file(msg_buf, msg_file.size());
+      log_write(true, msg_buf, msg_file.size());
     }
 
     if((unsigned int) severity >= (unsigned int) out_level_)
@@ -225,7 +284,7 @@ namespace redc
       std::string msg_term = severity_color(severity) + msg_file + RESET_C;
       char* msg_buf = new char[msg_term.size()];
       std::memcpy(msg_buf, msg_term.data(), msg_term.size());
-      log_out(msg_buf, msg_term.size());
+      log_write(false, msg_buf, msg_term.size());
     }
   }
 }
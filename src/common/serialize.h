@@ -0,0 +1,303 @@
+/*
+ * Copyright (C) 2017 Luke San Antonio
+ * All rights reserved.
+ */
+#ifndef REDC_COMMON_SERIALIZE_H
+#define REDC_COMMON_SERIALIZE_H
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include <glm/glm.hpp>
+#include "bit_stream.h"
+namespace redc
+{
+  /*!
+   * \brief Fixed layout binary serialization, without any allocation for
+   * fixed size types.
+   *
+   * A struct lists its fields once with REDC_SERIALIZE and they are written
+   * in that order, with nothing in between. Bools are one bit so a bunch of
+   * them end up as a bitfield. Integers and floats always take their full
+   * width, enums take the width of their underlying type. Strings and
+   * vectors are prefixed with a 16 bit length, they're the only thing that
+   * allocates, and only when reading.
+   *
+   * Reads are bounds checked: any read past the end makes the whole thing
+   * fail, so does a length that can't possibly fit in what's left.
+   *
+   * Specialize Serializer for anything else.
+   */
+  template <class T, class Enable = void>
+  struct Serializer
+  {
+    template <class Writer>
+    static void write(Writer& w, T const& t) noexcept;
+    static void read(Bit_Reader& r, T& t) noexcept;
+  };
+
+#define REDC_SERIALIZE(...) \
+  template <class Archive> \
+  void serialize_fields(Archive& ar) { ar(__VA_ARGS__); } \
+  template <class Archive> \
+  void serialize_fields(Archive& ar) const { ar(__VA_ARGS__); }
+
+  template <class T, class Writer>
+  void serialize_value(Writer& w, T const& t) noexcept
+  {
+    Serializer<T>::write(w, t);
+  }
+  template <class T>
+  void deserialize_value(Bit_Reader& r, T& t) noexcept
+  {
+    Serializer<T>::read(r, t);
+  }
+
+  namespace detail
+  {
+    template <class Writer>
+    struct Field_Writer
+    {
+      Writer& w;
+
+      template <class... Fields>
+      void operator()(Fields const&... fields) noexcept
+      {
+        int unused[] = {0, (serialize_value(w, fields), 0)...};
+        (void) unused;
+      }
+    };
+
+    struct Field_Reader
+    {
+      Bit_Reader& r;
+
+      template <class... Fields>
+      void operator()(Fields&... fields) noexcept
+      {
+        // Give up on the rest as soon as something goes wrong.
+        int unused[] = {0, (r.good() ? deserialize_value(r, fields) :
+                                       void(), 0)...};
+        (void) unused;
+      }
+    };
+  }
+
+  // Structs with REDC_SERIALIZE.
+  template <class T, class Enable>
+  template <class Writer>
+  void Serializer<T, Enable>::write(Writer& w, T const& t) noexcept
+  {
+    detail::Field_Writer<Writer> fields{w};
+    t.serialize_fields(fields);
+  }
+  template <class T, class Enable>
+  void Serializer<T, Enable>::read(Bit_Reader& r, T& t) noexcept
+  {
+    detail::Field_Reader fields{r};
+    t.serialize_fields(fields);
+  }
+
+  template <>
+  struct Serializer<bool>
+  {
+    template <class Writer>
+    static void write(Writer& w, bool b) noexcept { w.write_bool(b); }
+    static void read(Bit_Reader& r, bool& b) noexcept { b = r.read_bool(); }
+  };
+
+  template <class T>
+  struct Serializer<T, std::enable_if_t<std::is_integral<T>::value &&
+                                        !std::is_same<T, bool>::value> >
+  {
+    using unsigned_t = std::make_unsigned_t<T>;
+    // Bit streams only do 32 bits at a time.
+    static constexpr unsigned int bits = sizeof(T) * 8;
+    static constexpr unsigned int low_bits = bits > 32 ? 32 : bits;
+    static constexpr unsigned int high_bits = bits - low_bits;
+
+    template <class Writer>
+    static void write(Writer& w, T t) noexcept
+    {
+      uint64_t value = static_cast<unsigned_t>(t);
+      w.write(static_cast<uint32_t>(value), low_bits);
+      if(high_bits) w.write(static_cast<uint32_t>(value >> 32), high_bits);
+    }
+    static void read(Bit_Reader& r, T& t) noexcept
+    {
+      uint64_t value = r.read(low_bits);
+      if(high_bits) value |= static_cast<uint64_t>(r.read(high_bits)) << 32;
+      t = static_cast<T>(static_cast<unsigned_t>(value));
+    }
+  };
+
+  template <class T>
+  struct Serializer<T, std::enable_if_t<std::is_enum<T>::value> >
+  {
+    using underlying_t = std::underlying_type_t<T>;
+
+    template <class Writer>
+    static void write(Writer& w, T t) noexcept
+    {
+      serialize_value(w, static_cast<underlying_t>(t));
+    }
+    static void read(Bit_Reader& r, T& t) noexcept
+    {
+      underlying_t value;
+      deserialize_value(r, value);
+      t = static_cast<T>(value);
+    }
+  };
+
+  template <>
+  struct Serializer<float>
+  {
+    template <class Writer>
+    static void write(Writer& w, float f) noexcept
+    {
+      uint32_t bits;
+      std::memcpy(&bits, &f, sizeof(bits));
+      w.write(bits, 32);
+    }
+    static void read(Bit_Reader& r, float& f) noexcept
+    {
+      uint32_t bits = r.read(32);
+      std::memcpy(&f, &bits, sizeof(f));
+    }
+  };
+
+  template <class T, std::size_t N>
+  struct Serializer<std::array<T, N> >
+  {
+    template <class Writer>
+    static void write(Writer& w, std::array<T, N> const& a) noexcept
+    {
+      for(auto const& t : a) serialize_value(w, t);
+    }
+    static void read(Bit_Reader& r, std::array<T, N>& a) noexcept
+    {
+      for(auto& t : a)
+      {
+        if(!r.good()) return;
+        deserialize_value(r, t);
+      }
+    }
+  };
+
+  // glm vectors are just their components.
+#define REDC_SERIALIZE_GLM_VEC(n) \
+  template <> \
+  struct Serializer<glm::vec##n> \
+  { \
+    template <class Writer> \
+    static void write(Writer& w, glm::vec##n const& v) noexcept \
+    { \
+      for(int i = 0; i < n; ++i) serialize_value(w, v[i]); \
+    } \
+    static void read(Bit_Reader& r, glm::vec##n& v) noexcept \
+    { \
+      for(int i = 0; i < n; ++i) deserialize_value(r, v[i]); \
+    } \
+  }
+
+  REDC_SERIALIZE_GLM_VEC(2);
+  REDC_SERIALIZE_GLM_VEC(3);
+  REDC_SERIALIZE_GLM_VEC(4);
+
+#undef REDC_SERIALIZE_GLM_VEC
+
+  // Strings and vectors can't be longer than this.
+  constexpr std::size_t SERIALIZE_MAX_LENGTH = 0xffff;
+
+  template <>
+  struct Serializer<std::string>
+  {
+    template <class Writer>
+    static void write(Writer& w, std::string const& s) noexcept
+    {
+      REDC_ASSERT(s.size() <= SERIALIZE_MAX_LENGTH);
+      w.write(s.size(), 16);
+      for(char c : s) w.write(static_cast<uint8_t>(c), 8);
+    }
+    static void read(Bit_Reader& r, std::string& s) noexcept
+    {
+      std::size_t size = r.read(16);
+      if(!r.good() || size * 8 > r.bits_left())
+      {
+        r.fail();
+        return;
+      }
+
+      s.resize(size);
+      for(char& c : s) c = static_cast<char>(r.read(8));
+    }
+  };
+
+  template <class T>
+  struct Serializer<std::vector<T> >
+  {
+    template <class Writer>
+    static void write(Writer& w, std::vector<T> const& v) noexcept
+    {
+      REDC_ASSERT(v.size() <= SERIALIZE_MAX_LENGTH);
+      w.write(v.size(), 16);
+      for(auto const& t : v) serialize_value(w, t);
+    }
+    static void read(Bit_Reader& r, std::vector<T>& v) noexcept
+    {
+      // Everything takes at least a bit, don't let a bad length make us
+      // allocate a bunch of elements we'll never fill.
+      std::size_t size = r.read(16);
+      if(!r.good() || size > r.bits_left())
+      {
+        r.fail();
+        return;
+      }
+
+      v.resize(size);
+      for(auto& t : v)
+      {
+        if(!r.good()) return;
+        deserialize_value(r, t);
+      }
+    }
+  };
+
+  // How many bits t takes.
+  template <class T>
+  std::size_t serialized_bits(T const& t) noexcept
+  {
+    Bit_Counter counter;
+    serialize_value(counter, t);
+    return counter.bit_size();
+  }
+  template <class T>
+  std::size_t serialized_size(T const& t) noexcept
+  {
+    return (serialized_bits(t) + 7) / 8;
+  }
+
+  // False if it doesn't fit, the buffer should be serialized_size(t).
+  template <class T>
+  bool serialize(T const& t, uint8_t* data, std::size_t size) noexcept
+  {
+    Bit_Span_Writer writer(data, size);
+    serialize_value(writer, t);
+    return writer.good();
+  }
+
+  // False if the data is short or has anything but zero padding after it,
+  // so there's only one way to encode anything. On failure t is left half
+  // read.
+  template <class T>
+  bool deserialize(T& t, uint8_t const* data, std::size_t size) noexcept
+  {
+    Bit_Reader reader(data, size);
+    deserialize_value(reader, t);
+    if(!reader.good() || reader.bits_left() >= 8) return false;
+    return reader.read(reader.bits_left()) == 0;
+  }
+}
+#endif
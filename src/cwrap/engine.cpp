@@ -14,7 +14,9 @@
 
 #include "../assets/load_dir.h"
 #include "../gfx/gl/driver.h"
+#include "../gfx/gl/program_cache.h"
 
+#include <array>
 #include <thread>
 #include <chrono>
 
@@ -79,9 +81,19 @@ extern "C"
     // Play at full volume.
     eng->audio->setPostClipScaler(1.0f);
 
+    eng->jobs = std::make_unique<Job_System>();
+
     eng->mesh_cache =
             std::make_unique<gfx::Mesh_Cache>(eng->share_path / "obj",
-                                              eng->share_path / "obj_cache");
+                                              eng->share_path / "obj_cache",
+                                              eng->jobs.get());
+    eng->texture_cache =
+            std::make_unique<gfx::Texture_Cache>(eng->share_path / "tex",
+                                                 eng->share_path / "tex_cache",
+                                                 cfg.compress_textures);
+
+    eng->map_loader = std::make_unique<Map_Loader>(*eng->jobs);
+    eng->file_watcher = std::make_unique<assets::File_Watcher>();
 
     log_i("Initialized the Red Crane Engine alpha version %.%.% (Mod: %)",
           REDC_ENGINE_VERSION_MAJOR, REDC_ENGINE_VERSION_MINOR,
@@ -114,10 +126,20 @@ extern "C"
     int x, y;
     SDL_GetWindowSize(sdl_window, &x, &y);
 
-    rce->client->driver = std::make_unique<gfx::gl::Driver>(Vec<int>{x,y});
+    auto driver = std::make_unique<gfx::gl::Driver>(Vec<int>{x,y});
+    driver->use_program_cache((rce->share_path / "shader_cache").string());
+    rce->client->driver = std::move(driver);
 
     rce->client->driver->set_clear_color(colors::clear_black);
 
+    if(rce->config.texture_budget)
+    {
+      rce->client->texture_streamer = std::make_unique<gfx::Texture_Streamer>(
+        *rce->client->driver, *rce->texture_cache,
+        static_cast<std::size_t>(rce->config.texture_budget) * 1024 * 1024
+      );
+    }
+
     // Load default shader, etc.
     auto df_shade = rce->client->driver->make_shader_repr();
 
@@ -136,6 +158,9 @@ extern "C"
     df_shade->set_var_tag(dif_tex_tag, "diffuse");
     df_shade->set_integer(dif_tex_tag, 0);
 
+    df_shade->set_var_tag(uv_transform_tag, "uv_transform");
+    df_shade->set_vec4(uv_transform_tag, glm::vec4(1.0f, 1.0f, 0.0f, 0.0f));
+
     // TODO: Put this in a lua script so we don't have to do this.
     df_shade->tag_var("light_pos");
     // Set light position, maybe put standardize this tag?
@@ -171,6 +196,10 @@ extern "C"
   {
     auto rce = (Engine*) eng;
     rce->audio->deinit();
+
+    // How busy was everyone?
+    rce->jobs->log_stats();
+
     delete rce;
 
     // Shutdown Yojimbo
@@ -180,12 +209,50 @@ extern "C"
   void redc_step_engine(void* eng)
   {
     auto rce = (Engine*) eng;
-    Event event;
-    while(rce->poll_event(event))
+
+    rce->file_watcher->dispatch();
+
+    // Pick up maps that finished loading in the background. If we're going to
+    // render them they are uploaded over the next few frames first, the server
+    // doesn't find out about a map until it's completely ready.
+    std::unique_ptr<Map> map;
+    while(rce->map_loader->poll_loaded(map))
+    {
+      if(rce->client) rce->client->begin_map_upload(std::move(map));
+      else if(rce->server) rce->server->add_map(std::move(map));
+    }
+    if(rce->client)
+    {
+      map = rce->client->step_map_uploads();
+      if(map && rce->server) rce->server->add_map(std::move(map));
+
+      // Bring in the texture levels last frame asked for.
+      if(rce->client->texture_streamer)
+      {
+        rce->client->texture_streamer->step(rce->client->map_upload_budget);
+      }
+
+      // By the first step the game has built every shader it starts with.
+      if(!rce->client->logged_program_totals)
+      {
+        auto& driver = static_cast<gfx::gl::Driver&>(*rce->client->driver);
+        if(driver.program_cache()) driver.program_cache()->log_totals();
+        rce->client->logged_program_totals = true;
+      }
+    }
+
+    // Take them a batch at a time, that's one trip to the queue for all of
+    // them.
+    std::array<Event, 32> events;
+    std::size_t count;
+    while((count = rce->poll_events(events.data(), events.size())))
     {
-      // Please branch predictor save me
-      if(rce->client) rce->client->process_event(event);
-      if(rce->server) rce->server->process_event(event);
+      for(std::size_t i = 0; i < count; ++i)
+      {
+        // Please branch predictor save me
+        if(rce->client) rce->client->process_event(events[i]);
+        if(rce->server) rce->server->process_event(events[i]);
+      }
     }
   }
 
@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2017 Luke San Antonio
+ * All rights reserved.
+ *
+ * This file provides the implementation for the engine's C interface,
+ * specifically tailored for LuaJIT's FFI facilities.
+ *
+ * Network telemetry
+ */
+
+#include <cstring>
+#include "../net/telemetry.h"
+#include "redcrane.hpp"
+
+using namespace redc;
+
+extern "C"
+{
+  int redc_net_peer_count()
+  {
+    return net::net_telemetry().num_peers();
+  }
+
+  int redc_net_peer_stats(int index, Redc_Peer_Stats *stats)
+  {
+    auto& telemetry = net::net_telemetry();
+    if(index < 0 || static_cast<std::size_t>(index) >= telemetry.num_peers())
+    {
+      return false;
+    }
+
+    auto summary = telemetry.summary(index);
+    if(enet_address_get_host_ip(&summary.address, stats->address,
+                                sizeof(stats->address)) != 0)
+    {
+      std::strcpy(stats->address, "unknown");
+    }
+    stats->port = summary.address.port;
+
+    stats->rtt_ms = summary.rtt_ms;
+    stats->rtt_max_ms = summary.rtt_max_ms;
+    stats->jitter_ms = summary.jitter_ms;
+    stats->packet_loss = summary.packet_loss;
+    stats->reliable_in_transit = summary.reliable_in_transit_max;
+    stats->bytes_in = summary.bytes_in;
+    stats->bytes_out = summary.bytes_out;
+    stats->saturated = summary.saturated();
+    return true;
+  }
+
+  int redc_net_peer_message_rate(int index, const char *type, float *in,
+                                 float *out)
+  {
+    auto& telemetry = net::net_telemetry();
+    if(index < 0 || static_cast<std::size_t>(index) >= telemetry.num_peers())
+    {
+      return false;
+    }
+
+    auto summary = telemetry.summary(index);
+    auto i = static_cast<std::size_t>(net::message_type_from_string(type));
+    *in = summary.type_bytes_in[i];
+    *out = summary.type_bytes_out[i];
+    return true;
+  }
+}
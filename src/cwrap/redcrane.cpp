@@ -7,15 +7,12 @@
  */
 
 #include "redcrane.hpp"
+#include "../common/log.h"
 
 #include "../gfx/extra/format.h"
 #include "../gfx/extra/allocate.h"
 #include "../gfx/extra/write_data_to_mesh.h"
 
-#include "../common/json.h"
-
-#include "../assets/minigltf.h"
-
 namespace redc
 {
   struct Model_Visitor : boost::static_visitor<glm::mat4>
@@ -48,11 +45,14 @@ namespace redc
 
   void Engine::push_outgoing_event(Event event)
   {
-    event_queue_.push_outgoing_event(std::move(event));
+    if(!event_queue_.push_outgoing_event(std::move(event)))
+    {
+      log_w("Engine event queue is full, dropping an event");
+    }
   }
-  bool Engine::poll_event(Event& event)
+  std::size_t Engine::poll_events(Event* events, std::size_t max)
   {
-    return event_queue_.poll_event(event);
+    return event_queue_.poll_events(events, max);
   }
 
   struct Client_Event_Visitor : boost::static_visitor<>
@@ -66,25 +66,50 @@ namespace redc
     {
       REDC_ASSERT_MSG(event.map != nullptr, "Invalid map provided to client");
 
-      // Compile the map glTF scene into a renderable asset
-      event.map->render = std::make_unique<Rendering_Component>();
-
-      // Load the cel techniques first
-      tinygltf::Scene cel_scene;
-      bool gltf_load_succeeded = load_gltf_file(cel_scene,
-                                                "../assets/gltf/library-pre.gltf");
-      REDC_ASSERT_MSG(gltf_load_succeeded,
-        "glTF techniques could not be found; broken installation");
-      event.map->render->asset = load_asset(*client_->driver, cel_scene);
-
-      // Then the map
-      append_to_asset(*client_->driver, event.map->render->asset,
-                      event.map->scene);
+      // Nothing to do, the map was uploaded before this event was sent. See
+      // Client::step_map_uploads.
     }
   private:
     Client* client_;
   };
 
+  void Client::begin_map_upload(std::unique_ptr<Map> map)
+  {
+    // Compile the map glTF scene into a renderable asset
+    map->render = std::make_unique<Rendering_Component>();
+
+    Map_Upload upload;
+
+    // Load the cel techniques first, then the map
+    upload.techniques =
+      gfx::begin_asset_upload(map->render->asset, map->techniques);
+    upload.scene = gfx::begin_asset_upload(map->render->asset, map->scene);
+
+    upload.map = std::move(map);
+    map_uploads_.push(std::move(upload));
+  }
+  std::unique_ptr<Map> Client::step_map_uploads()
+  {
+    if(map_uploads_.empty()) return nullptr;
+
+    Map_Upload& upload = map_uploads_.front();
+
+    std::size_t budget = map_upload_budget;
+    auto deadline = std::chrono::steady_clock::now() + map_upload_time;
+    if(!gfx::step_asset_upload(*driver, upload.techniques, budget, deadline))
+    {
+      return nullptr;
+    }
+    if(!gfx::step_asset_upload(*driver, upload.scene, budget, deadline))
+    {
+      return nullptr;
+    }
+
+    std::unique_ptr<Map> map = std::move(upload.map);
+    map_uploads_.pop();
+    return map;
+  }
+
   void Client::process_event(event_t const& event)
   {
     boost::apply_visitor(Client_Event_Visitor{*this}, event);
@@ -112,15 +137,11 @@ namespace redc
   {
     // This is a map-specific shape, so it goes here. Use it to construct the
     // rigid body found in our base class.
-    std::unique_ptr<btTriangleIndexVertexArray> vertices;
-    std::unique_ptr<btBvhTriangleMeshShape> shape;
+    std::unique_ptr<Collision_Mesh> mesh;
 
     Map_Collision(Server& server) : server_(&server) {}
     ~Map_Collision();
 
-    std::vector<uint8_t>* vertex_data;
-    std::vector<uint8_t>* index_data;
-
     std::vector<std::unique_ptr<btCollisionShape> > click_shapes;
     std::vector<std::unique_ptr<btRigidBody> > click_objects;
   private:
@@ -138,9 +159,6 @@ namespace redc
     {
       server_->bt_world->removeRigidBody(body_iter->get());
     }
-
-    delete vertex_data;
-    delete index_data;
   }
 
   void Server_Event_Visitor::operator()(Map_Loaded_Event const& event) const
@@ -149,107 +167,20 @@ namespace redc
 
     auto& map = event.map;
 
-    // Use the accessors from the glTF scene.
-    std::vector<uint8_t>* verts_data = new std::vector<uint8_t>();
-    tinygltf::Accessor verts_access;
-
-    std::vector<uint8_t>* indices_data = new std::vector<uint8_t>();
-    tinygltf::Accessor indices_access;
-
-    if(!resolve_gltf_accessor_data(map->scene, map->collision_vertices_source,
-                                   *verts_data, verts_access) ||
-       !resolve_gltf_accessor_data(map->scene, map->collision_indices_source,
-                                   *indices_data, indices_access))
-    {
-      log_w("Failed to load collision mesh - map collision will be turned off");
-      return;
-    }
-
-    // Some assertions (but they shouldn't crash the program)
-    if(verts_access.type != TINYGLTF_TYPE_VEC3 &&
-       verts_access.type != TINYGLTF_TYPE_VEC4)
-    {
-      log_w("Collision vertex data must be given as VEC3s or VEC4s");
-      return;
-    }
-    if(indices_access.type != TINYGLTF_TYPE_SCALAR)
-    {
-      log_w("Collision index data must be given as SCALARs");
-      return;
-    }
-
-    // Sensible default of the size of a short.
-    std::size_t index_size = 2;
-
-    // I hope the bullet knows what we mean when it comes to signedness.
-    PHY_ScalarType index_type = PHY_INTEGER;
-
-    // Find the size of each index
-    switch(indices_access.componentType)
-    {
-    case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
-    case TINYGLTF_COMPONENT_TYPE_BYTE:
-      index_size = 1;
-      index_type = PHY_UCHAR;
-      break;
-    case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
-    case TINYGLTF_COMPONENT_TYPE_SHORT:
-      index_size = 2;
-      index_type = PHY_SHORT;
-      break;
-    case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:
-    case TINYGLTF_COMPONENT_TYPE_INT:
-      index_size = 4;
-      index_type = PHY_INTEGER;
-      break;
-    default:
-      log_w("Invalid data type of collision index data");
-      return;
-    }
-
-    std::size_t vert_size = sizeof(float);
-    PHY_ScalarType vert_type = PHY_FLOAT;
-    switch(verts_access.componentType)
-    {
-    case TINYGLTF_COMPONENT_TYPE_FLOAT:
-      vert_size = sizeof(float);
-      vert_type = PHY_FLOAT;
-      break;
-    case TINYGLTF_COMPONENT_TYPE_DOUBLE:
-      vert_size = sizeof(double);
-      vert_type = PHY_DOUBLE;
-      break;
-    }
+    // The collision mesh and its BVH were built by the map loader, we just
+    // have to put it in our world. If it's missing a warning was already
+    // logged.
+    if(!map->collision_mesh) return;
 
     auto collision = std::make_unique<Map_Collision>(*server_);
-
-    collision->vertex_data = verts_data;
-    collision->index_data = indices_data;
-
-    btIndexedMesh indexed_mesh;
-
-    indexed_mesh.m_numVertices = indices_access.count;
-    indexed_mesh.m_triangleIndexBase = &(*indices_data)[indices_access.byteOffset];
-    indexed_mesh.m_triangleIndexStride = index_size * 3;
-
-    indexed_mesh.m_numTriangles = indices_access.count / 3;
-    indexed_mesh.m_vertexBase = &(*verts_data)[verts_access.byteOffset];
-    indexed_mesh.m_vertexStride = vert_size * 3;
-    indexed_mesh.m_vertexType = vert_type;
-
-    collision->vertices = std::make_unique<btTriangleIndexVertexArray>();
-    collision->vertices->addIndexedMesh(indexed_mesh, index_type);
-
-    collision->shape = std::make_unique<btBvhTriangleMeshShape>(
-        collision->vertices.get(), false, true);
+    collision->mesh = std::move(map->collision_mesh);
 
     btRigidBody::btRigidBodyConstructionInfo map_rb_info
-            {0, nullptr, collision->shape.get()};
+            {0, nullptr, collision->mesh->shape.get()};
 
     collision->body = std::make_unique<btRigidBody>(map_rb_info);
 
     server_->bt_world->addRigidBody(collision->body.get());
-
     // Add physics event shapes
     for(auto iter = map->physics_events.begin();
         iter != map->physics_events.end(); ++iter)
@@ -332,6 +263,13 @@ namespace redc
   {
     return lua_event_queue_.poll_event(event);
   }
+  void Server::push_lua_event(Lua_Event event)
+  {
+    if(!lua_event_queue_.push(event))
+    {
+      log_w("Lua event queue is full, dropping an event");
+    }
+  }
 
   Server::Server(Engine& eng) : engine_(&eng)
   {
@@ -361,41 +299,40 @@ namespace redc
     // Be careful about reusing the memory for the player controller here.
     Player& player = at_id(this->players, id);
     player.controller.reset();
-    player.controller.server = this;
+    player.controller.on_click = [this](btCollisionObject const* object)
+    {
+      on_physics_click(object);
+    };
 
     // New player, notify anyone who cares
     engine_->push_outgoing_event(New_Player_Event{id, true});
   }
-  Player& Server::player(player_id id)
-  {
-    return players[id-1];
-  }
-  void Server::load_map(std::string const& filename)
+  void Server::step()
   {
-    log_i("Loading map '%'...", filename);
-
-    // Load json file
-    rapidjson::Document mapdoc;
-    if(!load_json(mapdoc, filename + ".json"))
+    while(ticker.begin(tick_clock_t::now()))
     {
-      log_e("Failed to load map file: %.json", filename);
-      return;
+      bt_world->stepSimulation(ticker.dt(), 0);
+      ticker.end(tick_clock_t::now());
     }
 
-    // Allocate on the heap so the address doesn't change, it might be
-    // referenced in the physics or render component.
-    auto map = std::make_unique<Map>();
-
-    std::string err;
-    if(load_map_json(*map, mapdoc, &err))
+    if(ticker.stats().ticks >= ticker.tickrate() * 30)
     {
-      log_i("Successfully loaded map '%'", filename);
+      ticker.log_stats("Server");
+      ticker.reset_stats();
     }
-    else
-    {
-      log_e("Failed to load map '%': %", filename, err);
-    }
-
+  }
+  Player& Server::player(player_id id)
+  {
+    return players[id-1];
+  }
+  void Server::load_map(std::string const& filename)
+  {
+    // If we are rendering the map the client will need the techniques as well
+    // as the scene.
+    engine_->map_loader->load(filename, engine_->client != nullptr);
+  }
+  void Server::add_map(std::unique_ptr<Map> map)
+  {
     // Record the pointer to the map
     auto map_observer = observer_ptr<Map>{map.get()};
 
@@ -403,11 +340,10 @@ namespace redc
     maps.push_back(std::move(map));
 
     // Queue the new map event. This should inform the client and a Server
-    // routine that the map has been loaded. The client will probably upload
-    // the data to GPU memory and the server will give bullet the data so we
-    // have collision.
+    // routine that the map has been loaded. The map is already on the GPU if
+    // we are rendering it, the server still has to give bullet the collision
+    // mesh.
     engine_->push_outgoing_event(Map_Loaded_Event{map_observer});
-
   }
 
   struct Scene_Event_Visitor : public boost::static_visitor<>
@@ -8,6 +8,7 @@
 #pragma once
 #include <cstdint>
 #include <memory>
+#include <queue>
 
 #include <boost/variant.hpp>
 
@@ -20,6 +21,8 @@
 #include "../effects/envmap.h"
 
 #include "../use/mesh_cache.h"
+#include "../use/texture_cache.h"
+#include "../use/texture_streamer.h"
 #include "../use/texture.h"
 
 #include "../gfx/idriver.h"
@@ -31,8 +34,12 @@
 
 #include "../common/cache.h"
 
+#include "../assets/file_watcher.h"
+
 #include "../fps/camera_controller.h"
 
+#include "../input/input.h"
+
 #include "../sdl_helper.h"
 
 #include <boost/filesystem.hpp>
@@ -41,10 +48,13 @@
 #include <btBulletDynamicsCommon.h>
 
 #include "../map.h"
+#include "../map_loader.h"
 #include "../player.h"
 #include "../server.h"
 #include "../event.h"
-#include "../common/reactor.h"
+#include "../common/event_channel.h"
+#include "../common/jobs.h"
+#include "../common/fixed_tick.h"
 
 #include "soloud.h"
 #include "soloud_wav.h"
@@ -87,6 +97,18 @@ namespace redc
     bool running = true;
 
     std::unique_ptr<gfx::Mesh_Cache> mesh_cache;
+    std::unique_ptr<gfx::Texture_Cache> texture_cache;
+
+    // Anything that can be split up and run in parallel should go through
+    // here rather than starting its own threads.
+    std::unique_ptr<Job_System> jobs;
+
+    std::unique_ptr<Map_Loader> map_loader;
+
+    // Anything that wants to know when a file changes on disk subscribes
+    // here, changes are dispatched at the start of every step. Its thread
+    // only starts once something does.
+    std::unique_ptr<assets::File_Watcher> file_watcher;
 
     std::unique_ptr<SoLoud::Soloud> audio;
 
@@ -96,10 +118,11 @@ namespace redc
     std::chrono::high_resolution_clock::time_point start_time;
     std::chrono::high_resolution_clock::time_point last_frame;
 
+    // Any thread can push, only the main thread polls.
     void push_outgoing_event(Event event);
-    bool poll_event(Event& event);
+    std::size_t poll_events(Event* events, std::size_t max);
   private:
-    Queue_Event_Source<Event> event_queue_;
+    MPSC_Channel<Event> event_queue_;
   };
 
   template <class T>
@@ -112,6 +135,14 @@ namespace redc
 
   struct Scene;
 
+  struct Map_Upload
+  {
+    std::unique_ptr<Map> map;
+
+    gfx::Asset_Upload techniques;
+    gfx::Asset_Upload scene;
+  };
+
   struct Client : public Event_Sink<Event>
   {
     Client(redc::SDL_Init_Lock l)
@@ -128,6 +159,10 @@ namespace redc
     // in the game.
     std::unique_ptr<gfx::IDriver> driver;
 
+    // Textures lua loads are streamed when there is a texture budget. It has
+    // to outlive the peers, they may be streamed textures.
+    std::unique_ptr<gfx::Texture_Streamer> texture_streamer;
+
     // Destruct all these together, if lua hasn't already.
     std::vector<Peer_Ptr<void> > peers;
 
@@ -144,7 +179,23 @@ namespace redc
     // We should reserve some amount of memory for each scene so that we can
     // pass around pointers and no they won't suddenly become invalid.
 
+    // Shader compile times are logged once, after startup.
+    bool logged_program_totals = false;
+
+    // How many bytes of map buffer and texture data we upload per frame, and
+    // how long we can spend doing it.
+    std::size_t map_upload_budget = 4 * 1024 * 1024;
+    std::chrono::microseconds map_upload_time{2000};
+
+    // Maps are uploaded one at a time, a bit every frame. Call
+    // step_map_uploads every frame, it returns a map once it is completely
+    // ready to be rendered.
+    void begin_map_upload(std::unique_ptr<Map> map);
+    std::unique_ptr<Map> step_map_uploads();
+
     void process_event(event_t const& event) override;
+  private:
+    std::queue<Map_Upload> map_uploads_;
   };
 
   struct Lua_Event
@@ -160,6 +211,8 @@ namespace redc
       Map* map;
     };
   };
+  constexpr unsigned int SERVER_TICKRATE = 60;
+
   struct Server : public Server_Base
   {
     Server(Engine& eng);
@@ -169,6 +222,14 @@ namespace redc
     Player& player(player_id id) override;
 
     void load_map(std::string const& map) override;
+    // Takes ownership of a completely loaded map and lets everyone know
+    // about it.
+    void add_map(std::unique_ptr<Map> map);
+
+    // Runs whatever ticks are due, physics is stepped by the same amount
+    // every tick no matter the frame rate.
+    void step();
+    Fixed_Tick ticker{SERVER_TICKRATE};
 
     std::unique_ptr<btDefaultCollisionConfiguration> bt_config;
     std::unique_ptr<btCollisionDispatcher> bt_dispatcher;
@@ -190,11 +251,19 @@ namespace redc
 
     // Server events are distinctly different from engine standard events.
     bool poll_lua_event(Lua_Event& event);
-    void push_lua_event(Lua_Event event) { lua_event_queue_.push(event); }
+    void push_lua_event(Lua_Event event);
   private:
     Engine* engine_;
 
-    Queue_Event_Source<Lua_Event> lua_event_queue_;
+    MPSC_Channel<Lua_Event> lua_event_queue_;
+  };
+
+  // Each page is a peer of the engine as well, so objects can lock them
+  // like any other texture.
+  struct Atlas
+  {
+    std::vector<Peer_Ptr<gfx::ITexture> > pages;
+    std::vector<gfx::Atlas_Region> regions;
   };
 
   struct Mesh_Object
@@ -205,6 +274,12 @@ namespace redc
     Peer_Lock<gfx::ITexture> texture;
     Peer_Lock<gfx::IShader> shader;
     glm::mat4 model;
+
+    // Where the texture is when it's on an atlas page, see Atlas_Region.
+    glm::vec4 uv_transform = glm::vec4(1.0f, 1.0f, 0.0f, 0.0f);
+
+    // The lod we drew last frame.
+    unsigned int lod = 0;
   };
 
   struct Cam_Object
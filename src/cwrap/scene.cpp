@@ -10,6 +10,9 @@
 
 #include "redcrane.hpp"
 #include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <utility>
+#include <vector>
 
 #define CHECK_ID(id) \
         REDC_ASSERT_MSG(id != 0, "No more room for any more objects"); \
@@ -33,9 +36,9 @@ extern "C"
     // Add a crosshair to the camera, this is only used though if there is a
     // camera following the player which is why we can go ahead and add it now,
     // no problem.
-    // TODO: Fix filename
     sc->get()->crosshair = gfx::load_texture(*engine->client->driver,
-                                             "../assets/tex/crosshair.png");
+                                             *engine->texture_cache,
+                                             "crosshair");
 
     {
       // Set up the mesh, buffer, shader
@@ -227,7 +230,32 @@ extern "C"
     else
     {
       auto texture = (Peer_Ptr<gfx::ITexture>*) tex;
-      boost::get<Mesh_Object>(object.obj).texture = texture->lock();
+      auto& mesh_obj = boost::get<Mesh_Object>(object.obj);
+      mesh_obj.texture = texture->lock();
+      mesh_obj.uv_transform = glm::vec4(1.0f, 1.0f, 0.0f, 0.0f);
+    }
+  }
+  void redc_scene_object_set_atlas_texture(void *sc, obj_id obj, void *atlas,
+                                           unsigned int index)
+  {
+    auto scene = lock_resource<Scene>(sc);
+    auto atlas_lock = lock_resource<Atlas>(atlas);
+
+    auto& object = at_id(scene->objs, obj);
+    if(object.obj.which() != Object::Mesh)
+    {
+      log_w("Cannot set texture of a non-mesh object");
+    }
+    else if(index >= atlas_lock->regions.size())
+    {
+      log_w("Atlas has no texture %", index);
+    }
+    else
+    {
+      auto const& region = atlas_lock->regions[index];
+      auto& mesh_obj = boost::get<Mesh_Object>(object.obj);
+      mesh_obj.texture = atlas_lock->pages[region.page].lock();
+      mesh_obj.uv_transform = region.uv_transform;
     }
   }
 
@@ -288,7 +316,7 @@ extern "C"
     }
 
     // The controller has access to input, step the simulation
-    engine->server->bt_world->stepSimulation(time_since(engine->last_frame), 10);
+    engine->server->step();
     engine->last_frame = std::chrono::high_resolution_clock::now();
 
     Player_Event player_event;
@@ -364,6 +392,13 @@ extern "C"
       gfx::Blend_Policy::Transparency
     );
 
+    // Everything uses the first slot, set it once so the driver can skip
+    // binding the same texture or atlas page over and over.
+    scene->engine->client->driver->active_texture(0);
+
+    // Find every mesh first so they can be drawn in a better order.
+    std::vector<Object*> meshes;
+
     // i is the loop counter, id is our current id.
     // Loop however many times as we have ids.
     int cur_id = 0;
@@ -404,27 +439,80 @@ extern "C"
       }
       else if(obj.obj.which() == Object::Mesh)
       {
-        auto mesh_obj = boost::get<Mesh_Object>(obj.obj);
+        meshes.push_back(&obj);
+      }
+    }
+
+    // Draw everything with the same shader and texture back to back, that
+    // way objects on one atlas page only need the page bound once and the
+    // camera only goes to each shader once.
+    auto shader_of = [&scene](Object const* obj) -> gfx::IShader*
+    {
+      auto const& mesh_obj = boost::get<Mesh_Object>(obj->obj);
+      if(mesh_obj.shader) return mesh_obj.shader.get();
+      return scene->engine->client->default_shader.get();
+    };
+    std::stable_sort(meshes.begin(), meshes.end(),
+                     [&shader_of](Object const* lhs, Object const* rhs)
+    {
+      auto lhs_tex = boost::get<Mesh_Object>(lhs->obj).texture.get();
+      auto rhs_tex = boost::get<Mesh_Object>(rhs->obj).texture.get();
+      return std::make_pair(shader_of(lhs), lhs_tex) <
+             std::make_pair(shader_of(rhs), rhs_tex);
+    });
+
+    // TODO: Make this easier to do, I had to avoid the use_camera function
+    // because it went through the driver. The thing is, with our new shader
+    // interface it's easier to deal with shaders directly so use_camera
+    // just got less useful.
+    auto proj = camera_proj_matrix(active_camera.cam);
+    auto view = camera_view_matrix(active_camera.cam);
+    float viewport_height =
+      scene->engine->client->driver->window_extents().y;
+
+    gfx::IShader* cur_shader = nullptr;
+    for(Object* obj : meshes)
+    {
+      auto& mesh_obj = boost::get<Mesh_Object>(obj->obj);
 
-        // Select a shader to use, either default or mesh-specific.
-        auto shader = scene->engine->client->default_shader.get();
-        if(mesh_obj.shader) shader = mesh_obj.shader.get();
+      // Select a shader to use, either default or mesh-specific.
+      auto shader = shader_of(obj);
+      if(shader != cur_shader)
+      {
         scene->engine->client->driver->use_shader(*shader);
+        shader->set_mat4(proj_tag, proj);
+        shader->set_mat4(view_tag, view);
+        cur_shader = shader;
+      }
 
-        // TODO: Make this easier to do, I had to avoid the use_camera function
-        // because it went through the driver. The thing is, with our new shader
-        // interface it's easier to deal with shaders directly so use_camera
-        // just got less useful.
-        using namespace gfx::tags;
-        shader->set_mat4(proj_tag, camera_proj_matrix(active_camera.cam));
-        shader->set_mat4(view_tag, camera_view_matrix(active_camera.cam));
+      // Find out the model
+      auto model = object_model(*obj);
+      shader->set_mat4(model_tag, model);
 
-        // Find out the model
-        auto model = object_model(obj);
-        shader->set_mat4(model_tag, model);
+      // Far away things don't need every triangle.
+      auto const& chunk = *mesh_obj.chunk;
+      float pixels_per_unit =
+        gfx::lod_pixels_per_unit(chunk, proj, view * model, viewport_height);
+      mesh_obj.lod = gfx::select_lod(chunk, pixels_per_unit, mesh_obj.lod);
 
-        gfx::render_chunk(*mesh_obj.chunk);
+      shader->set_vec4(uv_transform_tag, mesh_obj.uv_transform);
+      if(mesh_obj.texture)
+      {
+        scene->engine->client->driver->bind_texture(
+          *mesh_obj.texture, gfx::Texture_Target::Tex_2D
+        );
+
+        // Assume the uvs cover the mesh once, then the texture is about as
+        // big as the mesh on screen.
+        auto& streamer = scene->engine->client->texture_streamer;
+        if(streamer)
+        {
+          streamer->report(*mesh_obj.texture,
+                           pixels_per_unit * chunk.radius * 2.0f);
+        }
       }
+
+      gfx::render_chunk(chunk, mesh_obj.lod);
     }
 
     // Render the crosshair only if the active camera is a camera that follows
@@ -433,10 +521,13 @@ extern "C"
     scene->engine->client->driver->write_depth(false);
     scene->engine->client->driver->depth_test(false);
     scene->engine->client->driver->use_shader(*scene->ch_shader);
-    scene->engine->client->driver->active_texture(0);
-    scene->engine->client->driver->bind_texture(*scene->crosshair,
-                                                gfx::Texture_Target::Tex_2D);
-    scene->ch_mesh->draw_arrays(0, 6);
+    if(scene->crosshair)
+    {
+      scene->engine->client->driver->active_texture(0);
+      scene->engine->client->driver->bind_texture(*scene->crosshair,
+                                                  gfx::Texture_Target::Tex_2D);
+      scene->ch_mesh->draw_arrays(0, 6);
+    }
     scene->engine->client->driver->blending(false);
     scene->engine->client->driver->write_depth(true);
     scene->engine->client->driver->depth_test(true);
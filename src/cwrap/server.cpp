@@ -37,6 +37,8 @@ extern "C"
   {
     auto rce = (Engine*) eng;
     REDC_ASSERT_HAS_SERVER(rce);
+
+    rce->server->step();
   }
 
   void redc_server_req_player(void *eng)
@@ -18,11 +18,22 @@ extern "C"
     // This only makes sense for clients to do
     REDC_ASSERT_HAS_CLIENT(rce);
 
-    // Load the texture
-    auto texture = load_texture(*rce->client->driver, std::string{str});
-
-    // Lua needs one peer
-    auto peer = new Peer_Ptr<gfx::ITexture>(std::move(texture));
+    // Load the texture, str is relative to the texture directory and doesn't
+    // have the extension. Lua needs one peer, or null if it didn't load.
+    Peer_Ptr<gfx::ITexture>* peer;
+    if(rce->client->texture_streamer)
+    {
+      auto texture = rce->client->texture_streamer->load(std::string{str});
+      if(!texture) return NULL;
+      peer = new Peer_Ptr<gfx::ITexture>(std::move(texture));
+    }
+    else
+    {
+      auto texture = load_texture(*rce->client->driver, *rce->texture_cache,
+                                  std::string{str});
+      if(!texture) return NULL;
+      peer = new Peer_Ptr<gfx::ITexture>(std::move(texture));
+    }
 
     // The engine needs the other
     rce->client->peers.push_back(peer->peer());
@@ -34,4 +45,54 @@ extern "C"
     auto peer = (Peer_Ptr<gfx::ITexture>*) tex;
     delete peer;
   }
+
+  void* redc_load_atlas(void* eng, const char** names, unsigned int count)
+  {
+    auto rce = (Engine*) eng;
+
+    REDC_ASSERT_HAS_CLIENT(rce);
+
+    std::vector<std::string> name_list(names, names + count);
+    auto textures = gfx::load_atlas(*rce->client->driver,
+                                    (rce->share_path / "tex").string(),
+                                    name_list);
+
+    auto peer = new Peer_Ptr<Atlas>(new Atlas);
+    for(auto& page : textures.pages)
+    {
+      (*peer)->pages.emplace_back(std::move(page));
+      rce->client->peers.push_back((*peer)->pages.back().peer());
+    }
+    (*peer)->regions = std::move(textures.regions);
+
+    rce->client->peers.push_back(peer->peer());
+
+    return peer;
+  }
+  void redc_unload_atlas(void* atlas)
+  {
+    auto peer = (Peer_Ptr<Atlas>*) atlas;
+    delete peer;
+  }
+
+  Redc_Atlas_Region redc_atlas_region(void* atlas, unsigned int index)
+  {
+    auto lock = lock_resource<Atlas>(atlas);
+
+    Redc_Atlas_Region ret;
+    if(index >= lock->regions.size())
+    {
+      log_w("Atlas has no texture %", index);
+      ret.page = 0;
+      ret.uv_scale = {1.0f, 1.0f};
+      ret.uv_offset = {0.0f, 0.0f};
+      return ret;
+    }
+
+    auto const& region = lock->regions[index];
+    ret.page = region.page;
+    ret.uv_scale = {region.uv_transform.x, region.uv_transform.y};
+    ret.uv_offset = {region.uv_transform.z, region.uv_transform.w};
+    return ret;
+  }
 }
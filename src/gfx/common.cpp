@@ -46,6 +46,8 @@ namespace redc { namespace gfx
     case Texture_Format::Rgba:
     case Texture_Format::Rgba32F:
     case Texture_Format::Srgb_Alpha:
+    case Texture_Format::Bc1_Srgb_Alpha:
+    case Texture_Format::Bc3_Srgb_Alpha:
       return 4;
     default:
       REDC_UNREACHABLE_MSG("Unknown texture format");
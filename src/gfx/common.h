@@ -32,7 +32,9 @@ namespace redc { namespace gfx
   enum class Texture_Format
   {
     Alpha, Rgb, Rgba, Srgb, Srgb_Alpha, Depth, Depth_Stencil, Stencil, Red,
-    Rgba32F
+    Rgba32F,
+    // Block compressed, these can only be uploaded as whole levels.
+    Bc1_Srgb_Alpha, Bc3_Srgb_Alpha
   };
   enum class Texture_Target
   {
@@ -0,0 +1,412 @@
+/*
+ * Copyright (C) 2016 Luke San Antonio
+ * All rights reserved.
+ */
+#include "block_compress.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "../../common/debugging.h"
+namespace redc { namespace gfx
+{
+  namespace
+  {
+    constexpr int BLOCK_DIM = 4;
+    constexpr int BLOCK_TEXELS = BLOCK_DIM * BLOCK_DIM;
+
+    // Anything less than this is transparent in a BC1 block.
+    constexpr int BC1_ALPHA_CUTOFF = 128;
+
+    struct Rgb
+    {
+      int r, g, b;
+    };
+
+    inline int dist_sq(Rgb const& lhs, Color const& rhs) noexcept
+    {
+      int dr = lhs.r - rhs.r;
+      int dg = lhs.g - rhs.g;
+      int db = lhs.b - rhs.b;
+      return dr * dr + dg * dg + db * db;
+    }
+
+    inline uint16_t to_565(float r, float g, float b) noexcept
+    {
+      auto quantize = [](float c, int max)
+      {
+        c = std::min(std::max(c, 0.0f), 255.0f);
+        return static_cast<uint16_t>(c * max / 255.0f + 0.5f);
+      };
+      return (quantize(r, 31) << 11) | (quantize(g, 63) << 5) |
+             quantize(b, 31);
+    }
+    inline Rgb from_565(uint16_t c) noexcept
+    {
+      int r = (c >> 11) & 0x1f;
+      int g = (c >> 5) & 0x3f;
+      int b = c & 0x1f;
+      return {(r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2)};
+    }
+
+    inline void write_u16(uint8_t* out, uint16_t v) noexcept
+    {
+      out[0] = v & 0xff;
+      out[1] = v >> 8;
+    }
+    inline uint16_t read_u16(uint8_t const* in) noexcept
+    {
+      return in[0] | (in[1] << 8);
+    }
+
+    void color_palette(uint16_t c0, uint16_t c1, bool four_color,
+                       Rgb (&palette)[4]) noexcept
+    {
+      palette[0] = from_565(c0);
+      palette[1] = from_565(c1);
+      Rgb const& p0 = palette[0];
+      Rgb const& p1 = palette[1];
+      if(four_color)
+      {
+        palette[2] = {(2 * p0.r + p1.r) / 3, (2 * p0.g + p1.g) / 3,
+                      (2 * p0.b + p1.b) / 3};
+        palette[3] = {(p0.r + 2 * p1.r) / 3, (p0.g + 2 * p1.g) / 3,
+                      (p0.b + 2 * p1.b) / 3};
+      }
+      else
+      {
+        palette[2] = {(p0.r + p1.r) / 2, (p0.g + p1.g) / 2,
+                      (p0.b + p1.b) / 2};
+        palette[3] = {0, 0, 0};
+      }
+    }
+
+    // Finds the two endpoints of the line through the colors that matter.
+    void fit_endpoints(Color const (&block)[BLOCK_TEXELS],
+                       bool const (&use)[BLOCK_TEXELS],
+                       uint16_t& c0, uint16_t& c1) noexcept
+    {
+      float mean[3] = {0.0f, 0.0f, 0.0f};
+      int count = 0;
+      for(int i = 0; i < BLOCK_TEXELS; ++i)
+      {
+        if(!use[i]) continue;
+        mean[0] += block[i].r;
+        mean[1] += block[i].g;
+        mean[2] += block[i].b;
+        ++count;
+      }
+      if(count == 0)
+      {
+        c0 = c1 = 0;
+        return;
+      }
+      for(float& m : mean) m /= count;
+
+      // Covariance, then its biggest eigenvector by power iteration.
+      float cov[6] = {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+      for(int i = 0; i < BLOCK_TEXELS; ++i)
+      {
+        if(!use[i]) continue;
+        float r = block[i].r - mean[0];
+        float g = block[i].g - mean[1];
+        float b = block[i].b - mean[2];
+        cov[0] += r * r; cov[1] += r * g; cov[2] += r * b;
+        cov[3] += g * g; cov[4] += g * b;
+        cov[5] += b * b;
+      }
+
+      float axis[3] = {1.0f, 1.0f, 1.0f};
+      for(int iter = 0; iter < 8; ++iter)
+      {
+        float x = cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2];
+        float y = cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2];
+        float z = cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2];
+        float length = std::max(std::abs(x), std::max(std::abs(y),
+                                                      std::abs(z)));
+        // Every color is the same.
+        if(length == 0.0f) break;
+        axis[0] = x / length;
+        axis[1] = y / length;
+        axis[2] = z / length;
+      }
+      float axis_sq = axis[0] * axis[0] + axis[1] * axis[1] +
+                      axis[2] * axis[2];
+
+      float min_t = 0.0f, max_t = 0.0f;
+      for(int i = 0; i < BLOCK_TEXELS; ++i)
+      {
+        if(!use[i]) continue;
+        float t = ((block[i].r - mean[0]) * axis[0] +
+                   (block[i].g - mean[1]) * axis[1] +
+                   (block[i].b - mean[2]) * axis[2]) / axis_sq;
+        min_t = std::min(min_t, t);
+        max_t = std::max(max_t, t);
+      }
+
+      c0 = to_565(mean[0] + axis[0] * max_t, mean[1] + axis[1] * max_t,
+                  mean[2] + axis[2] * max_t);
+      c1 = to_565(mean[0] + axis[0] * min_t, mean[1] + axis[1] * min_t,
+                  mean[2] + axis[2] * min_t);
+    }
+
+    void compress_color_block(Color const (&block)[BLOCK_TEXELS],
+                              bool allow_transparent, uint8_t* out) noexcept
+    {
+      bool use[BLOCK_TEXELS];
+      bool any_transparent = false;
+      for(int i = 0; i < BLOCK_TEXELS; ++i)
+      {
+        bool transparent = allow_transparent &&
+                           block[i].a < BC1_ALPHA_CUTOFF;
+        use[i] = !transparent;
+        any_transparent = any_transparent || transparent;
+      }
+
+      uint16_t c0, c1;
+      fit_endpoints(block, use, c0, c1);
+
+      // The order of the endpoints picks the mode.
+      bool four_color = !any_transparent;
+      if(four_color ? c0 < c1 : c0 > c1) std::swap(c0, c1);
+
+      Rgb palette[4];
+      color_palette(c0, c1, four_color, palette);
+
+      uint32_t indices = 0;
+      if(c0 != c1 || any_transparent)
+      {
+        for(int i = 0; i < BLOCK_TEXELS; ++i)
+        {
+          uint32_t best = 3;
+          if(use[i])
+          {
+            int best_dist = dist_sq(palette[0], block[i]);
+            best = 0;
+            for(uint32_t p = 1; p < (four_color ? 4u : 3u); ++p)
+            {
+              int dist = dist_sq(palette[p], block[i]);
+              if(dist < best_dist)
+              {
+                best_dist = dist;
+                best = p;
+              }
+            }
+          }
+          indices |= best << (i * 2);
+        }
+      }
+
+      write_u16(out, c0);
+      write_u16(out + 2, c1);
+      for(int i = 0; i < 4; ++i) out[4 + i] = (indices >> (i * 8)) & 0xff;
+    }
+
+    void alpha_palette(int a0, int a1, int (&palette)[8]) noexcept
+    {
+      palette[0] = a0;
+      palette[1] = a1;
+      if(a0 > a1)
+      {
+        for(int i = 2; i < 8; ++i)
+        {
+          palette[i] = ((8 - i) * a0 + (i - 1) * a1) / 7;
+        }
+      }
+      else
+      {
+        for(int i = 2; i < 6; ++i)
+        {
+          palette[i] = ((6 - i) * a0 + (i - 1) * a1) / 5;
+        }
+        palette[6] = 0;
+        palette[7] = 255;
+      }
+    }
+
+    void compress_alpha_block(Color const (&block)[BLOCK_TEXELS],
+                              uint8_t* out) noexcept
+    {
+      int a0 = 0, a1 = 255;
+      for(int i = 0; i < BLOCK_TEXELS; ++i)
+      {
+        a0 = std::max<int>(a0, block[i].a);
+        a1 = std::min<int>(a1, block[i].a);
+      }
+
+      int palette[8];
+      alpha_palette(a0, a1, palette);
+
+      uint64_t indices = 0;
+      if(a0 != a1)
+      {
+        for(int i = 0; i < BLOCK_TEXELS; ++i)
+        {
+          uint64_t best = 0;
+          int best_dist = 256;
+          for(int p = 0; p < 8; ++p)
+          {
+            int dist = std::abs(palette[p] - block[i].a);
+            if(dist < best_dist)
+            {
+              best_dist = dist;
+              best = p;
+            }
+          }
+          indices |= best << (i * 3);
+        }
+      }
+
+      out[0] = a0;
+      out[1] = a1;
+      for(int i = 0; i < 6; ++i) out[2 + i] = (indices >> (i * 8)) & 0xff;
+    }
+
+    void decompress_color_block(uint8_t const* in, bool force_four_color,
+                                Color (&block)[BLOCK_TEXELS]) noexcept
+    {
+      uint16_t c0 = read_u16(in);
+      uint16_t c1 = read_u16(in + 2);
+      bool four_color = force_four_color || c0 > c1;
+
+      Rgb palette[4];
+      color_palette(c0, c1, four_color, palette);
+
+      uint32_t indices = in[4] | (in[5] << 8) | (in[6] << 16) |
+                         (static_cast<uint32_t>(in[7]) << 24);
+      for(int i = 0; i < BLOCK_TEXELS; ++i)
+      {
+        uint32_t index = (indices >> (i * 2)) & 0x3;
+        Rgb const& c = palette[index];
+        block[i] = Color(c.r, c.g, c.b, 0xff);
+        if(!four_color && index == 3) block[i].a = 0;
+      }
+    }
+
+    void decompress_alpha_block(uint8_t const* in,
+                                Color (&block)[BLOCK_TEXELS]) noexcept
+    {
+      int palette[8];
+      alpha_palette(in[0], in[1], palette);
+
+      uint64_t indices = 0;
+      for(int i = 0; i < 6; ++i)
+      {
+        indices |= static_cast<uint64_t>(in[2 + i]) << (i * 8);
+      }
+      for(int i = 0; i < BLOCK_TEXELS; ++i)
+      {
+        block[i].a = palette[(indices >> (i * 3)) & 0x7];
+      }
+    }
+
+    std::size_t blocks_across(std::size_t texels) noexcept
+    {
+      return (texels + BLOCK_DIM - 1) / BLOCK_DIM;
+    }
+  }
+
+  std::size_t block_size(Texture_Format format) noexcept
+  {
+    switch(format)
+    {
+    case Texture_Format::Bc1_Srgb_Alpha:
+      return 8;
+    case Texture_Format::Bc3_Srgb_Alpha:
+      return 16;
+    default:
+      REDC_UNREACHABLE_MSG("Not a block compressed format");
+      return 0;
+    }
+  }
+
+  std::size_t compressed_size(Vec<std::size_t> const& extents,
+                              Texture_Format format) noexcept
+  {
+    return blocks_across(extents.x) * blocks_across(extents.y) *
+           block_size(format);
+  }
+
+  std::vector<uint8_t> compress_image(Image const& image,
+                                      Texture_Format format) noexcept
+  {
+    std::vector<uint8_t> ret(compressed_size(image.extents, format));
+    if(image.data.empty()) return ret;
+
+    std::size_t bytes_per_block = block_size(format);
+    std::size_t blocks_x = blocks_across(image.extents.x);
+    std::size_t blocks_y = blocks_across(image.extents.y);
+
+    uint8_t* out = ret.data();
+    for(std::size_t by = 0; by < blocks_y; ++by)
+    {
+      for(std::size_t bx = 0; bx < blocks_x; ++bx)
+      {
+        // Edges are padded by repeating the last row and column.
+        Color block[BLOCK_TEXELS];
+        for(int y = 0; y < BLOCK_DIM; ++y)
+        {
+          for(int x = 0; x < BLOCK_DIM; ++x)
+          {
+            std::size_t px = std::min(bx * BLOCK_DIM + x, image.extents.x - 1);
+            std::size_t py = std::min(by * BLOCK_DIM + y, image.extents.y - 1);
+            block[y * BLOCK_DIM + x] = image.data[py * image.extents.x + px];
+          }
+        }
+
+        if(format == Texture_Format::Bc3_Srgb_Alpha)
+        {
+          compress_alpha_block(block, out);
+          compress_color_block(block, false, out + 8);
+        }
+        else
+        {
+          compress_color_block(block, true, out);
+        }
+        out += bytes_per_block;
+      }
+    }
+    return ret;
+  }
+
+  Image decompress_image(uint8_t const* data, Vec<std::size_t> const& extents,
+                         Texture_Format format) noexcept
+  {
+    Image image;
+    image.extents = extents;
+    image.data.resize(extents.x * extents.y);
+
+    std::size_t bytes_per_block = block_size(format);
+    std::size_t blocks_x = blocks_across(extents.x);
+    std::size_t blocks_y = blocks_across(extents.y);
+
+    for(std::size_t by = 0; by < blocks_y; ++by)
+    {
+      for(std::size_t bx = 0; bx < blocks_x; ++bx)
+      {
+        Color block[BLOCK_TEXELS];
+        if(format == Texture_Format::Bc3_Srgb_Alpha)
+        {
+          decompress_color_block(data + 8, true, block);
+          decompress_alpha_block(data, block);
+        }
+        else
+        {
+          decompress_color_block(data, false, block);
+        }
+        data += bytes_per_block;
+
+        for(int y = 0; y < BLOCK_DIM; ++y)
+        {
+          for(int x = 0; x < BLOCK_DIM; ++x)
+          {
+            std::size_t px = bx * BLOCK_DIM + x;
+            std::size_t py = by * BLOCK_DIM + y;
+            if(px >= extents.x || py >= extents.y) continue;
+            image.data[py * extents.x + px] = block[y * BLOCK_DIM + x];
+          }
+        }
+      }
+    }
+    return image;
+  }
+} }
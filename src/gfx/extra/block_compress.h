@@ -0,0 +1,34 @@
+/*
+ * Copyright (C) 2016 Luke San Antonio
+ * All rights reserved.
+ */
+#ifndef REDC_GFX_EXTRA_BLOCK_COMPRESS_H
+#define REDC_GFX_EXTRA_BLOCK_COMPRESS_H
+#include <cstdint>
+#include <vector>
+#include "texture_load.h"
+namespace redc { namespace gfx
+{
+  // Bytes per 4x4 block for Bc1_Srgb_Alpha or Bc3_Srgb_Alpha.
+  std::size_t block_size(Texture_Format format) noexcept;
+  // How big an image of the given size is once compressed, partial blocks
+  // at the edges take up a whole block.
+  std::size_t compressed_size(Vec<std::size_t> const& extents,
+                              Texture_Format format) noexcept;
+
+  /*!
+   * \brief Compresses an image to BC1 (DXT1) or BC3 (DXT5).
+   *
+   * This is a simple range fit along the principal axis of each block, good
+   * enough for an importer that only runs when the cache is cold. BC1 blocks
+   * with any alpha under half use the three color mode with transparent
+   * black, anything else loses its alpha.
+   */
+  std::vector<uint8_t> compress_image(Image const& image,
+                                      Texture_Format format) noexcept;
+
+  // The other way, mostly so we can tell how well the above did.
+  Image decompress_image(uint8_t const* data, Vec<std::size_t> const& extents,
+                         Texture_Format format) noexcept;
+} }
+#endif
@@ -3,104 +3,552 @@
  * All rights reserved.
  */
 #include "load_wavefront.h"
-#include <fstream>
-#include <sstream>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
 #include <algorithm>
 #include "../../common/log.h"
+#include "../../common/jobs.h"
+#include "../../assets/mapped_file.h"
 namespace redc { namespace gfx
 {
-  Vert_Ref parse_wavefront_vert_ref(std::string str) noexcept
+  namespace
   {
-    // str could be "2" or "2/1" or "2//4" or "2/1/4"
-    Vert_Ref f;
+    // Files smaller than this aren't worth splitting up.
+    constexpr std::size_t PARALLEL_THRESHOLD = 4 * 1024 * 1024;
+    // Aim for chunks about this big when we do split.
+    constexpr std::size_t CHUNK_SIZE = 1024 * 1024;
+
+    enum Ref_Component : uint8_t
+    {
+      Ref_Position, Ref_Tex_Coord, Ref_Normal
+    };
 
-    std::istringstream stream{str};
+    // A relative face index that we can only resolve once we know how many
+    // vertices came before the chunk it was in.
+    struct Ref_Fixup
+    {
+      std::size_t index;
+      Ref_Component component;
+      long relative;
+    };
 
-    std::string vert_str;
-    std::getline(stream, vert_str, '/');
+    struct Chunk_Result
+    {
+      Indexed_Split_Mesh_Data mesh;
+      std::vector<Ref_Fixup> fixups;
+    };
 
-    std::string tex_str;
-    std::getline(stream, tex_str, '/');
+    // Everything fits in a 64-bit mantissa if there are no more than this
+    // many significant digits.
+    constexpr int MAX_MANTISSA_DIGITS = 19;
 
-    std::string norm_str;
-    std::getline(stream, norm_str, '/');
+    constexpr double POW10[] = {
+      1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12,
+      1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    constexpr int MAX_POW10 = 22;
 
-    try
+    inline bool is_space(char c) noexcept
     {
-      if(!vert_str.empty()) f.position = std::stoi(vert_str) - 1;
-    } catch(...) {}
-    try
+      return c == ' ' || c == '\t' || c == '\r';
+    }
+    inline bool is_digit(char c) noexcept
+    {
+      return c >= '0' && c <= '9';
+    }
+
+    inline void skip_space(char const*& cur, char const* end) noexcept
     {
-      if(!tex_str.empty()) f.tex_coord = std::stoi(tex_str) - 1;
-    } catch(...) {}
-    try
+      while(cur != end && is_space(*cur)) ++cur;
+    }
+    inline void skip_token(char const*& cur, char const* end) noexcept
     {
-      if(!norm_str.empty()) f.normal = std::stoi(norm_str) - 1;
-    } catch(...) {}
+      while(cur != end && !is_space(*cur)) ++cur;
+    }
 
-    return f;
-  }
-  glm::vec3 parse_vec3(std::istream& stream) noexcept
-  {
-    glm::vec3 t;
-    stream >> t.x >> t.y >> t.z;
-    return t;
-  }
+    double scale_pow10(double value, int exp) noexcept
+    {
+      if(exp < 0)
+      {
+        while(exp < -MAX_POW10)
+        {
+          value /= POW10[MAX_POW10];
+          exp += MAX_POW10;
+        }
+        return value / POW10[-exp];
+      }
+      while(exp > MAX_POW10)
+      {
+        value *= POW10[MAX_POW10];
+        exp -= MAX_POW10;
+      }
+      return value * POW10[exp];
+    }
 
-  Indexed_Split_Mesh_Data load_wavefront(std::istream& stream) noexcept
-  {
-    Indexed_Split_Mesh_Data ret{};
+    // Parses something like -1.2345e-3. Anything unparseable ends up as zero
+    // and the token is skipped, like a stream would have left it.
+    float parse_float(char const*& cur, char const* end) noexcept
+    {
+      skip_space(cur, end);
+
+      bool negative = false;
+      if(cur != end && (*cur == '-' || *cur == '+'))
+      {
+        negative = *cur == '-';
+        ++cur;
+      }
+
+      uint64_t mantissa = 0;
+      int digits = 0;
+      int exp = 0;
+      bool any_digits = false;
+
+      // Integer part
+      for(; cur != end && is_digit(*cur); ++cur)
+      {
+        any_digits = true;
+        // Ignore leading zeros so they don't eat up our precision.
+        if(digits == 0 && *cur == '0') continue;
+        if(digits < MAX_MANTISSA_DIGITS)
+        {
+          mantissa = mantissa * 10 + (*cur - '0');
+          ++digits;
+        }
+        else ++exp;
+      }
+      // Fractional part
+      if(cur != end && *cur == '.')
+      {
+        ++cur;
+        for(; cur != end && is_digit(*cur); ++cur)
+        {
+          any_digits = true;
+          if(digits == 0 && *cur == '0')
+          {
+            --exp;
+            continue;
+          }
+          if(digits < MAX_MANTISSA_DIGITS)
+          {
+            mantissa = mantissa * 10 + (*cur - '0');
+            ++digits;
+            --exp;
+          }
+        }
+      }
+
+      if(!any_digits)
+      {
+        skip_token(cur, end);
+        return 0.0f;
+      }
+
+      // Exponent
+      if(cur != end && (*cur == 'e' || *cur == 'E'))
+      {
+        char const* exp_start = cur;
+        ++cur;
+
+        bool exp_negative = false;
+        if(cur != end && (*cur == '-' || *cur == '+'))
+        {
+          exp_negative = *cur == '-';
+          ++cur;
+        }
+        if(cur != end && is_digit(*cur))
+        {
+          int exp_value = 0;
+          for(; cur != end && is_digit(*cur); ++cur)
+          {
+            // Don't overflow, anything this big is inf or zero anyway.
+            if(exp_value < 10000) exp_value = exp_value * 10 + (*cur - '0');
+          }
+          exp += exp_negative ? -exp_value : exp_value;
+        }
+        // Just an 'e' with nothing after it, pretend we never saw it.
+        else cur = exp_start;
+      }
+
+      double value = static_cast<double>(mantissa);
+      if(mantissa != 0 && exp != 0) value = scale_pow10(value, exp);
+      if(negative) value = -value;
+      return static_cast<float>(value);
+    }
+
+    // Anything bigger than this can't be an index, and stays clear of
+    // overflowing a long anywhere.
+    constexpr long MAX_INDEX = 0x7fffffff;
+
+    // Returns false if there is no number at all, or if it's too big to be
+    // an index, in which case too_big is set and the digits are skipped.
+    bool parse_int(char const*& cur, char const* end, long& value,
+                   bool& too_big) noexcept
+    {
+      bool negative = false;
+      if(cur != end && (*cur == '-' || *cur == '+'))
+      {
+        negative = *cur == '-';
+        ++cur;
+      }
+      if(cur == end || !is_digit(*cur)) return false;
+
+      long ret = 0;
+      for(; cur != end && is_digit(*cur); ++cur)
+      {
+        if(ret > (MAX_INDEX - (*cur - '0')) / 10)
+        {
+          while(cur != end && is_digit(*cur)) ++cur;
+          too_big = true;
+          return false;
+        }
+        ret = ret * 10 + (*cur - '0');
+      }
+      value = negative ? -ret : ret;
+      return true;
+    }
+
+    // Parses "2" or "2/1" or "2//4" or "2/1/4" without resolving anything.
+    // Returns a bit for each component that was there, none at all if any of
+    // them was out of range.
+    unsigned int parse_raw_ref(char const*& cur, char const* end,
+                               long (&values)[3]) noexcept
+    {
+      unsigned int present = 0;
+      bool too_big = false;
+      for(int i = 0; i < 3; ++i)
+      {
+        if(parse_int(cur, end, values[i], too_big)) present |= 1 << i;
+
+        // Whatever is left of this component (garbage), then the slash.
+        while(cur != end && !is_space(*cur) && *cur != '/') ++cur;
+        if(cur == end || *cur != '/') break;
+        ++cur;
+      }
+      skip_token(cur, end);
+      return too_big ? 0 : present;
+    }
+
+    void parse_vec3(char const*& cur, char const* end, glm::vec3& v) noexcept
+    {
+      v.x = parse_float(cur, end);
+      v.y = parse_float(cur, end);
+      v.z = parse_float(cur, end);
+    }
+
+    // A face vertex as it was parsed, with whatever couldn't be resolved
+    // within the chunk left to the side.
+    struct Face_Ref
+    {
+      Vert_Ref ref;
+      unsigned int unresolved = 0;
+      long relative[3];
+    };
 
-    std::string line;
-    while(!std::getline(stream, line).eof() && stream.good())
+    struct Chunk_Parser
     {
-      if(line.size() == 0) continue;
+      Chunk_Result& res;
+      bool chunked;
+
+      long count(Ref_Component comp) const noexcept
+      {
+        switch(comp)
+        {
+        case Ref_Position:
+          return static_cast<long>(res.mesh.positions.size());
+        case Ref_Tex_Coord:
+          return static_cast<long>(res.mesh.tex_coords.size());
+        case Ref_Normal:
+        default:
+          return static_cast<long>(res.mesh.normals.size());
+        }
+      }
 
-      std::istringstream line_stream{line};
+      void resolve(long value, Ref_Component comp, Face_Ref& face_ref,
+                   boost::optional<unsigned int>& out) noexcept
+      {
+        if(value > 0)
+        {
+          out = static_cast<unsigned int>(value - 1);
+          return;
+        }
+        if(value == 0) return;
 
-      // Operation
-      std::string op;
-      line_stream >> op;
+        // Relative to the end of the corresponding list so far. When this is
+        // only a piece of the file that index is relative to the start of the
+        // piece, which we don't know yet.
+        long absolute = count(comp) + value;
+        if(absolute >= 0 && !chunked)
+        {
+          out = static_cast<unsigned int>(absolute);
+        }
+        else
+        {
+          face_ref.unresolved |= 1 << comp;
+          face_ref.relative[comp] = absolute;
+        }
+      }
 
-      // Load vertices, normals and texture coordinates into basic_mesh.
-      if(op == "v")
+      bool parse_face_ref(char const*& cur, char const* end,
+                          Face_Ref& face_ref) noexcept
       {
-        ret.positions.push_back(parse_vec3(line_stream));
+        long values[3];
+        unsigned int present = parse_raw_ref(cur, end, values);
+        if(!present) return false;
+
+        face_ref = Face_Ref{};
+        auto& ref = face_ref.ref;
+        if(present & 1) resolve(values[0], Ref_Position, face_ref,
+                                ref.position);
+        if(present & 2) resolve(values[1], Ref_Tex_Coord, face_ref,
+                                ref.tex_coord);
+        if(present & 4) resolve(values[2], Ref_Normal, face_ref, ref.normal);
+        return true;
       }
-      if(op == "vn")
+
+      void push(Face_Ref const& face_ref) noexcept
       {
-        ret.normals.push_back(parse_vec3(line_stream));
+        if(face_ref.unresolved)
+        {
+          for(int i = 0; i < 3; ++i)
+          {
+            if(!(face_ref.unresolved & (1 << i))) continue;
+            res.fixups.push_back({res.mesh.indices.size(),
+                                  static_cast<Ref_Component>(i),
+                                  face_ref.relative[i]});
+          }
+        }
+        res.mesh.indices.push_back(face_ref.ref);
       }
-      if(op == "vt")
+
+      void parse_face(char const* cur, char const* end) noexcept
       {
-        glm::vec2 coord;
-        line_stream >> coord.x >> coord.y;
-        ret.tex_coords.push_back(coord);
+        // Anything bigger than a triangle is triangulated as a fan around
+        // the first vertex.
+        Face_Ref first, prev, cur_ref;
+        int num_verts = 0;
+        while(true)
+        {
+          skip_space(cur, end);
+          if(cur == end) break;
+
+          if(!parse_face_ref(cur, end, cur_ref)) continue;
+
+          if(num_verts == 0) first = cur_ref;
+          else if(num_verts >= 2)
+          {
+            push(first);
+            push(prev);
+            push(cur_ref);
+          }
+          prev = cur_ref;
+          ++num_verts;
+        }
       }
-      if(op == "f")
+
+      void parse_line(char const* cur, char const* end) noexcept
       {
-        // For each tuple of indices in the face.
-        for(int i = 0; i < 3; ++i)
+        skip_space(cur, end);
+        if(cur == end || *cur == '#') return;
+
+        char const* op = cur;
+        skip_token(cur, end);
+        std::size_t op_len = cur - op;
+
+        if(op_len == 1 && op[0] == 'v')
+        {
+          glm::vec3 pos;
+          parse_vec3(cur, end, pos);
+          res.mesh.positions.push_back(pos);
+        }
+        else if(op_len == 2 && op[0] == 'v' && op[1] == 'n')
+        {
+          glm::vec3 normal;
+          parse_vec3(cur, end, normal);
+          res.mesh.normals.push_back(normal);
+        }
+        else if(op_len == 2 && op[0] == 'v' && op[1] == 't')
         {
-          std::string index_str;
-          line_stream >> index_str;
-          ret.indices.push_back(parse_wavefront_vert_ref(index_str));
+          glm::vec2 coord;
+          coord.x = parse_float(cur, end);
+          coord.y = parse_float(cur, end);
+          res.mesh.tex_coords.push_back(coord);
         }
+        else if(op_len == 1 && op[0] == 'f')
+        {
+          parse_face(cur, end);
+        }
+        // Everything else (groups, materials, smoothing) we don't care about.
+      }
+    };
+
+    void parse_chunk(char const* begin, char const* end, bool chunked,
+                     Chunk_Result& res) noexcept
+    {
+      // Guess at how much we'll need, faces are usually about as common as
+      // vertices and a line is about 30 bytes.
+      std::size_t guess = (end - begin) / 32;
+      res.mesh.positions.reserve(guess);
+      res.mesh.indices.reserve(guess * 3);
+
+      Chunk_Parser parser{res, chunked};
+      char const* cur = begin;
+      while(cur != end)
+      {
+        auto line_end =
+          static_cast<char const*>(std::memchr(cur, '\n', end - cur));
+        if(!line_end) line_end = end;
+
+        parser.parse_line(cur, line_end);
+
+        cur = line_end;
+        if(cur != end) ++cur;
+      }
+    }
+
+    template <class T>
+    void append(std::vector<T>& dst, std::vector<T>& src)
+    {
+      dst.insert(dst.end(), std::make_move_iterator(src.begin()),
+                 std::make_move_iterator(src.end()));
+    }
+  }
+
+  Vert_Ref parse_wavefront_vert_ref(std::string str) noexcept
+  {
+    // str could be "2" or "2/1" or "2//4" or "2/1/4"
+    Vert_Ref f;
+
+    char const* cur = str.data();
+    long values[3];
+    unsigned int present = parse_raw_ref(cur, str.data() + str.size(), values);
+
+    // Without the rest of the file we can't resolve relative indices.
+    if(present & 1 && values[0] > 0) f.position = values[0] - 1;
+    if(present & 2 && values[1] > 0) f.tex_coord = values[1] - 1;
+    if(present & 4 && values[2] > 0) f.normal = values[2] - 1;
+
+    return f;
+  }
+
+  Indexed_Split_Mesh_Data parse_wavefront(char const* begin, char const* end,
+                                          Job_System* jobs) noexcept
+  {
+    std::size_t size = end - begin;
+
+    if(!jobs || size < PARALLEL_THRESHOLD)
+    {
+      Chunk_Result res;
+      parse_chunk(begin, end, false, res);
+      if(res.fixups.size())
+      {
+        log_w("Ignoring % relative face indices that point before the "
+              "beginning of the file", res.fixups.size());
       }
+      return std::move(res.mesh);
+    }
+
+    // Split the file up at line boundaries.
+    std::vector<char const*> bounds;
+    bounds.push_back(begin);
+    for(char const* cur = begin + CHUNK_SIZE; cur < end; cur += CHUNK_SIZE)
+    {
+      cur = static_cast<char const*>(std::memchr(cur, '\n', end - cur));
+      if(!cur) break;
+      ++cur;
+      bounds.push_back(cur);
+    }
+    bounds.push_back(end);
+
+    std::size_t num_chunks = bounds.size() - 1;
+    std::vector<Chunk_Result> chunks(num_chunks);
+    jobs->parallel_for(0, num_chunks, 1, [&](std::size_t i)
+    {
+      parse_chunk(bounds[i], bounds[i + 1], true, chunks[i]);
+    });
+
+    // Stitch everything back together, offsetting relative indices by
+    // however many of each thing came before.
+    Indexed_Split_Mesh_Data ret;
+    std::size_t total_positions = 0, total_normals = 0, total_tex_coords = 0,
+                total_indices = 0;
+    for(auto const& chunk : chunks)
+    {
+      total_positions += chunk.mesh.positions.size();
+      total_normals += chunk.mesh.normals.size();
+      total_tex_coords += chunk.mesh.tex_coords.size();
+      total_indices += chunk.mesh.indices.size();
     }
+    ret.positions.reserve(total_positions);
+    ret.normals.reserve(total_normals);
+    ret.tex_coords.reserve(total_tex_coords);
+    ret.indices.reserve(total_indices);
+
+    std::size_t bad_refs = 0;
+    for(auto& chunk : chunks)
+    {
+      std::size_t index_base = ret.indices.size();
+      long bases[3] = {
+        static_cast<long>(ret.positions.size()),
+        static_cast<long>(ret.tex_coords.size()),
+        static_cast<long>(ret.normals.size())
+      };
+
+      append(ret.positions, chunk.mesh.positions);
+      append(ret.normals, chunk.mesh.normals);
+      append(ret.tex_coords, chunk.mesh.tex_coords);
+      append(ret.indices, chunk.mesh.indices);
+
+      for(auto const& fixup : chunk.fixups)
+      {
+        long absolute = bases[fixup.component] + fixup.relative;
+        if(absolute < 0)
+        {
+          ++bad_refs;
+          continue;
+        }
 
+        Vert_Ref& ref = ret.indices[index_base + fixup.index];
+        auto value = static_cast<unsigned int>(absolute);
+        switch(fixup.component)
+        {
+        case Ref_Position:
+          ref.position = value;
+          break;
+        case Ref_Tex_Coord:
+          ref.tex_coord = value;
+          break;
+        case Ref_Normal:
+          ref.normal = value;
+          break;
+        }
+      }
+    }
+    if(bad_refs)
+    {
+      log_w("Ignoring % relative face indices that point before the "
+            "beginning of the file", bad_refs);
+    }
     return ret;
   }
-  Indexed_Split_Mesh_Data load_wavefront(std::string file) noexcept
+
+  Indexed_Split_Mesh_Data load_wavefront(std::istream& stream) noexcept
+  {
+    std::string data{std::istreambuf_iterator<char>(stream),
+                     std::istreambuf_iterator<char>()};
+    return parse_wavefront(data.data(), data.data() + data.size());
+  }
+  Indexed_Split_Mesh_Data load_wavefront(std::string file,
+                                         Job_System* jobs) noexcept
   {
-    // Load us a stream.
-    std::ifstream stream{file};
-    if(!stream.good())
+    assets::Mapped_File mapping;
+    if(!mapping.open(file))
     {
       // Fuck. Abort.
-      log_w("File stream from '%' not good", file);
+      log_w("Failed to map '%'", file);
       return Indexed_Split_Mesh_Data{};
     }
-    return load_wavefront(stream);
+    auto data = reinterpret_cast<char const*>(mapping.data());
+    return parse_wavefront(data, data + mapping.size(), jobs);
   }
 } }
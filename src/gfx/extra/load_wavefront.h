@@ -6,10 +6,23 @@
 #include <istream>
 #include <string>
 #include "../mesh_data.h"
+namespace redc
+{
+  struct Job_System;
+}
 namespace redc { namespace gfx
 {
   Vert_Ref parse_wavefront_vert_ref(std::string str) noexcept;
 
-  Indexed_Split_Mesh_Data load_wavefront(std::string obj) noexcept;
+  // Parses an obj file that's already in memory. Faces with more than three
+  // vertices are triangulated as fans and negative (relative) indices are
+  // resolved. If a job system is given, big files are split up at line
+  // boundaries and the pieces are parsed in parallel.
+  Indexed_Split_Mesh_Data parse_wavefront(char const* begin, char const* end,
+                                          Job_System* jobs = nullptr) noexcept;
+
+  // This one maps the file rather than reading it.
+  Indexed_Split_Mesh_Data load_wavefront(std::string obj,
+                                         Job_System* jobs = nullptr) noexcept;
   Indexed_Split_Mesh_Data load_wavefront(std::istream& stream) noexcept;
 } }
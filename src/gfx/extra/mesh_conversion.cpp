@@ -3,90 +3,104 @@
  * All rights reserved.
  */
 #include "mesh_conversion.h"
-#include <tuple>
-#include <set>
+#include <cstdint>
 namespace redc { namespace gfx
 {
-  // Pronounded Ordered-vertex-reference.
-  struct Ord_Vert_Ref
+  namespace
   {
-    unsigned int where;
-    Vert_Ref vert;
-  };
-  bool operator<(Ord_Vert_Ref const& lhs, Ord_Vert_Ref const& rhs) noexcept
-  {
-    return lhs.vert < rhs.vert;
-  }
-  bool operator==(Ord_Vert_Ref const& lhs, Ord_Vert_Ref const& rhs) noexcept
-  {
-    return lhs.vert == rhs.vert;
+    // A vert ref flattened into something cheap to hash and compare, with
+    // zero meaning the component isn't there.
+    struct Flat_Ref
+    {
+      uint32_t position;
+      uint32_t normal;
+      uint32_t tex_coord;
+    };
+
+    inline uint32_t flatten(boost::optional<unsigned int> const& index)
+    {
+      return index ? index.get() + 1 : 0;
+    }
+    inline Flat_Ref flatten(Vert_Ref const& ref)
+    {
+      return {flatten(ref.position), flatten(ref.normal),
+              flatten(ref.tex_coord)};
+    }
+    inline bool operator==(Flat_Ref const& lhs, Flat_Ref const& rhs)
+    {
+      return lhs.position == rhs.position && lhs.normal == rhs.normal &&
+             lhs.tex_coord == rhs.tex_coord;
+    }
+
+    inline uint32_t hash_ref(Flat_Ref const& ref)
+    {
+      // Multiplicative mixing is plenty for indices, they are small and
+      // nicely spread out already.
+      uint64_t h = ref.position * 0x9e3779b97f4a7c15ull;
+      h ^= ref.normal * 0xc2b2ae3d27d4eb4full;
+      h ^= ref.tex_coord * 0x165667b19e3779f9ull;
+      h ^= h >> 32;
+      return static_cast<uint32_t>(h);
+    }
+
+    constexpr uint32_t EMPTY_SLOT = 0xffffffff;
   }
 
   Indexed_Mesh_Data
   to_indexed_mesh_data(Indexed_Split_Mesh_Data const& data) noexcept
   {
     Indexed_Mesh_Data ret;
+    ret.primitive = data.primitive;
 
-    using std::begin; using std::end;
+    // Open addressing table of indices into unique_refs, at most half full
+    // so probe sequences stay short.
+    std::size_t table_size = 16;
+    while(table_size < data.indices.size() * 2) table_size *= 2;
+    std::vector<uint32_t> table(table_size, EMPTY_SLOT);
+    uint32_t const mask = table_size - 1;
 
-    std::set<Ord_Vert_Ref> vert_set;
-    unsigned int where = 0;
+    std::vector<Flat_Ref> unique_refs;
+    unique_refs.reserve(data.indices.size());
 
-    // Insert each unique permutation of vertices (unique vert_ref instance)
-    // into the set.
-    for(Vert_Ref orig_v : data.indices)
+    // Each unique vert ref gets a vertex in the order they are first seen.
+    ret.elements.reserve(data.indices.size());
+    for(Vert_Ref const& orig_ref : data.indices)
     {
-      Ord_Vert_Ref ref;
-      ref.where = where;
-      ref.vert = orig_v;
+      Flat_Ref ref = flatten(orig_ref);
 
-      auto insert_res = vert_set.insert(ref);
-      if(std::get<1>(insert_res)) ++where;
+      uint32_t slot = hash_ref(ref) & mask;
+      while(table[slot] != EMPTY_SLOT && !(unique_refs[table[slot]] == ref))
+      {
+        slot = (slot + 1) & mask;
+      }
+
+      if(table[slot] == EMPTY_SLOT)
+      {
+        table[slot] = unique_refs.size();
+        unique_refs.push_back(ref);
+      }
+      ret.elements.push_back(table[slot]);
     }
 
     auto set_with = [](auto& input_vert, auto Vertex::* member,
-                       auto const& index_opt, auto const& vec)
+                       uint32_t flat_index, auto const& vec)
     {
-      if(index_opt)
+      if(flat_index && flat_index - 1 < vec.size())
       {
-        auto val = index_opt.get();
-        if(val < vec.size())
-        {
-          input_vert.*member = vec[val];
-        }
+        input_vert.*member = vec[flat_index - 1];
       }
     };
 
-    // Insert each necessary vertex. One for every element of the vert_set.
-    ret.vertices.resize(vert_set.size());
-    for(auto const& ref : vert_set)
+    // Insert each necessary vertex.
+    ret.vertices.resize(unique_refs.size());
+    for(std::size_t i = 0; i < unique_refs.size(); ++i)
     {
-      Vertex vert;
-
-      set_with(vert, &Vertex::position, ref.vert.position, data.positions);
-      set_with(vert, &Vertex::normal, ref.vert.normal, data.normals);
-      set_with(vert, &Vertex::uv, ref.vert.tex_coord, data.tex_coords);
-
-      // Use the order from when each vert_ref was added to the set. This was
-      // preserved in the Ord_Vert_Ref::where member. We need to know where
-      // each vertex is no matter what (to convert indices / the element array)
-      // so we might as well do it from the start. Otherwise we would have to
-      // record the order here. That is, we need a way to find the index of a
-      // given vert ref.
-      ret.vertices[ref.where] = vert;
-    }
-
-    // Create an index list, by finding each permutation in the set.
-    for(Vert_Ref orig_ref : data.indices)
-    {
-      Ord_Vert_Ref ref;
-      ref.vert = orig_ref;
-      auto ord_find = vert_set.find(ref);
-
-      // This shouldn't even happen once.
-      if(ord_find == vert_set.end()) continue;
+      Flat_Ref const& ref = unique_refs[i];
+      Vertex& vert = ret.vertices[i];
 
-      ret.elements.push_back(ord_find->where);
+      set_with(vert, &Vertex::position, ref.position, data.positions);
+      set_with(vert, &Vertex::normal, ref.normal, data.normals);
+      set_with(vert, &Vertex::uv, ref.tex_coord, data.tex_coords);
     }
 
     return ret;
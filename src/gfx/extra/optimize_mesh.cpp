@@ -0,0 +1,368 @@
+/*
+ * Copyright (C) 2016 Luke San Antonio
+ * All rights reserved.
+ */
+#include "optimize_mesh.h"
+#include <algorithm>
+#include <numeric>
+namespace redc { namespace gfx
+{
+  namespace
+  {
+    constexpr unsigned int NO_VERTEX = 0xffffffff;
+
+    // A cluster may end early once the cache misses so far are within this
+    // factor of the whole cluster's. Bigger means more and smaller clusters,
+    // so better overdraw but more cache misses.
+    constexpr float OVERDRAW_THRESHOLD = 1.05f;
+
+    // Simulates a FIFO cache one vertex at a time.
+    struct Fifo_Cache
+    {
+      Fifo_Cache(std::size_t num_vertices, unsigned int size)
+        : timestamps(num_vertices, 0), size(size), time(size + 1) {}
+
+      // Returns true on a miss.
+      bool use(unsigned int vertex) noexcept
+      {
+        if(time - timestamps[vertex] > size)
+        {
+          timestamps[vertex] = time++;
+          return true;
+        }
+        return false;
+      }
+      void flush() noexcept
+      {
+        // Nothing used before now can be considered in the cache.
+        time += size + 1;
+      }
+
+      std::vector<unsigned int> timestamps;
+      unsigned int size;
+      unsigned int time;
+    };
+
+    // Triangles using each vertex, packed the usual way.
+    struct Adjacency
+    {
+      std::vector<unsigned int> offsets;
+      std::vector<unsigned int> triangles;
+    };
+
+    // Leftover elements after the last whole triangle aren't included.
+    Adjacency build_adjacency(std::vector<unsigned int> const& elements,
+                              std::size_t num_vertices,
+                              std::size_t num_tris) noexcept
+    {
+      std::size_t num_elements = num_tris * 3;
+
+      Adjacency adj;
+      adj.offsets.assign(num_vertices + 1, 0);
+      for(std::size_t i = 0; i < num_elements; ++i)
+      {
+        ++adj.offsets[elements[i] + 1];
+      }
+      std::partial_sum(adj.offsets.begin(), adj.offsets.end(),
+                       adj.offsets.begin());
+
+      adj.triangles.resize(num_elements);
+      std::vector<unsigned int> fill(adj.offsets.begin(),
+                                     adj.offsets.end() - 1);
+      for(std::size_t i = 0; i < num_elements; ++i)
+      {
+        adj.triangles[fill[elements[i]]++] = i / 3;
+      }
+      return adj;
+    }
+
+    float cluster_acmr(std::vector<unsigned int> const& elements,
+                       std::size_t begin, std::size_t end,
+                       Fifo_Cache& cache) noexcept
+    {
+      cache.flush();
+      std::size_t misses = 0;
+      for(std::size_t i = begin; i < end; ++i)
+      {
+        misses += cache.use(elements[i]);
+      }
+      return misses / static_cast<float>((end - begin) / 3);
+    }
+
+    // Splits up the clusters from Tipsify further, wherever the cache has
+    // done about as well as it's going to do for that cluster anyway.
+    std::vector<std::size_t>
+    soft_boundaries(std::vector<unsigned int> const& elements,
+                    std::vector<std::size_t> const& clusters,
+                    std::size_t num_vertices, unsigned int cache_size) noexcept
+    {
+      Fifo_Cache cache(num_vertices, cache_size);
+
+      std::vector<std::size_t> ret;
+      for(std::size_t c = 0; c < clusters.size(); ++c)
+      {
+        std::size_t begin = clusters[c];
+        std::size_t end = c + 1 < clusters.size() ? clusters[c + 1]
+                                                  : elements.size();
+
+        float threshold =
+          cluster_acmr(elements, begin, end, cache) * OVERDRAW_THRESHOLD;
+
+        ret.push_back(begin);
+        cache.flush();
+
+        std::size_t misses = 0;
+        std::size_t sub_begin = begin;
+        for(std::size_t i = begin; i < end; i += 3)
+        {
+          misses += cache.use(elements[i]);
+          misses += cache.use(elements[i + 1]);
+          misses += cache.use(elements[i + 2]);
+
+          std::size_t tris = (i + 3 - sub_begin) / 3;
+          if(i + 3 < end && misses <= threshold * tris)
+          {
+            ret.push_back(i + 3);
+            sub_begin = i + 3;
+            misses = 0;
+            cache.flush();
+          }
+        }
+      }
+      return ret;
+    }
+  }
+
+  float compute_acmr(std::vector<unsigned int> const& elements,
+                     std::size_t num_vertices,
+                     unsigned int cache_size) noexcept
+  {
+    if(elements.size() < 3) return 0.0f;
+
+    Fifo_Cache cache(num_vertices, cache_size);
+    std::size_t misses = 0;
+    for(unsigned int v : elements) misses += cache.use(v);
+    return misses / static_cast<float>(elements.size() / 3);
+  }
+
+  std::vector<std::size_t>
+  optimize_vertex_cache(std::vector<unsigned int>& elements,
+                        std::size_t num_vertices,
+                        unsigned int cache_size) noexcept
+  {
+    std::vector<std::size_t> clusters;
+    std::size_t num_tris = elements.size() / 3;
+    if(num_tris == 0) return clusters;
+
+    Adjacency adj = build_adjacency(elements, num_vertices, num_tris);
+
+    // How many triangles using each vertex haven't been emitted yet.
+    std::vector<unsigned int> live(num_vertices, 0);
+    for(std::size_t v = 0; v < num_vertices; ++v)
+    {
+      live[v] = adj.offsets[v + 1] - adj.offsets[v];
+    }
+
+    std::vector<bool> emitted(num_tris, false);
+    std::vector<unsigned int> dead_end;
+    std::vector<unsigned int> candidates;
+    std::vector<unsigned int> timestamps(num_vertices, 0);
+
+    std::vector<unsigned int> out;
+    out.reserve(elements.size());
+
+    unsigned int time = cache_size + 1;
+    unsigned int cursor = 0;
+
+    // Start on the first vertex that's used at all.
+    unsigned int fan = 0;
+    while(fan < num_vertices && !live[fan]) ++fan;
+
+    clusters.push_back(0);
+    while(fan != NO_VERTEX)
+    {
+      candidates.clear();
+
+      // Emit every triangle around the current vertex.
+      for(unsigned int a = adj.offsets[fan]; a < adj.offsets[fan + 1]; ++a)
+      {
+        unsigned int tri = adj.triangles[a];
+        if(emitted[tri]) continue;
+
+        for(int i = 0; i < 3; ++i)
+        {
+          unsigned int v = elements[tri * 3 + i];
+          out.push_back(v);
+          dead_end.push_back(v);
+          candidates.push_back(v);
+          --live[v];
+          if(time - timestamps[v] > cache_size) timestamps[v] = time++;
+        }
+        emitted[tri] = true;
+      }
+
+      // Find the candidate that will still be in the cache after its
+      // triangles are done, preferring the oldest one.
+      unsigned int next = NO_VERTEX;
+      int best_priority = -1;
+      for(unsigned int v : candidates)
+      {
+        if(!live[v]) continue;
+
+        int priority = 0;
+        if(time - timestamps[v] + 2 * live[v] <= cache_size)
+        {
+          priority = time - timestamps[v];
+        }
+        if(priority > best_priority)
+        {
+          best_priority = priority;
+          next = v;
+        }
+      }
+
+      if(next == NO_VERTEX)
+      {
+        // Dead end, try anything recently used and then just go through
+        // the rest in order.
+        while(!dead_end.empty() && next == NO_VERTEX)
+        {
+          unsigned int v = dead_end.back();
+          dead_end.pop_back();
+          if(live[v]) next = v;
+        }
+        while(next == NO_VERTEX && cursor < num_vertices)
+        {
+          if(live[cursor]) next = cursor;
+          else ++cursor;
+        }
+
+        // Whatever we do next probably starts with a cold cache, which makes
+        // this a good place to split.
+        if(next != NO_VERTEX) clusters.push_back(out.size());
+      }
+      fan = next;
+    }
+
+    // Anything that's not a triangle at the end just goes back on.
+    out.insert(out.end(), elements.begin() + num_tris * 3, elements.end());
+    elements.swap(out);
+    return clusters;
+  }
+
+  void optimize_overdraw(std::vector<unsigned int>& elements,
+                         std::vector<std::size_t> const& clusters,
+                         std::vector<Vertex> const& vertices) noexcept
+  {
+    std::size_t num_tris = elements.size() / 3;
+    if(clusters.size() < 2 || num_tris == 0) return;
+
+    // Middle of the whole mesh, weighted by triangle area.
+    glm::vec3 mesh_center(0.0f);
+    float mesh_area = 0.0f;
+
+    struct Cluster
+    {
+      std::size_t begin;
+      std::size_t end;
+      glm::vec3 center;
+      glm::vec3 normal;
+      float area;
+      float sort_key;
+    };
+    std::vector<Cluster> sorted(clusters.size());
+
+    for(std::size_t c = 0; c < clusters.size(); ++c)
+    {
+      Cluster& cluster = sorted[c];
+      cluster.begin = clusters[c];
+      cluster.end = c + 1 < clusters.size() ? clusters[c + 1]
+                                            : num_tris * 3;
+      cluster.center = glm::vec3(0.0f);
+      cluster.normal = glm::vec3(0.0f);
+      cluster.area = 0.0f;
+
+      for(std::size_t i = cluster.begin; i < cluster.end; i += 3)
+      {
+        glm::vec3 const& p0 = vertices[elements[i]].position;
+        glm::vec3 const& p1 = vertices[elements[i + 1]].position;
+        glm::vec3 const& p2 = vertices[elements[i + 2]].position;
+
+        glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+        float area = glm::length(normal);
+
+        cluster.center += (p0 + p1 + p2) * (area / 3.0f);
+        cluster.normal += normal;
+        cluster.area += area;
+      }
+
+      mesh_center += cluster.center;
+      mesh_area += cluster.area;
+
+      if(cluster.area > 0.0f) cluster.center /= cluster.area;
+      float normal_length = glm::length(cluster.normal);
+      if(normal_length > 0.0f) cluster.normal /= normal_length;
+    }
+    if(mesh_area > 0.0f) mesh_center /= mesh_area;
+
+    for(auto& cluster : sorted)
+    {
+      cluster.sort_key = glm::dot(cluster.center - mesh_center,
+                                  cluster.normal);
+    }
+    std::stable_sort(sorted.begin(), sorted.end(),
+    [](Cluster const& lhs, Cluster const& rhs)
+    {
+      return lhs.sort_key > rhs.sort_key;
+    });
+
+    std::vector<unsigned int> out;
+    out.reserve(elements.size());
+    for(auto const& cluster : sorted)
+    {
+      out.insert(out.end(), elements.begin() + cluster.begin,
+                 elements.begin() + cluster.end);
+    }
+    out.insert(out.end(), elements.begin() + num_tris * 3, elements.end());
+    elements.swap(out);
+  }
+
+  void optimize_vertex_fetch(Indexed_Mesh_Data& mesh) noexcept
+  {
+    std::vector<unsigned int> remap(mesh.vertices.size(), NO_VERTEX);
+    std::vector<Vertex> vertices;
+    vertices.reserve(mesh.vertices.size());
+
+    for(unsigned int& v : mesh.elements)
+    {
+      if(remap[v] == NO_VERTEX)
+      {
+        remap[v] = vertices.size();
+        vertices.push_back(mesh.vertices[v]);
+      }
+      v = remap[v];
+    }
+
+    // Unused vertices are dropped.
+    mesh.vertices.swap(vertices);
+  }
+
+  Mesh_Optimize_Stats optimize_mesh(Indexed_Mesh_Data& mesh) noexcept
+  {
+    Mesh_Optimize_Stats stats;
+    stats.acmr_before = compute_acmr(mesh.elements, mesh.vertices.size());
+
+    if(mesh.primitive == Primitive_Type::Triangles)
+    {
+      auto clusters = optimize_vertex_cache(mesh.elements,
+                                            mesh.vertices.size());
+      clusters = soft_boundaries(mesh.elements, clusters,
+                                 mesh.vertices.size(), VERTEX_CACHE_SIZE);
+      optimize_overdraw(mesh.elements, clusters, mesh.vertices);
+      optimize_vertex_fetch(mesh);
+    }
+
+    stats.acmr_after = compute_acmr(mesh.elements, mesh.vertices.size());
+    return stats;
+  }
+} }
@@ -0,0 +1,47 @@
+/*
+ * Copyright (C) 2016 Luke San Antonio
+ * All rights reserved.
+ */
+#ifndef REDC_GFX_EXTRA_OPTIMIZE_MESH_H
+#define REDC_GFX_EXTRA_OPTIMIZE_MESH_H
+#include "../mesh_data.h"
+namespace redc { namespace gfx
+{
+  // Roughly what post-transform caches we care about behave like.
+  constexpr unsigned int VERTEX_CACHE_SIZE = 16;
+
+  // Average number of vertex shader invocations per triangle with a FIFO
+  // cache of the given size. 3 is as bad as it gets, 0.5 is the ideal for
+  // a big regular grid.
+  float compute_acmr(std::vector<unsigned int> const& elements,
+                     std::size_t num_vertices,
+                     unsigned int cache_size = VERTEX_CACHE_SIZE) noexcept;
+
+  // Reorders triangles for the post-transform cache using Tipsify (Sander,
+  // Nehab, Barczak 2007). Returns the offsets (in elements) of clusters that
+  // can be drawn in any order without hurting the cache much.
+  std::vector<std::size_t>
+  optimize_vertex_cache(std::vector<unsigned int>& elements,
+                        std::size_t num_vertices,
+                        unsigned int cache_size = VERTEX_CACHE_SIZE) noexcept;
+
+  // Sorts the clusters from above so the ones facing away from the middle of
+  // the mesh go first, since they're the most likely to occlude the rest.
+  void optimize_overdraw(std::vector<unsigned int>& elements,
+                         std::vector<std::size_t> const& clusters,
+                         std::vector<Vertex> const& vertices) noexcept;
+
+  // Renumbers vertices in the order they're used so they're fetched more or
+  // less sequentially.
+  void optimize_vertex_fetch(Indexed_Mesh_Data& mesh) noexcept;
+
+  struct Mesh_Optimize_Stats
+  {
+    float acmr_before;
+    float acmr_after;
+  };
+
+  // All of the above in the right order. Only triangle lists are touched.
+  Mesh_Optimize_Stats optimize_mesh(Indexed_Mesh_Data& mesh) noexcept;
+} }
+#endif
@@ -0,0 +1,541 @@
+/*
+ * Copyright (C) 2016 Luke San Antonio
+ * All rights reserved.
+ */
+#include "simplify_mesh.h"
+#include "optimize_mesh.h"
+#include <algorithm>
+#include <cmath>
+#include <queue>
+#include <unordered_set>
+#include <utility>
+namespace redc { namespace gfx
+{
+  namespace
+  {
+    // Each level should have about this many of the triangles of the one
+    // before.
+    constexpr float LOD_REDUCTION = 0.5f;
+    // Don't bother keeping a level that doesn't get rid of at least this much
+    // more than the last one.
+    constexpr float LOD_MIN_REDUCTION = 0.9f;
+
+    // A collapse isn't allowed if it would turn any triangle more than this
+    // (as the cosine of the angle), which includes flipping it over.
+    constexpr float MAX_NORMAL_CHANGE = 0.25f;
+
+    // The upper triangle of a symmetric 4x4 matrix, the sum of squared
+    // distances to a bunch of planes.
+    struct Quadric
+    {
+      double a00 = 0, a01 = 0, a02 = 0, a03 = 0;
+      double a11 = 0, a12 = 0, a13 = 0;
+      double a22 = 0, a23 = 0;
+      double a33 = 0;
+
+      void add_plane(double a, double b, double c, double d) noexcept
+      {
+        a00 += a * a; a01 += a * b; a02 += a * c; a03 += a * d;
+        a11 += b * b; a12 += b * c; a13 += b * d;
+        a22 += c * c; a23 += c * d;
+        a33 += d * d;
+      }
+      Quadric& operator+=(Quadric const& q) noexcept
+      {
+        a00 += q.a00; a01 += q.a01; a02 += q.a02; a03 += q.a03;
+        a11 += q.a11; a12 += q.a12; a13 += q.a13;
+        a22 += q.a22; a23 += q.a23;
+        a33 += q.a33;
+        return *this;
+      }
+
+      double error(glm::vec3 const& p) const noexcept
+      {
+        double x = p.x, y = p.y, z = p.z;
+        return a00*x*x + 2*a01*x*y + 2*a02*x*z + 2*a03*x +
+               a11*y*y + 2*a12*y*z + 2*a13*y +
+               a22*z*z + 2*a23*z +
+               a33;
+      }
+    };
+
+    struct Collapse
+    {
+      double cost;
+      unsigned int from;
+      unsigned int to;
+
+      bool operator>(Collapse const& rhs) const noexcept
+      {
+        return cost > rhs.cost;
+      }
+    };
+
+    constexpr unsigned int NO_VERTEX = 0xffffffff;
+
+    /*
+     * Collapses work on positions rather than vertices. Vertices that share a
+     * position (wedges) because of different normals or uvs are welded
+     * together for the topology and the error, then when a position goes
+     * each of its wedges is moved onto a wedge of the position it collapsed
+     * into. Wedges with the same uv at a position are one side of a seam.
+     */
+    struct Simplifier
+    {
+      Simplifier(std::vector<unsigned int> const& elements,
+                 std::vector<Vertex> const& vertices) noexcept;
+
+      std::vector<unsigned int> run(std::size_t target_elements,
+                                    float& error) noexcept;
+
+    private:
+      using wedge_map_t = std::vector<std::pair<unsigned int, unsigned int> >;
+
+      void weld_() noexcept;
+      void find_borders_() noexcept;
+
+      glm::vec3 const& pos_(unsigned int v) const noexcept
+      {
+        return vertices_[v].position;
+      }
+
+      bool adjacent_(unsigned int from, unsigned int to) const noexcept;
+      bool flips_(unsigned int from, unsigned int to) const noexcept;
+      double cost_(unsigned int from, unsigned int to) const noexcept;
+      bool map_wedges_(unsigned int from, unsigned int to,
+                       wedge_map_t& map) const noexcept;
+
+      void push_collapses_(unsigned int from) noexcept;
+      void collapse_(unsigned int from, unsigned int to,
+                     wedge_map_t const& map) noexcept;
+
+      std::vector<unsigned int> tris_;
+      std::vector<bool> tri_alive_;
+      std::size_t num_alive_;
+
+      std::vector<Vertex> const& vertices_;
+
+      // Every vertex has the first vertex at its position. Everything below
+      // that is kept per position is indexed by that one.
+      std::vector<unsigned int> canonical_;
+      // Which side of a uv seam each vertex is on, counted per position.
+      std::vector<unsigned int> uv_group_;
+
+      std::vector<std::vector<unsigned int> > vert_tris_;
+      std::vector<Quadric> quadrics_;
+      std::vector<bool> locked_;
+      std::vector<bool> collapsed_;
+
+      std::priority_queue<Collapse, std::vector<Collapse>,
+                          std::greater<Collapse> > queue_;
+    };
+
+    Simplifier::Simplifier(std::vector<unsigned int> const& elements,
+                           std::vector<Vertex> const& vertices) noexcept
+      : tris_(elements.begin(), elements.begin() + elements.size() / 3 * 3),
+        tri_alive_(tris_.size() / 3, true), num_alive_(tris_.size() / 3),
+        vertices_(vertices), canonical_(vertices.size()),
+        uv_group_(vertices.size(), 0), vert_tris_(vertices.size()),
+        quadrics_(vertices.size()), locked_(vertices.size(), false),
+        collapsed_(vertices.size(), false)
+    {
+      weld_();
+
+      for(std::size_t t = 0; t < tris_.size() / 3; ++t)
+      {
+        unsigned int const* tri = &tris_[t * 3];
+        for(int i = 0; i < 3; ++i)
+        {
+          auto& tris = vert_tris_[canonical_[tri[i]]];
+          if(tris.empty() || tris.back() != t) tris.push_back(t);
+        }
+
+        // Every position starts out with the planes of its triangles.
+        glm::vec3 normal = glm::cross(pos_(tri[1]) - pos_(tri[0]),
+                                      pos_(tri[2]) - pos_(tri[0]));
+        float length = glm::length(normal);
+        if(length == 0.0f) continue;
+        normal /= length;
+
+        double d = -glm::dot(normal, pos_(tri[0]));
+        for(int i = 0; i < 3; ++i)
+        {
+          quadrics_[canonical_[tri[i]]].add_plane(normal.x, normal.y,
+                                                  normal.z, d);
+        }
+      }
+
+      find_borders_();
+    }
+
+    void Simplifier::weld_() noexcept
+    {
+      std::vector<unsigned int> by_pos(vertices_.size());
+      for(unsigned int i = 0; i < by_pos.size(); ++i) by_pos[i] = i;
+
+      auto pos_less = [&](unsigned int lhs, unsigned int rhs)
+      {
+        auto const& l = pos_(lhs);
+        auto const& r = pos_(rhs);
+        if(l.x != r.x) return l.x < r.x;
+        if(l.y != r.y) return l.y < r.y;
+        if(l.z != r.z) return l.z < r.z;
+        return lhs < rhs;
+      };
+      std::sort(by_pos.begin(), by_pos.end(), pos_less);
+
+      for(std::size_t i = 0; i < by_pos.size(); )
+      {
+        std::size_t j = i + 1;
+        while(j < by_pos.size() && pos_(by_pos[j]) == pos_(by_pos[i])) ++j;
+
+        for(std::size_t k = i; k < j; ++k)
+        {
+          unsigned int v = by_pos[k];
+          canonical_[v] = by_pos[i];
+
+          // Same uv as one before it is the same side.
+          uv_group_[v] = k - i;
+          for(std::size_t l = i; l < k; ++l)
+          {
+            if(vertices_[by_pos[l]].uv == vertices_[v].uv)
+            {
+              uv_group_[v] = uv_group_[by_pos[l]];
+              break;
+            }
+          }
+        }
+        i = j;
+      }
+    }
+
+    void Simplifier::find_borders_() noexcept
+    {
+      auto edge_key = [](unsigned int a, unsigned int b)
+      {
+        return (static_cast<uint64_t>(a) << 32) | b;
+      };
+
+      std::unordered_set<uint64_t> edges;
+      edges.reserve(tris_.size());
+      for(std::size_t i = 0; i < tris_.size(); i += 3)
+      {
+        for(int e = 0; e < 3; ++e)
+        {
+          edges.insert(edge_key(canonical_[tris_[i + e]],
+                                canonical_[tris_[i + (e + 1) % 3]]));
+        }
+      }
+
+      // A border edge is one that isn't there going the other way, those
+      // have to stay or there would be holes.
+      for(std::size_t i = 0; i < tris_.size(); i += 3)
+      {
+        for(int e = 0; e < 3; ++e)
+        {
+          unsigned int a = canonical_[tris_[i + e]];
+          unsigned int b = canonical_[tris_[i + (e + 1) % 3]];
+          if(!edges.count(edge_key(b, a)))
+          {
+            locked_[a] = true;
+            locked_[b] = true;
+          }
+        }
+      }
+    }
+
+    bool Simplifier::adjacent_(unsigned int from, unsigned int to)
+      const noexcept
+    {
+      for(unsigned int t : vert_tris_[from])
+      {
+        if(!tri_alive_[t]) continue;
+        unsigned int const* tri = &tris_[t * 3];
+        for(int i = 0; i < 3; ++i)
+        {
+          if(canonical_[tri[i]] == to) return true;
+        }
+      }
+      return false;
+    }
+
+    bool Simplifier::flips_(unsigned int from, unsigned int to) const noexcept
+    {
+      for(unsigned int t : vert_tris_[from])
+      {
+        if(!tri_alive_[t]) continue;
+
+        unsigned int const* tri = &tris_[t * 3];
+        unsigned int at[3] = {canonical_[tri[0]], canonical_[tri[1]],
+                              canonical_[tri[2]]};
+        // These go away.
+        if(at[0] == to || at[1] == to || at[2] == to) continue;
+
+        glm::vec3 before[3], after[3];
+        for(int i = 0; i < 3; ++i)
+        {
+          before[i] = pos_(tri[i]);
+          after[i] = at[i] == from ? pos_(to) : pos_(tri[i]);
+        }
+
+        glm::vec3 n_before = glm::cross(before[1] - before[0],
+                                        before[2] - before[0]);
+        glm::vec3 n_after = glm::cross(after[1] - after[0],
+                                       after[2] - after[0]);
+
+        float lengths = glm::length(n_before) * glm::length(n_after);
+        if(glm::dot(n_before, n_after) <= MAX_NORMAL_CHANGE * lengths)
+        {
+          return true;
+        }
+      }
+      return false;
+    }
+
+    double Simplifier::cost_(unsigned int from, unsigned int to) const noexcept
+    {
+      Quadric q = quadrics_[from];
+      q += quadrics_[to];
+      // Rounding can make this slightly negative.
+      return std::max(q.error(pos_(to)), 0.0);
+    }
+
+    bool Simplifier::map_wedges_(unsigned int from, unsigned int to,
+                                 wedge_map_t& map) const noexcept
+    {
+      // The wedges still in use and, for the triangles along the edge, which
+      // wedge at the other end they're connected to.
+      std::vector<unsigned int> wedges;
+      wedge_map_t links;
+      for(unsigned int t : vert_tris_[from])
+      {
+        if(!tri_alive_[t]) continue;
+
+        unsigned int const* tri = &tris_[t * 3];
+        unsigned int a = NO_VERTEX, b = NO_VERTEX;
+        for(int i = 0; i < 3; ++i)
+        {
+          if(canonical_[tri[i]] == from) a = tri[i];
+          else if(canonical_[tri[i]] == to) b = tri[i];
+        }
+        if(std::find(wedges.begin(), wedges.end(), a) == wedges.end())
+        {
+          wedges.push_back(a);
+        }
+        if(b != NO_VERTEX) links.emplace_back(a, b);
+      }
+
+      // Each side of a seam has to slide along the edge onto the same side
+      // at the other end. A side that isn't on the edge can't go anywhere
+      // without moving the seam.
+      map.clear();
+      for(unsigned int w : wedges)
+      {
+        unsigned int side = NO_VERTEX;
+        unsigned int best = NO_VERTEX;
+        for(auto const& link : links)
+        {
+          if(uv_group_[link.first] != uv_group_[w]) continue;
+
+          unsigned int link_side = uv_group_[link.second];
+          if(side != NO_VERTEX && side != link_side) return false;
+          side = link_side;
+          if(link.first == w) best = link.second;
+        }
+        if(side == NO_VERTEX) return false;
+
+        // Otherwise it's only split by normal, take the closest on our side.
+        if(best == NO_VERTEX)
+        {
+          float best_dot = -2.0f;
+          for(unsigned int t : vert_tris_[to])
+          {
+            if(!tri_alive_[t]) continue;
+            for(int i = 0; i < 3; ++i)
+            {
+              unsigned int v = tris_[t * 3 + i];
+              if(canonical_[v] != to || uv_group_[v] != side) continue;
+
+              float d = glm::dot(vertices_[w].normal, vertices_[v].normal);
+              if(d > best_dot)
+              {
+                best_dot = d;
+                best = v;
+              }
+            }
+          }
+        }
+        map.emplace_back(w, best);
+      }
+      return true;
+    }
+
+    void Simplifier::push_collapses_(unsigned int from) noexcept
+    {
+      if(locked_[from] || collapsed_[from]) return;
+
+      for(unsigned int t : vert_tris_[from])
+      {
+        if(!tri_alive_[t]) continue;
+        for(int i = 0; i < 3; ++i)
+        {
+          unsigned int to = canonical_[tris_[t * 3 + i]];
+          if(to == from) continue;
+          queue_.push({cost_(from, to), from, to});
+        }
+      }
+    }
+
+    void Simplifier::collapse_(unsigned int from, unsigned int to,
+                               wedge_map_t const& map) noexcept
+    {
+      for(unsigned int t : vert_tris_[from])
+      {
+        if(!tri_alive_[t]) continue;
+
+        unsigned int* tri = &tris_[t * 3];
+        if(canonical_[tri[0]] == to || canonical_[tri[1]] == to ||
+           canonical_[tri[2]] == to)
+        {
+          tri_alive_[t] = false;
+          --num_alive_;
+          continue;
+        }
+
+        for(int i = 0; i < 3; ++i)
+        {
+          if(canonical_[tri[i]] != from) continue;
+          for(auto const& wedge : map)
+          {
+            if(wedge.first == tri[i])
+            {
+              tri[i] = wedge.second;
+              break;
+            }
+          }
+        }
+        vert_tris_[to].push_back(t);
+      }
+
+      quadrics_[to] += quadrics_[from];
+      collapsed_[from] = true;
+      vert_tris_[from].clear();
+
+      // Anything around here may be cheaper or more expensive now. Costs
+      // only ever go up though, so the queue is fixed up lazily as things
+      // are popped, we only need to add the new edges.
+      push_collapses_(to);
+      for(unsigned int t : vert_tris_[to])
+      {
+        if(!tri_alive_[t]) continue;
+        for(int i = 0; i < 3; ++i)
+        {
+          unsigned int other = canonical_[tris_[t * 3 + i]];
+          if(other != to && !locked_[other])
+          {
+            queue_.push({cost_(other, to), other, to});
+          }
+        }
+      }
+    }
+
+    std::vector<unsigned int>
+    Simplifier::run(std::size_t target_elements, float& error) noexcept
+    {
+      for(unsigned int v = 0; v < vertices_.size(); ++v)
+      {
+        if(canonical_[v] == v) push_collapses_(v);
+      }
+
+      wedge_map_t wedges;
+
+      double max_cost = 0.0;
+      while(num_alive_ * 3 > target_elements && !queue_.empty())
+      {
+        Collapse c = queue_.top();
+        queue_.pop();
+
+        if(collapsed_[c.from] || collapsed_[c.to]) continue;
+        if(!adjacent_(c.from, c.to)) continue;
+
+        // Something changed around here since this was queued, go back in
+        // line with the right cost.
+        double cost = cost_(c.from, c.to);
+        if(cost > c.cost)
+        {
+          c.cost = cost;
+          queue_.push(c);
+          continue;
+        }
+
+        // Don't queue this again, if the neighborhood changes enough for it
+        // to be okay it will get queued then.
+        if(flips_(c.from, c.to)) continue;
+        if(!map_wedges_(c.from, c.to, wedges)) continue;
+
+        collapse_(c.from, c.to, wedges);
+        max_cost = std::max(max_cost, cost);
+      }
+
+      std::vector<unsigned int> ret;
+      ret.reserve(num_alive_ * 3);
+      for(std::size_t t = 0; t < tri_alive_.size(); ++t)
+      {
+        if(!tri_alive_[t]) continue;
+        ret.insert(ret.end(), &tris_[t * 3], &tris_[t * 3] + 3);
+      }
+
+      error = static_cast<float>(std::sqrt(max_cost));
+      return ret;
+    }
+  }
+
+  std::vector<unsigned int>
+  simplify_mesh(std::vector<unsigned int> const& elements,
+                std::vector<Vertex> const& vertices,
+                std::size_t target_elements, float& error) noexcept
+  {
+    Simplifier simplifier(elements, vertices);
+    return simplifier.run(target_elements, error);
+  }
+
+  std::vector<Mesh_Lod> generate_lods(Indexed_Mesh_Data& mesh,
+                                      unsigned int max_lods) noexcept
+  {
+    std::vector<Mesh_Lod> lods;
+    lods.push_back({0, static_cast<unsigned int>(mesh.elements.size()), 0.0f});
+
+    if(mesh.primitive != Primitive_Type::Triangles) return lods;
+
+    // Simplify each level from the one before, it's a lot less work and
+    // the error only adds up.
+    std::vector<unsigned int> prev = mesh.elements;
+    float total_error = 0.0f;
+    while(lods.size() < max_lods)
+    {
+      std::size_t target = static_cast<std::size_t>(prev.size() / 3 *
+                                                    LOD_REDUCTION) * 3;
+      if(target == 0) break;
+
+      float error = 0.0f;
+      auto elements = simplify_mesh(prev, mesh.vertices, target, error);
+      if(elements.empty() ||
+         elements.size() > prev.size() * LOD_MIN_REDUCTION)
+      {
+        break;
+      }
+
+      // Each level gets drawn on its own, so it gets its own triangle order.
+      optimize_vertex_cache(elements, mesh.vertices.size());
+
+      total_error += error;
+      lods.push_back({static_cast<unsigned int>(mesh.elements.size()),
+                      static_cast<unsigned int>(elements.size()),
+                      total_error});
+      mesh.elements.insert(mesh.elements.end(), elements.begin(),
+                           elements.end());
+      prev = std::move(elements);
+    }
+    return lods;
+  }
+} }
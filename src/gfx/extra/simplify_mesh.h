@@ -0,0 +1,35 @@
+/*
+ * Copyright (C) 2016 Luke San Antonio
+ * All rights reserved.
+ */
+#ifndef REDC_GFX_EXTRA_SIMPLIFY_MESH_H
+#define REDC_GFX_EXTRA_SIMPLIFY_MESH_H
+#include "../mesh_data.h"
+namespace redc { namespace gfx
+{
+  /*!
+   * \brief Simplifies a triangle list with quadric error metrics.
+   *
+   * Edges are collapsed cheapest first (Garland and Heckbert 1997) until at
+   * most target_elements are left or nothing else can go. Vertices are only
+   * ever collapsed onto other existing vertices, so the result indexes the
+   * same vertex array as the input. Vertices that share a position are
+   * collapsed together, so seams between normals or uvs don't stop anything,
+   * but a uv seam can only slide along itself. Borders stay put so there are
+   * no holes.
+   *
+   * \param error Set to roughly how far the result strays from the input.
+   */
+  std::vector<unsigned int>
+  simplify_mesh(std::vector<unsigned int> const& elements,
+                std::vector<Vertex> const& vertices,
+                std::size_t target_elements, float& error) noexcept;
+
+  // Appends progressively simplified versions of the mesh to its elements,
+  // each about half of the one before, and returns the range of each one
+  // including the original. Fewer than max_lods come back when the mesh
+  // stops simplifying.
+  std::vector<Mesh_Lod> generate_lods(Indexed_Mesh_Data& mesh,
+                                      unsigned int max_lods = 4) noexcept;
+} }
+#endif
@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2016 Luke San Antonio
+ * All rights reserved.
+ */
+#include "texture_atlas.h"
+#include <algorithm>
+#include "../../common/debugging.h"
+#include "../../common/log.h"
+
+// Keep our copy of the packer to ourselves, imgui has its own.
+#define STBRP_STATIC
+#define STB_RECT_PACK_IMPLEMENTATION
+#include "imgui/stb_rect_pack.h"
+
+namespace redc { namespace gfx
+{
+  namespace
+  {
+    std::size_t round_up_pow2(std::size_t size) noexcept
+    {
+      std::size_t ret = 1;
+      while(ret < size) ret *= 2;
+      return ret;
+    }
+
+    // Copies the image in with its edges repeated into the padding.
+    void blit_padded(Image& page, Image const& image,
+                     Vec<std::size_t> const& pos, std::size_t padding) noexcept
+    {
+      if(image.data.empty()) return;
+
+      long width = image.extents.x;
+      long height = image.extents.y;
+      long pad = padding;
+      for(long y = -pad; y < height + pad; ++y)
+      {
+        long src_y = std::min(std::max(y, 0L), height - 1);
+        for(long x = -pad; x < width + pad; ++x)
+        {
+          long src_x = std::min(std::max(x, 0L), width - 1);
+          std::size_t dst = (pos.y + y) * page.extents.x + (pos.x + x);
+          page.data[dst] = image.data[src_y * width + src_x];
+        }
+      }
+    }
+  }
+
+  bool fits_in_atlas(Vec<std::size_t> const& extents,
+                     Vec<std::size_t> const& page_extents,
+                     std::size_t padding) noexcept
+  {
+    return extents.x + padding * 2 <= page_extents.x &&
+           extents.y + padding * 2 <= page_extents.y;
+  }
+
+  Texture_Atlas build_atlas(std::vector<Image> const& images,
+                            Vec<std::size_t> const& page_extents,
+                            std::size_t padding) noexcept
+  {
+    Texture_Atlas atlas;
+    atlas.regions.resize(images.size());
+
+    std::vector<stbrp_rect> remaining;
+    for(std::size_t i = 0; i < images.size(); ++i)
+    {
+      REDC_ASSERT_MSG(fits_in_atlas(images[i].extents, page_extents, padding),
+                      "Image % is too big for an atlas page", i);
+
+      stbrp_rect rect;
+      rect.id = i;
+      rect.w = images[i].extents.x + padding * 2;
+      rect.h = images[i].extents.y + padding * 2;
+      remaining.push_back(rect);
+    }
+
+    std::vector<stbrp_node> nodes(page_extents.x);
+    while(!remaining.empty())
+    {
+      stbrp_context ctx;
+      stbrp_init_target(&ctx, page_extents.x, page_extents.y, nodes.data(),
+                        nodes.size());
+      stbrp_pack_rects(&ctx, remaining.data(), remaining.size());
+
+      // Whatever didn't make it goes on the next page.
+      auto unpacked = std::partition(remaining.begin(), remaining.end(),
+                                     [](stbrp_rect const& rect)
+                                     { return rect.was_packed != 0; });
+      if(unpacked == remaining.begin())
+      {
+        log_e("Failed to pack % images into an atlas", remaining.size());
+        break;
+      }
+
+      std::size_t used_height = 0;
+      for(auto it = remaining.begin(); it != unpacked; ++it)
+      {
+        used_height = std::max<std::size_t>(used_height, it->y + it->h);
+      }
+
+      Image page;
+      page.extents.x = page_extents.x;
+      page.extents.y = std::min(round_up_pow2(used_height), page_extents.y);
+      page.data.resize(page.extents.x * page.extents.y, Color(0, 0, 0, 0));
+
+      unsigned int page_index = atlas.pages.size();
+      for(auto it = remaining.begin(); it != unpacked; ++it)
+      {
+        Image const& image = images[it->id];
+
+        Atlas_Region& region = atlas.regions[it->id];
+        region.page = page_index;
+        region.pos = {it->x + padding, it->y + padding};
+        region.extents = image.extents;
+
+        // The page gets flipped, so the bottom of the region is measured
+        // from the bottom of the page.
+        float page_w = page.extents.x;
+        float page_h = page.extents.y;
+        float bottom = page.extents.y - region.pos.y - region.extents.y;
+        region.uv_transform = glm::vec4(region.extents.x / page_w,
+                                        region.extents.y / page_h,
+                                        region.pos.x / page_w,
+                                        bottom / page_h);
+
+        blit_padded(page, image, region.pos, padding);
+      }
+      atlas.pages.push_back(std::move(page));
+
+      remaining.erase(remaining.begin(), unpacked);
+    }
+    return atlas;
+  }
+} }
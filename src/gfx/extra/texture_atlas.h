@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) 2016 Luke San Antonio
+ * All rights reserved.
+ */
+#ifndef REDC_GFX_EXTRA_TEXTURE_ATLAS_H
+#define REDC_GFX_EXTRA_TEXTURE_ATLAS_H
+#include <vector>
+#include <glm/glm.hpp>
+#include "texture_load.h"
+namespace redc { namespace gfx
+{
+  constexpr std::size_t ATLAS_PAGE_EXTENT = 1024;
+
+  // Empty space around every image, its edges are repeated into it so
+  // filtering doesn't pick up the neighbors. This also limits how many mip
+  // levels a page can have.
+  constexpr std::size_t ATLAS_PADDING = 4;
+
+  struct Atlas_Region
+  {
+    unsigned int page;
+
+    // Top left corner in the page, in pixels.
+    Vec<std::size_t> pos;
+    Vec<std::size_t> extents;
+
+    // Maps uvs of the original texture onto the page: uv * xy + zw. This is
+    // for after the page is flipped for GL, so v still goes up.
+    glm::vec4 uv_transform;
+  };
+
+  struct Texture_Atlas
+  {
+    // Top row first, like loaded images.
+    std::vector<Image> pages;
+    // One for every image, in the same order.
+    std::vector<Atlas_Region> regions;
+  };
+
+  bool fits_in_atlas(Vec<std::size_t> const& extents,
+                     Vec<std::size_t> const& page_extents,
+                     std::size_t padding = ATLAS_PADDING) noexcept;
+
+  /*!
+   * \brief Packs images onto as few pages as possible.
+   *
+   * Every image must fit on a page by itself, see fits_in_atlas. Pages are
+   * as wide as page_extents but the last one may be shorter, it is cut down
+   * to the next power of two that fits everything on it.
+   */
+  Texture_Atlas build_atlas(std::vector<Image> const& images,
+                            Vec<std::size_t> const& page_extents =
+                              {ATLAS_PAGE_EXTENT, ATLAS_PAGE_EXTENT},
+                            std::size_t padding = ATLAS_PADDING) noexcept;
+} }
+#endif
@@ -8,118 +8,168 @@
 #include <cstring>
 namespace redc { namespace gfx
 {
+  constexpr int PNG_HEADER_READ = 7;
+
   void error_fn(void*) {}
 
-  Image load_png_data(std::string filename)
+  namespace
   {
-    Image image;
-
-    std::FILE* fp = std::fopen(filename.c_str(), "rb");
-    if(!fp)
+    struct Png_Memory_Source
     {
-      log_w("Failed to open file '%'", filename);
-      return {};
-    }
+      uint8_t const* data;
+      std::size_t size;
+      std::size_t pos;
+    };
 
-    constexpr int HEADER_READ = 7;
-    unsigned char* const header = new unsigned char[HEADER_READ];
-    fread(header, 1, HEADER_READ, fp);
-    bool is_png = !png_sig_cmp(header, 0, HEADER_READ);
-    if(!is_png)
+    void read_png_memory(png_structp png_ptr, png_bytep out, png_size_t len)
     {
-      log_w("File '%' not a png", filename);
-      return {};
+      auto src = static_cast<Png_Memory_Source*>(png_get_io_ptr(png_ptr));
+      if(len > src->size - src->pos)
+      {
+        png_error(png_ptr, "Unexpected end of data");
+      }
+      std::memcpy(out, src->data + src->pos, len);
+      src->pos += len;
     }
 
-    png_structp png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING,
-                                                 NULL, NULL, NULL);
-    if(!png_ptr)
+    // Does the actual decoding once the caller has given libpng some way to
+    // get at the data, the signature should already be consumed.
+    template <class Init_Io>
+    Image decode_png(std::string const& filename, Init_Io init_io)
     {
-      log_w("Failed to initialize png struct for '%'", filename);
-      return {};
-    }
+      Image image;
 
-    png_infop info_ptr = png_create_info_struct(png_ptr);
-    if(!info_ptr)
-    {
-      png_destroy_read_struct(&png_ptr, NULL, NULL);
-      log_w("Failed to initialize png info for '%'", filename);
-      return {};
-    }
+      png_structp png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING,
+                                                   NULL, NULL, NULL);
+      if(!png_ptr)
+      {
+        log_w("Failed to initialize png struct for '%'", filename);
+        return {};
+      }
 
-    png_infop end_info_ptr = png_create_info_struct(png_ptr);
-    if(!info_ptr)
-    {
-      png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
-      log_w("Failed to initialize png end info for '%'", filename);
-      return {};
-    }
+      png_infop info_ptr = png_create_info_struct(png_ptr);
+      if(!info_ptr)
+      {
+        png_destroy_read_struct(&png_ptr, NULL, NULL);
+        log_w("Failed to initialize png info for '%'", filename);
+        return {};
+      }
 
-    if(setjmp(png_jmpbuf(png_ptr)))
-    {
-      png_destroy_read_struct(&png_ptr, &info_ptr, &end_info_ptr);
-      fclose(fp);
+      png_infop end_info_ptr = png_create_info_struct(png_ptr);
+      if(!end_info_ptr)
+      {
+        png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
+        log_w("Failed to initialize png end info for '%'", filename);
+        return {};
+      }
 
-      log_w("libpng error for '%'", filename);
-      return {};
-    }
+      if(setjmp(png_jmpbuf(png_ptr)))
+      {
+        png_destroy_read_struct(&png_ptr, &info_ptr, &end_info_ptr);
 
-    png_init_io(png_ptr, fp);
-    png_set_sig_bytes(png_ptr, HEADER_READ);
+        log_w("libpng error for '%'", filename);
+        return {};
+      }
 
-    png_read_png(png_ptr, info_ptr, PNG_TRANSFORM_GRAY_TO_RGB, NULL);
+      init_io(png_ptr);
+      png_set_sig_bytes(png_ptr, PNG_HEADER_READ);
 
-    image.extents.x = png_get_image_width(png_ptr, info_ptr);
-    image.extents.y = png_get_image_height(png_ptr, info_ptr);
+      png_read_png(png_ptr, info_ptr, PNG_TRANSFORM_GRAY_TO_RGB, NULL);
 
-    auto png_data = png_get_rows(png_ptr, info_ptr);
-    auto format = png_get_color_type(png_ptr, info_ptr);
+      image.extents.x = png_get_image_width(png_ptr, info_ptr);
+      image.extents.y = png_get_image_height(png_ptr, info_ptr);
 
-    int png_bytes_per_pixel = 0;
-    if(format == PNG_COLOR_TYPE_RGB)
-    {
-      png_bytes_per_pixel = 3;
-    }
-    else if(format == PNG_COLOR_TYPE_RGBA)
-    {
-      png_bytes_per_pixel = 4;
-    }
+      auto png_data = png_get_rows(png_ptr, info_ptr);
+      auto format = png_get_color_type(png_ptr, info_ptr);
 
-    image.data.reserve(image.extents.x * image.extents.y);
-    for(std::size_t i = 0; i < image.extents.y * image.extents.x; ++i)
-    {
-      // Find out our position.
-      std::size_t x = i % image.extents.x;
-      std::size_t y = i / image.extents.y;
-
-      // Find where we are in png's data.
-      auto dst_ptr = *(png_data + y);
-      dst_ptr += x * png_bytes_per_pixel;
-
-      Color c;
-      c.r = dst_ptr[0];
-      c.g = dst_ptr[1];
-      c.b = dst_ptr[2];
+      int png_bytes_per_pixel = 0;
       if(format == PNG_COLOR_TYPE_RGB)
       {
-        // We don't have an alpha value, so fill in full opacity.
-        c.a = 0xff;
+        png_bytes_per_pixel = 3;
       }
       else if(format == PNG_COLOR_TYPE_RGBA)
       {
-        c.a = dst_ptr[3];
+        png_bytes_per_pixel = 4;
       }
 
-      image.data.push_back(c);
+      image.data.reserve(image.extents.x * image.extents.y);
+      for(std::size_t i = 0; i < image.extents.y * image.extents.x; ++i)
+      {
+        // Find out our position.
+        std::size_t x = i % image.extents.x;
+        std::size_t y = i / image.extents.x;
+
+        // Find where we are in png's data.
+        auto dst_ptr = *(png_data + y);
+        dst_ptr += x * png_bytes_per_pixel;
+
+        Color c;
+        c.r = dst_ptr[0];
+        c.g = dst_ptr[1];
+        c.b = dst_ptr[2];
+        if(format == PNG_COLOR_TYPE_RGB)
+        {
+          // We don't have an alpha value, so fill in full opacity.
+          c.a = 0xff;
+        }
+        else if(format == PNG_COLOR_TYPE_RGBA)
+        {
+          c.a = dst_ptr[3];
+        }
+
+        image.data.push_back(c);
+      }
+
+      // We copied the data, so just forget about png now.
+      png_destroy_read_struct(&png_ptr, &info_ptr, &end_info_ptr);
+
+      return image;
+    }
+  }
+
+  Image load_png_data(std::string filename)
+  {
+    std::FILE* fp = std::fopen(filename.c_str(), "rb");
+    if(!fp)
+    {
+      log_w("Failed to open file '%'", filename);
+      return {};
     }
 
-    // We copied the data, so just forget about png now.
-    png_destroy_read_struct(&png_ptr, &info_ptr, &end_info_ptr);
+    unsigned char header[PNG_HEADER_READ];
+    bool is_png = fread(header, 1, PNG_HEADER_READ, fp) == PNG_HEADER_READ &&
+                  !png_sig_cmp(header, 0, PNG_HEADER_READ);
+    if(!is_png)
+    {
+      log_w("File '%' not a png", filename);
+      fclose(fp);
+      return {};
+    }
+
+    Image image = decode_png(filename, [&](png_structp png_ptr)
+    {
+      png_init_io(png_ptr, fp);
+    });
+
     // Close the file of course.
     fclose(fp);
-
     return image;
   }
+  Image load_png_data(uint8_t const* data, std::size_t size,
+                      std::string const& name)
+  {
+    if(size < PNG_HEADER_READ || png_sig_cmp(data, 0, PNG_HEADER_READ))
+    {
+      log_w("File '%' not a png", name);
+      return {};
+    }
+
+    Png_Memory_Source source{data, size, PNG_HEADER_READ};
+    return decode_png(name, [&](png_structp png_ptr)
+    {
+      png_set_read_fn(png_ptr, &source, read_png_memory);
+    });
+  }
   void blit_image(ITexture& t, Image const& img)
   {
     static_assert(sizeof(Color) == sizeof(unsigned char) * 4,
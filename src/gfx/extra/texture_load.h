@@ -3,6 +3,7 @@
  * All rights reserved.
  */
 #pragma once
+#include <cstdint>
 #include <string>
 #include "../itexture.h"
 namespace redc { namespace gfx
@@ -13,6 +14,9 @@ namespace redc { namespace gfx
     Vec<std::size_t> extents;
   };
   Image load_png_data(std::string filename);
+  // Decodes a png that's already in memory, name is just for errors.
+  Image load_png_data(uint8_t const* data, std::size_t size,
+                      std::string const& name);
   void blit_image(ITexture& t, Image const& img);
 
   void allocate_cube_map(ITexture& t, Vec<std::size_t> const& img);
@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2016 Luke San Antonio
+ * All rights reserved.
+ */
+#include "texture_mips.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+namespace redc { namespace gfx
+{
+  namespace
+  {
+    float srgb_to_linear(float c) noexcept
+    {
+      if(c <= 0.04045f) return c / 12.92f;
+      return std::pow((c + 0.055f) / 1.055f, 2.4f);
+    }
+    float linear_to_srgb(float c) noexcept
+    {
+      if(c <= 0.0031308f) return c * 12.92f;
+      return 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+    }
+
+    std::array<float, 256> make_srgb_table() noexcept
+    {
+      std::array<float, 256> table;
+      for(int i = 0; i < 256; ++i) table[i] = srgb_to_linear(i / 255.0f);
+      return table;
+    }
+
+    Color::c_t to_byte(float c) noexcept
+    {
+      c = std::min(std::max(c, 0.0f), 1.0f);
+      return static_cast<Color::c_t>(c * 255.0f + 0.5f);
+    }
+
+    Image downsample(Image const& src,
+                     std::array<float, 256> const& to_linear) noexcept
+    {
+      Image dst;
+      dst.extents.x = std::max<std::size_t>(src.extents.x / 2, 1);
+      dst.extents.y = std::max<std::size_t>(src.extents.y / 2, 1);
+      dst.data.resize(dst.extents.x * dst.extents.y);
+
+      for(std::size_t y = 0; y < dst.extents.y; ++y)
+      {
+        for(std::size_t x = 0; x < dst.extents.x; ++x)
+        {
+          float r = 0.0f, g = 0.0f, b = 0.0f, a = 0.0f;
+          float plain_r = 0.0f, plain_g = 0.0f, plain_b = 0.0f;
+
+          // Odd sizes just lose the last row or column, when the source is
+          // one pixel wide or tall we use the same pixel twice.
+          for(std::size_t sy = 0; sy < 2; ++sy)
+          {
+            for(std::size_t sx = 0; sx < 2; ++sx)
+            {
+              std::size_t px = std::min(x * 2 + sx, src.extents.x - 1);
+              std::size_t py = std::min(y * 2 + sy, src.extents.y - 1);
+              Color const& c = src.data[py * src.extents.x + px];
+
+              float alpha = c.a / 255.0f;
+              r += to_linear[c.r] * alpha;
+              g += to_linear[c.g] * alpha;
+              b += to_linear[c.b] * alpha;
+              a += alpha;
+
+              plain_r += to_linear[c.r];
+              plain_g += to_linear[c.g];
+              plain_b += to_linear[c.b];
+            }
+          }
+
+          // Completely transparent pixels still have some color.
+          if(a > 0.0f)
+          {
+            r /= a;
+            g /= a;
+            b /= a;
+          }
+          else
+          {
+            r = plain_r / 4.0f;
+            g = plain_g / 4.0f;
+            b = plain_b / 4.0f;
+          }
+
+          Color& out = dst.data[y * dst.extents.x + x];
+          out.r = to_byte(linear_to_srgb(r));
+          out.g = to_byte(linear_to_srgb(g));
+          out.b = to_byte(linear_to_srgb(b));
+          out.a = to_byte(a / 4.0f);
+        }
+      }
+      return dst;
+    }
+  }
+
+  void flip_image_rows(Image& image) noexcept
+  {
+    for(std::size_t y = 0; y < image.extents.y / 2; ++y)
+    {
+      auto top = image.data.begin() + y * image.extents.x;
+      auto bottom = image.data.begin() +
+                    (image.extents.y - y - 1) * image.extents.x;
+      std::swap_ranges(top, top + image.extents.x, bottom);
+    }
+  }
+
+  unsigned int num_mip_levels(Vec<std::size_t> const& extents) noexcept
+  {
+    std::size_t size = std::max(extents.x, extents.y);
+    unsigned int levels = 1;
+    while(size > 1)
+    {
+      size /= 2;
+      ++levels;
+    }
+    return levels;
+  }
+
+  std::vector<Image> generate_srgb_mips(Image const& base) noexcept
+  {
+    static const std::array<float, 256> to_linear = make_srgb_table();
+
+    std::vector<Image> ret;
+    if(base.data.empty()) return ret;
+
+    // We keep a pointer to the last one, so don't reallocate.
+    ret.reserve(num_mip_levels(base.extents) - 1);
+
+    Image const* prev = &base;
+    while(prev->extents.x > 1 || prev->extents.y > 1)
+    {
+      ret.push_back(downsample(*prev, to_linear));
+      prev = &ret.back();
+    }
+    return ret;
+  }
+} }
@@ -0,0 +1,26 @@
+/*
+ * Copyright (C) 2016 Luke San Antonio
+ * All rights reserved.
+ */
+#ifndef REDC_GFX_EXTRA_TEXTURE_MIPS_H
+#define REDC_GFX_EXTRA_TEXTURE_MIPS_H
+#include <vector>
+#include "texture_load.h"
+namespace redc { namespace gfx
+{
+  // Images are loaded top row first, but GL wants the bottom row first.
+  void flip_image_rows(Image& image) noexcept;
+
+  // How many levels a full mip chain has, including the base.
+  unsigned int num_mip_levels(Vec<std::size_t> const& extents) noexcept;
+
+  /*!
+   * \brief Generates every mip level after the base down to 1x1.
+   *
+   * Colors are sRGB encoded, so they are box filtered in linear space and
+   * weighted by alpha. Otherwise everything gets darker each level and
+   * transparent pixels bleed their color into their neighbors.
+   */
+  std::vector<Image> generate_srgb_mips(Image const& base) noexcept;
+} }
+#endif
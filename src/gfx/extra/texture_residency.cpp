@@ -0,0 +1,225 @@
+/*
+ * Copyright (C) 2016 Luke San Antonio
+ * All rights reserved.
+ */
+#include "texture_residency.h"
+#include <algorithm>
+#include <cmath>
+#include <queue>
+#include "../../common/debugging.h"
+namespace redc { namespace gfx
+{
+  Texture_Residency::Texture_Residency(std::size_t budget) noexcept
+    : budget_(budget) {}
+
+  Texture_Residency::tex_id
+  Texture_Residency::add(Vec<std::size_t> const& extents,
+                         std::vector<std::size_t> level_sizes) noexcept
+  {
+    REDC_ASSERT_MSG(!level_sizes.empty(), "Textures need at least one level");
+
+    tex_id id;
+    if(free_ids_.empty())
+    {
+      id = textures_.size();
+      textures_.emplace_back();
+    }
+    else
+    {
+      id = free_ids_.back();
+      free_ids_.pop_back();
+    }
+
+    Texture& tex = textures_[id];
+    tex.valid = true;
+    tex.max_extent = std::max(extents.x, extents.y);
+    tex.level_sizes = std::move(level_sizes);
+
+    unsigned int num_levels = tex.level_sizes.size();
+    tex.tail = 0;
+    while(tex.tail + 1 < num_levels &&
+          (tex.max_extent >> tex.tail) > RESIDENCY_TAIL_EXTENT)
+    {
+      ++tex.tail;
+    }
+
+    tex.resident = num_levels;
+    tex.wanted = tex.tail;
+    tex.max_projected_size = 0.0f;
+    tex.last_used = 0;
+    tex.lru_pos = lru_.insert(lru_.end(), id);
+    return id;
+  }
+
+  void Texture_Residency::remove(tex_id id) noexcept
+  {
+    REDC_ASSERT(id < textures_.size() && textures_[id].valid);
+    Texture& tex = textures_[id];
+
+    for(unsigned int i = tex.resident; i < tex.level_sizes.size(); ++i)
+    {
+      resident_bytes_ -= tex.level_sizes[i];
+    }
+    lru_.erase(tex.lru_pos);
+
+    tex.valid = false;
+    tex.level_sizes.clear();
+    free_ids_.push_back(id);
+  }
+
+  void Texture_Residency::report(tex_id id, float projected_size) noexcept
+  {
+    REDC_ASSERT(id < textures_.size() && textures_[id].valid);
+    Texture& tex = textures_[id];
+
+    tex.max_projected_size = std::max(tex.max_projected_size, projected_size);
+    if(tex.last_used != frame_)
+    {
+      tex.last_used = frame_;
+      lru_.splice(lru_.begin(), lru_, tex.lru_pos);
+    }
+  }
+
+  void Texture_Residency::compute_wanted_(Texture& tex) noexcept
+  {
+    // Nobody drew it, so it only needs the tail.
+    if(tex.last_used != frame_ || tex.max_projected_size <= 0.0f)
+    {
+      tex.wanted = tex.tail;
+      return;
+    }
+
+    // Each level halves the texels, so the level that's about one texel per
+    // pixel is log2 of how much bigger the base is than the screen.
+    float ratio = tex.max_extent / tex.max_projected_size;
+    unsigned int level = 0;
+    if(ratio > 1.0f) level = static_cast<unsigned int>(std::log2(ratio));
+    tex.wanted = std::min(level, tex.tail);
+  }
+
+  void Texture_Residency::upload_(tex_id id,
+                                  std::vector<Change>& changes) noexcept
+  {
+    Texture& tex = textures_[id];
+    REDC_ASSERT(tex.resident > 0);
+
+    --tex.resident;
+    resident_bytes_ += tex.level_sizes[tex.resident];
+    changes.push_back({Change::Upload, id, tex.resident});
+  }
+  void Texture_Residency::evict_(tex_id id,
+                                 std::vector<Change>& changes) noexcept
+  {
+    Texture& tex = textures_[id];
+    REDC_ASSERT(tex.resident < tex.tail);
+
+    resident_bytes_ -= tex.level_sizes[tex.resident];
+    changes.push_back({Change::Evict, id, tex.resident});
+    ++tex.resident;
+  }
+
+  bool Texture_Residency::make_room_(std::size_t size, tex_id requester,
+                                     std::vector<Change>& changes) noexcept
+  {
+    if(resident_bytes_ + size <= budget_) return true;
+
+    // Least recently used first. Anything drawn this frame only gives up
+    // what it has beyond what it wants.
+    for(auto it = lru_.rbegin(); it != lru_.rend(); ++it)
+    {
+      if(*it == requester) continue;
+
+      Texture& tex = textures_[*it];
+      unsigned int limit = tex.last_used == frame_ ? tex.wanted : tex.tail;
+      while(tex.resident < limit && resident_bytes_ + size > budget_)
+      {
+        evict_(*it, changes);
+      }
+      if(resident_bytes_ + size <= budget_) return true;
+    }
+    return false;
+  }
+
+  std::vector<Texture_Residency::Change>
+  Texture_Residency::step(std::size_t upload_budget) noexcept
+  {
+    std::vector<Change> changes;
+
+    for(Texture& tex : textures_)
+    {
+      if(tex.valid) compute_wanted_(tex);
+    }
+
+    // New textures get their tail no matter what, there would be nothing to
+    // draw otherwise.
+    for(tex_id id = 0; id < textures_.size(); ++id)
+    {
+      Texture& tex = textures_[id];
+      if(!tex.valid) continue;
+      while(tex.resident > tex.tail)
+      {
+        make_room_(tex.level_sizes[tex.resident - 1], id, changes);
+        upload_(id, changes);
+      }
+    }
+
+    // Then whatever is the furthest from where it wants to be goes first.
+    auto further = [this](tex_id lhs, tex_id rhs)
+    {
+      Texture const& l = textures_[lhs];
+      Texture const& r = textures_[rhs];
+      unsigned int l_gap = l.resident - l.wanted;
+      unsigned int r_gap = r.resident - r.wanted;
+      if(l_gap != r_gap) return l_gap < r_gap;
+      return l.max_projected_size < r.max_projected_size;
+    };
+    std::priority_queue<tex_id, std::vector<tex_id>, decltype(further)>
+      queue(further);
+    for(tex_id id = 0; id < textures_.size(); ++id)
+    {
+      Texture const& tex = textures_[id];
+      if(tex.valid && tex.wanted < tex.resident) queue.push(id);
+    }
+
+    std::size_t spent = 0;
+    while(!queue.empty())
+    {
+      tex_id id = queue.top();
+      queue.pop();
+
+      Texture& tex = textures_[id];
+      std::size_t size = tex.level_sizes[tex.resident - 1];
+
+      // Always upload something, otherwise levels bigger than the upload
+      // budget would never make it.
+      if(spent > 0 && spent + size > upload_budget) break;
+      if(!make_room_(size, id, changes)) continue;
+
+      upload_(id, changes);
+      spent += size;
+
+      if(tex.wanted < tex.resident) queue.push(id);
+    }
+
+    for(Texture& tex : textures_) tex.max_projected_size = 0.0f;
+    ++frame_;
+
+    return changes;
+  }
+
+  unsigned int Texture_Residency::resident_level(tex_id id) const noexcept
+  {
+    REDC_ASSERT(id < textures_.size() && textures_[id].valid);
+    return textures_[id].resident;
+  }
+  unsigned int Texture_Residency::wanted_level(tex_id id) const noexcept
+  {
+    REDC_ASSERT(id < textures_.size() && textures_[id].valid);
+    return textures_[id].wanted;
+  }
+  unsigned int Texture_Residency::tail_level(tex_id id) const noexcept
+  {
+    REDC_ASSERT(id < textures_.size() && textures_[id].valid);
+    return textures_[id].tail;
+  }
+} }
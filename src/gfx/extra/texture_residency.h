@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2016 Luke San Antonio
+ * All rights reserved.
+ */
+#ifndef REDC_GFX_EXTRA_TEXTURE_RESIDENCY_H
+#define REDC_GFX_EXTRA_TEXTURE_RESIDENCY_H
+#include <cstdint>
+#include <list>
+#include <vector>
+#include "../../common/vec.h"
+namespace redc { namespace gfx
+{
+  // Levels this small or smaller are always resident, so there is always
+  // something to draw.
+  constexpr std::size_t RESIDENCY_TAIL_EXTENT = 32;
+
+  /*!
+   * \brief Decides which mip levels of streamed textures should be resident.
+   *
+   * This doesn't touch the driver at all, it only says what to upload and
+   * what to evict. Every frame the renderer reports how big each texture is
+   * on screen, then step is called and the returned changes applied in
+   * order.
+   *
+   * A texture's resident levels are always the smallest ones up to some
+   * level, so levels are uploaded from small to big and evicted from big to
+   * small. When an upload wouldn't fit in the budget, top levels of the
+   * least recently used textures are evicted to make room.
+   */
+  struct Texture_Residency
+  {
+    using tex_id = unsigned int;
+
+    struct Change
+    {
+      enum Type
+      {
+        Upload,
+        Evict
+      } type;
+      tex_id id;
+      unsigned int level;
+    };
+
+    explicit Texture_Residency(std::size_t budget) noexcept;
+
+    // Sizes in bytes of every level, base first. Nothing is resident until
+    // the next step.
+    tex_id add(Vec<std::size_t> const& extents,
+               std::vector<std::size_t> level_sizes) noexcept;
+    // Its levels stop counting against the budget immediately.
+    void remove(tex_id id) noexcept;
+
+    // The biggest the texture is on screen this frame, along its longest
+    // side in pixels. Textures that are never reported stay at their tail.
+    void report(tex_id id, float projected_size) noexcept;
+
+    // Spend at most upload_budget bytes on uploads, except that the tail of
+    // new textures is always uploaded.
+    std::vector<Change> step(std::size_t upload_budget) noexcept;
+
+    // The biggest level resident, or the number of levels when there are
+    // none.
+    unsigned int resident_level(tex_id id) const noexcept;
+    // The level the texture wanted as of the last step.
+    unsigned int wanted_level(tex_id id) const noexcept;
+    unsigned int tail_level(tex_id id) const noexcept;
+
+    std::size_t resident_bytes() const noexcept { return resident_bytes_; }
+    std::size_t budget() const noexcept { return budget_; }
+    void budget(std::size_t b) noexcept { budget_ = b; }
+
+  private:
+    struct Texture
+    {
+      bool valid = false;
+
+      std::size_t max_extent;
+      std::vector<std::size_t> level_sizes;
+      unsigned int tail;
+
+      unsigned int resident;
+      unsigned int wanted;
+
+      float max_projected_size;
+      unsigned long last_used;
+
+      std::list<tex_id>::iterator lru_pos;
+    };
+
+    void compute_wanted_(Texture& tex) noexcept;
+    void upload_(tex_id id, std::vector<Change>& changes) noexcept;
+    void evict_(tex_id id, std::vector<Change>& changes) noexcept;
+    bool make_room_(std::size_t size, tex_id requester,
+                    std::vector<Change>& changes) noexcept;
+
+    std::vector<Texture> textures_;
+    std::vector<tex_id> free_ids_;
+
+    // Most recently used at the front.
+    std::list<tex_id> lru_;
+
+    std::size_t budget_;
+    std::size_t resident_bytes_ = 0;
+
+    unsigned long frame_ = 1;
+  };
+} }
+#endif
@@ -4,6 +4,15 @@
  */
 #include "common.h"
 #include "../../common/debugging.h"
+
+// These come from EXT_texture_sRGB, which glad doesn't know about but every
+// driver with S3TC supports anyway.
+#ifndef GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT 0x8C4D
+#endif
+#ifndef GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 0x8C4F
+#endif
 namespace redc { namespace gfx { namespace gl
 {
   GLenum to_gl_buffer_target(Buffer_Target target)
@@ -95,6 +104,10 @@ namespace redc { namespace gfx { namespace gl
       return GL_RED;
     case Texture_Format::Rgba32F:
       return GL_RGBA32F;
+    case Texture_Format::Bc1_Srgb_Alpha:
+      return GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT;
+    case Texture_Format::Bc3_Srgb_Alpha:
+      return GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT;
     default:
       REDC_UNREACHABLE_MSG("Unknown texture format");
       return GL_ZERO;
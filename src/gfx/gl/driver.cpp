@@ -8,6 +8,7 @@
 #include "shader.h"
 #include "buffer.h"
 #include "framebuffer.h"
+#include "program_cache.h"
 
 #include "common.h"
 
@@ -331,6 +332,18 @@ namespace redc
           log_e("OpenGL: Invalid operation");
         }
       }
+
+      bool Driver::use_program_cache(std::string const& dir)
+      {
+        if(!Program_Cache::supported())
+        {
+          log_i("Program binaries aren't supported, shaders will be compiled "
+                "every time");
+          return false;
+        }
+        program_cache_ = std::make_unique<Program_Cache>(dir);
+        return true;
+      }
     }
   }
 }
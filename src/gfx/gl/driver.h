@@ -3,6 +3,8 @@
  * All rights reserved.
  */
 #pragma once
+#include <memory>
+#include <string>
 #include <unordered_map>
 #include "../idriver.h"
 #include "glad/glad.h"
@@ -13,6 +15,7 @@ namespace redc
     namespace gl
     {
       struct Driver;
+      struct Program_Cache;
     }
   }
 
@@ -73,6 +76,11 @@ namespace redc
 
     void check_error() override;
 
+    // Shaders linked from now on go through a program binary cache in the
+    // given directory, if the driver supports it. Returns false otherwise.
+    bool use_program_cache(std::string const& dir);
+    Program_Cache* program_cache() const { return program_cache_.get(); }
+
   private:
     // Store state so we can avoid draw calls.
     GLenum cur_buffer_target_;
@@ -89,5 +97,7 @@ namespace redc
     IFramebuffer* bound_framebuffer_;
 
     bool is_default_draw_buffers_ = true;
+
+    std::unique_ptr<Program_Cache> program_cache_;
   };
 }
@@ -0,0 +1,202 @@
+/*
+ * Copyright (C) 2016 Luke San Antonio
+ * All rights reserved.
+ */
+#include "program_cache.h"
+
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+#include <boost/filesystem/fstream.hpp>
+
+#include "../../assets/mapped_file.h"
+#include "../../common/hash.h"
+#include "../../common/log.h"
+#include "../../common/timer.hpp"
+
+namespace redc { namespace gfx { namespace gl
+{
+  namespace fs = boost::filesystem;
+
+  namespace
+  {
+    // Written as is, like the asset cache header. The binary follows.
+    struct Program_Binary_Header
+    {
+      char magic[4];
+      uint32_t cache_version;
+
+      uint64_t key;
+
+      uint32_t binary_format;
+      // How long it took to compile and link the program in the first place.
+      uint32_t compile_us;
+
+      uint64_t binary_size;
+    };
+
+    constexpr char PROGRAM_BINARY_MAGIC[4] = {'R', 'C', 'P', 'B'};
+
+    uint64_t hash_gl_string(GLenum name, uint64_t seed) noexcept
+    {
+      auto str = reinterpret_cast<char const*>(glGetString(name));
+      if(!str) return seed;
+      return xxhash64(str, std::strlen(str), seed);
+    }
+
+    float to_ms(Program_Cache::duration_t time) noexcept
+    {
+      return time.count() / 1000.0f;
+    }
+  }
+
+  Program_Cache::Program_Cache(fs::path dir) : dir_(std::move(dir))
+  {
+    boost::system::error_code err;
+    fs::create_directories(dir_, err);
+
+    driver_hash_ = PROGRAM_CACHE_VERSION;
+    driver_hash_ = hash_gl_string(GL_VENDOR, driver_hash_);
+    driver_hash_ = hash_gl_string(GL_RENDERER, driver_hash_);
+    driver_hash_ = hash_gl_string(GL_VERSION, driver_hash_);
+  }
+
+  bool Program_Cache::supported()
+  {
+    if(!GLAD_GL_VERSION_4_1 && !GLAD_GL_ARB_get_program_binary) return false;
+
+    GLint num_formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &num_formats);
+    return num_formats > 0;
+  }
+
+  uint64_t Program_Cache::add_to_key(uint64_t key, GLenum part,
+                                     char const* source,
+                                     std::size_t size) const noexcept
+  {
+    uint32_t header[2] = {part, static_cast<uint32_t>(size)};
+    key = xxhash64(&header[0], sizeof(header), key);
+    return xxhash64(source, size, key);
+  }
+
+  fs::path Program_Cache::entry_path_(uint64_t key) const
+  {
+    std::ostringstream name;
+    name << std::hex << std::setw(16) << std::setfill('0') << key << ".bin";
+    return dir_ / name.str();
+  }
+
+  bool Program_Cache::load(uint64_t key, GLuint program)
+  {
+    Timer<> timer;
+
+    auto path = entry_path_(key);
+
+    assets::Mapped_File file;
+    if(!exists(path) || !file.open(path.string()))
+    {
+      ++misses_;
+      return false;
+    }
+
+    Program_Binary_Header header;
+    bool valid = file.size() >= sizeof(header);
+    if(valid)
+    {
+      std::memcpy(&header, file.data(), sizeof(header));
+      valid = std::memcmp(header.magic, PROGRAM_BINARY_MAGIC,
+                          sizeof(PROGRAM_BINARY_MAGIC)) == 0 &&
+              header.cache_version == PROGRAM_CACHE_VERSION &&
+              header.key == key &&
+              header.binary_size <= file.size() - sizeof(header);
+    }
+
+    GLint linked = GL_FALSE;
+    if(valid)
+    {
+      glProgramBinary(program, header.binary_format,
+                      file.data() + sizeof(header), header.binary_size);
+      glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    }
+
+    if(linked == GL_FALSE)
+    {
+      log_i("Ignoring stale program binary '%'", path.string());
+
+      // Get rid of it so we don't try again next time, the new binary is
+      // written in its place anyway.
+      boost::system::error_code err;
+      fs::remove(path, err);
+
+      ++misses_;
+      return false;
+    }
+
+    auto took = timer.has_been<duration_t>();
+    auto compile_time = duration_t(header.compile_us);
+
+    ++hits_;
+    load_time_ += took;
+    if(compile_time > took) saved_time_ += compile_time - took;
+
+    log_d("Loaded program % from the cache in %ms (compiling took %ms)",
+          path.filename().string(), to_ms(took), to_ms(compile_time));
+    return true;
+  }
+
+  void Program_Cache::store(uint64_t key, GLuint program,
+                            duration_t compile_time)
+  {
+    compile_time_ += compile_time;
+
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if(length <= 0) return;
+
+    std::vector<char> binary(length);
+    GLsizei written = 0;
+    GLenum format = 0;
+    glGetProgramBinary(program, length, &written, &format, &binary[0]);
+    if(written <= 0) return;
+
+    Program_Binary_Header header;
+    std::memcpy(header.magic, PROGRAM_BINARY_MAGIC,
+                sizeof(PROGRAM_BINARY_MAGIC));
+    header.cache_version = PROGRAM_CACHE_VERSION;
+    header.key = key;
+    header.binary_format = format;
+    header.compile_us = compile_time.count();
+    header.binary_size = written;
+
+    // Same as the asset cache, write somewhere else and move it into place.
+    auto path = entry_path_(key);
+    fs::path temp_path = path;
+    temp_path += ".tmp";
+
+    fs::ofstream st(temp_path, std::ios_base::out | std::ios_base::binary);
+    st.write(reinterpret_cast<char const*>(&header), sizeof(header));
+    st.write(&binary[0], written);
+
+    bool good = st.good();
+    st.close();
+
+    boost::system::error_code err;
+    if(good) fs::rename(temp_path, path, err);
+    if(!good || err)
+    {
+      log_w("Failed to write program binary '%'", path.string());
+      fs::remove(temp_path, err);
+    }
+  }
+
+  void Program_Cache::log_totals() const
+  {
+    if(hits_ == 0 && misses_ == 0) return;
+
+    log_i("Shader programs: % from the cache in %ms, % compiled in %ms, "
+          "saved about %ms", hits_, to_ms(load_time_), misses_,
+          to_ms(compile_time_), to_ms(saved_time_));
+  }
+} } }
@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2016 Luke San Antonio
+ * All rights reserved.
+ */
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <boost/filesystem.hpp>
+#include "glad/glad.h"
+namespace redc { namespace gfx { namespace gl
+{
+  // Bump this whenever the way programs are keyed or stored changes.
+  constexpr uint32_t PROGRAM_CACHE_VERSION = 1;
+
+  /*!
+   * \brief Keeps linked program binaries on disk so we can skip compiling.
+   *
+   * Entries are keyed by a hash of every shader part and the vendor,
+   * renderer and version strings of the driver, so a driver update just
+   * misses. Drivers are also free to reject binaries they made themselves,
+   * in that case the caller compiles like normal and stores the new binary.
+   */
+  struct Program_Cache
+  {
+    using duration_t = std::chrono::microseconds;
+
+    explicit Program_Cache(boost::filesystem::path dir);
+
+    // Needs ARB_get_program_binary with at least one binary format, some
+    // drivers advertise the extension without supporting any.
+    static bool supported();
+
+    // Start a new key, then add every part in the order it's attached.
+    uint64_t begin_key() const noexcept { return driver_hash_; }
+    uint64_t add_to_key(uint64_t key, GLenum part, char const* source,
+                        std::size_t size) const noexcept;
+
+    // Returns true if the program is linked from a cached binary, otherwise
+    // it should be compiled and linked like normal.
+    bool load(uint64_t key, GLuint program);
+    // Program must have been linked successfully, with the retrievable hint
+    // set beforehand. Time is how long compiling and linking took, it's kept
+    // so we can tell how much a hit saves.
+    void store(uint64_t key, GLuint program, duration_t compile_time);
+
+    // How long we spent on programs so far and roughly how much the cache
+    // saved us.
+    void log_totals() const;
+  private:
+    boost::filesystem::path entry_path_(uint64_t key) const;
+
+    boost::filesystem::path dir_;
+    uint64_t driver_hash_;
+
+    unsigned int hits_ = 0;
+    unsigned int misses_ = 0;
+    duration_t load_time_{0};
+    duration_t compile_time_{0};
+    duration_t saved_time_{0};
+  };
+} } }
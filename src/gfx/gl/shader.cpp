@@ -9,7 +9,9 @@
 #include "glad/glad.h"
 
 #include "../../common/log.h"
+#include "../../common/timer.hpp"
 #include "driver.h"
+#include "program_cache.h"
 
 #include "../../common/debugging.h"
 
@@ -83,6 +85,10 @@ namespace redc { namespace gfx { namespace gl
   }
   GL_Shader::GL_Shader(Driver& d) : driver_(&d)
   {
+    parts_[0].type = GL_VERTEX_SHADER;
+    parts_[1].type = GL_FRAGMENT_SHADER;
+    parts_[2].type = GL_GEOMETRY_SHADER;
+
     allocate_shader_();
   }
   GL_Shader::~GL_Shader()
@@ -100,9 +106,13 @@ namespace redc { namespace gfx { namespace gl
     tags.clear();
 
     if(prog_) glDeleteProgram(prog_);
-    if(g_shade_) glDeleteShader(g_shade_);
-    if(f_shade_) glDeleteShader(f_shade_);
-    if(v_shade_) glDeleteShader(v_shade_);
+    for(Part& part : parts_)
+    {
+      if(part.shade) glDeleteShader(part.shade);
+      part.shade = 0;
+      part.loaded = false;
+      part.source.clear();
+    }
   }
 
   void GL_Shader::reinitialize()
@@ -112,43 +122,46 @@ namespace redc { namespace gfx { namespace gl
   }
 
   void GL_Shader::load_part(shader_source_t const& source, std::string name,
-                            GLenum part, GLuint& shade_obj)
+                            Part& part)
   {
-    // If the shader hasn't been created yet
-    if(!shade_obj)
-    {
-      // Create a new shader
-      shade_obj = glCreateShader(part);
-    }
-
-    // Attach it to our program
-    glAttachShader(prog_, shade_obj);
-
-    // Compile the shader with the given code
-    compile_shader(shade_obj, source, name);
+    // Hold on to it until we know whether the program is cached.
+    part.source = source;
+    part.name = std::move(name);
+    part.loaded = true;
   }
   void GL_Shader::load_vertex_part(shader_source_t const& code,
                                    std::string const& name)
   {
-    load_part(code, name, GL_VERTEX_SHADER, v_shade_);
+    load_part(code, name, parts_[0]);
   }
   void GL_Shader::load_fragment_part(shader_source_t const& code,
                                      std::string const& name)
   {
-    load_part(code, name, GL_FRAGMENT_SHADER, f_shade_);
+    load_part(code, name, parts_[1]);
   }
   void GL_Shader::load_geometry_part(shader_source_t const& code,
                                      std::string const& name)
   {
-    load_part(code, name, GL_GEOMETRY_SHADER, g_shade_);
+    load_part(code, name, parts_[2]);
   }
 
-  bool GL_Shader::link()
+  bool GL_Shader::compile_and_link_()
   {
-    // Make sure we have a vertex and fragment shader, otherwise we know it's
-    // not going to work.
-    REDC_ASSERT_MSG(v_shade_, "OpenGL shader program must have vertex shader");
-    REDC_ASSERT_MSG(f_shade_, "OpenGL shader program must have fragment shader");
+    for(Part& part : parts_)
+    {
+      if(!part.loaded) continue;
+
+      // If the shader hasn't been created yet
+      if(!part.shade)
+      {
+        // Create a new shader and attach it to our program
+        part.shade = glCreateShader(part.type);
+        glAttachShader(prog_, part.shade);
+      }
+
+      // Compile the shader with the given code
+      compile_shader(part.shade, part.source, part.name);
+    }
 
     // Attempt the link
     glLinkProgram(prog_);
@@ -173,11 +186,56 @@ namespace redc { namespace gfx { namespace gl
 
         log_e("Program link failed (info log):\n%", info_log);
       }
+      return false;
     }
-    else
+    return true;
+  }
+
+  bool GL_Shader::link()
+  {
+    // Make sure we have a vertex and fragment shader, otherwise we know it's
+    // not going to work.
+    REDC_ASSERT_MSG(vertex_part_().loaded,
+                    "OpenGL shader program must have vertex shader");
+    REDC_ASSERT_MSG(fragment_part_().loaded,
+                    "OpenGL shader program must have fragment shader");
+
+    Program_Cache* cache = driver_->program_cache();
+
+    // Everything that goes into the program goes into the key. Attribute
+    // locations are given with layout qualifiers so the source covers them.
+    uint64_t key = 0;
+    if(cache)
+    {
+      key = cache->begin_key();
+      for(Part const& part : parts_)
+      {
+        if(!part.loaded) continue;
+        key = cache->add_to_key(key, part.type, part.source.data(),
+                                part.source.size());
+      }
+    }
+
+    if(cache && cache->load(key, prog_))
     {
       linked_ = true;
     }
+    else
+    {
+      Timer<> timer;
+
+      // Otherwise the driver may not bother keeping the binary around.
+      if(cache)
+      {
+        glProgramParameteri(prog_, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+      }
+
+      linked_ = compile_and_link_();
+      if(linked_ && cache)
+      {
+        cache->store(key, prog_, timer.has_been<Program_Cache::duration_t>());
+      }
+    }
 
     // The tags are going to be invalid after a new link.
     tags.clear();
@@ -3,6 +3,7 @@
  * All rights reserved.
  */
 #pragma once
+#include <array>
 #include <unordered_map>
 #include "../ishader.h"
 #include "glad/glad.h"
@@ -76,10 +77,22 @@ namespace redc { namespace gfx { namespace gl
   private:
     Driver* driver_;
 
-    // Shader objects
-    GLuint v_shade_ = 0;
-    GLuint f_shade_ = 0;
-    GLuint g_shade_ = 0;
+    // Parts are only compiled when we link, and not at all when the program
+    // binary is cached.
+    struct Part
+    {
+      GLenum type;
+      shader_source_t source;
+      std::string name;
+
+      bool loaded = false;
+      // Shader object
+      GLuint shade = 0;
+    };
+    std::array<Part, 3> parts_;
+
+    Part& vertex_part_() { return parts_[0]; }
+    Part& fragment_part_() { return parts_[1]; }
 
     // Program object
     GLuint prog_;
@@ -95,6 +108,7 @@ namespace redc { namespace gfx { namespace gl
     std::unordered_map<tag_t, std::string> tag_vars_;
 
     void load_part(shader_source_t const& source, std::string name,
-                   GLenum part, GLuint& shade_obj);
+                   Part& part);
+    bool compile_and_link_();
   };
 } } }
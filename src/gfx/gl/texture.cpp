@@ -78,6 +78,26 @@ namespace redc { namespace gfx { namespace gl
     driver_->bind_texture(*this, this->gl_target);
     glTexParameteri(this->gl_target, GL_TEXTURE_MAX_LEVEL, level);
   }
+  void GL_Texture::set_base_mipmap_level(unsigned int level)
+  {
+    driver_->bind_texture(*this, this->gl_target);
+    glTexParameteri(this->gl_target, GL_TEXTURE_BASE_LEVEL, level);
+  }
+
+  void GL_Texture::release_tex2d_level(unsigned int level)
+  {
+    if(gl_target != GL_TEXTURE_2D)
+    {
+      log_d("Trying to release a level of a non-2d texture");
+      return;
+    }
+
+    // Respecifying the level as empty is the only way to give its memory
+    // back short of making a new texture.
+    driver_->bind_texture(*this, gl_target);
+    glTexImage2D(gl_target, level, GL_RGBA8, 0, 0, 0, GL_RGBA,
+                 GL_UNSIGNED_BYTE, NULL);
+  }
 
   void GL_Texture::allocate_(Vec<std::size_t> const& extents,
                              Texture_Format form,
@@ -174,6 +194,61 @@ namespace redc { namespace gfx { namespace gl
     delete[] out_data;
   }
 
+  void GL_Texture::blit_tex2d_level_(unsigned int level,
+                                     Vec<std::size_t> const& extents,
+                                     Texture_Format internal_format,
+                                     Texture_Format data_format,
+                                     Data_Type data_type,
+                                     void const* data)
+  {
+    if(level == 0)
+    {
+      gl_target = GL_TEXTURE_2D;
+      format = internal_format;
+    }
+    if(gl_target != GL_TEXTURE_2D)
+    {
+      log_d("Trying to blit 2D data to non-2d texture");
+      return;
+    }
+
+    driver_->bind_texture(*this, gl_target);
+
+    // Levels aren't necessarily four byte aligned, the small ones especially.
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(gl_target, level, to_gl_texture_format(internal_format),
+                 extents.x, extents.y, 0, to_gl_texture_format(data_format),
+                 to_gl_data_type(data_type), data);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  }
+  void GL_Texture::blit_compressed_tex2d_level_(unsigned int level,
+                                                Vec<std::size_t> const& extents,
+                                                Texture_Format data_format,
+                                                std::size_t size,
+                                                void const* data)
+  {
+    if(level == 0)
+    {
+      gl_target = GL_TEXTURE_2D;
+      format = data_format;
+    }
+    if(gl_target != GL_TEXTURE_2D)
+    {
+      log_d("Trying to blit 2D data to non-2d texture");
+      return;
+    }
+
+    driver_->bind_texture(*this, gl_target);
+    glCompressedTexImage2D(gl_target, level, to_gl_texture_format(data_format),
+                           extents.x, extents.y, 0, size, data);
+  }
+  void GL_Texture::allocate_streamed_(Texture_Format form)
+  {
+    gl_target = GL_TEXTURE_2D;
+    format = form;
+    driver_->bind_texture(*this, gl_target);
+  }
+
   void GL_Texture::blit_cube_data(Cube_Map_Texture const& side,
                                   Volume<std::size_t> const& vol,
                                   Texture_Format data_format,
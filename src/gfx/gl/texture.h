@@ -28,6 +28,9 @@ namespace redc { namespace gfx { namespace gl
     void set_wrap_t(Texture_Wrap wrap) override;
     void set_wrap_r(Texture_Wrap wrap) override;
     void set_mipmap_level(unsigned int level) override;
+    void set_base_mipmap_level(unsigned int level) override;
+
+    void release_tex2d_level(unsigned int level) override;
 
     GLuint tex;
     GLenum gl_target;
@@ -44,6 +47,17 @@ namespace redc { namespace gfx { namespace gl
     virtual void allocate_(Vec<std::size_t> const&, Texture_Format,
                            Texture_Target type) override;
 
+    void blit_tex2d_level_(unsigned int level,
+                           Vec<std::size_t> const& extents,
+                           Texture_Format internal_format,
+                           Texture_Format format, Data_Type type,
+                           void const* data) override;
+    void blit_compressed_tex2d_level_(unsigned int level,
+                                      Vec<std::size_t> const& extents,
+                                      Texture_Format format, std::size_t size,
+                                      void const* data) override;
+    void allocate_streamed_(Texture_Format format) override;
+
     void set_wrap_(GLenum coord,  Texture_Wrap wrap);
   };
 } } }
@@ -168,36 +168,36 @@ namespace redc { namespace gfx
 
   void Live_Shader::set_vertex_file(std::string const& filename)
   {
-    vertex_file_ = std::make_unique<Live_File>(filename);
+    vertex_file_ = std::make_unique<Live_File>(*watcher_, filename);
   }
 
   void Live_Shader::set_fragment_file(std::string const& filename)
   {
-    fragment_file_ = std::make_unique<Live_File>(filename);
+    fragment_file_ = std::make_unique<Live_File>(*watcher_, filename);
   }
   void Live_Shader::set_geometry_file(std::string const& filename)
   {
-    geometry_file_ = std::make_unique<Live_File>(filename);
+    geometry_file_ = std::make_unique<Live_File>(*watcher_, filename);
   }
 
   void Live_Shader::update_sources()
   {
     bool needs_link = false;
-    if(vertex_file_->changed_on_disk())
+    if(vertex_file_ && vertex_file_->changed_on_disk())
     {
       std::ifstream stream = vertex_file_->open_ifstream();
       shader_->load_vertex_part(load_stream(stream),
                                 vertex_file_->filename());
       needs_link = true;
     }
-    if(fragment_file_->changed_on_disk())
+    if(fragment_file_ && fragment_file_->changed_on_disk())
     {
       std::ifstream stream = fragment_file_->open_ifstream();
       shader_->load_fragment_part(load_stream(stream),
                                   fragment_file_->filename());
       needs_link = true;
     }
-    if(geometry_file_->changed_on_disk())
+    if(geometry_file_ && geometry_file_->changed_on_disk())
     {
       std::ifstream stream = geometry_file_->open_ifstream();
       shader_->load_geometry_part(load_stream(stream),
@@ -29,6 +29,8 @@ namespace redc
 
       constexpr const char* dif_tex_tag = "dif_tex";
       constexpr const char* bump_tex_tag = "bump_tex";
+      // Scale in xy, offset in zw. For textures on an atlas page.
+      constexpr const char* uv_transform_tag = "uv_transform";
 
       constexpr const char* envmap_tag = "envmap";
     }
@@ -163,7 +165,9 @@ namespace redc
 
     struct Live_Shader
     {
-      Live_Shader(std::unique_ptr<IShader> shade) : shader_(std::move(shade)) {}
+      Live_Shader(assets::File_Watcher& watcher,
+                  std::unique_ptr<IShader> shade)
+        : watcher_(&watcher), shader_(std::move(shade)) {}
 
       void set_vertex_file(std::string const& filename);
       void set_fragment_file(std::string const& filename);
@@ -171,6 +175,7 @@ namespace redc
 
       void update_sources();
     private:
+      assets::File_Watcher* watcher_;
       std::unique_ptr<IShader> shader_;
 
       std::unique_ptr<Live_File> vertex_file_;
@@ -12,4 +12,37 @@ namespace redc { namespace gfx
     target_ = type;
     allocate_(extents, form, type);
   }
+  void ITexture::blit_tex2d_level(unsigned int level,
+                                  Vec<std::size_t> const& extents,
+                                  Texture_Format internal_format,
+                                  Texture_Format format, Data_Type type,
+                                  void const* data)
+  {
+    if(level == 0)
+    {
+      extents_ = extents;
+      target_ = Texture_Target::Tex_2D;
+    }
+    blit_tex2d_level_(level, extents, internal_format, format, type, data);
+  }
+  void ITexture::blit_compressed_tex2d_level(unsigned int level,
+                                             Vec<std::size_t> const& extents,
+                                             Texture_Format format,
+                                             std::size_t size,
+                                             void const* data)
+  {
+    if(level == 0)
+    {
+      extents_ = extents;
+      target_ = Texture_Target::Tex_2D;
+    }
+    blit_compressed_tex2d_level_(level, extents, format, size, data);
+  }
+  void ITexture::allocate_streamed(Vec<std::size_t> const& extents,
+                                   Texture_Format format)
+  {
+    extents_ = extents;
+    target_ = Texture_Target::Tex_2D;
+    allocate_streamed_(format);
+  }
 } }
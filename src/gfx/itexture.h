@@ -32,6 +32,26 @@ namespace redc { namespace gfx
                                 Texture_Format format, Data_Type type,
                                 void const* data) = 0;
 
+    // These upload a whole mip level of a 2D texture and allocate it at the
+    // same time, so there is no need to call allocate first. Rows are taken
+    // bottom to top, as is, and level 0 should go first.
+    void blit_tex2d_level(unsigned int level, Vec<std::size_t> const& extents,
+                          Texture_Format internal_format,
+                          Texture_Format format, Data_Type type,
+                          void const* data);
+    // Format must be one of the block compressed ones.
+    void blit_compressed_tex2d_level(unsigned int level,
+                                     Vec<std::size_t> const& extents,
+                                     Texture_Format format, std::size_t size,
+                                     void const* data);
+
+    // Makes this a 2D texture whose levels are blit and released in any
+    // order with the above, without allocating any of them.
+    void allocate_streamed(Vec<std::size_t> const& extents,
+                           Texture_Format format);
+    // Frees the storage of a level, it must be below the base level.
+    virtual void release_tex2d_level(unsigned int level) = 0;
+
     inline Vec<int> allocated_extents() const { return extents_; }
 
     virtual void set_mag_filter(Texture_Filter filter) = 0;
@@ -40,11 +60,25 @@ namespace redc { namespace gfx
     virtual void set_wrap_t(Texture_Wrap wrap) = 0;
     virtual void set_wrap_r(Texture_Wrap wrap) = 0;
     virtual void set_mipmap_level(unsigned int level) = 0;
+    // Levels before this one aren't sampled and don't have to exist.
+    virtual void set_base_mipmap_level(unsigned int level) = 0;
 
   private:
     virtual void allocate_(Vec<std::size_t> const&, Texture_Format,
                            Texture_Target) = 0;
 
+    virtual void blit_tex2d_level_(unsigned int level,
+                                   Vec<std::size_t> const& extents,
+                                   Texture_Format internal_format,
+                                   Texture_Format format, Data_Type type,
+                                   void const* data) = 0;
+    virtual void blit_compressed_tex2d_level_(unsigned int level,
+                                              Vec<std::size_t> const& extents,
+                                              Texture_Format format,
+                                              std::size_t size,
+                                              void const* data) = 0;
+    virtual void allocate_streamed_(Texture_Format format) = 0;
+
     Texture_Target target_;
     Vec<int> extents_;
   };
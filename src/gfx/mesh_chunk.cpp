@@ -3,6 +3,7 @@
  * All rights reserved
  */
 #include "mesh_chunk.h"
+#include <algorithm>
 namespace redc { namespace gfx
 {
   Mesh_Chunk copy_mesh_chunk_share_mesh(Mesh_Chunk const& orig) noexcept
@@ -23,6 +24,10 @@ namespace redc { namespace gfx
 
     ret.base_vertex = orig.base_vertex;
 
+    ret.lods = orig.lods;
+    ret.center = orig.center;
+    ret.radius = orig.radius;
+
     return ret;
   }
   Mesh_Chunk copy_mesh_chunk_move_mesh(Mesh_Chunk& orig) noexcept
@@ -39,22 +44,94 @@ namespace redc { namespace gfx
 
     ret.base_vertex = orig.base_vertex;
 
+    ret.lods = orig.lods;
+    ret.center = orig.center;
+    ret.radius = orig.radius;
+
     return ret;
   }
+  namespace
+  {
+    // Lods are picked so their error is less than this many pixels.
+    constexpr float LOD_PIXEL_ERROR = 1.0f;
+    // But we only switch to a coarser one when it's this much less than that.
+    constexpr float LOD_HYSTERESIS = 0.75f;
+
+    void draw_range(Mesh_Chunk const& m, unsigned int start,
+                    unsigned int count) noexcept
+    {
+      if(!m.mesh) return;
+
+      m.mesh->set_primitive_type(m.type);
+
+      // Ahh this function is deprecated as of 1.56 I think
+      if(m.base_vertex.get_value_or(0) == 0)
+      {
+        m.mesh->draw_elements(start, count);
+      }
+      else
+      {
+        m.mesh->draw_elements_base_vertex(start, count, m.base_vertex.get());
+      }
+    }
+  }
+
   void render_chunk(Mesh_Chunk const& m) noexcept
   {
-    if(!m.mesh) return;
+    render_chunk(m, 0);
+  }
+  void render_chunk(Mesh_Chunk const& m, unsigned int lod) noexcept
+  {
+    if(m.lods.empty())
+    {
+      draw_range(m, m.start, m.count);
+      return;
+    }
+
+    // The element array holds every lod back to back, even the full detail
+    // one only gets its own range.
+    if(lod >= m.lods.size()) lod = 0;
+    draw_range(m, m.start + m.lods[lod].start, m.lods[lod].count);
+  }
+
+  float lod_pixels_per_unit(Mesh_Chunk const& chunk, glm::mat4 const& proj,
+                            glm::mat4 const& model_view,
+                            float viewport_height) noexcept
+  {
+    // The model matrix may scale things, use the biggest axis.
+    float scale = std::max(glm::length(glm::vec3(model_view[0])),
+                           std::max(glm::length(glm::vec3(model_view[1])),
+                                    glm::length(glm::vec3(model_view[2]))));
 
-    m.mesh->set_primitive_type(m.type);
+    // This is w in clip space, orthographic projections don't have any.
+    float dist = 1.0f;
+    if(proj[2][3] != 0.0f)
+    {
+      glm::vec4 center = model_view * glm::vec4(chunk.center, 1.0f);
+      // Inside the bounds means we're as close as it gets, don't let it
+      // blow up though.
+      dist = std::max(-center.z - chunk.radius * scale, 0.001f);
+    }
+    return proj[1][1] * viewport_height * 0.5f * scale / dist;
+  }
+
+  unsigned int select_lod(Mesh_Chunk const& chunk, float pixels_per_unit,
+                          unsigned int cur_lod) noexcept
+  {
+    if(chunk.lods.empty()) return 0;
 
-    // Ahh this function is deprecated as of 1.56 I think
-    if(m.base_vertex.get_value_or(0) == 0)
+    unsigned int lod = std::min<unsigned int>(cur_lod, chunk.lods.size() - 1);
+    while(lod > 0 &&
+          chunk.lods[lod].error * pixels_per_unit > LOD_PIXEL_ERROR)
     {
-      m.mesh->draw_elements(m.start, m.count);
+      --lod;
     }
-    else
+    while(lod + 1 < chunk.lods.size() &&
+          chunk.lods[lod + 1].error * pixels_per_unit <
+            LOD_PIXEL_ERROR * LOD_HYSTERESIS)
     {
-      m.mesh->draw_elements_base_vertex(m.start, m.count, m.base_vertex.get());
+      ++lod;
     }
+    return lod;
   }
 } }
@@ -5,6 +5,7 @@
 #pragma once
 #include "imesh.h"
 #include "ibuffer.h"
+#include "mesh_data.h"
 #include "../common/maybe_owned.hpp"
 #include <boost/optional.hpp>
 namespace redc { namespace gfx
@@ -20,6 +21,14 @@ namespace redc { namespace gfx
     Maybe_Owned<IMesh> mesh;
 
     boost::optional<int> base_vertex;
+
+    // Coarser versions of the same chunk, these include the full detail one
+    // first. Empty if there aren't any.
+    std::vector<Mesh_Lod> lods;
+
+    // Bounding sphere in model space, used to pick a lod.
+    glm::vec3 center;
+    float radius = 0.0f;
   };
 
   /*!
@@ -31,5 +40,25 @@ namespace redc { namespace gfx
    */
   Mesh_Chunk copy_mesh_chunk_move_mesh(Mesh_Chunk&) noexcept;
 
+  // Without a lod this draws the full detail one.
   void render_chunk(Mesh_Chunk const&) noexcept;
+  void render_chunk(Mesh_Chunk const&, unsigned int lod) noexcept;
+
+  // How many pixels a unit of the chunk's model space covers on screen, at
+  // the closest point of its bounds.
+  float lod_pixels_per_unit(Mesh_Chunk const& chunk, glm::mat4 const& proj,
+                            glm::mat4 const& model_view,
+                            float viewport_height) noexcept;
+
+  /*!
+   * \brief Picks the coarsest lod whose error is less than about a pixel.
+   *
+   * Going coarser needs the error to be comfortably under a pixel while going
+   * finer happens as soon as it's over, so a chunk sitting right on the edge
+   * doesn't flicker between two of them.
+   *
+   * \param cur_lod The lod that was used last time.
+   */
+  unsigned int select_lod(Mesh_Chunk const& chunk, float pixels_per_unit,
+                          unsigned int cur_lod) noexcept;
 } }
@@ -95,4 +95,16 @@ namespace redc { namespace gfx
 
     Primitive_Type primitive = Primitive_Type::Triangles;
   };
+
+  // A range of elements that draws a coarser version of a mesh with the same
+  // vertices.
+  struct Mesh_Lod
+  {
+    unsigned int start;
+    unsigned int count;
+
+    // Roughly how far the simplified surface strays from the original, in
+    // model units.
+    float error;
+  };
 } }
@@ -10,6 +10,7 @@
 #include <glm/gtc/quaternion.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <boost/variant/get.hpp>
+#include <algorithm>
 
 namespace redc { namespace gfx
 {
@@ -445,60 +446,75 @@ namespace redc { namespace gfx
 
   // = Load functions
 
-  void load_buffers(IDriver& driver, Asset& asset, tinygltf::Scene const& scene)
+  // Returns the amount of bytes uploaded to the GPU.
+  std::size_t load_buffer(IDriver& driver, Asset& asset,
+                          std::string const& name,
+                          tinygltf::BufferView const& buf_view,
+                          tinygltf::Scene const& scene)
   {
-    // Add room for new buffers
-    asset.buffers.reserve(asset.buffers.size() + scene.bufferViews.size());
-    asset.buf_names.reserve(asset.buf_names.size() + scene.bufferViews.size());
+    // Push the name for later cross-referencing, the index of the name in
+    // this vector is the same index of the buffer in the scene.
+    asset.buf_names.push_back(name);
 
-    // We sort of compress the concept of buffers and buffer views.
+    // Form our own buffer
+    Buffer our_buf;
+    // Figure our target - this will affect how we store the data later.
+    our_buf.target = to_buffer_target(buf_view.target);
 
-    for(auto pair : scene.bufferViews)
-    {
-      tinygltf::BufferView const& buf_view = pair.second;
+    // Look up the buffer this view references
+    auto their_buf_iter = scene.buffers.find(buf_view.buffer);
+    REDC_ASSERT(their_buf_iter != scene.buffers.end());
 
-      // Push the name for later cross-referencing, the index of the name in
-      // this vector is the same index of the buffer in the scene.
-      asset.buf_names.push_back(pair.first);
+    tinygltf::Buffer const& their_buf = their_buf_iter->second;
 
-      // Form our own buffer
-      Buffer our_buf;
-      // Figure our target - this will affect how we store the data later.
-      our_buf.target = to_buffer_target(buf_view.target);
+    // Copy data - we do this no matter the target. If it's a GPU target
+    // though we could save memory by forgetting about it.
+    our_buf.data.resize(their_buf.data.size());
+    std::memcpy(&our_buf.data[0], &their_buf.data[buf_view.byteOffset],
+                buf_view.byteLength);
 
-      // Look up the buffer this view references
-      auto their_buf_iter = scene.buffers.find(buf_view.buffer);
-      REDC_ASSERT(their_buf_iter != scene.buffers.end());
+    std::size_t uploaded = 0;
 
-      tinygltf::Buffer const& their_buf = their_buf_iter->second;
+    // Make a repr if the target requires.
+    if(our_buf.target == Buffer_Target::Array ||
+       our_buf.target == Buffer_Target::Element_Array)
+    {
+      std::unique_ptr<IBuffer> repr = driver.make_buffer_repr();
+      // Upload our data to our GPU buffer now. No need to use the offset
+      // because we already did when copying over to Buffer::data.
+      repr->allocate(our_buf.target, our_buf.data.size(), &our_buf.data[0],
+                     Usage_Hint::Draw, Upload_Hint::Static);
+
+      our_buf.repr = std::move(repr);
+      uploaded = our_buf.data.size();
+    }
+    else
+    {
+      our_buf.repr = nullptr;
+    }
 
-      // Copy data - we do this no matter the target. If it's a GPU target
-      // though we could save memory by forgetting about it.
-      our_buf.data.resize(their_buf.data.size());
-      std::memcpy(&our_buf.data[0], &their_buf.data[buf_view.byteOffset],
-                  buf_view.byteLength);
+    asset.buffers.push_back(std::move(our_buf));
+    return uploaded;
+  }
 
-      // Make a repr if the target requires.
-      if(our_buf.target == Buffer_Target::Array ||
-         our_buf.target == Buffer_Target::Element_Array)
-      {
-        std::unique_ptr<IBuffer> repr = driver.make_buffer_repr();
-        // Upload our data to our GPU buffer now. No need to use the offset
-        // because we already did when copying over to Buffer::data.
-        repr->allocate(our_buf.target, our_buf.data.size(), &our_buf.data[0],
-                       Usage_Hint::Draw, Upload_Hint::Static);
+  void reserve_buffers(Asset& asset, tinygltf::Scene const& scene)
+  {
+    // Add room for new buffers
+    asset.buffers.reserve(asset.buffers.size() + scene.bufferViews.size());
+    asset.buf_names.reserve(asset.buf_names.size() + scene.bufferViews.size());
+  }
 
-        our_buf.repr = std::move(repr);
-      }
-      else
-      {
-        our_buf.repr = nullptr;
-      }
+  void load_buffers(IDriver& driver, Asset& asset, tinygltf::Scene const& scene)
+  {
+    reserve_buffers(asset, scene);
 
-      asset.buffers.push_back(std::move(our_buf));
+    // We sort of compress the concept of buffers and buffer views.
+
+    for(auto const& pair : scene.bufferViews)
+    {
+      load_buffer(driver, asset, pair.first, pair.second, scene);
     }
   }
-
   void load_nodes(Asset& asset, tinygltf::Scene const& scene)
   {
     // Don't reserve any space because light nodes go somewhere else.
@@ -654,7 +670,10 @@ namespace redc { namespace gfx
     }
   }
 
-  void load_textures(IDriver& driver, Asset& asset, tinygltf::Scene const& scene)
+  // Makes texture objects for every texture in the scene, they are filled in
+  // by load_texture. Returns the index of the first new texture.
+  std::size_t make_textures(IDriver& driver, Asset& asset,
+                            tinygltf::Scene const& scene)
   {
     // Starting index
     std::size_t i = asset.textures.size();
@@ -667,84 +686,98 @@ namespace redc { namespace gfx
       asset.texture_names.size() + scene.textures.size()
     );
 
-    for(auto tex_pair : scene.textures)
-    {
-      auto& in_tex = tex_pair.second;
-      asset.texture_names.push_back(tex_pair.first);
+    return i;
+  }
 
-      // Find image by name
-      auto image_find = scene.images.find(in_tex.source);
-      REDC_ASSERT(image_find != scene.images.end());
+  // Returns the amount of bytes uploaded to the GPU.
+  std::size_t load_texture(ITexture& tex, Asset& asset, std::string const& name,
+                           tinygltf::Texture const& in_tex,
+                           tinygltf::Scene const& scene)
+  {
+    asset.texture_names.push_back(name);
+
+    // Find image by name
+    auto image_find = scene.images.find(in_tex.source);
+    REDC_ASSERT(image_find != scene.images.end());
 
-      // Load as enums
-      Texture_Target  target = to_texture_target(in_tex.target);
-      Texture_Format dformat = to_texture_format(in_tex.format);
-      Texture_Format iformat = to_texture_format(in_tex.internalFormat);
-      Data_Type    data_type = to_data_type(in_tex.type);
+    // Load as enums
+    Texture_Target  target = to_texture_target(in_tex.target);
+    Texture_Format dformat = to_texture_format(in_tex.format);
+    Texture_Format iformat = to_texture_format(in_tex.internalFormat);
+    Data_Type    data_type = to_data_type(in_tex.type);
 
-      switch(image_find->second.component)
+    switch(image_find->second.component)
+    {
+    case 1:
+      if(dformat != Texture_Format::Alpha)
       {
-      case 1:
-        if(dformat != Texture_Format::Alpha)
-        {
-          log_w("Ignoring texture format because image has one component");
-          dformat = Texture_Format::Alpha;
-        }
-        break;
-      case 3:
-        if(dformat != Texture_Format::Rgb && dformat != Texture_Format::Srgb)
-          log_w("Ignoring texture format because image has three components");
+        log_w("Ignoring texture format because image has one component");
+        dformat = Texture_Format::Alpha;
+      }
+      break;
+    case 3:
+      if(dformat != Texture_Format::Rgb && dformat != Texture_Format::Srgb)
+        log_w("Ignoring texture format because image has three components");
 
-        // Don't lose the fact that we are using srgb
-        if(dformat == Texture_Format::Srgb_Alpha)
-          dformat = Texture_Format::Srgb;
-        else
-          dformat = Texture_Format::Rgb;
+      // Don't lose the fact that we are using srgb
+      if(dformat == Texture_Format::Srgb_Alpha)
+        dformat = Texture_Format::Srgb;
+      else
+        dformat = Texture_Format::Rgb;
 
-        break;
-      case 4:
-        if(dformat != Texture_Format::Rgba &&
-           dformat != Texture_Format::Srgb_Alpha)
-          log_w("Ignoring texture format because image has four components");
+      break;
+    case 4:
+      if(dformat != Texture_Format::Rgba &&
+         dformat != Texture_Format::Srgb_Alpha)
+        log_w("Ignoring texture format because image has four components");
 
-        if(dformat == Texture_Format::Srgb)
-          dformat = Texture_Format::Srgb_Alpha;
-        else
-          dformat = Texture_Format::Rgba;
+      if(dformat == Texture_Format::Srgb)
+        dformat = Texture_Format::Srgb_Alpha;
+      else
+        dformat = Texture_Format::Rgba;
 
-        break;
-      default:
-        REDC_UNREACHABLE_MSG("Unsupported number of image components");
-        break;
-      }
+      break;
+    default:
+      REDC_UNREACHABLE_MSG("Unsupported number of image components");
+      break;
+    }
 
-      ITexture* tex = asset.textures[i].get();
+    Vec<std::size_t> image_size(image_find->second.width,
+                                image_find->second.height);
+    // Although we pass target from the glTF, we only really support 2D
+    // textures. Cube maps have a whole different blitting process.
+    tex.allocate(image_size, iformat, target);
 
-      Vec<std::size_t> image_size(image_find->second.width,
-                                  image_find->second.height);
-      // Although we pass target from the glTF, we only really support 2D
-      // textures. Cube maps have a whole different blitting process.
-      tex->allocate(image_size, iformat, target);
+    Volume<std::size_t> blit_size;
+    blit_size.pos = Vec<std::size_t>();
+    blit_size.width = image_size.x;
+    blit_size.height = image_size.y;
 
-      Volume<std::size_t> blit_size;
-      blit_size.pos = Vec<std::size_t>();
-      blit_size.width = image_size.x;
-      blit_size.height = image_size.y;
+    tex.blit_tex2d_data(blit_size, dformat, data_type,
+                        &image_find->second.image[0]);
 
-      tex->blit_tex2d_data(blit_size, dformat, data_type,
-                           &image_find->second.image[0]);
+    // Find the sampler
+    auto sampler_find = scene.samplers.find(in_tex.sampler);
+    REDC_ASSERT(sampler_find != scene.samplers.end());
 
-      // Find the sampler
-      auto sampler_find = scene.samplers.find(in_tex.sampler);
-      REDC_ASSERT(sampler_find != scene.samplers.end());
+    tinygltf::Sampler const& sampler = sampler_find->second;
+    tex.set_min_filter(to_texture_filter(sampler.minFilter));
+    tex.set_mag_filter(to_texture_filter(sampler.magFilter));
 
-      tinygltf::Sampler const& sampler = sampler_find->second;
-      tex->set_min_filter(to_texture_filter(sampler.minFilter));
-      tex->set_mag_filter(to_texture_filter(sampler.magFilter));
+    tex.set_wrap_s(to_texture_wrap(sampler.wrapS));
+    tex.set_wrap_t(to_texture_wrap(sampler.wrapT));
 
-      tex->set_wrap_s(to_texture_wrap(sampler.wrapS));
-      tex->set_wrap_t(to_texture_wrap(sampler.wrapT));
+    return image_find->second.image.size();
+  }
+
+  void load_textures(IDriver& driver, Asset& asset, tinygltf::Scene const& scene)
+  {
+    std::size_t i = make_textures(driver, asset, scene);
 
+    for(auto const& tex_pair : scene.textures)
+    {
+      load_texture(*asset.textures[i], asset, tex_pair.first, tex_pair.second,
+                   scene);
       ++i;
     }
   }
@@ -1167,14 +1200,9 @@ namespace redc { namespace gfx
     append_to_asset(driver, ret, scene);
     return std::move(ret);
   }
-  void append_to_asset(IDriver& driver, Asset& ret, tinygltf::Scene const& scene)
+  // Everything that comes after buffers and textures have been uploaded.
+  void finish_asset(IDriver& driver, Asset& ret, tinygltf::Scene const& scene)
   {
-    load_buffers(driver, ret, scene);
-
-    load_accessors(ret, scene);
-
-    load_textures(driver, ret, scene);
-
     load_programs(driver, ret, scene);
 
     load_lights(ret, scene);
@@ -1191,4 +1219,84 @@ namespace redc { namespace gfx
 
     load_meshes_given_names(driver, ret, mesh_off, scene);
   }
+
+  void append_to_asset(IDriver& driver, Asset& ret, tinygltf::Scene const& scene)
+  {
+    load_buffers(driver, ret, scene);
+
+    load_accessors(ret, scene);
+
+    load_textures(driver, ret, scene);
+
+    finish_asset(driver, ret, scene);
+  }
+
+  Asset_Upload begin_asset_upload(Asset& asset, tinygltf::Scene const& scene)
+  {
+    Asset_Upload upload;
+    upload.asset = &asset;
+    upload.scene = &scene;
+    upload.stage = Asset_Upload::Stage::Buffers;
+    upload.buf_iter = scene.bufferViews.begin();
+    upload.tex_iter = scene.textures.begin();
+
+    reserve_buffers(asset, scene);
+    return upload;
+  }
+
+  bool step_asset_upload(IDriver& driver, Asset_Upload& upload,
+                         std::size_t& budget,
+                         std::chrono::steady_clock::time_point deadline)
+  {
+    Asset& asset = *upload.asset;
+    tinygltf::Scene const& scene = *upload.scene;
+
+    while(budget > 0 && upload.stage != Asset_Upload::Stage::Done)
+    {
+      std::size_t uploaded = 0;
+      switch(upload.stage)
+      {
+      case Asset_Upload::Stage::Buffers:
+        if(upload.buf_iter == scene.bufferViews.end())
+        {
+          // Accessors reference buffer representations, so they can only be
+          // loaded once every buffer is in.
+          load_accessors(asset, scene);
+
+          upload.tex_i = make_textures(driver, asset, scene);
+          upload.stage = Asset_Upload::Stage::Textures;
+          break;
+        }
+        uploaded = load_buffer(driver, asset, upload.buf_iter->first,
+                               upload.buf_iter->second, scene);
+        ++upload.buf_iter;
+        break;
+      case Asset_Upload::Stage::Textures:
+        if(upload.tex_iter == scene.textures.end())
+        {
+          upload.stage = Asset_Upload::Stage::Finish;
+          break;
+        }
+        uploaded = load_texture(*asset.textures[upload.tex_i], asset,
+                                upload.tex_iter->first,
+                                upload.tex_iter->second, scene);
+        ++upload.tex_iter;
+        ++upload.tex_i;
+        break;
+      case Asset_Upload::Stage::Finish:
+        finish_asset(driver, asset, scene);
+        upload.stage = Asset_Upload::Stage::Done;
+        break;
+      case Asset_Upload::Stage::Done:
+        break;
+      }
+
+      budget -= std::min(uploaded, budget);
+
+      // Big textures can take a while to go up even when they fit.
+      if(std::chrono::steady_clock::now() >= deadline) break;
+    }
+
+    return upload.stage == Asset_Upload::Stage::Done;
+  }
 } }
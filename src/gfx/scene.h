@@ -13,7 +13,9 @@
 #include "itexture.h"
 #include "ibuffer.h"
 
+#include <chrono>
 #include <vector>
+#include <map>
 #include <unordered_map>
 #include <boost/variant.hpp>
 #include <boost/optional.hpp>
@@ -265,6 +267,41 @@ namespace redc { namespace gfx
   Asset load_asset(IDriver& driver, tinygltf::Scene const& scene);
   void append_to_asset(IDriver& driver, Asset& ret, tinygltf::Scene const& scene);
 
+  // Does the same thing as append_to_asset but a few buffers and textures at a
+  // time so that a big scene can be uploaded over multiple frames. Both the
+  // asset and scene must outlive the upload.
+  struct Asset_Upload
+  {
+    enum class Stage
+    {
+      Buffers, Textures, Finish, Done
+    };
+
+    Asset* asset = nullptr;
+    tinygltf::Scene const* scene = nullptr;
+
+    Stage stage = Stage::Buffers;
+
+    std::map<std::string, tinygltf::BufferView>::const_iterator buf_iter;
+    std::map<std::string, tinygltf::Texture>::const_iterator tex_iter;
+
+    // Index of the next texture in the asset.
+    std::size_t tex_i = 0;
+  };
+
+  Asset_Upload begin_asset_upload(Asset& asset, tinygltf::Scene const& scene);
+
+  // Uploads buffer and texture data until the byte budget is used up or the
+  // deadline has passed, the budget is decreased by the amount uploaded.
+  // Something is always uploaded as long as the budget is non-zero, even if
+  // it is bigger than the budget or the deadline has already passed.
+  // Returns true once the upload is complete, at which point the asset is
+  // identical to one built with append_to_asset.
+  bool step_asset_upload(IDriver& driver, Asset_Upload& upload,
+                         std::size_t& budget,
+                         std::chrono::steady_clock::time_point deadline =
+                           std::chrono::steady_clock::time_point::max());
+
   Attrib_Bind get_attrib_semantic_bind(Technique const& tech,
                                        Attrib_Semantic attrib_semantic);
 
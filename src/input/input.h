@@ -3,30 +3,10 @@
  * All rights reserved.
  */
 #pragma once
-#include <msgpack.hpp>
+#include "sampled_input.h"
 #include "SDL.h"
 namespace redc
 {
-  // Sampled input (no mouse motion)
-  struct Input
-  {
-    bool forward;
-    bool backward;
-
-    bool strafe_left;
-    bool strafe_right;
-
-    bool jump;
-    bool crouch;
-
-    bool primary_attack;
-    bool secondary_attack;
-    bool tertiary_attack;
-
-    MSGPACK_DEFINE(forward, backward, strafe_left, strafe_right, jump, crouch,
-                   primary_attack, secondary_attack, tertiary_attack);
-  };
-
   // Abstraction of an input button, may be a mouse button or key.
   struct Button
   {
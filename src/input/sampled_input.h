@@ -0,0 +1,29 @@
+/*
+ * Copyright (C) 2017 Luke San Antonio
+ * All rights reserved.
+ */
+#pragma once
+#include "../common/serialize.h"
+namespace redc
+{
+  // Sampled input (no mouse motion)
+  struct Input
+  {
+    bool forward = false;
+    bool backward = false;
+
+    bool strafe_left = false;
+    bool strafe_right = false;
+
+    bool jump = false;
+    bool crouch = false;
+
+    bool primary_attack = false;
+    bool secondary_attack = false;
+    bool tertiary_attack = false;
+
+    // Nine bits on the wire.
+    REDC_SERIALIZE(forward, backward, strafe_left, strafe_right, jump, crouch,
+                   primary_attack, secondary_attack, tertiary_attack);
+  };
+}
@@ -3,13 +3,14 @@
  * All rights reserved.
  */
 #include "buffer.h"
+#include <algorithm>
 namespace redc
 {
   bool operator==(std::vector<uchar> const& buf1,
                   std::vector<uchar> const& buf2) noexcept
   {
     if(buf1.size() != buf2.size()) return false;
-    return std::equal(buf1.begin(), buf1.end(), buf2.end());
+    return std::equal(buf1.begin(), buf1.end(), buf2.begin());
   }
 
   std::vector<uchar> buf_from_string(const std::string& s) noexcept
@@ -32,6 +33,44 @@ namespace redc
     return out;
   }
 
+  Shared_Buf::Shared_Buf(buf_t&& buf) noexcept
+    : bytes_(std::make_shared<const buf_t>(std::move(buf))),
+      size_(bytes_->size()) {}
+  Shared_Buf::Shared_Buf(buf_t const& buf) noexcept
+    : bytes_(std::make_shared<const buf_t>(buf)), size_(bytes_->size()) {}
+
+  uchar const* Shared_Buf::data() const noexcept
+  {
+    if(!bytes_) return nullptr;
+    return bytes_->data() + offset_;
+  }
+
+  Shared_Buf Shared_Buf::slice(std::size_t offset,
+                               std::size_t size) const noexcept
+  {
+    Shared_Buf ret = *this;
+    offset = std::min(offset, size_);
+    ret.offset_ = offset_ + offset;
+    ret.size_ = std::min(size, size_ - offset);
+    return ret;
+  }
+
+  buf_t Shared_Buf::to_buf() const noexcept
+  {
+    return buf_t(begin(), end());
+  }
+
+  bool operator==(Shared_Buf const& buf1, Shared_Buf const& buf2) noexcept
+  {
+    if(buf1.size() != buf2.size()) return false;
+    return std::equal(buf1.begin(), buf1.end(), buf2.begin());
+  }
+
+  std::string string_from_buf(Shared_Buf const& buf) noexcept
+  {
+    return std::string(buf.begin(), buf.end());
+  }
+
   namespace literals
   {
     std::vector<uchar>
@@ -3,6 +3,7 @@
  * All rights reserved.
  */
 #pragma once
+#include <memory>
 #include <vector>
 #include <string>
 namespace redc
@@ -24,6 +25,41 @@ namespace redc
   std::string string_from_buf(const buf_t& buf) noexcept;
   std::ostream& operator<<(std::ostream& out, buf_t const& buf) noexcept;
 
+  /*!
+   * \brief An immutable buffer that's cheap to copy and slice.
+   *
+   * Every copy and slice shares the same bytes, which go away with the last
+   * one. Build it by moving a buf_t in to avoid copying the data at all.
+   */
+  struct Shared_Buf
+  {
+    Shared_Buf() noexcept {}
+    Shared_Buf(buf_t&& buf) noexcept;
+    Shared_Buf(buf_t const& buf) noexcept;
+
+    uchar const* data() const noexcept;
+    std::size_t size() const noexcept { return size_; }
+    bool empty() const noexcept { return size_ == 0; }
+
+    uchar const* begin() const noexcept { return data(); }
+    uchar const* end() const noexcept { return data() + size_; }
+
+    // Shares the bytes starting at offset, both are clamped to this buffer.
+    Shared_Buf slice(std::size_t offset,
+                     std::size_t size = std::size_t(-1)) const noexcept;
+
+    // A copy of just the bytes in this slice.
+    buf_t to_buf() const noexcept;
+  private:
+    std::shared_ptr<const buf_t> bytes_;
+    std::size_t offset_ = 0;
+    std::size_t size_ = 0;
+  };
+
+  bool operator==(Shared_Buf const& b1, Shared_Buf const& b2) noexcept;
+
+  std::string string_from_buf(Shared_Buf const& buf) noexcept;
+
   namespace literals
   {
     std::vector<uchar>
@@ -4,55 +4,134 @@
  */
 #include "external_io.h"
 #include "common.h"
+#include "../common/io_reactor.h"
+#include "../common/log.h"
 #include "../common/utility.h"
 namespace redc
 {
-  void post_pipe_buffer(ipc::Pipe* p) noexcept
+  struct Child_Process::Line
   {
-    External_IO* io = (External_IO*) p->user_data;
-    io->post(*p->buf);
-  }
-  void post_error_from_buffer(ipc::Pipe* p) noexcept
-  {
-    External_IO* io = (External_IO*) p->user_data;
-    io->post_error(*p->buf);
-  }
+    Shared_Buf buf;
+    bool error;
+    Line* next;
+  };
 
   Child_Process::Child_Process(ipc::Spawn_Options& opt) noexcept
+    : lines_(nullptr)
   {
-    uv_loop_init(&loop_);
+    start_io_reactor();
 
-    process_ = ipc::create_process(&loop_, opt);
+    int spawn_err = 0;
+    io_reactor()->call([&](uv_loop_t* loop)
+    {
+      try
+      {
+        process_ = ipc::create_process(loop, opt);
+      }
+      catch(ipc::Spawn_Error& e)
+      {
+        spawn_err = e.err;
+        return;
+      }
 
-    process_->io.in.user_data = this;
-    process_->io.in.action_cb = post_pipe_buffer;
-    uv_read_start((uv_stream_t*) &process_->io.in, alloc, ipc::collect_lines);
+      process_->io.in.user_data = this;
+      process_->io.in.action_cb = [](ipc::Pipe* p)
+      {
+        ((Child_Process*) p->user_data)->push_line_(p, false);
+      };
+      uv_read_start((uv_stream_t*) &process_->io.in, alloc,
+                    ipc::collect_lines);
 
-    process_->err.user_data = this;
-    process_->err.action_cb = post_error_from_buffer;
-    uv_read_start((uv_stream_t*) &process_->err, alloc, ipc::collect_lines);
+      process_->err.user_data = this;
+      process_->err.action_cb = [](ipc::Pipe* p)
+      {
+        ((Child_Process*) p->user_data)->push_line_(p, true);
+      };
+      uv_read_start((uv_stream_t*) &process_->err, alloc,
+                    ipc::collect_lines);
+    });
 
-    // Start the boll rollin'!
-    //*process_->io.out.buf = buf_from_string("PpM");
-    ipc::write_buffer(&process_->io.out);
+    // Logged here rather than in the task, on a thread that may have
+    // initialized the log.
+    if(spawn_err)
+    {
+      log_e("Failed to spawn %: %", opt.args[0], uv_strerror(spawn_err));
+    }
   }
   Child_Process::~Child_Process() noexcept
   {
-    ipc::delete_process(process_);
+    // Once this returns the pipes are closed and won't call us anymore.
+    if(process_)
+    {
+      ipc::Process* process = process_;
+      io_reactor()->call([process](uv_loop_t*)
+      {
+        ipc::delete_process(process);
+      });
+    }
+    stop_io_reactor();
 
-    uv_run(&loop_, UV_RUN_DEFAULT);
-    uv_loop_close(&loop_);
+    Line* line = lines_.exchange(nullptr);
+    while(line)
+    {
+      Line* next = line->next;
+      delete line;
+      line = next;
+    }
   }
-  void Child_Process::write(buf_t const& buf) noexcept
+  void Child_Process::write(Shared_Buf const& buf) noexcept
   {
-    step();
-    if(!process_->running) return;
-    *process_->io.out.buf = buf;
-    ipc::write_buffer(&process_->io.out);
+    if(!process_) return;
+    out_.push_back(buf);
   }
   void Child_Process::step() noexcept
   {
-    uv_run(&loop_, UV_RUN_NOWAIT);
+    if(process_ && !out_.empty())
+    {
+      ipc::Process* process = process_;
+      io_reactor()->post([process, bufs = std::move(out_)](uv_loop_t*)
+      {
+        if(!process->running) return;
+
+        auto& queued = process->io.out.queued;
+        queued.insert(queued.end(), bufs.begin(), bufs.end());
+        ipc::flush_pipe(&process->io.out);
+      });
+      out_.clear();
+    }
+
+    Line* line = lines_.exchange(nullptr, std::memory_order_acquire);
+
+    // It's a stack, put the oldest first.
+    Line* ordered = nullptr;
+    while(line)
+    {
+      Line* next = line->next;
+      line->next = ordered;
+      ordered = line;
+      line = next;
+    }
+
+    while(ordered)
+    {
+      Line* next = ordered->next;
+      if(ordered->error) post_error(ordered->buf);
+      else post(ordered->buf);
+      delete ordered;
+      ordered = next;
+    }
+  }
+  void Child_Process::push_line_(ipc::Pipe* p, bool error) noexcept
+  {
+    // Hand the line over instead of copying it, collect_lines starts a new
+    // one.
+    Line* line = new Line{Shared_Buf(std::move(*p->buf)), error, nullptr};
+    p->buf->clear();
+
+    line->next = lines_.load(std::memory_order_relaxed);
+    while(!lines_.compare_exchange_weak(line->next, line,
+                                        std::memory_order_release,
+                                        std::memory_order_relaxed)) {}
   }
 
   Pipe_IO::Pipe_IO() noexcept
@@ -66,7 +145,7 @@ namespace redc
     return *cp_;
   }
 
-  void Pipe_IO::write(buf_t const& buf) noexcept
+  void Pipe_IO::write(Shared_Buf const& buf) noexcept
   {
     // Write to the counterpart's input.
     counterpart().input_.push(buf);
@@ -80,8 +159,7 @@ namespace redc
     // Read our pending input.
     while(!input_.empty())
     {
-      buf_t const& buf = input_.front();
-      post(buf);
+      post(input_.front());
       input_.pop();
     }
 
@@ -4,18 +4,23 @@
  */
 #pragma once
 #include <uv.h>
+#include <atomic>
 #include <string>
 #include <functional>
 #include <queue>
+#include <vector>
 #include "../common/maybe_owned.hpp"
 #include "ipc.h"
 namespace redc
 {
   /*!  \brief Manages and connects client code to some arbitrary io source.
+   *
+   * Buffers are shared rather than copied on their way through, so hang on
+   * to a Shared_Buf (or a slice of it) instead of copying it out.
    */
   struct External_IO
   {
-    using read_cb = std::function<void (buf_t const&)>;
+    using read_cb = std::function<void (Shared_Buf const&)>;
 
     External_IO(read_cb r_cb = nullptr, read_cb e_cb = nullptr) noexcept
                 : read_cb_(r_cb), err_cb_(e_cb) {}
@@ -24,12 +29,12 @@ namespace redc
 
     inline void set_read_callback(read_cb cb) noexcept;
     inline void set_error_callback(read_cb cb) noexcept;
-    inline void post(buf_t const& buf) noexcept;
-    inline void post_error(buf_t const& err) noexcept;
+    inline void post(Shared_Buf const& buf) noexcept;
+    inline void post_error(Shared_Buf const& err) noexcept;
 
     inline virtual void set_reliable(bool) noexcept {}
 
-    virtual void write(buf_t const& buf) noexcept = 0;
+    virtual void write(Shared_Buf const& buf) noexcept = 0;
     virtual void step() noexcept = 0;
   private:
     read_cb read_cb_;
@@ -44,25 +49,43 @@ namespace redc
   {
     err_cb_ = cb;
   }
-  inline void External_IO::post(buf_t const& buf) noexcept
+  inline void External_IO::post(Shared_Buf const& buf) noexcept
   {
     read_cb_(buf);
   }
-  inline void External_IO::post_error(buf_t const& buf) noexcept
+  inline void External_IO::post_error(Shared_Buf const& buf) noexcept
   {
     err_cb_(buf);
   }
 
+  /*!  \brief Talks to a child process over its stdin, stdout and stderr.
+   *
+   * The process and its pipes live on the I/O reactor's thread, so reading
+   * and writing doesn't cost the caller any polling. Lines are handed back
+   * and posted from step.
+   */
   struct Child_Process : public External_IO
   {
     Child_Process(ipc::Spawn_Options&) noexcept;
     ~Child_Process() noexcept;
 
-    void write(buf_t const& buf) noexcept override;
+    // Queue a write to the child's stdin.
+    void write(Shared_Buf const& buf) noexcept override;
+
+    // Send everything queued at once and post the lines the child sent.
     void step() noexcept override;
   private:
-    ipc::Process* process_;
-    uv_loop_t loop_;
+    struct Line;
+
+    void push_line_(ipc::Pipe* p, bool error) noexcept;
+
+    // Only touched on the I/O thread, null if it couldn't be spawned.
+    ipc::Process* process_ = nullptr;
+
+    std::vector<Shared_Buf> out_;
+
+    // Read by the I/O thread, step takes them all at once.
+    std::atomic<Line*> lines_;
   };
 
   struct Pipe_IO : public External_IO
@@ -77,7 +100,7 @@ namespace redc
     Pipe_IO& counterpart() noexcept;
 
     // Queue a write to the counterpart.
-    void write(buf_t const& buf) noexcept override;
+    void write(Shared_Buf const& buf) noexcept override;
 
     // Read from the counterpart and send queued buffers.
     void step() noexcept override;
@@ -90,6 +113,6 @@ namespace redc
     // Represents a Pipe_IO object that is maybe owned.
     Maybe_Owned<Pipe_IO> cp_;
 
-    std::queue<buf_t> input_;
+    std::queue<Shared_Buf> input_;
   };
 }
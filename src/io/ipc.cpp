@@ -29,6 +29,7 @@ namespace redc { namespace ipc
   void uninit_pipe(Pipe& self) noexcept
   {
     delete self.buf;
+    self.queued.clear();
   }
 
   // Duplex_Pipe initialization functions.
@@ -58,15 +59,25 @@ namespace redc { namespace ipc
 
   void on_process_exit(uv_process_t* p, int64_t exit, int sig) noexcept
   {
+    // The handle stays open until delete_process.
     Process* proc = (Process*) p;
+    proc->running = false;
+  }
 
-    // Tidy up.
-    uv_run(proc->loop, UV_RUN_DEFAULT);
+  void on_process_handle_close(uv_handle_t* handle) noexcept
+  {
+    Process* proc = (Process*) handle->data;
+    if(--proc->open_handles > 0) return;
 
-    // Close the process then uninitialize.
-    uv_close((uv_handle_t*) proc, NULL);
-    proc->running = false;
-    delete_process(proc);
+    uninit_duplex_pipe(proc->io);
+    uninit_pipe(proc->err);
+    delete proc;
+  }
+
+  void close_process_handle(Process* proc, uv_handle_t* handle) noexcept
+  {
+    handle->data = proc;
+    uv_close(handle, on_process_handle_close);
   }
 
   Process* create_process(uv_loop_t* loop, const Spawn_Options& spawn_opt)
@@ -74,6 +85,7 @@ namespace redc { namespace ipc
     Process* self = new Process;
     self->loop = loop;
     self->running = false;
+    self->open_handles = 0;
 
     // Initialize pipes.
     init_duplex_pipe(self->io, self);
@@ -83,8 +95,7 @@ namespace redc { namespace ipc
     uv_pipe_init(loop, (uv_pipe_t*) &self->io.out, 1);
     uv_pipe_init(loop, (uv_pipe_t*) &self->err, 1);
 
-    uv_process_options_t options;
-    options.exit_cb = 0;
+    uv_process_options_t options = {};
 
     // Specify executable.
     options.file = spawn_opt.args[0];
@@ -114,9 +125,15 @@ namespace redc { namespace ipc
     int err = uv_spawn(loop, (uv_process_t*) self, &options);
     if(err)
     {
+      // uv_spawn initializes the process handle even when it fails, so it
+      // gets closed with the pipes. The Process goes away after the loop
+      // gets around to it.
+      self->open_handles = 4;
+      close_process_handle(self, (uv_handle_t*) &self->proc);
+      close_process_handle(self, (uv_handle_t*) &self->io.in);
+      close_process_handle(self, (uv_handle_t*) &self->io.out);
+      close_process_handle(self, (uv_handle_t*) &self->err);
       throw Spawn_Error{spawn_opt, err};
-      delete_process(self);
-      return nullptr;
     }
 
     self->running = true;
@@ -128,20 +145,13 @@ namespace redc { namespace ipc
     // Kill the process (if necessary)
     kill_process(self, SIGTERM);
 
-    // Tidy up all pending events.
-    uv_run(self->loop, UV_RUN_DEFAULT);
-
-    // Close and uninitialize pipes connected to the child process.
-    uv_close((uv_handle_t*) &self->io.in, NULL);
-    uninit_pipe(self->io.in);
-
-    uv_close((uv_handle_t*) &self->io.out, NULL);
-    uninit_pipe(self->io.out);
-
-    uv_close((uv_handle_t*) &self->err, NULL);
-    uninit_pipe(self->err);
-
-    delete self;
+    // Close the process and the pipes connected to it, the last one to close
+    // uninitializes and deletes the whole thing.
+    self->open_handles = 4;
+    close_process_handle(self, (uv_handle_t*) &self->proc);
+    close_process_handle(self, (uv_handle_t*) &self->io.in);
+    close_process_handle(self, (uv_handle_t*) &self->io.out);
+    close_process_handle(self, (uv_handle_t*) &self->err);
   }
 
   void kill_process(Process* proc, int signum)
@@ -160,6 +170,7 @@ namespace redc { namespace ipc
     uv_write_t req;
     Pipe* pipe;
     on_write_cb after_write;
+    std::vector<Shared_Buf> bufs;
   };
 
   void on_write_buffer(uv_write_t* r, int status)
@@ -168,17 +179,40 @@ namespace redc { namespace ipc
     if(req->after_write) req->after_write(req->pipe);
     delete req;
   }
-  void write_buffer(Pipe* pipe, on_write_cb after_write) noexcept
+  void write_buffers(Pipe* pipe, std::vector<Shared_Buf> bufs,
+                     on_write_cb after_write) noexcept
   {
-    // I don't think the reinterpret cast will cause too many issues.
-    uv_buf_t buf = uv_buf_init(reinterpret_cast<char*>(&(*pipe->buf)[0]),
-                               pipe->buf->size());
+    if(bufs.empty()) return;
 
     Write_Buf_Req* req = new Write_Buf_Req;
     req->pipe = pipe;
     req->after_write = after_write;
+    req->bufs = std::move(bufs);
+
+    // libuv copies the uv_buf_t array but not what it points to, the
+    // request owns that until the write is done.
+    std::vector<uv_buf_t> uv_bufs;
+    uv_bufs.reserve(req->bufs.size());
+    for(Shared_Buf const& buf : req->bufs)
+    {
+      // uv_buf_t is used for reading too, so it isn't const.
+      uv_bufs.push_back(uv_buf_init((char*) buf.data(), buf.size()));
+    }
 
-    uv_write((uv_write_t*) req, (uv_stream_t*) pipe, &buf, 1, on_write_buffer);
+    uv_write((uv_write_t*) req, (uv_stream_t*) pipe, &uv_bufs[0],
+             uv_bufs.size(), on_write_buffer);
+  }
+  void write_buffer(Pipe* pipe, Shared_Buf buf,
+                    on_write_cb after_write) noexcept
+  {
+    write_buffers(pipe, {std::move(buf)}, after_write);
+  }
+
+  void flush_pipe(Pipe* pipe, on_write_cb after_write) noexcept
+  {
+    std::vector<Shared_Buf> bufs;
+    bufs.swap(pipe->queued);
+    write_buffers(pipe, std::move(bufs), after_write);
   }
 
   void collect_lines(uv_stream_t* s, ssize_t nread, const uv_buf_t* buf)
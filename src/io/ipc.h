@@ -4,6 +4,7 @@
  */
 #pragma once
 #include <uv.h>
+#include <vector>
 #include "buffer.h"
 
 namespace redc { namespace ipc
@@ -12,7 +13,10 @@ namespace redc { namespace ipc
   struct Pipe
   {
     uv_pipe_t pipe;
+    // The line being read.
     buf_t* buf;
+    // Waiting to be written with the next call to flush_pipe.
+    std::vector<Shared_Buf> queued;
     Process* proc;
     void (*action_cb)(Pipe* p);
     void* user_data;
@@ -35,7 +39,16 @@ namespace redc { namespace ipc
   void uninit_duplex_pipe(Duplex_Pipe& self) noexcept;
 
   using on_write_cb = void (*)(Pipe*);
-  void write_buffer(Pipe* pipe, on_write_cb after_write = nullptr) noexcept;
+
+  // Writes every buffer with a single request, the buffers are kept alive
+  // until it's done.
+  void write_buffers(Pipe* pipe, std::vector<Shared_Buf> bufs,
+                     on_write_cb after_write = nullptr) noexcept;
+  void write_buffer(Pipe* pipe, Shared_Buf buf,
+                    on_write_cb after_write = nullptr) noexcept;
+
+  // Writes everything queued on the pipe at once.
+  void flush_pipe(Pipe* pipe, on_write_cb after_write = nullptr) noexcept;
 
   struct Kill_Error
   {
@@ -62,9 +75,15 @@ namespace redc { namespace ipc
     Pipe err;
     uv_loop_t* loop;
     bool running;
+    // Counts down as they close after delete_process.
+    int open_handles;
   };
 
+  // All of these have to be called from the thread running the loop, they
+  // never run it themselves.
   Process* create_process(uv_loop_t* loop, const Spawn_Options& spawn_opt);
+  // Kills the process and closes everything, the Process is deleted once the
+  // loop is done with it.
   void delete_process(Process*) noexcept;
   void kill_process(Process*, int signum);
 
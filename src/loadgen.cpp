@@ -0,0 +1,473 @@
+/*
+ * Copyright (C) 2017 Luke San Antonio
+ * All rights reserved.
+ *
+ * Connects a bunch of simulated clients to a server and reports how it holds
+ * up. There's no window, GPU or audio involved so this can run anywhere.
+ */
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/program_options.hpp>
+
+#include "common/log.h"
+#include "common/fixed_tick.h"
+#include "net/client.h"
+#include "net/server_protocol.h"
+
+namespace po = boost::program_options;
+
+namespace
+{
+  using namespace redc;
+
+  struct Sim_Client
+  {
+    net::Client_Context ctx;
+    bool failed = false;
+
+    Input input = {};
+    std::size_t script_line = 0;
+
+    // Snapshot ticks we saw and the ones that never showed up, this assumes
+    // the server sends a snapshot every tick.
+    uint32_t last_tick = NO_BASELINE;
+    uint64_t snapshots = 0;
+    uint64_t missed = 0;
+  };
+
+  // Each line of a script is the input for one tick, clients loop over it
+  // starting at different lines. The letters are the keys held down:
+  // w a s d, j for jump, c for crouch and p for the primary attack.
+  using Script = std::vector<Input>;
+
+  bool load_script(std::string const& filename, Script& script)
+  {
+    std::ifstream file(filename);
+    if(!file) return false;
+
+    std::string line;
+    while(std::getline(file, line))
+    {
+      Input input = {};
+      for(char c : line)
+      {
+        switch(c)
+        {
+          case 'w': input.forward = true; break;
+          case 's': input.backward = true; break;
+          case 'a': input.strafe_left = true; break;
+          case 'd': input.strafe_right = true; break;
+          case 'j': input.jump = true; break;
+          case 'c': input.crouch = true; break;
+          case 'p': input.primary_attack = true; break;
+          default: break;
+        }
+      }
+      script.push_back(input);
+    }
+    return !script.empty();
+  }
+
+  // Mostly keep doing the same thing, like people do.
+  void random_input(Input& input, std::mt19937& rand)
+  {
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    if(unit(rand) < 0.05f) input.forward = !input.forward;
+    if(unit(rand) < 0.02f) input.backward = !input.backward;
+    if(unit(rand) < 0.05f) input.strafe_left = !input.strafe_left;
+    if(unit(rand) < 0.05f) input.strafe_right = !input.strafe_right;
+    input.jump = unit(rand) < 0.02f;
+    if(unit(rand) < 0.01f) input.crouch = !input.crouch;
+    input.primary_attack = unit(rand) < 0.05f;
+  }
+
+  // Resident memory of the whole process, zero if we can't tell.
+  std::size_t resident_bytes()
+  {
+    std::ifstream statm("/proc/self/statm");
+    std::size_t size = 0, resident = 0;
+    if(!(statm >> size >> resident)) return 0;
+    return resident * 4096;
+  }
+
+  // A server running in this process, it gets its own thread so its timing
+  // isn't mixed up with the clients'.
+  struct Local_Server
+  {
+    net::Server_Context ctx;
+    std::unordered_map<player_id, glm::vec3> positions;
+
+    std::atomic<bool> running;
+    std::thread thread;
+
+    // The server resets its stats every so often, this is a copy of them
+    // for reporting from the main thread.
+    std::mutex stats_mut;
+    Tick_Stats stats;
+  };
+
+  void start_local_server(Local_Server& server, uint16_t port,
+                          std::size_t max_peers, uint8_t tickrate)
+  {
+    auto& ctx = server.ctx;
+    ctx.port = port;
+    ctx.max_peers = max_peers;
+    ctx.rules.tickrate = tickrate;
+    ctx.rules.max_players = std::min<std::size_t>(max_peers, 255);
+    ctx.grid.min = glm::vec3(-512.0f, -16.0f, -512.0f);
+    ctx.grid.max = glm::vec3(512.0f, 48.0f, 512.0f);
+
+    // Nothing fancy, just enough that snapshots have something to say.
+    ctx.simulate = [&server](net::Server_Context& ctx, float dt)
+    {
+      for(auto& client_pair : ctx.clients)
+      {
+        auto& client = client_pair.second;
+        if(!client.player_info) continue;
+
+        auto& pos = server.positions[client.player_info->id];
+        if(client.input.forward) pos.z -= 5.0f * dt;
+        if(client.input.backward) pos.z += 5.0f * dt;
+        if(client.input.strafe_left) pos.x -= 5.0f * dt;
+        if(client.input.strafe_right) pos.x += 5.0f * dt;
+      }
+    };
+    ctx.make_snapshot = [&server](net::Server_Context& ctx)
+    {
+      net::Snapshot snap;
+      for(auto& client_pair : ctx.clients)
+      {
+        auto& client = client_pair.second;
+        if(client.state != net::Remote_Client_State::Playing) continue;
+
+        net::Player_Snapshot player;
+        player.id = client.player_info->id;
+        player.input = client.input;
+        player.position = server.positions[player.id];
+        snap.players.push_back(player);
+      }
+      std::sort(snap.players.begin(), snap.players.end(),
+                [](auto const& lhs, auto const& rhs)
+                {
+                  return lhs.id < rhs.id;
+                });
+      return snap;
+    };
+
+    net::init_server(ctx);
+
+    server.running = true;
+    server.thread = std::thread([&server]()
+    {
+      Scoped_Log_Init log_init{};
+      while(server.running)
+      {
+        net::service_server(server.ctx);
+
+        std::lock_guard<std::mutex> lock(server.stats_mut);
+        server.stats = server.ctx.ticker->stats();
+      }
+    });
+  }
+
+  struct Totals
+  {
+    std::size_t playing = 0;
+    std::size_t connecting = 0;
+    std::size_t failed = 0;
+
+    uint64_t rtt_total = 0;
+    uint32_t rtt_max = 0;
+    double loss_total = 0.0;
+
+    uint64_t sent = 0;
+    uint64_t received = 0;
+    uint64_t snapshots = 0;
+    uint64_t missed = 0;
+  };
+
+  Totals total_up(std::vector<Sim_Client> const& clients)
+  {
+    Totals ret;
+    for(auto const& client : clients)
+    {
+      if(client.failed)
+      {
+        ++ret.failed;
+        continue;
+      }
+      if(client.ctx.state != net::Client_State::Playing)
+      {
+        ++ret.connecting;
+        continue;
+      }
+      ++ret.playing;
+
+      ENetPeer* peer = client.ctx.server_peer;
+      ret.rtt_total += peer->roundTripTime;
+      ret.rtt_max = std::max(ret.rtt_max, peer->roundTripTime);
+      ret.loss_total += peer->packetLoss / (double) ENET_PEER_PACKET_LOSS_SCALE;
+
+      ret.sent += client.ctx.host.host->totalSentData;
+      ret.received += client.ctx.host.host->totalReceivedData;
+      ret.snapshots += client.snapshots;
+      ret.missed += client.missed;
+    }
+    return ret;
+  }
+
+  void report(std::vector<Sim_Client> const& clients, Totals const& last,
+              Totals const& cur, double seconds, Local_Server* server)
+  {
+    double playing = std::max<std::size_t>(cur.playing, 1);
+    double up = (cur.sent - std::min(cur.sent, last.sent)) / 1024.0 / seconds;
+    double down = (cur.received - std::min(cur.received, last.received)) /
+                  1024.0 / seconds;
+
+    uint64_t snapshots = cur.snapshots - std::min(cur.snapshots,
+                                                  last.snapshots);
+    uint64_t missed = cur.missed - std::min(cur.missed, last.missed);
+    double snapshot_loss = snapshots + missed == 0 ? 0.0 :
+                           missed * 100.0 / (snapshots + missed);
+
+    log_i("% clients: % playing, % connecting, % failed", clients.size(),
+          cur.playing, cur.connecting, cur.failed);
+    log_i("  rtt %ms avg, %ms max; reliable loss % percent, snapshot loss "
+          "% percent",
+          cur.rtt_total / playing, cur.rtt_max,
+          cur.loss_total * 100.0 / playing, snapshot_loss);
+    log_i("  per client % KB/s up, % KB/s down; % KB/s down total",
+          up / playing, down / playing, down);
+
+    if(server)
+    {
+      std::lock_guard<std::mutex> lock(server->stats_mut);
+      Tick_Stats const& stats = server->stats;
+      log_i("  server ticks %ms avg, %ms max, % overran, % skipped, started "
+            "%ms late avg", stats.avg_duration_ms(),
+            std::chrono::duration<double, std::milli>(stats.max_duration)
+              .count(), stats.overruns, stats.skipped,
+            stats.avg_jitter_ms());
+    }
+    log_i("  resident memory % MB", resident_bytes() / (1024.0 * 1024.0));
+  }
+}
+
+int main(int argc, char** argv)
+{
+  Scoped_Log_Init log_init{};
+
+  po::options_description desc("Allowed Options");
+  desc.add_options()
+          ("help", "display help")
+          ("clients", po::value<std::size_t>()->default_value(64),
+           "number of simulated clients")
+          ("connect", po::value<std::string>(),
+           "server to connect to, without it a server is started here")
+          ("port", po::value<uint16_t>()->default_value(28222),
+           "server port")
+          ("tickrate", po::value<unsigned int>()->default_value(20),
+           "tickrate of the local server")
+          ("rate", po::value<unsigned int>(),
+           "inputs sent per second by each client, the server's tickrate by "
+           "default")
+          ("script", po::value<std::string>(),
+           "file of inputs to play back instead of random ones")
+          ("duration", po::value<float>()->default_value(60.0f),
+           "seconds to run for")
+          ("report-interval", po::value<float>()->default_value(5.0f),
+           "seconds between reports")
+          ("seed", po::value<unsigned int>()->default_value(1),
+           "seed for random inputs");
+
+  po::variables_map vm;
+  try
+  {
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    po::notify(vm);
+  }
+  catch(po::error& e)
+  {
+    log_e("%", e.what());
+    return EXIT_FAILURE;
+  }
+
+  if(vm.count("help"))
+  {
+    std::cerr << desc << std::endl;
+    return EXIT_SUCCESS;
+  }
+
+  auto num_clients = vm["clients"].as<std::size_t>();
+  auto port = vm["port"].as<uint16_t>();
+  auto tickrate = vm["tickrate"].as<unsigned int>();
+
+  Script script;
+  if(vm.count("script") &&
+     !load_script(vm["script"].as<std::string>(), script))
+  {
+    log_e("Failed to load input script %", vm["script"].as<std::string>());
+    return EXIT_FAILURE;
+  }
+
+  std::unique_ptr<Local_Server> server;
+  std::string addr = "127.0.0.1";
+  if(vm.count("connect"))
+  {
+    addr = vm["connect"].as<std::string>();
+  }
+  else
+  {
+    server = std::make_unique<Local_Server>();
+    start_local_server(*server, port, num_clients,
+                       std::min(tickrate, 255u));
+    log_i("Started a local server at %hz on port %", tickrate, port);
+  }
+
+  std::vector<Sim_Client> clients(num_clients);
+  for(std::size_t i = 0; i < num_clients; ++i)
+  {
+    auto& ctx = clients[i].ctx;
+    enet_address_set_host(&ctx.server_addr, addr.c_str());
+    ctx.server_addr.port = port;
+    ctx.client_version = 0x01;
+
+    ctx.player_info.id = i + 1;
+    ctx.player_info.name = "loadgen-" + std::to_string(i);
+    ctx.player_info.team = 0;
+
+    clients[i].script_line = script.empty() ? 0 : i % script.size();
+
+    // Starts connecting.
+    net::step_client(ctx, nullptr);
+  }
+
+  std::mt19937 rand(vm["seed"].as<unsigned int>());
+
+  unsigned int rate = vm.count("rate") ? vm["rate"].as<unsigned int>() :
+                                         tickrate;
+  Fixed_Tick input_ticker(std::max(rate, 1u));
+
+  using namespace std::chrono;
+  auto start = tick_clock_t::now();
+  auto last_report = start;
+  auto run_time = duration_cast<tick_clock_t::duration>(
+    duration<float>(vm["duration"].as<float>()));
+  auto report_interval = duration_cast<tick_clock_t::duration>(
+    duration<float>(vm["report-interval"].as<float>()));
+  Totals last_totals;
+
+  while(tick_clock_t::now() - start < run_time)
+  {
+    for(auto& client : clients)
+    {
+      if(client.failed) continue;
+      auto& ctx = client.ctx;
+
+      ENetEvent event;
+      while(ctx.host.host && enet_host_service(ctx.host.host, &event, 0) > 0)
+      {
+        auto res = net::step_client(ctx, &event);
+        if(!res.event_handled)
+        {
+          if(event.type == ENET_EVENT_TYPE_RECEIVE)
+          {
+            enet_packet_destroy(event.packet);
+          }
+          else if(event.type == ENET_EVENT_TYPE_DISCONNECT)
+          {
+            client.failed = true;
+            ctx.server_peer = nullptr;
+            break;
+          }
+        }
+
+        if(ctx.state == net::Client_State::Bad_Version)
+        {
+          client.failed = true;
+          break;
+        }
+
+        // Anything newer than what we've seen is a new snapshot.
+        uint32_t tick = ctx.cur_snapshot.tick;
+        if(ctx.cur_input.ack_tick != NO_BASELINE &&
+           (client.last_tick == NO_BASELINE || tick > client.last_tick))
+        {
+          if(client.last_tick != NO_BASELINE)
+          {
+            client.missed += tick - client.last_tick - 1;
+          }
+          client.last_tick = tick;
+          ++client.snapshots;
+        }
+      }
+
+      // These states move on without anything from the server.
+      if(ctx.state == net::Client_State::Sending_Client_Info)
+      {
+        net::step_client(ctx, nullptr);
+      }
+    }
+
+    while(input_ticker.begin(tick_clock_t::now()))
+    {
+      for(auto& client : clients)
+      {
+        if(client.failed) continue;
+        if(client.ctx.state != net::Client_State::Playing) continue;
+
+        if(script.empty())
+        {
+          random_input(client.input, rand);
+        }
+        else
+        {
+          client.input = script[client.script_line];
+          client.script_line = (client.script_line + 1) % script.size();
+        }
+        net::send_input(client.ctx, client.input);
+        enet_host_flush(client.ctx.host.host);
+      }
+      input_ticker.end(tick_clock_t::now());
+    }
+
+    auto now = tick_clock_t::now();
+    if(now - last_report >= report_interval)
+    {
+      Totals totals = total_up(clients);
+      double seconds = duration<double>(now - last_report).count();
+      report(clients, last_totals, totals, seconds, server.get());
+
+      last_totals = totals;
+      last_report = now;
+    }
+
+    std::this_thread::sleep_for(milliseconds(1));
+  }
+
+  for(auto& client : clients)
+  {
+    if(client.ctx.server_peer) enet_peer_disconnect(client.ctx.server_peer, 0);
+    if(client.ctx.host.host) enet_host_flush(client.ctx.host.host);
+  }
+
+  if(server)
+  {
+    server->running = false;
+    server->thread.join();
+    server->ctx.ticker->log_stats("Local server");
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -37,6 +37,16 @@ local config_spec = {
         expected_type = "string",
         default = "server.lua",
     },
+    compress_textures = {
+        desc = "Block compress cached textures",
+        expected_type = "boolean",
+        default = false,
+    },
+    texture_budget = {
+        desc = "Streamed texture memory budget in megabytes, zero to disable",
+        expected_type = "number",
+        default = 256,
+    },
 }
 
 -- Verifies the type of a given value.
@@ -64,7 +64,13 @@ function scene.make_scene()
     end
 
     function sc:object_set_texture(obj, texture)
-       ffi.C.redc_scene_object_set_texture(self._scene_ptr_, obj, texture)
+       ffi.C.redc_scene_object_set_texture(self._scene_ptr, obj, texture)
+    end
+
+    -- Index is zero based, in the order the names were given to the atlas.
+    function sc:object_set_atlas_texture(obj, atlas, index)
+       ffi.C.redc_scene_object_set_atlas_texture(self._scene_ptr, obj, atlas,
+                                                 index)
     end
 
     function sc:step()
@@ -24,4 +24,41 @@ function server:step()
     ffi.C.redc_server_step(rc.engine)
 end
 
+local message_types = {
+    "version_info", "version_okay", "server_info", "player_info",
+    "roster_update", "spawn", "input_update", "snapshot", "other"
+}
+
+-- Network stats of every peer, averaged over the last few seconds.
+function server:peer_stats()
+    local ret = {}
+    local stats = ffi.new("Redc_Peer_Stats")
+    local rate_in = ffi.new("float[1]")
+    local rate_out = ffi.new("float[1]")
+    for i = 0, ffi.C.redc_net_peer_count() - 1 do
+        if ffi.C.redc_net_peer_stats(i, stats) == 1 then
+            local peer = {
+                address = ffi.string(stats.address),
+                port = stats.port,
+                rtt_ms = stats.rtt_ms,
+                rtt_max_ms = stats.rtt_max_ms,
+                jitter_ms = stats.jitter_ms,
+                packet_loss = stats.packet_loss,
+                reliable_in_transit = stats.reliable_in_transit,
+                bytes_in = stats.bytes_in,
+                bytes_out = stats.bytes_out,
+                saturated = stats.saturated,
+                messages = {}
+            }
+            for _, type in ipairs(message_types) do
+                ffi.C.redc_net_peer_message_rate(i, type, rate_in, rate_out)
+                peer.messages[type] = { bytes_in = rate_in[0],
+                                        bytes_out = rate_out[0] }
+            end
+            table.insert(ret, peer)
+        end
+    end
+    return ret
+end
+
 return server
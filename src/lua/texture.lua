@@ -9,8 +9,21 @@ local rc = require("redcrane")
 local texture = {}
 
 function texture:load_texture(str)
-   return ffi.gc(ffi.redc_load_texture(rc.engine, str),
+   return ffi.gc(ffi.C.redc_load_texture(rc.engine, str),
                  ffi.C.redc_unload_texture)
 end
 
+function texture:load_atlas(names)
+   local c_names = ffi.new("const char*[?]", #names)
+   for i, name in ipairs(names) do
+      c_names[i - 1] = name
+   end
+   return ffi.gc(ffi.C.redc_load_atlas(rc.engine, c_names, #names),
+                 ffi.C.redc_unload_atlas)
+end
+
+function texture:atlas_region(atlas, index)
+   return ffi.C.redc_atlas_region(atlas, index)
+end
+
 return texture
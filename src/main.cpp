@@ -316,12 +316,8 @@ int start_dedicated(po::variables_map const& vm)
   bool running = true;
   while(running)
   {
-    ENetEvent event;
-    // For right now this is all we are doing so feel free to wait for a while
-    while(enet_host_service(server.host.host, &event, 100))
-    {
-      net::step_server(server, event);
-    }
+    // Sleeps in ENet until the next tick.
+    net::service_server(server);
   }
 #endif
   return EXIT_SUCCESS;
@@ -0,0 +1,308 @@
+/*
+ * Copyright (C) 2017 Luke San Antonio
+ * All rights reserved.
+ *
+ * A dedicated server with nothing but the simulation and the network, there's
+ * no window, GPU or audio. One process hosts a bunch of independent matches
+ * on consecutive ports, spread over a few threads.
+ */
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/program_options.hpp>
+#include <btBulletDynamicsCommon.h>
+
+#include "common/log.h"
+#include "common/fixed_tick.h"
+#include "net/server_protocol.h"
+#include "player.h"
+
+namespace po = boost::program_options;
+
+namespace
+{
+  using namespace redc;
+
+  // Don't sleep any longer than this so we notice when it's time to stop.
+  constexpr auto MAX_WAIT = std::chrono::milliseconds(100);
+
+  std::atomic<bool> running_(true);
+
+  void on_stop_signal(int)
+  {
+    running_ = false;
+  }
+
+  struct Match_Player
+  {
+    Player player;
+    // The controller reads from here, clients come and go from the id map
+    // so it can't point into that.
+    Input input = {};
+  };
+
+  // Everything one match needs, nothing is shared with the other matches.
+  struct Match
+  {
+    Match(std::string name, uint16_t port, std::size_t max_peers,
+          uint8_t tickrate);
+    ~Match();
+
+    Match(Match const&) = delete;
+    Match& operator=(Match const&) = delete;
+
+    net::Server_Context ctx;
+
+    std::unique_ptr<btDefaultCollisionConfiguration> bt_config;
+    std::unique_ptr<btCollisionDispatcher> bt_dispatcher;
+    std::unique_ptr<btDbvtBroadphase> bt_broadphase;
+    std::unique_ptr<btSequentialImpulseConstraintSolver> bt_solver;
+
+    std::unique_ptr<btDiscreteDynamicsWorld> bt_world;
+
+    // Maps are still loaded along with their meshes and textures, until
+    // they can be loaded without a GPU everybody stands on a plane.
+    btStaticPlaneShape ground_shape{btVector3(0.0f, 1.0f, 0.0f), 0.0f};
+    btCollisionObject ground;
+
+    std::unordered_map<player_id, std::unique_ptr<Match_Player> > players;
+
+    void simulate(float dt);
+    net::Snapshot make_snapshot();
+
+  private:
+    void remove_player(Match_Player& player);
+  };
+
+  Match::Match(std::string name, uint16_t port, std::size_t max_peers,
+               uint8_t tickrate)
+  {
+    bt_config = std::make_unique<btDefaultCollisionConfiguration>();
+    bt_dispatcher = std::make_unique<btCollisionDispatcher>(bt_config.get());
+    bt_broadphase = std::make_unique<btDbvtBroadphase>();
+    bt_solver = std::make_unique<btSequentialImpulseConstraintSolver>();
+
+    bt_world = std::make_unique<btDiscreteDynamicsWorld>(bt_dispatcher.get(),
+                                                         bt_broadphase.get(),
+                                                         bt_solver.get(),
+                                                         bt_config.get());
+
+    bt_world->setGravity(btVector3(0.0f, -9.81f, 0.0f));
+
+    ground.setCollisionShape(&ground_shape);
+    bt_world->addCollisionObject(&ground);
+
+    ctx.name = name;
+    ctx.port = port;
+    ctx.max_peers = max_peers;
+    ctx.rules.tickrate = tickrate;
+    ctx.rules.max_players = std::min<std::size_t>(max_peers, 255);
+    ctx.grid.min = glm::vec3(-512.0f, -16.0f, -512.0f);
+    ctx.grid.max = glm::vec3(512.0f, 48.0f, 512.0f);
+
+    ctx.simulate = [this](net::Server_Context&, float dt)
+    {
+      simulate(dt);
+    };
+    ctx.make_snapshot = [this](net::Server_Context&)
+    {
+      return make_snapshot();
+    };
+
+    net::init_server(ctx);
+  }
+  Match::~Match()
+  {
+    for(auto& player_pair : players) remove_player(*player_pair.second);
+    bt_world->removeCollisionObject(&ground);
+  }
+
+  void Match::simulate(float dt)
+  {
+    // Players come and go with their clients.
+    for(auto it = players.begin(); it != players.end();)
+    {
+      if(ctx.player_ids.count(it->first))
+      {
+        ++it;
+        continue;
+      }
+      remove_player(*it->second);
+      it = players.erase(it);
+    }
+
+    for(auto& client_pair : ctx.clients)
+    {
+      auto& client = client_pair.second;
+      if(client.state != net::Remote_Client_State::Playing) continue;
+
+      auto& player = players[client.player_info->id];
+      if(!player)
+      {
+        player = std::make_unique<Match_Player>();
+        player->player.controller.set_input_ref(&player->input);
+        bt_world->addAction(&player->player.controller);
+      }
+      player->input = client.input;
+    }
+
+    bt_world->stepSimulation(dt, 0);
+  }
+
+  net::Snapshot Match::make_snapshot()
+  {
+    net::Snapshot snap;
+    for(auto& client_pair : ctx.clients)
+    {
+      auto& client = client_pair.second;
+      if(client.state != net::Remote_Client_State::Playing) continue;
+
+      auto player_find = players.find(client.player_info->id);
+      if(player_find == players.end()) continue;
+
+      net::Player_Snapshot player;
+      player.id = client.player_info->id;
+      player.input = client.input;
+      player.position =
+        player_find->second->player.controller.get_player_pos();
+      snap.players.push_back(player);
+    }
+    std::sort(snap.players.begin(), snap.players.end(),
+              [](auto const& lhs, auto const& rhs)
+              {
+                return lhs.id < rhs.id;
+              });
+    return snap;
+  }
+
+  void Match::remove_player(Match_Player& player)
+  {
+    bt_world->removeAction(&player.player.controller);
+    player.player.controller.remove_ghost(bt_world.get());
+  }
+
+  // Every match stays on the thread it started on, the packet pool, channel
+  // pacer and telemetry are all per thread.
+  void run_matches(std::vector<Match*> const& matches)
+  {
+    Scoped_Log_Init log_init{};
+
+    using namespace std::chrono;
+    while(running_)
+    {
+      tick_clock_t::duration wait = MAX_WAIT;
+      for(Match* match : matches)
+      {
+        wait = std::min(wait, net::poll_server(match->ctx));
+      }
+
+      // Sleep until something shows up for any of them or a tick is due.
+      ENetSocketSet sockets;
+      ENET_SOCKETSET_EMPTY(sockets);
+      ENetSocket max_socket = 0;
+      for(Match* match : matches)
+      {
+        ENetSocket socket = match->ctx.host.host->socket;
+        ENET_SOCKETSET_ADD(sockets, socket);
+        max_socket = std::max(max_socket, socket);
+      }
+
+      auto wait_ms = duration_cast<milliseconds>(wait).count();
+      enet_socketset_select(max_socket, &sockets, NULL,
+                            static_cast<enet_uint32>(wait_ms > 0 ? wait_ms :
+                                                     0));
+    }
+  }
+}
+
+int main(int argc, char** argv)
+{
+  Scoped_Log_Init log_init{};
+
+  po::options_description desc("Allowed Options");
+  desc.add_options()
+          ("help", "display help")
+          ("matches", po::value<unsigned int>()->default_value(1),
+           "number of matches to host")
+          ("threads", po::value<unsigned int>(),
+           "threads to run them on, one per core by default")
+          ("port", po::value<uint16_t>()->default_value(28222),
+           "port of the first match, the rest count up from here")
+          ("max-peers", po::value<uint16_t>()->default_value(12),
+           "players in each match")
+          ("tickrate", po::value<unsigned int>()->default_value(20),
+           "ticks per second of every match");
+
+  po::variables_map vm;
+  try
+  {
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    po::notify(vm);
+  }
+  catch(po::error& e)
+  {
+    log_e("%", e.what());
+    return EXIT_FAILURE;
+  }
+
+  if(vm.count("help"))
+  {
+    std::cerr << desc << std::endl;
+    return EXIT_SUCCESS;
+  }
+
+  auto num_matches = std::max(vm["matches"].as<unsigned int>(), 1u);
+  auto port = vm["port"].as<uint16_t>();
+  auto max_peers = vm["max-peers"].as<uint16_t>();
+  auto tickrate = std::min(vm["tickrate"].as<unsigned int>(), 255u);
+
+  unsigned int num_threads = vm.count("threads") ?
+                             vm["threads"].as<unsigned int>() :
+                             std::thread::hardware_concurrency();
+  num_threads = std::max(std::min(num_threads, num_matches), 1u);
+
+  std::vector<std::unique_ptr<Match> > matches;
+  for(unsigned int i = 0; i < num_matches; ++i)
+  {
+    matches.push_back(std::make_unique<Match>("Match " + std::to_string(i),
+                                              port + i, max_peers,
+                                              tickrate));
+  }
+
+  std::signal(SIGINT, on_stop_signal);
+  std::signal(SIGTERM, on_stop_signal);
+
+  // Deal the matches out to the threads.
+  std::vector<std::vector<Match*> > thread_matches(num_threads);
+  for(unsigned int i = 0; i < num_matches; ++i)
+  {
+    thread_matches[i % num_threads].push_back(matches[i].get());
+  }
+
+  std::vector<std::thread> threads;
+  for(auto const& these_matches : thread_matches)
+  {
+    threads.emplace_back([&these_matches]() { run_matches(these_matches); });
+  }
+
+  log_i("Hosting % matches at %hz on ports % to %, % threads", num_matches,
+        tickrate, port, port + num_matches - 1, num_threads);
+
+  for(auto& thread : threads) thread.join();
+
+  log_i("Shutting down");
+  for(auto& match : matches)
+  {
+    match->ctx.ticker->log_stats(match->ctx.name.c_str());
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -11,6 +11,7 @@
 
 // For format(...)
 #include "common/translate.h"
+#include "common/log.h"
 namespace redc
 {
   bool load_spawns(Spawns_Decl& spawns, rapidjson::Value const& val,
@@ -134,13 +135,7 @@ namespace redc
     val = &doc["asset"];
     if(val->IsString())
     {
-      std::string gltfname{val->GetString(), val->GetStringLength()};
-      // Load the gltf scene file
-      if(!load_gltf_file(map.scene, gltfname))
-      {
-        if(err) *err = "Failed to load glTF asset";
-        return false;
-      }
+      map.asset_file = std::string{val->GetString(), val->GetStringLength()};
     }
     else
     {
@@ -191,4 +186,99 @@ namespace redc
 
     return true;
   }
+
+  std::unique_ptr<Collision_Mesh> build_collision_mesh(Map const& map)
+  {
+    auto mesh = std::make_unique<Collision_Mesh>();
+
+    // Use the accessors from the glTF scene.
+    tinygltf::Accessor verts_access;
+    tinygltf::Accessor indices_access;
+
+    if(!resolve_gltf_accessor_data(map.scene, map.collision_vertices_source,
+                                   mesh->vertex_data, verts_access) ||
+       !resolve_gltf_accessor_data(map.scene, map.collision_indices_source,
+                                   mesh->index_data, indices_access))
+    {
+      log_w("Failed to load collision mesh - map collision will be turned off");
+      return nullptr;
+    }
+
+    // Some assertions (but they shouldn't crash the program)
+    if(verts_access.type != TINYGLTF_TYPE_VEC3 &&
+       verts_access.type != TINYGLTF_TYPE_VEC4)
+    {
+      log_w("Collision vertex data must be given as VEC3s or VEC4s");
+      return nullptr;
+    }
+    if(indices_access.type != TINYGLTF_TYPE_SCALAR)
+    {
+      log_w("Collision index data must be given as SCALARs");
+      return nullptr;
+    }
+
+    // Sensible default of the size of a short.
+    std::size_t index_size = 2;
+
+    // I hope the bullet knows what we mean when it comes to signedness.
+    PHY_ScalarType index_type = PHY_INTEGER;
+
+    // Find the size of each index
+    switch(indices_access.componentType)
+    {
+    case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+    case TINYGLTF_COMPONENT_TYPE_BYTE:
+      index_size = 1;
+      index_type = PHY_UCHAR;
+      break;
+    case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+    case TINYGLTF_COMPONENT_TYPE_SHORT:
+      index_size = 2;
+      index_type = PHY_SHORT;
+      break;
+    case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:
+    case TINYGLTF_COMPONENT_TYPE_INT:
+      index_size = 4;
+      index_type = PHY_INTEGER;
+      break;
+    default:
+      log_w("Invalid data type of collision index data");
+      return nullptr;
+    }
+
+    std::size_t vert_size = sizeof(float);
+    PHY_ScalarType vert_type = PHY_FLOAT;
+    switch(verts_access.componentType)
+    {
+    case TINYGLTF_COMPONENT_TYPE_FLOAT:
+      vert_size = sizeof(float);
+      vert_type = PHY_FLOAT;
+      break;
+    case TINYGLTF_COMPONENT_TYPE_DOUBLE:
+      vert_size = sizeof(double);
+      vert_type = PHY_DOUBLE;
+      break;
+    }
+
+    btIndexedMesh indexed_mesh;
+
+    indexed_mesh.m_numVertices = indices_access.count;
+    indexed_mesh.m_triangleIndexBase =
+      &mesh->index_data[indices_access.byteOffset];
+    indexed_mesh.m_triangleIndexStride = index_size * 3;
+
+    indexed_mesh.m_numTriangles = indices_access.count / 3;
+    indexed_mesh.m_vertexBase = &mesh->vertex_data[verts_access.byteOffset];
+    indexed_mesh.m_vertexStride = vert_size * 3;
+    indexed_mesh.m_vertexType = vert_type;
+
+    mesh->vertices = std::make_unique<btTriangleIndexVertexArray>();
+    mesh->vertices->addIndexedMesh(indexed_mesh, index_type);
+
+    // This builds the BVH, it's the expensive part.
+    mesh->shape = std::make_unique<btBvhTriangleMeshShape>(
+        mesh->vertices.get(), false, true);
+
+    return mesh;
+  }
 }
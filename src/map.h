@@ -81,11 +81,29 @@ namespace redc
     glm::vec3 gravity;
   };
 
+  // Collision geometry for a map. This doesn't touch the physics world so it
+  // can be built on any thread, which is nice because the BVH build for a big
+  // map is not cheap.
+  struct Collision_Mesh
+  {
+    std::vector<uint8_t> vertex_data;
+    std::vector<uint8_t> index_data;
+
+    std::unique_ptr<btTriangleIndexVertexArray> vertices;
+    std::unique_ptr<btBvhTriangleMeshShape> shape;
+  };
+
   struct Map
   {
     std::string name;
 
+    // The glTF file given in the map json, it's loaded into scene separately.
+    std::string asset_file;
     tinygltf::Scene scene;
+
+    // Techniques the scene's materials are rendered with. Only loaded when the
+    // map is going to be rendered.
+    tinygltf::Scene techniques;
     short players;
 
     Spawns_Decl spawns;
@@ -97,6 +115,9 @@ namespace redc
     Physics_Decl physics_decl;
     std::vector<Physics_Event_Decl> physics_events;
 
+    // Built while loading, it's up to the server to put it in a world.
+    std::unique_ptr<Collision_Mesh> collision_mesh;
+
     // Initialized later, if necessary.
     std::unique_ptr<Rendering_Component> render;
     std::unique_ptr<Physics_Component> physics;
@@ -105,6 +126,11 @@ namespace redc
 
   bool load_spawns(Spawns_Decl& spawns, rapidjson::Value const& val,
                    std::string* err);
+  // This doesn't load the glTF asset itself, see Map::asset_file.
   bool load_map_json(Map& map, rapidjson::Value const& doc, std::string* err);
 
+  // Returns nullptr and logs a warning if the map's collision accessors are
+  // missing or invalid.
+  std::unique_ptr<Collision_Mesh> build_collision_mesh(Map const& map);
+
 }
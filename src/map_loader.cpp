@@ -0,0 +1,206 @@
+/*
+ * Copyright (C) 2016 Luke San Antonio
+ * All rights reserved.
+ */
+#include "map_loader.h"
+#include "map.h"
+
+#include <atomic>
+#include <fstream>
+#include <sstream>
+
+#include "common/json.h"
+#include "common/log.h"
+#include "assets/minigltf.h"
+
+#include <boost/filesystem/path.hpp>
+
+namespace redc
+{
+  // The cel shading techniques every rendered map uses.
+  constexpr char const* TECHNIQUES_FILE = "../assets/gltf/library-pre.gltf";
+
+  struct Map_Loader::Load_Job
+  {
+    std::string filename;
+    bool load_render_data;
+
+    std::unique_ptr<Map> map;
+
+    std::string scene_source;
+    std::string techniques_source;
+
+    // Worker stages that haven't finished yet, whoever finishes last hands the
+    // map off.
+    std::atomic<int> stages_left;
+    std::atomic<bool> failed;
+  };
+
+  namespace
+  {
+    bool read_file(std::string const& filename, std::string& out)
+    {
+      std::ifstream file{filename};
+      if(!file.good()) return false;
+
+      std::ostringstream buf;
+      buf << file.rdbuf();
+      out = buf.str();
+      return true;
+    }
+
+    std::string base_dir(std::string const& filename)
+    {
+      return boost::filesystem::path(filename).parent_path().string();
+    }
+  }
+
+  Map_Loader::Map_Loader(Job_System& jobs)
+    : jobs_(&jobs), running_(true)
+  {
+    io_thread_ = std::thread([this]() { run_io_(); });
+  }
+  Map_Loader::~Map_Loader()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mut_);
+      running_ = false;
+    }
+    io_cond_.notify_all();
+
+    // Maps that haven't been read yet are dropped, but we can't go anywhere
+    // until the jobs that were already started finish.
+    io_thread_.join();
+    jobs_->wait(pending_);
+  }
+
+  void Map_Loader::load(std::string const& filename, bool load_render_data)
+  {
+    log_i("Loading map '%'...", filename);
+
+    auto job = std::make_shared<Load_Job>();
+    job->filename = filename;
+    job->load_render_data = load_render_data;
+    job->stages_left = load_render_data ? 2 : 1;
+    job->failed = false;
+
+    {
+      std::lock_guard<std::mutex> lock(mut_);
+      io_queue_.push(std::move(job));
+    }
+    io_cond_.notify_one();
+  }
+
+  bool Map_Loader::poll_loaded(std::unique_ptr<Map>& map)
+  {
+    std::lock_guard<std::mutex> lock(mut_);
+    if(loaded_.empty()) return false;
+
+    map = std::move(loaded_.front());
+    loaded_.pop();
+    return true;
+  }
+
+  void Map_Loader::run_io_()
+  {
+    while(true)
+    {
+      std::shared_ptr<Load_Job> job;
+      {
+        std::unique_lock<std::mutex> lock(mut_);
+        io_cond_.wait(lock, [this]() { return !running_ || io_queue_.size(); });
+        if(!running_) return;
+
+        job = std::move(io_queue_.front());
+        io_queue_.pop();
+      }
+
+      // Load json file
+      rapidjson::Document mapdoc;
+      if(!load_json(mapdoc, job->filename + ".json"))
+      {
+        log_e("Failed to load map file: %.json", job->filename);
+        continue;
+      }
+
+      // Allocate on the heap so the address doesn't change, it might be
+      // referenced in the physics or render component.
+      job->map = std::make_unique<Map>();
+
+      std::string err;
+      if(!load_map_json(*job->map, mapdoc, &err))
+      {
+        log_e("Failed to load map '%': %", job->filename, err);
+        continue;
+      }
+
+      if(!read_file(job->map->asset_file, job->scene_source))
+      {
+        log_e("Failed to load map '%': Failed to read glTF asset '%'",
+              job->filename, job->map->asset_file);
+        continue;
+      }
+      if(job->load_render_data &&
+         !read_file(TECHNIQUES_FILE, job->techniques_source))
+      {
+        log_e("glTF techniques could not be found; broken installation");
+        continue;
+      }
+
+      // Everything else is CPU-bound, let the job system deal with it. The
+      // scene and techniques don't depend on each other so they can be parsed
+      // at the same time.
+      jobs_->run([this, job]()
+      {
+        Map& map = *job->map;
+        if(load_gltf_string(map.scene, job->scene_source,
+                            base_dir(map.asset_file), map.asset_file))
+        {
+          // We don't need the source anymore.
+          job->scene_source = std::string{};
+
+          // This logs on failure but the map is still usable without
+          // collision.
+          map.collision_mesh = build_collision_mesh(map);
+        }
+        else
+        {
+          job->failed = true;
+        }
+        finish_job_stage_(job);
+      }, &pending_);
+
+      if(job->load_render_data)
+      {
+        jobs_->run([this, job]()
+        {
+          if(!load_gltf_string(job->map->techniques, job->techniques_source,
+                               base_dir(TECHNIQUES_FILE), TECHNIQUES_FILE))
+          {
+            log_e("glTF techniques could not be loaded; broken installation");
+            job->failed = true;
+          }
+          job->techniques_source = std::string{};
+          finish_job_stage_(job);
+        }, &pending_);
+      }
+    }
+  }
+
+  void Map_Loader::finish_job_stage_(std::shared_ptr<Load_Job> const& job)
+  {
+    // Only the last stage to finish gets to hand off the map.
+    if(--job->stages_left != 0) return;
+
+    if(job->failed)
+    {
+      log_e("Failed to load map '%'", job->filename);
+      return;
+    }
+
+    log_i("Successfully loaded map '%'", job->filename);
+
+    std::lock_guard<std::mutex> lock(mut_);
+    loaded_.push(std::move(job->map));
+  }
+}
@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2016 Luke San Antonio
+ * All rights reserved.
+ */
+#ifndef REDC_MAP_LOADER_H
+#define REDC_MAP_LOADER_H
+#include <memory>
+#include <string>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "common/jobs.h"
+namespace redc
+{
+  struct Map;
+
+  // Loads maps without stalling the main thread. Files are read and the map
+  // json is parsed on an I/O thread, then the glTF documents are parsed (this
+  // is where images get decoded) and the collision BVH is built as jobs.
+  // Nothing here touches the GPU or a physics world, finished maps are picked
+  // up on the main thread with poll_loaded.
+  struct Map_Loader
+  {
+    // The job system must outlive the loader.
+    explicit Map_Loader(Job_System& jobs);
+    ~Map_Loader();
+
+    // Returns immediately, the map shows up in poll_loaded some time later. If
+    // it fails to load an error is logged and it never shows up at all.
+    void load(std::string const& filename, bool load_render_data);
+
+    bool poll_loaded(std::unique_ptr<Map>& map);
+
+  private:
+    struct Load_Job;
+
+    void run_io_();
+    void finish_job_stage_(std::shared_ptr<Load_Job> const& job);
+
+    Job_System* jobs_;
+
+    std::mutex mut_;
+    std::condition_variable io_cond_;
+    bool running_;
+
+    std::queue<std::shared_ptr<Load_Job> > io_queue_;
+    std::queue<std::unique_ptr<Map> > loaded_;
+
+    // Jobs that haven't finished yet, we have to wait on these before we are
+    // destroyed since they reference us.
+    Job_Counter pending_;
+
+    std::thread io_thread_;
+  };
+}
+#endif
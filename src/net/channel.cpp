@@ -0,0 +1,173 @@
+/*
+ * Copyright (C) 2017 Luke San Antonio
+ * All rights reserved.
+ */
+#include "channel.h"
+#include <algorithm>
+#include "../common/thread_local.h"
+namespace redc { namespace net
+{
+  namespace
+  {
+    // A channel can save up this much of its cap for a burst.
+    constexpr float MAX_BURST_SECONDS = 0.25f;
+
+    bool send_now(ENetPacket* packet, ENetPeer* peer, Channel channel)
+    {
+      return enet_peer_send(peer, static_cast<uint8_t>(channel), packet) == 0;
+    }
+
+    void release_held(ENetPacket* packet)
+    {
+      if(--packet->referenceCount == 0) enet_packet_destroy(packet);
+    }
+  }
+
+  Channel_Config default_channel_config(Channel channel) noexcept
+  {
+    switch(channel)
+    {
+      case Channel::Control:
+        return {true, 0};
+      case Channel::Events:
+        return {true, 32 * 1024};
+      case Channel::State:
+        return {false, 64 * 1024};
+      case Channel::Bulk:
+        return {true, 64 * 1024};
+    }
+    return {true, 0};
+  }
+
+  Channel_Pacer::Channel_Pacer() noexcept
+  {
+    for(std::size_t i = 0; i < CHANNEL_COUNT; ++i)
+    {
+      configs_[i] = default_channel_config(static_cast<Channel>(i));
+    }
+  }
+  Channel_Pacer::~Channel_Pacer() noexcept
+  {
+    for(auto& peer_pair : peers_)
+    {
+      for(Lane& lane : peer_pair.second)
+      {
+        for(ENetPacket* packet : lane.held) release_held(packet);
+      }
+    }
+  }
+
+  void Channel_Pacer::configure(Channel channel,
+                                Channel_Config config) noexcept
+  {
+    configs_[static_cast<std::size_t>(channel)] = config;
+  }
+  Channel_Config const& Channel_Pacer::config(Channel channel) const noexcept
+  {
+    return configs_[static_cast<std::size_t>(channel)];
+  }
+
+  bool Channel_Pacer::send(ENetPacket* packet, ENetPeer* peer,
+                           Channel channel) noexcept
+  {
+    if(!packet) return false;
+
+    auto index = static_cast<std::size_t>(channel);
+    Channel_Config const& config = configs_[index];
+    if(!config.bytes_per_second) return send_now(packet, peer, channel);
+
+    Lane& lane = peers_[peer][index];
+    refill_(lane, config, tick_clock_t::now());
+
+    // Reliable packets have to stay behind whatever is already held.
+    if(lane.held.empty() && lane.allowance > 0.0f)
+    {
+      if(!send_now(packet, peer, channel)) return false;
+      lane.allowance -= packet->dataLength;
+      return true;
+    }
+
+    if(!(packet->flags & ENET_PACKET_FLAG_RELIABLE)) return false;
+
+    // Keep it alive until we get around to it.
+    ++packet->referenceCount;
+    lane.held.push_back(packet);
+    return true;
+  }
+
+  void Channel_Pacer::pump() noexcept
+  {
+    auto now = tick_clock_t::now();
+    for(auto& peer_pair : peers_)
+    {
+      ENetPeer* peer = peer_pair.first;
+      for(std::size_t i = 0; i < CHANNEL_COUNT; ++i)
+      {
+        Lane& lane = peer_pair.second[i];
+        if(lane.held.empty()) continue;
+
+        refill_(lane, configs_[i], now);
+        while(!lane.held.empty() && lane.allowance > 0.0f)
+        {
+          ENetPacket* packet = lane.held.front();
+          lane.held.pop_front();
+          lane.allowance -= packet->dataLength;
+
+          // ENet takes its own reference if it takes the packet at all.
+          --packet->referenceCount;
+          if(!send_now(packet, peer, static_cast<Channel>(i)) &&
+             packet->referenceCount == 0)
+          {
+            enet_packet_destroy(packet);
+          }
+        }
+      }
+    }
+  }
+
+  void Channel_Pacer::forget(ENetPeer* peer) noexcept
+  {
+    auto peer_find = peers_.find(peer);
+    if(peer_find == peers_.end()) return;
+
+    for(Lane& lane : peer_find->second)
+    {
+      for(ENetPacket* packet : lane.held) release_held(packet);
+    }
+    peers_.erase(peer_find);
+  }
+
+  std::size_t Channel_Pacer::held(ENetPeer* peer,
+                                  Channel channel) const noexcept
+  {
+    auto peer_find = peers_.find(peer);
+    if(peer_find == peers_.end()) return 0;
+    return peer_find->second[static_cast<std::size_t>(channel)].held.size();
+  }
+
+  void Channel_Pacer::refill_(Lane& lane, Channel_Config const& config,
+                              tick_clock_t::time_point now) noexcept
+  {
+    float burst = config.bytes_per_second * MAX_BURST_SECONDS;
+    if(!lane.started)
+    {
+      lane.started = true;
+      lane.last_refill = now;
+      lane.allowance = burst;
+      return;
+    }
+
+    float seconds = std::chrono::duration<float>(now - lane.last_refill)
+                      .count();
+    lane.last_refill = now;
+    lane.allowance = std::min(lane.allowance +
+                              seconds * config.bytes_per_second, burst);
+  }
+
+  Channel_Pacer& channel_pacer() noexcept
+  {
+    static REDC_THREAD_LOCAL Channel_Pacer* pacer = nullptr;
+    if(!pacer) pacer = new Channel_Pacer;
+    return *pacer;
+  }
+} }
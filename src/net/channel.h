@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2017 Luke San Antonio
+ * All rights reserved.
+ */
+#pragma once
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <unordered_map>
+#include <enet/enet.h>
+#include "../common/fixed_tick.h"
+namespace redc { namespace net
+{
+  // Reliable traffic on one ENet channel waits for anything lost before it,
+  // so things that don't depend on each other go on different channels.
+  enum class Channel : uint8_t
+  {
+    // The handshake and anything else the connection can't go on without.
+    // Players joining and leaving go here too, so they can't get ahead of
+    // the server info they're changing.
+    Control,
+    // Gameplay events that have to arrive in order.
+    Events,
+    // Unreliable, ENet drops anything older than what it already delivered
+    // on this channel. Snapshots and input.
+    State,
+    // Big reliable transfers like maps and assets, so they don't hold up
+    // anything else.
+    Bulk,
+  };
+
+  constexpr std::size_t CHANNEL_COUNT =
+    static_cast<std::size_t>(Channel::Bulk) + 1;
+
+  struct Channel_Config
+  {
+    bool reliable;
+    // Most we send any one peer on this channel, zero for no limit.
+    uint32_t bytes_per_second;
+  };
+
+  Channel_Config default_channel_config(Channel channel) noexcept;
+
+  /*!
+   * \brief Keeps each peer's channels under their bandwidth caps.
+   *
+   * Over the cap, unreliable packets are dropped since a newer one will be
+   * along soon. Reliable ones are held, in order, until there's room for
+   * them: call pump regularly, before flushing the host. A channel can go
+   * over by one packet so nothing is ever too big to send.
+   *
+   * Like the packet pool there's one of these for each thread.
+   */
+  struct Channel_Pacer
+  {
+    Channel_Pacer() noexcept;
+    ~Channel_Pacer() noexcept;
+
+    Channel_Pacer(Channel_Pacer const&) = delete;
+    Channel_Pacer& operator=(Channel_Pacer const&) = delete;
+
+    void configure(Channel channel, Channel_Config config) noexcept;
+    Channel_Config const& config(Channel channel) const noexcept;
+
+    // False if the packet was dropped or ENet wouldn't take it, a held
+    // packet counts as sent. Release the packet as usual afterwards.
+    bool send(ENetPacket* packet, ENetPeer* peer, Channel channel) noexcept;
+
+    // Sends whatever held packets fit now.
+    void pump() noexcept;
+
+    // Drops anything held for the peer, call it when they disconnect.
+    void forget(ENetPeer* peer) noexcept;
+
+    std::size_t held(ENetPeer* peer, Channel channel) const noexcept;
+
+  private:
+    struct Lane
+    {
+      // Bytes we can send right now, negative after going over.
+      float allowance = 0.0f;
+      tick_clock_t::time_point last_refill;
+      bool started = false;
+
+      std::deque<ENetPacket*> held;
+    };
+    using Peer_Lanes = std::array<Lane, CHANNEL_COUNT>;
+
+    std::array<Channel_Config, CHANNEL_COUNT> configs_;
+    std::unordered_map<ENetPeer*, Peer_Lanes> peers_;
+
+    void refill_(Lane& lane, Channel_Config const& config,
+                 tick_clock_t::time_point now) noexcept;
+  };
+
+  Channel_Pacer& channel_pacer() noexcept;
+} }
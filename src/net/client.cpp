@@ -3,6 +3,7 @@
  * All rights reserved.
  */
 #include "client.h"
+#include <algorithm>
 #include "../common/log.h"
 namespace redc { namespace net
 {
@@ -26,6 +27,57 @@ namespace redc { namespace net
     res.event_handled = true;
   }
 
+  bool receive_snapshot(Client_Context& ctx, ENetPacket* packet) noexcept
+  {
+    auto data = packet->data;
+    auto size = packet->dataLength;
+    if(size < 1 || data[0] != SNAPSHOT_PACKET_TAG) return false;
+
+    // Snapshots are unreliable, anything older than what we have is useless.
+    Snapshot snap;
+    auto baseline = ctx.snapshots.find(snapshot_baseline_tick(data, size));
+    net_telemetry().count_received(ctx.server_peer, Message_Type::Snapshot,
+                                   size);
+    if(decode_snapshot(data, size, baseline, ctx.server_info.grid, snap) &&
+       (ctx.cur_input.ack_tick == NO_BASELINE ||
+        snap.tick > ctx.cur_input.ack_tick))
+    {
+      ctx.cur_input.ack_tick = snap.tick;
+      ctx.cur_snapshot = snap;
+      ctx.snapshots.push(std::move(snap));
+    }
+    return true;
+  }
+
+  bool receive_roster_update(Client_Context& ctx, ENetPacket* packet) noexcept
+  {
+    Roster_Update update;
+    if(!receive_data(update, packet, ctx.server_peer)) return false;
+
+    auto& players = ctx.server_info.players;
+    auto player = std::find_if(players.begin(), players.end(),
+      [&](auto const& info) { return info.id == update.player.id; });
+
+    if(update.joined)
+    {
+      if(player == players.end()) players.push_back(update.player);
+      else *player = update.player;
+    }
+    else if(player != players.end())
+    {
+      players.erase(player);
+    }
+    return true;
+  }
+
+  uint8_t send_input(Client_Context& ctx, Input const& input) noexcept
+  {
+    ++ctx.cur_input.index;
+    ctx.cur_input.input = input;
+    send_data(ctx.cur_input, ctx.server_peer, Channel::State);
+    return ctx.cur_input.index;
+  }
+
 #define REQUIRE_EVENT(ctx, event, type_name) \
   if(!event) break; \
   if(event->type != ENET_EVENT_TYPE_##type_name) break
@@ -44,8 +96,7 @@ namespace redc { namespace net
       {
         // Assuming that the server address has already been set.
         ctx.host = std::move(*make_client_host().ok());
-        // How many channels? Just one?
-        enet_host_connect(ctx.host.host, &ctx.server_addr, 1, 0);
+        enet_host_connect(ctx.host.host, &ctx.server_addr, CHANNEL_COUNT, 0);
         // We are now in the process of connecting! Exciting times!
         set_state(res, ctx, Client_State::Connecting);
         break;
@@ -66,7 +117,7 @@ namespace redc { namespace net
 
           // Send both
           Version_Info version{PROTOCOL_VERSION, ctx.client_version};
-          send_data(version, ctx.server_peer);
+          send_data(version, ctx.server_peer, Channel::Control);
 
           // Now we are waiting for a response
           set_state(res, ctx, Client_State::Waiting_For_Server_Info);
@@ -85,7 +136,7 @@ namespace redc { namespace net
         Version_Okay version_okay;
         Server_Info server_info;
 
-        if(receive_data(version_okay, event->packet))
+        if(receive_data(version_okay, event->packet, event->peer))
         {
           // Was our protocol version rejected, client version rejected?
           // Or both?
@@ -118,7 +169,7 @@ namespace redc { namespace net
           // We did handle this event
           set_event_handled(res, event->packet);
         }
-        else if(receive_data(server_info, event->packet))
+        else if(receive_data(server_info, event->packet, event->peer))
         {
           // Looks like we got server info on our hands.
           ctx.server_info = server_info;
@@ -129,7 +180,7 @@ namespace redc { namespace net
       }
       case Client_State::Sending_Client_Info:
       {
-        send_data(ctx.player_info, ctx.server_peer);
+        send_data(ctx.player_info, ctx.server_peer, Channel::Control);
         set_state(res, ctx, Client_State::Waiting_For_Spawn);
         break;
       }
@@ -138,8 +189,15 @@ namespace redc { namespace net
         REQUIRE_EVENT(ctx, event, RECEIVE);
         REQUIRE_EVENT_FROM_SERVER(ctx, event);
 
+        // Players can come and go while we wait.
+        if(receive_roster_update(ctx, event->packet))
+        {
+          set_event_handled(res, event->packet);
+          break;
+        }
+
         // Try to decode Spawn information struct
-        if(receive_data(ctx.spawn, event->packet))
+        if(receive_data(ctx.spawn, event->packet, event->peer))
         {
           // The client code should now populate the inventory field.
           set_state(res, ctx, Client_State::Playing);
@@ -154,7 +212,11 @@ namespace redc { namespace net
           if(event->type == ENET_EVENT_TYPE_RECEIVE)
           {
             // Receive game packets
-            receive_data(ctx.cur_update, event->packet);
+            if(receive_snapshot(ctx, event->packet) ||
+               receive_roster_update(ctx, event->packet))
+            {
+              set_event_handled(res, event->packet);
+            }
           }
         }
         else
@@ -163,13 +225,19 @@ namespace redc { namespace net
 
           // Send latest client input with some index so that inputs with the
           // same id can be idempotent.
-          send_data(ctx.cur_input, ctx.server_peer);
+          send_data(ctx.cur_input, ctx.server_peer, Channel::State);
         }
       }
       case Client_State::Bad_Version:
         break;
     }
 
+    // So we know our own rtt and loss, the server does the same on its end.
+    if(ctx.host.host)
+    {
+      net_telemetry().sample(ctx.host.host, tick_clock_t::now());
+    }
+
     return res;
   }
 } }
@@ -4,15 +4,17 @@
  */
 #pragma once
 #include <cstdint>
+#include <set>
 #include <string>
 #include <glm/glm.hpp>
 #include <glm/gtc/quaternion.hpp>
-#include <msgpack.hpp>
-
-#include "../common/glm_vec_serialize.h"
 
 #include "net_io.h"
 #include "common.h"
+#include "packet_pool.h"
+#include "snapshot.h"
+#include "prediction.h"
+#include "telemetry.h"
 namespace redc { namespace net
 {
   // 1. Client initiates a connection to the server, sends a packet with:
@@ -59,7 +61,7 @@ namespace redc { namespace net
     uint8_t tickrate;
     uint8_t max_players;
 
-    MSGPACK_DEFINE(tickrate, max_players);
+    REDC_SERIALIZE(tickrate, max_players);
   };
 
   // Player information
@@ -71,7 +73,7 @@ namespace redc { namespace net
     // Zero for no team association
     team_id team;
 
-    MSGPACK_DEFINE(id, name);
+    REDC_SERIALIZE(id, name);
   };
 
   // Hashs the objects id member
@@ -91,7 +93,7 @@ namespace redc { namespace net
   struct Team
   {
     std::string name;
-    MSGPACK_DEFINE(name);
+    REDC_SERIALIZE(name);
   };
 
   // Includes meta-information about the game. Each client receives this as
@@ -103,7 +105,21 @@ namespace redc { namespace net
     std::vector<Player_Info> players;
     std::vector<Team> teams;
 
-    MSGPACK_DEFINE(rules, players, teams);
+    // Snapshot positions are on this grid.
+    Quantize_Grid grid;
+
+    REDC_SERIALIZE(rules, players, teams, grid);
+  };
+
+  // Everybody that has the server info gets one of these when a player joins
+  // or leaves, rather than the whole server info again. Players that left
+  // only have their id filled in.
+  struct Roster_Update
+  {
+    bool joined;
+    Player_Info player;
+
+    REDC_SERIALIZE(joined, player);
   };
 
   struct Spawn
@@ -114,7 +130,7 @@ namespace redc { namespace net
     // Angle of the player rotating around the y axis.
     float angle;
 
-    MSGPACK_DEFINE(position, angle);
+    REDC_SERIALIZE(position, angle);
   };
 
   // This is for clients to keep track of the server
@@ -138,6 +154,9 @@ namespace redc { namespace net
     Spawn spawn;
     // Playing
     Input_Update cur_input;
+    // Newest snapshot from the server, and the ones it may delta against.
+    Snapshot cur_snapshot;
+    Snapshot_History snapshots;
   };
 
   /*!
@@ -146,7 +165,8 @@ namespace redc { namespace net
 
    * This function will properly destroy a packet it has consumed / used.
    * If event_handled is returned false, the packet should still be usable and
-   * must be destroyed by other code.
+   * must be destroyed by other code. Every step also samples the host for
+   * net_telemetry.
    *
    * \returns Whether or not the event parameter was utilized. If it's false,
    * the event should be handled elsewhere, if it's true ctx probably changed
@@ -160,43 +180,88 @@ namespace redc { namespace net
   Step_Client_Result step_client(Client_Context& ctx,
                                  ENetEvent const* event) noexcept;
 
+  // Sends the next input, returns the index it went out with. Predict with
+  // that index.
+  uint8_t send_input(Client_Context& ctx, Input const& input) noexcept;
+
+  // Checks our prediction against the newest snapshot.
+  template <class State>
+  void reconcile_snapshot(Client_Context const& ctx,
+                          Client_Prediction<State>& prediction) noexcept
+  {
+    Snapshot const& snap = ctx.cur_snapshot;
+    if(!snap.has_input_ack) return;
+
+    for(auto const& player : snap.players)
+    {
+      if(player.id == ctx.player_info.id)
+      {
+        prediction.reconcile(snap.input_ack, player.position);
+        break;
+      }
+    }
+  }
+
   // I'm thinking the above stuff (player, team) could be idempotent at the
   // cost of the little extra bandwidth. Instead of worrying about specifically
   // constructed packets that say "This team now has this name" we can just
   // resend the definition, we can let the client figure out the differences.
 
-  // Helper functions to send and receive.
+  // Telemetry counts bandwidth by these.
+  REDC_NET_MESSAGE_TYPE(Version_Info);
+  REDC_NET_MESSAGE_TYPE(Version_Okay);
+  REDC_NET_MESSAGE_TYPE(Server_Info);
+  REDC_NET_MESSAGE_TYPE(Player_Info);
+  REDC_NET_MESSAGE_TYPE(Roster_Update);
+  REDC_NET_MESSAGE_TYPE(Spawn);
+  REDC_NET_MESSAGE_TYPE(Input_Update);
+
+  // Helper functions to send and receive. Whether it's reliable depends on
+  // the channel.
   template <class T>
-  void send_data(T const& t, ENetPeer* peer, bool reliable = true) noexcept
+  void send_data(T const& t, ENetPeer* peer, Channel channel) noexcept
   {
-    msgpack::sbuffer buf;
-    msgpack::pack(buf, t);
+    auto packet = pack_packet(t, channel_pacer().config(channel).reliable);
+    if(!packet) return;
 
-    uint32_t flags = 0;
-    if(reliable) flags = ENET_PACKET_FLAG_RELIABLE;
+    // Once it's sent it may not be ours to look at anymore.
+    std::size_t size = packet->dataLength;
+    if(send_packet(packet, peer, channel))
+    {
+      net_telemetry().count_sent(peer, Message_Type_Of<T>::value, size);
+    }
+    release_unsent(packet);
+  }
 
+  // Packs the data once and sends the same packet to every peer.
+  template <class T, class Peer_It, class Get_Peer>
+  void broadcast_data(T const& t, Peer_It begin, Peer_It end,
+                      Get_Peer get_peer, Channel channel) noexcept
+  {
+    auto packet = pack_packet(t, channel_pacer().config(channel).reliable);
+    if(!packet) return;
 
-    // Make the version packet
-    auto packet = enet_packet_create(buf.data(), buf.size(), flags);
-    enet_peer_send(peer, 0, packet);
+    std::size_t size = packet->dataLength;
+    for(; begin != end; ++begin)
+    {
+      ENetPeer* peer = get_peer(*begin);
+      if(send_packet(packet, peer, channel))
+      {
+        net_telemetry().count_sent(peer, Message_Type_Of<T>::value, size);
+      }
+    }
+    release_unsent(packet);
   }
 
+  // Counted against the peer it came from, if there is one.
   template <class T>
-  bool receive_data(T& t, ENetPacket* packet) noexcept
+  bool receive_data(T& t, ENetPacket* packet,
+                    ENetPeer* from = nullptr) noexcept
   {
-    msgpack::unpacked unpacked;
-    msgpack::unpack(unpacked, (const char*) packet->data, packet->dataLength);
-    try
-    {
-      // Try to do the conversion
-      t = unpacked.get().as<T>();
-      // If we get here it worked!
-      return true;
-    }
-    catch(...)
-    {
-      // We failed to do that conversion
-      return false;
-    }
+    if(!unpack_packet(t, packet)) return false;
+
+    net_telemetry().count_received(from, Message_Type_Of<T>::value,
+                                   packet->dataLength);
+    return true;
   }
 } }
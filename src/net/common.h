@@ -6,11 +6,11 @@
 #ifndef REDC_ENGINE_COMMON_H
 #define REDC_ENGINE_COMMON_H
 #include <cstdint>
-#include <msgpack.hpp>
-#include "../input/input.h"
+#include "../common/serialize.h"
+#include "../input/sampled_input.h"
 namespace redc
 {
-  constexpr static uint16_t PROTOCOL_VERSION = 1;
+  constexpr static uint16_t PROTOCOL_VERSION = 5;
 
   // Hahahaha fuck it
   using okay_t = bool;
@@ -23,7 +23,7 @@ namespace redc
     version_t protocol_version;
     version_t client_version;
 
-    MSGPACK_DEFINE(protocol_version, client_version);
+    REDC_SERIALIZE(protocol_version, client_version);
   };
 
   struct Version_Okay
@@ -31,7 +31,7 @@ namespace redc
     okay_t protocol;
     okay_t client;
 
-    MSGPACK_DEFINE(protocol, client);
+    REDC_SERIALIZE(protocol, client);
   };
 
   // Yah I'm going to have to say a maximum of 65,535 teams, sorry.
@@ -40,12 +40,18 @@ namespace redc
 
   using player_id = uint16_t;
 
+  // Snapshots are numbered by server tick, this one means no snapshot.
+  constexpr static uint32_t NO_BASELINE = 0xffffffff;
+
   struct Input_Update
   {
     uint8_t index;
     Input input;
 
-    MSGPACK_DEFINE(index, input);
+    // The newest snapshot we have, the server sends deltas against it.
+    uint32_t ack_tick = NO_BASELINE;
+
+    REDC_SERIALIZE(index, input, ack_tick);
   };
 }
 #endif //RED_CRANE_ENGINE_COMMON_H
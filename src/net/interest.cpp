@@ -0,0 +1,165 @@
+/*
+ * Copyright (C) 2017 Luke San Antonio
+ * All rights reserved.
+ */
+#include "interest.h"
+#include <algorithm>
+#include <cmath>
+namespace redc { namespace net
+{
+  namespace
+  {
+    // Nothing comes before the viewer's own player.
+    constexpr float SELF_RELEVANCE = 1.0e6f;
+
+    struct Candidate
+    {
+      std::size_t index;
+      float priority;
+    };
+
+    Player_Snapshot const* find_player(Snapshot const* snap,
+                                       player_id id) noexcept
+    {
+      if(!snap) return nullptr;
+
+      auto it = std::lower_bound(snap->players.begin(), snap->players.end(),
+                                 id, [](auto const& player, player_id id)
+                                 {
+                                   return player.id < id;
+                                 });
+      if(it == snap->players.end() || it->id != id) return nullptr;
+      return &*it;
+    }
+  }
+
+  void Spatial_Grid::build(Snapshot const& snap) noexcept
+  {
+    for(auto& cell : cells_) cell.second.clear();
+
+    for(std::size_t i = 0; i < snap.players.size(); ++i)
+    {
+      glm::vec3 const& pos = snap.players[i].position;
+      cells_[key_(cell_(pos.x), cell_(pos.z))].push_back(i);
+    }
+  }
+
+  int32_t Spatial_Grid::cell_(float coord) const noexcept
+  {
+    return static_cast<int32_t>(std::floor(coord / cell_size_));
+  }
+  uint64_t Spatial_Grid::key_(int32_t x, int32_t z) noexcept
+  {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) |
+           static_cast<uint32_t>(z);
+  }
+
+  Snapshot interest_snapshot(Snapshot const& world, Spatial_Grid const& grid,
+                             Client_Interest& interest,
+                             glm::vec3 const* viewer, player_id self,
+                             Snapshot const* baseline,
+                             Quantize_Grid const& qgrid,
+                             Interest_Config const& config) noexcept
+  {
+    // Find who's relevant now and bump everybody's priority.
+    std::vector<Candidate> candidates;
+    std::unordered_set<player_id> relevant;
+
+    auto consider = [&](std::size_t index, float relevance)
+    {
+      player_id id = world.players[index].id;
+      relevant.insert(id);
+
+      float& priority = interest.priority[id];
+      priority += relevance;
+      candidates.push_back({index, priority});
+    };
+
+    if(viewer)
+    {
+      float enter2 = config.enter_radius * config.enter_radius;
+      float leave2 = config.leave_radius * config.leave_radius;
+
+      grid.query(*viewer, config.leave_radius, [&](std::size_t index)
+      {
+        auto const& player = world.players[index];
+        if(player.id == self)
+        {
+          consider(index, SELF_RELEVANCE);
+          return;
+        }
+
+        glm::vec3 diff = player.position - *viewer;
+        float dist2 = glm::dot(diff, diff);
+        if(dist2 > leave2) return;
+        if(dist2 > enter2 && !interest.relevant.count(player.id)) return;
+
+        // Closer is more important, the edge of the view is worth a quarter
+        // of somebody right next to us.
+        float dist = std::sqrt(dist2);
+        consider(index, 1.0f / (1.0f + 3.0f * dist / config.leave_radius));
+      });
+    }
+    else
+    {
+      for(std::size_t i = 0; i < world.players.size(); ++i) consider(i, 1.0f);
+    }
+
+    // Forget about whoever left.
+    for(auto it = interest.priority.begin(); it != interest.priority.end();)
+    {
+      if(!relevant.count(it->first)) it = interest.priority.erase(it);
+      else ++it;
+    }
+    interest.relevant = std::move(relevant);
+
+    std::size_t num_removed = 0;
+    if(baseline)
+    {
+      for(auto const& player : baseline->players)
+      {
+        if(!interest.relevant.count(player.id)) ++num_removed;
+      }
+    }
+
+    // Removals have to go out regardless, the rest is first come first
+    // served by priority.
+    std::size_t budget = config.budget_bytes * 8;
+    std::size_t overhead = snapshot_overhead_bits(num_removed);
+    budget = budget > overhead ? budget - overhead : 0;
+
+    std::sort(candidates.begin(), candidates.end(),
+              [](Candidate const& lhs, Candidate const& rhs)
+              {
+                return lhs.priority > rhs.priority;
+              });
+
+    Snapshot ret;
+    ret.tick = world.tick;
+    for(Candidate const& candidate : candidates)
+    {
+      auto const& player = world.players[candidate.index];
+      auto known = find_player(baseline, player.id);
+
+      std::size_t bits = player_delta_bits(player, known, qgrid);
+      if(bits <= budget)
+      {
+        budget -= bits;
+        ret.players.push_back(player);
+        interest.priority[player.id] = 0.0f;
+      }
+      else if(known)
+      {
+        // Keep what they have, they'll get the rest later.
+        ret.players.push_back(*known);
+      }
+    }
+
+    std::sort(ret.players.begin(), ret.players.end(),
+              [](auto const& lhs, auto const& rhs)
+              {
+                return lhs.id < rhs.id;
+              });
+    return ret;
+  }
+} }
@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2017 Luke San Antonio
+ * All rights reserved.
+ */
+#pragma once
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <glm/glm.hpp>
+#include "common.h"
+#include "snapshot.h"
+namespace redc { namespace net
+{
+  struct Interest_Config
+  {
+    // Players come into view within enter_radius and stay until they are
+    // past leave_radius, so somebody standing on the edge doesn't flicker in
+    // and out.
+    float enter_radius = 96.0f;
+    float leave_radius = 128.0f;
+
+    // Most we send any one client in a tick, including the snapshot header.
+    // Whatever doesn't fit goes out on a later tick.
+    std::size_t budget_bytes = 512;
+  };
+
+  /*!
+   * \brief Buckets snapshot players into square cells on the ground plane.
+   *
+   * Maps are a lot wider than they are tall, so only x and z are used.
+   * Cells are kept around between builds so rebuilding every tick doesn't
+   * allocate. Cells around the size of the interest radius work best.
+   */
+  struct Spatial_Grid
+  {
+    explicit Spatial_Grid(float cell_size = 32.0f) noexcept
+      : cell_size_(cell_size) {}
+
+    void build(Snapshot const& snap) noexcept;
+
+    // Calls fn with the index of every player in the cells touching the
+    // circle, some of those will be outside of it.
+    template <class Fn>
+    void query(glm::vec3 center, float radius, Fn&& fn) const;
+
+  private:
+    float cell_size_;
+    std::unordered_map<uint64_t, std::vector<std::size_t> > cells_;
+
+    int32_t cell_(float coord) const noexcept;
+    static uint64_t key_(int32_t x, int32_t z) noexcept;
+  };
+
+  template <class Fn>
+  void Spatial_Grid::query(glm::vec3 center, float radius, Fn&& fn) const
+  {
+    int32_t min_x = cell_(center.x - radius), max_x = cell_(center.x + radius);
+    int32_t min_z = cell_(center.z - radius), max_z = cell_(center.z + radius);
+    for(int32_t z = min_z; z <= max_z; ++z)
+    {
+      for(int32_t x = min_x; x <= max_x; ++x)
+      {
+        auto cell = cells_.find(key_(x, z));
+        if(cell == cells_.end()) continue;
+        for(std::size_t index : cell->second) fn(index);
+      }
+    }
+  }
+
+  // What each client is interested in, kept between ticks.
+  struct Client_Interest
+  {
+    std::unordered_set<player_id> relevant;
+
+    // Grows every tick a relevant player isn't sent by how relevant they
+    // are, so far away players still get a turn eventually.
+    std::unordered_map<player_id, float> priority;
+
+    // What we actually sent them, their acks refer to these.
+    Snapshot_History sent;
+  };
+
+  /*!
+   * \brief Picks what part of the world one client gets this tick.
+   *
+   * Players that aren't relevant to the viewer are left out. The rest go
+   * by priority until the budget runs out. A player that doesn't fit keeps
+   * whatever the client already has for them, so leaving them out of one
+   * tick costs nothing. Without a viewer every player is relevant.
+   *
+   * The result is sorted by id and must be encoded against baseline.
+   */
+  Snapshot interest_snapshot(Snapshot const& world, Spatial_Grid const& grid,
+                             Client_Interest& interest,
+                             glm::vec3 const* viewer, player_id self,
+                             Snapshot const* baseline,
+                             Quantize_Grid const& qgrid,
+                             Interest_Config const& config) noexcept;
+} }
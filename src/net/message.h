@@ -0,0 +1,36 @@
+/*
+ * Copyright (C) 2017 Luke San Antonio
+ * All rights reserved.
+ */
+#pragma once
+#include <cstddef>
+#include <cstdint>
+namespace redc { namespace net
+{
+  // Every message starts with one of these, see pack_packet.
+  enum class Message_Type : uint8_t
+  {
+    Version_Info,
+    Version_Okay,
+    Server_Info,
+    Player_Info,
+    Roster_Update,
+    Spawn,
+    Input_Update,
+    Snapshot,
+    Other,
+  };
+
+  constexpr std::size_t MESSAGE_TYPE_COUNT =
+    static_cast<std::size_t>(Message_Type::Other) + 1;
+
+  // Specialize this for anything sent with send_data, see client.h.
+  template <class T>
+  struct Message_Type_Of;
+
+#define REDC_NET_MESSAGE_TYPE(type_name) \
+  template <> struct Message_Type_Of<type_name> \
+  { \
+    static constexpr Message_Type value = Message_Type::type_name; \
+  }
+} }
@@ -3,6 +3,7 @@
  * All rights reserved.
  */
 #include "net_io.h"
+#include "channel.h"
 #include "../common/log.h"
 namespace redc
 {
@@ -84,7 +85,8 @@ namespace redc
       addr.host = ENET_HOST_ANY;
       addr.port = port;
 
-      ENetHost* host = enet_host_create(&addr, max_peers, 1, 0, 0);
+      ENetHost* host = enet_host_create(&addr, max_peers, CHANNEL_COUNT, 0,
+                                         0);
       if(!host)
       {
         log_e("Failed to init server host on port % for % max peers", port,
@@ -102,7 +104,7 @@ namespace redc
       auto init_err = enet_initialize_refct();
       if(init_err) return err(Error::ENet_Init_Failed);
 
-      ENetHost* host = enet_host_create(NULL, 1, 1, 0, 0);
+      ENetHost* host = enet_host_create(NULL, 1, CHANNEL_COUNT, 0, 0);
       if(!host)
       {
         log_e("Failed to init client host");
@@ -118,7 +120,7 @@ namespace redc
       enet_address_set_host(&addr, h.data());
       addr.port = port;
 
-      enet_host_connect(host.host, &addr, 1, 0);
+      enet_host_connect(host.host, &addr, CHANNEL_COUNT, 0);
     }
 
     ENetPeer* wait_for_connection(Host& host, uint32_t time) noexcept
@@ -156,7 +158,7 @@ namespace redc
     enet_peer_disconnect_later(peer_, 0);
   }
 
-  void Net_IO::write(buf_t const& buf) noexcept
+  void Net_IO::write(Shared_Buf const& buf) noexcept
   {
     ENetPacketFlag flags = (ENetPacketFlag) 0;
     if(send_reliable_)
@@ -166,7 +168,8 @@ namespace redc
 
     // Should we buffer this and wait for a call to Net_IO::step?
     ENetPacket* packet = enet_packet_create(buf.data(), buf.size(), flags);
-    enet_peer_send(peer_, 0, packet);
+    enet_peer_send(peer_, static_cast<uint8_t>(net::Channel::Control),
+                   packet);
   }
   void Net_IO::step() noexcept
   {
@@ -177,10 +180,9 @@ namespace redc
     // If we recieved data from our client / peer.
     if(event.type == ENET_EVENT_TYPE_RECEIVE && event.peer == peer_)
     {
-      // Post it
-      buf_t buf(event.packet->data,
-                event.packet->data + event.packet->dataLength);
-      post(buf);
+      // Post it, the packet is going away so this is the one copy.
+      post(buf_t(event.packet->data,
+                 event.packet->data + event.packet->dataLength));
       enet_packet_destroy(event.packet);
       return true;
     }
@@ -56,7 +56,7 @@ namespace redc
     void disconnect() noexcept;
 
     // Write to the peer
-    void write(buf_t const& buf) noexcept override;
+    void write(Shared_Buf const& buf) noexcept override;
 
     // Send out any messages to the peer
     void step() noexcept override;
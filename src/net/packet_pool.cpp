@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2017 Luke San Antonio
+ * All rights reserved.
+ */
+#include "packet_pool.h"
+#include "../common/debugging.h"
+#include "../common/log.h"
+#include "../common/thread_local.h"
+namespace redc { namespace net
+{
+  namespace
+  {
+    // Don't hang on to more than this, a burst of big packets shouldn't keep
+    // its memory around forever.
+    constexpr std::size_t MAX_FREE_BLOCKS = 64;
+    constexpr std::size_t MAX_FREE_BLOCK_CAPACITY = 64 * 1024;
+
+    void ENET_CALLBACK free_pooled_packet(ENetPacket* packet)
+    {
+      auto block = static_cast<Packet_Pool::Block*>(packet->userData);
+      block->pool->release(block);
+    }
+  }
+
+  Packet_Pool::~Packet_Pool() noexcept
+  {
+    REDC_ASSERT_MSG(used_ == 0, "% pooled packets outlived their pool",
+                    used_);
+    for(Block* block : free_) delete block;
+  }
+
+  Packet_Pool::Block* Packet_Pool::acquire() noexcept
+  {
+    ++used_;
+    if(free_.empty())
+    {
+      auto block = new Block;
+      block->pool = this;
+      return block;
+    }
+
+    Block* block = free_.back();
+    free_.pop_back();
+    return block;
+  }
+  void Packet_Pool::release(Block* block) noexcept
+  {
+    --used_;
+    if(free_.size() >= MAX_FREE_BLOCKS ||
+       block->data.capacity() > MAX_FREE_BLOCK_CAPACITY)
+    {
+      delete block;
+      return;
+    }
+
+    block->data.clear();
+    free_.push_back(block);
+  }
+
+  ENetPacket* Packet_Pool::make_packet(Block* block, uint32_t flags) noexcept
+  {
+    auto packet = enet_packet_create(block->data.data(), block->data.size(),
+                                     flags | ENET_PACKET_FLAG_NO_ALLOCATE);
+    if(!packet)
+    {
+      log_e("Failed to create a packet of % bytes", block->data.size());
+      release(block);
+      return nullptr;
+    }
+
+    packet->userData = block;
+    packet->freeCallback = free_pooled_packet;
+    return packet;
+  }
+
+  Packet_Pool& packet_pool() noexcept
+  {
+    static REDC_THREAD_LOCAL Packet_Pool* pool = nullptr;
+    if(!pool) pool = new Packet_Pool;
+    return *pool;
+  }
+
+  bool send_packet(ENetPacket* packet, ENetPeer* peer,
+                   Channel channel) noexcept
+  {
+    return channel_pacer().send(packet, peer, channel);
+  }
+  void release_unsent(ENetPacket* packet) noexcept
+  {
+    if(packet && packet->referenceCount == 0) enet_packet_destroy(packet);
+  }
+} }
@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2017 Luke San Antonio
+ * All rights reserved.
+ */
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <enet/enet.h>
+#include "../common/serialize.h"
+#include "channel.h"
+#include "message.h"
+namespace redc { namespace net
+{
+  /*!
+   * \brief Reusable storage for outgoing packets.
+   *
+   * Messages are packed straight into a block and ENet is given that block
+   * as is, so there's no copy on the way out. The block comes back to the
+   * pool when ENet destroys the packet, which for a packet sent to a bunch
+   * of peers is after the last one is done with it. Not thread safe, use it
+   * from whatever thread services the host.
+   */
+  struct Packet_Pool
+  {
+    struct Block
+    {
+      std::vector<uint8_t> data;
+      Packet_Pool* pool;
+    };
+
+    Packet_Pool() noexcept {}
+    // Every packet made from this pool must be destroyed by now.
+    ~Packet_Pool() noexcept;
+
+    Packet_Pool(Packet_Pool const&) = delete;
+    Packet_Pool& operator=(Packet_Pool const&) = delete;
+
+    // An empty block, with whatever capacity it had last time.
+    Block* acquire() noexcept;
+    void release(Block* block) noexcept;
+
+    // Takes ownership of the block.
+    ENetPacket* make_packet(Block* block, uint32_t flags) noexcept;
+
+    std::size_t free_blocks() const noexcept { return free_.size(); }
+    // How many blocks are in use, by us or ENet.
+    std::size_t used_blocks() const noexcept { return used_; }
+
+  private:
+    std::vector<Block*> free_;
+    std::size_t used_ = 0;
+  };
+
+  // One for each thread, so a server and clients can each service their
+  // hosts on their own threads. These are never destroyed, so packets from
+  // them can outlive anything.
+  Packet_Pool& packet_pool() noexcept;
+
+  // Messages are their Message_Type followed by the message itself, so they
+  // can't be mistaken for one another. They're serialized right into the
+  // block, which doesn't allocate once it has grown big enough.
+  template <class T>
+  ENetPacket* pack_packet(T const& t, bool reliable = true,
+                          Packet_Pool& pool = packet_pool()) noexcept
+  {
+    auto block = pool.acquire();
+    block->data.resize(1 + serialized_size(t));
+    block->data[0] = static_cast<uint8_t>(Message_Type_Of<T>::value);
+    serialize(t, &block->data[1], block->data.size() - 1);
+
+    uint32_t flags = 0;
+    if(reliable) flags = ENET_PACKET_FLAG_RELIABLE;
+    return pool.make_packet(block, flags);
+  }
+
+  // Reads straight out of the packet, false if it isn't a T or it's
+  // malformed. t is only changed on success.
+  template <class T>
+  bool unpack_packet(T& t, ENetPacket const* packet) noexcept
+  {
+    auto data = packet->data;
+    auto size = packet->dataLength;
+    if(size < 1 || data[0] != static_cast<uint8_t>(Message_Type_Of<T>::value))
+    {
+      return false;
+    }
+
+    T ret;
+    if(!deserialize(ret, data + 1, size - 1)) return false;
+    t = std::move(ret);
+    return true;
+  }
+
+  // The same packet can be sent to as many peers as we want. Once it's been
+  // sent to everybody that should get it, call release_unsent: ENet owns it
+  // from then on unless nobody took it. Goes through the channel pacer, so
+  // this is false if the channel was full and the packet was dropped.
+  bool send_packet(ENetPacket* packet, ENetPeer* peer,
+                   Channel channel) noexcept;
+  void release_unsent(ENetPacket* packet) noexcept;
+} }
@@ -0,0 +1,158 @@
+/*
+ * Copyright (C) 2017 Luke San Antonio
+ * All rights reserved.
+ */
+#pragma once
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <glm/glm.hpp>
+#include "../input/sampled_input.h"
+namespace redc { namespace net
+{
+  // Corrections smaller than this are left alone, they're just quantization.
+  constexpr float PREDICTION_EPSILON = 1.0f / 32.0f;
+
+  // Corrections bigger than this are a teleport, don't smooth them.
+  constexpr float PREDICTION_SNAP_DISTANCE = 2.0f;
+
+  // How long it takes to smooth out half of a correction, in seconds.
+  constexpr float PREDICTION_SMOOTH_HALF_LIFE = 0.1f;
+
+  /*!
+   * \brief Runs the local player ahead of the server so input doesn't wait
+   * for a round trip.
+   *
+   * Every input sent to the server is run locally right away and the state
+   * it results in is kept under the input's index. When a snapshot says the
+   * server is done with some input, the server's position is compared with
+   * what we predicted for it. If they disagree we go back to that input,
+   * take the server's position and run every input after it again. Either
+   * way the server is done with that input and those before it, so they're
+   * dropped and a snapshot that shows up late won't go back to them.
+   *
+   * Corrections aren't shown all at once, the difference is kept as an
+   * offset that decays over a few frames. State must have a glm::vec3
+   * position member, the step function runs one tick of input from a state
+   * and returns the result. When replaying it's also given what was
+   * predicted for that input the first time, for anything that comes from
+   * the client rather than the simulation, like which way the player was
+   * facing.
+   *
+   * Don't let the simulation step the local player as well, prediction is
+   * the only thing that moves it.
+   */
+  template <class State>
+  struct Client_Prediction
+  {
+    using step_fn = std::function<State (State const& from, Input const&,
+                                         State const& last, bool replay)>;
+
+    Client_Prediction(step_fn step, State initial) noexcept
+      : step_(std::move(step)), state_(initial) {}
+
+    // Runs input locally, it must then be sent with the given index.
+    void predict(uint8_t index, Input const& input) noexcept;
+
+    // The server applied up to index and put us at position.
+    void reconcile(uint8_t index, glm::vec3 position) noexcept;
+
+    // Call once a frame, returns where the local player should be drawn.
+    glm::vec3 smooth(float dt) noexcept;
+
+    State const& state() const noexcept { return state_; }
+    glm::vec3 correction() const noexcept { return offset_; }
+    unsigned int replays() const noexcept { return replays_; }
+
+  private:
+    struct Move
+    {
+      bool valid = false;
+      Input input;
+      State state;
+    };
+
+    step_fn step_;
+    State state_;
+
+    bool predicted_ = false;
+    uint8_t newest_ = 0;
+    std::array<Move, 256> moves_;
+
+    glm::vec3 offset_ = glm::vec3(0.0f);
+    unsigned int replays_ = 0;
+  };
+
+  template <class State>
+  void Client_Prediction<State>::predict(uint8_t index,
+                                         Input const& input) noexcept
+  {
+    Move& move = moves_[index];
+    state_ = step_(state_, input, state_, false);
+
+    move.valid = true;
+    move.input = input;
+    move.state = state_;
+
+    predicted_ = true;
+    newest_ = index;
+  }
+
+  template <class State>
+  void Client_Prediction<State>::reconcile(uint8_t index,
+                                           glm::vec3 position) noexcept
+  {
+    // Nothing to compare against, or we've wrapped all the way around.
+    Move& acked = moves_[index];
+    if(!predicted_ || !acked.valid) return;
+    if(static_cast<uint8_t>(newest_ - index) >= 128) return;
+
+    State state = acked.state;
+
+    // Inputs are sent in order, so the ones before it that are still around
+    // are the ones this snapshot acknowledged too.
+    uint8_t drop = index;
+    for(int n = 0; n < 128 && moves_[drop].valid; ++n, --drop)
+    {
+      moves_[drop].valid = false;
+    }
+
+    glm::vec3 error = position - state.position;
+    float error_len = std::sqrt(glm::dot(error, error));
+    if(error_len < PREDICTION_EPSILON) return;
+
+    glm::vec3 before = state_.position;
+
+    // Go back to what the server says and run everything it hasn't seen.
+    state.position = position;
+
+    for(uint8_t i = index + 1; i != static_cast<uint8_t>(newest_ + 1); ++i)
+    {
+      Move& move = moves_[i];
+      if(!move.valid) continue;
+
+      state = step_(state, move.input, move.state, true);
+      move.state = state;
+    }
+    state_ = state;
+    ++replays_;
+
+    if(error_len > PREDICTION_SNAP_DISTANCE)
+    {
+      offset_ = glm::vec3(0.0f);
+    }
+    else
+    {
+      // Keep drawing where we were, then ease into the right spot.
+      offset_ = offset_ + (before - state_.position);
+    }
+  }
+
+  template <class State>
+  glm::vec3 Client_Prediction<State>::smooth(float dt) noexcept
+  {
+    offset_ = offset_ * std::exp2(-dt / PREDICTION_SMOOTH_HALF_LIFE);
+    return state_.position + offset_;
+  }
+} }
@@ -3,12 +3,40 @@
  * All rights reserved.
  */
 #include "server_protocol.h"
+#include <algorithm>
+#include "../common/debugging.h"
 #include "../common/log.h"
 namespace redc { namespace net
 {
+  namespace
+  {
+    constexpr uint8_t DEFAULT_TICKRATE = 20;
+
+    // Log tick timing this often.
+    constexpr unsigned int TICK_REPORT_SECONDS = 30;
+
+    // Don't let a client get more than this many inputs ahead of what we
+    // are applying, otherwise a burst of inputs turns into lasting latency.
+    constexpr uint8_t MAX_BUFFERED_INPUTS = 4;
+
+    // Whether input index a comes after b, they wrap around.
+    bool input_newer(uint8_t a, uint8_t b) noexcept
+    {
+      uint8_t ahead = a - b;
+      return ahead != 0 && ahead < 128;
+    }
+  }
+
   void init_server(Server_Context& ctx) noexcept
   {
     ctx.host = std::move(*make_server_host(ctx.port, ctx.max_peers).ok());
+
+    if(ctx.rules.tickrate == 0)
+    {
+      log_w("No server tickrate given, using %", +DEFAULT_TICKRATE);
+      ctx.rules.tickrate = DEFAULT_TICKRATE;
+    }
+    ctx.ticker.emplace(ctx.rules.tickrate);
   }
 
   Server_Info make_server_info(Server_Context& ctx) noexcept
@@ -18,6 +46,7 @@ namespace redc { namespace net
     // A player consists of a name and id.
 
     auto players = std::vector<Player_Info>{};
+    players.reserve(ctx.player_ids.size());
     for(auto& client_id_pair : ctx.clients)
     {
       // They will need to select a team at some point.
@@ -30,21 +59,33 @@ namespace redc { namespace net
       }
     }
 
-    return Server_Info{ctx.rules, players, ctx.teams};
+    return Server_Info{ctx.rules, players, ctx.teams, ctx.grid};
   }
 
   bool is_valid_player_id(Server_Context& ctx, player_id id)
   {
-    for(auto client_id_pair : ctx.clients)
+    return ctx.player_ids.count(id) == 0;
+  }
+
+  // Lets everybody that already has the server info know about a player
+  // coming or going. It goes on the same channel as the server info so it
+  // can't arrive before it.
+  void broadcast_roster_update(Server_Context& ctx,
+                               Roster_Update const& update) noexcept
+  {
+    std::vector<ENetPeer*> peers;
+    for(auto& client_pair : ctx.clients)
     {
-      // Duplicate!
-      if(client_id_pair.second.player_info)
+      auto state = client_pair.second.state;
+      if(state == Remote_Client_State::Client_Info ||
+         state == Remote_Client_State::Playing)
       {
-        if(client_id_pair.second.player_info->id == id) return false;
+        peers.push_back(client_pair.second.peer);
       }
     }
-    // No duplicate
-    return true;
+
+    broadcast_data(update, peers.begin(), peers.end(),
+                   [](ENetPeer* peer) { return peer; }, Channel::Control);
   }
 
   void step_remote_client(Server_Context& ctx, Remote_Client& client,
@@ -56,7 +97,7 @@ namespace redc { namespace net
       case Remote_Client_State::Version:
       {
         // Receive version
-        if(!receive_data(client.version, event.packet))
+        if(!receive_data(client.version, event.packet, event.peer))
         {
           // Err, ignore:
           break;
@@ -94,7 +135,7 @@ namespace redc { namespace net
           }
 
           // Inform the client
-          send_data(versions_okay, event.peer);
+          send_data(versions_okay, event.peer, Channel::Control);
 
           // Disconnect the peer and jump ship.
           enet_peer_disconnect_later(event.peer, 0);
@@ -103,7 +144,7 @@ namespace redc { namespace net
         else
         {
           // Everything is good, send them the current state of our server!
-          send_data(make_server_info(ctx), event.peer);
+          send_data(make_server_info(ctx), event.peer, Channel::Control);
           client.state = Remote_Client_State::Client_Info;
         }
 
@@ -113,7 +154,7 @@ namespace redc { namespace net
       {
         // Read client info, break if it doesn't work
         Player_Info player_info;
-        if(!receive_data(player_info, event.packet)) break;
+        if(!receive_data(player_info, event.packet, event.peer)) break;
 
         // Don't add this player info to the client yet so the player id search
         // doesn't find itself and falsely trigger a duplicate
@@ -133,39 +174,68 @@ namespace redc { namespace net
         {
           // Else we have a valid player id
           client.player_info = player_info;
+          ctx.player_ids.insert(player_info.id);
 
           // Otherwise send spawn info
-          send_data(Spawn{}, event.peer);
+          send_data(Spawn{}, event.peer, Channel::Control);
           client.state = Remote_Client_State::Playing;
 
           log_i("Spawning player %", client.player_info->name);
 
           // We just added a new player...
-          ctx.must_resend_server_info = true;
+          broadcast_roster_update(ctx, Roster_Update{true, player_info});
         }
         break;
       }
       case Remote_Client_State::Playing:
       {
         Input_Update input;
-        if(receive_data(input, event.packet))
+        if(receive_data(input, event.packet, event.peer))
         {
-          client.inputs[input.index] = input.input;
-          client.cur_input_i = input.index;
+          if(!client.got_input)
+          {
+            client.got_input = true;
+            client.cur_input_i = input.index;
+            client.next_input_i = input.index;
+          }
+          // Only buffer it if we haven't applied that one yet.
+          if(!input_newer(client.next_input_i, input.index))
+          {
+            client.inputs[input.index] = input.input;
+            client.have_input[input.index] = true;
+          }
+          if(input_newer(input.index, client.cur_input_i))
+          {
+            client.cur_input_i = input.index;
+          }
+
+          // Input is unreliable too, an old ack may show up late.
+          if(input.ack_tick != NO_BASELINE &&
+             (client.acked_tick == NO_BASELINE ||
+              input.ack_tick > client.acked_tick))
+          {
+            client.acked_tick = input.ack_tick;
+          }
         }
         break;
       }
     }
   }
 
+  using client_id = ID_Map<Remote_Client>::id_type;
+
+  // Zero is never a valid id so a peer without one has null data.
+  void set_peer_client(ENetPeer* peer, client_id id) noexcept
+  {
+    peer->data = reinterpret_cast<void*>(static_cast<uintptr_t>(id));
+  }
+
   ID_Map<Remote_Client>::iterator
     find_client_by_peer(ID_Map<Remote_Client>& cts, ENetPeer* peer) noexcept
   {
-    return std::find_if(std::begin(cts), std::end(cts),
-      [&peer](auto& client_state)
-      {
-        return client_state.second.peer == peer;
-      });
+    auto id = static_cast<client_id>(reinterpret_cast<uintptr_t>(peer->data));
+    if(!id) return cts.end();
+    return cts.find(id);
   }
 
   void step_server(Server_Context& ctx, ENetEvent const& event) noexcept
@@ -182,7 +252,14 @@ namespace redc { namespace net
         client.state = Remote_Client_State::Version;
 
         // Keep track of it, of course
-        ctx.clients.insert(std::move(client));
+        auto id = ctx.clients.insert(std::move(client));
+        if(!id)
+        {
+          log_e("Out of client ids, disconnecting new client");
+          enet_peer_disconnect(event.peer, 0);
+          break;
+        }
+        set_peer_client(event.peer, id);
 
         // At this point we will receive its version info.
         break;
@@ -230,9 +307,19 @@ namespace redc { namespace net
         else
         {
           // Remove it from our clients list.
+          auto player_info = client_find->second.player_info;
           ctx.clients.erase(client_find);
+          event.peer->data = nullptr;
+          net_telemetry().forget(event.peer);
+          channel_pacer().forget(event.peer);
+
           // No need to remove it from teams but we do have to notify everyone
           // that this player no longer exists.
+          if(player_info)
+          {
+            ctx.player_ids.erase(player_info->id);
+            broadcast_roster_update(ctx, Roster_Update{false, *player_info});
+          }
         }
 
         break;
@@ -241,23 +328,170 @@ namespace redc { namespace net
       default:
         break;
     }
+  }
+
+  void send_snapshot(Server_Context& ctx, Snapshot snap) noexcept
+  {
+    ctx.interest_grid.build(snap);
+
+    for(auto& client_pair : ctx.clients)
+    {
+      Remote_Client& client = client_pair.second;
+      if(client.state != Remote_Client_State::Playing) continue;
+
+      // Their own player is what they're looking from.
+      glm::vec3 const* viewer = nullptr;
+      player_id self = client.player_info->id;
+      auto own = std::lower_bound(snap.players.begin(), snap.players.end(),
+                                  self, [](auto const& player, player_id id)
+                                  {
+                                    return player.id < id;
+                                  });
+      if(own != snap.players.end() && own->id == self)
+      {
+        viewer = &own->position;
+      }
+
+      // If their baseline is too old we just send everything.
+      auto baseline = client.interest.sent.find(client.acked_tick);
+      auto view = interest_snapshot(snap, ctx.interest_grid, client.interest,
+                                    viewer, self, baseline, ctx.grid,
+                                    ctx.interest);
+      view.has_input_ack = client.applied_input;
+      view.input_ack = client.applied_input_i;
+
+      // Straight into the block, it keeps its capacity from last time.
+      auto block = packet_pool().acquire();
+      encode_snapshot(view, baseline, ctx.grid, block->data);
+      std::size_t size = block->data.size();
+      client.interest.sent.push(std::move(view));
+
+      auto packet = packet_pool().make_packet(block, 0);
+      if(!packet) continue;
+
+      if(send_packet(packet, client.peer, Channel::State))
+      {
+        net_telemetry().count_sent(client.peer, Message_Type::Snapshot, size);
+      }
+      release_unsent(packet);
+
+      ctx.snapshot_bytes_sent += size;
+    }
+  }
 
-    if(ctx.must_resend_server_info)
+
+  void apply_next_input(Remote_Client& client) noexcept
+  {
+    if(!client.got_input) return;
+
+    // Nothing new, keep doing whatever they were doing.
+    if(input_newer(client.next_input_i, client.cur_input_i)) return;
+
+    uint8_t buffered = client.cur_input_i - client.next_input_i;
+    if(buffered >= MAX_BUFFERED_INPUTS)
     {
-      auto server_info = make_server_info(ctx);
-      for(auto& client : ctx.clients)
+      uint8_t keep_from = client.cur_input_i - (MAX_BUFFERED_INPUTS - 1);
+      for(; client.next_input_i != keep_from; ++client.next_input_i)
       {
-        // First send this identifier which says we are sending this not state.
-        send_data(0x01, client.second.peer);
+        client.have_input[client.next_input_i] = false;
+      }
+    }
 
-        // Send that info to everyone
-        send_data(server_info, client.second.peer);
+    // When one was lost on the way, repeat the last one we applied.
+    if(client.have_input[client.next_input_i])
+    {
+      client.input = client.inputs[client.next_input_i];
+      client.have_input[client.next_input_i] = false;
+    }
+    client.applied_input = true;
+    client.applied_input_i = client.next_input_i;
+    ++client.next_input_i;
+  }
+
+  void tick_server(Server_Context& ctx) noexcept
+  {
+    for(auto& client_pair : ctx.clients)
+    {
+      Remote_Client& client = client_pair.second;
+      if(client.state == Remote_Client_State::Playing)
+      {
+        apply_next_input(client);
       }
+    }
+
+    if(ctx.simulate) ctx.simulate(ctx, ctx.ticker->dt());
+
+    if(ctx.make_snapshot &&
+       ctx.ticker->tick() % std::max(ctx.snapshot_interval, 1u) == 0)
+    {
+      Snapshot snap = ctx.make_snapshot(ctx);
+      snap.tick = ctx.ticker->tick();
+      send_snapshot(ctx, std::move(snap));
+    }
+
+    // Get everything out now rather than whenever we next service the host.
+    channel_pacer().pump();
+    enet_host_flush(ctx.host.host);
+  }
+
+  void run_due_ticks(Server_Context& ctx) noexcept
+  {
+    Fixed_Tick& ticker = *ctx.ticker;
+    while(ticker.begin(tick_clock_t::now()))
+    {
+      tick_server(ctx);
+      ticker.end(tick_clock_t::now());
+    }
+    net_telemetry().sample(ctx.host.host, tick_clock_t::now());
 
-      // I've found that enet will refuse to clean up a packet if the client
-      // we give it has disconnected, which is why we put this after handling
-      // events (which importantly includes the disconnect event)
-      ctx.must_resend_server_info = false;
+    if(ticker.stats().ticks >= ticker.tickrate() * TICK_REPORT_SECONDS)
+    {
+      ticker.log_stats(ctx.name.c_str());
+      log_i("%: Sent % snapshot KB/s", ctx.name, ctx.snapshot_bytes_sent /
+            1024.0 / TICK_REPORT_SECONDS);
+      net_telemetry().log_summary((ctx.name + " peers").c_str(),
+                                  ctx.host.host);
+
+      ticker.reset_stats();
+      ctx.snapshot_bytes_sent = 0;
     }
   }
+
+  void service_server(Server_Context& ctx) noexcept
+  {
+    REDC_ASSERT_MSG(ctx.ticker.is_initialized(),
+                    "Server must be initialized");
+    Fixed_Tick& ticker = *ctx.ticker;
+
+    // Handle everything that shows up until it's time for the next tick.
+    ENetEvent event;
+    auto wait = [&]()
+    {
+      using namespace std::chrono;
+      auto until = ticker.until_next(tick_clock_t::now());
+      return static_cast<enet_uint32>(duration_cast<milliseconds>(until)
+                                        .count());
+    };
+    while(enet_host_service(ctx.host.host, &event, wait()) > 0)
+    {
+      step_server(ctx, event);
+    }
+
+    run_due_ticks(ctx);
+  }
+
+  tick_clock_t::duration poll_server(Server_Context& ctx) noexcept
+  {
+    REDC_ASSERT_MSG(ctx.ticker.is_initialized(),
+                    "Server must be initialized");
+
+    ENetEvent event;
+    while(enet_host_service(ctx.host.host, &event, 0) > 0)
+    {
+      step_server(ctx, event);
+    }
+
+    run_due_ticks(ctx);
+    return ctx.ticker->until_next(tick_clock_t::now());
+  }
 } }
@@ -3,14 +3,19 @@
  * All rights reserved.
  */
 #pragma once
+#include <functional>
+#include <string>
+#include <unordered_set>
 #include <boost/optional.hpp>
 
 #include "common.h"
 #include "client.h"
+#include "interest.h"
 
 #include "../common/id_map.hpp"
+#include "../common/fixed_tick.h"
 
-#include "../input/input.h"
+#include "../input/sampled_input.h"
 namespace redc { namespace net
 {
   // Sent from server to client about all clients (even the owner).
@@ -28,7 +33,7 @@ namespace redc { namespace net
     // This is all about the boat.
     glm::vec3 position;
 
-    MSGPACK_DEFINE(input, position);
+    REDC_SERIALIZE(input, position);
   };
 
   enum class Remote_Client_State
@@ -49,9 +54,26 @@ namespace redc { namespace net
     Version_Info version;
     boost::optional<Player_Info> player_info;
 
-    // Somehow limit this to a certain amount? Circular buffer?
-    std::size_t cur_input_i = 0;
-    std::array<Input, 256> inputs;
+    // Inputs are buffered as they come in and applied one per tick, in
+    // order. The index wraps around so compare them with input_newer.
+    bool got_input = false;
+    uint8_t cur_input_i = 0;
+    uint8_t next_input_i = 0;
+    std::array<Input, 256> inputs{};
+    // Which of those actually showed up, they're cleared once applied.
+    std::array<bool, 256> have_input{};
+
+    // What they are doing this tick, the last input sticks around when we
+    // run out. Their snapshots say which one it was so they can predict.
+    Input input;
+    bool applied_input = false;
+    uint8_t applied_input_i = 0;
+
+    // The newest snapshot they told us they have.
+    uint32_t acked_tick = NO_BASELINE;
+
+    // What part of the world they get, and what we've sent them of it.
+    Client_Interest interest;
   };
 
   struct Server_Context
@@ -66,19 +88,60 @@ namespace redc { namespace net
     Server_Rules rules;
     std::vector<Team> teams;
 
-    // Player id from the Player_Info struct are for this map
+    // Player id from the Player_Info struct are for this map. Each peer's
+    // data is the id of its client here.
     ID_Map<Remote_Client> clients;
 
+    // Ids of everyone that has player info, they have to be unique.
+    std::unordered_set<player_id> player_ids;
+
     uint16_t port;
     // This is a little wasteful but whatever.
     uint16_t max_peers;
     Host host;
 
-    bool must_resend_server_info = false;
+    // What the logs call us, for telling servers in one process apart.
+    std::string name = "Server";
+
+    // Set this from the map bounds before anybody connects, clients get it
+    // with the server info.
+    Quantize_Grid grid;
+
+    // Clients only get players near them, within a budget.
+    Interest_Config interest;
+    Spatial_Grid interest_grid;
+
+    // Everything that went out in snapshots, for measuring bandwidth.
+    std::size_t snapshot_bytes_sent = 0;
+
+    // Runs at rules.tickrate once the server is initialized.
+    boost::optional<Fixed_Tick> ticker;
+    // Ticks between snapshots, one sends state every tick.
+    unsigned int snapshot_interval = 1;
+
+    // Called every tick, after each client's input for it is applied. Step
+    // physics and whatever else by dt here.
+    std::function<void (Server_Context&, float dt)> simulate;
+    // Called on the ticks a snapshot goes out, the tick is filled in.
+    std::function<Snapshot (Server_Context&)> make_snapshot;
   };
 
   void init_server(Server_Context& ctx) noexcept;
 
   void step_server(Server_Context& context, ENetEvent const& event) noexcept;
 
+  // Handles ENet events until the next tick is due, then runs every tick that
+  // is due. Call this in a loop, it sleeps in ENet when there's nothing to do.
+  void service_server(Server_Context& ctx) noexcept;
+
+  // The same without ever waiting, for running a few servers on one thread.
+  // Returns how long until the next tick is due, wait on the host's socket
+  // until then.
+  tick_clock_t::duration poll_server(Server_Context& ctx) noexcept;
+
+  // Sends every playing client the players they're interested in, and only
+  // what changed since the last snapshot they acknowledged. Players must be
+  // sorted by id.
+  void send_snapshot(Server_Context& ctx, Snapshot snap) noexcept;
+
 } }
@@ -0,0 +1,333 @@
+/*
+ * Copyright (C) 2017 Luke San Antonio
+ * All rights reserved.
+ */
+#include "snapshot.h"
+#include <algorithm>
+#include <cmath>
+#include "../common/bit_stream.h"
+#include "../common/debugging.h"
+namespace redc { namespace net
+{
+  namespace
+  {
+    constexpr unsigned int TICK_BITS = 32;
+    constexpr unsigned int COUNT_BITS = 16;
+    constexpr unsigned int ID_BITS = 16;
+    constexpr unsigned int INPUT_BITS = 9;
+    constexpr unsigned int INPUT_INDEX_BITS = 8;
+
+    uint32_t max_cell(float min, float max, float resolution) noexcept
+    {
+      double cells = std::floor((max - min) / (double) resolution + 0.5);
+      if(cells <= 0.0) return 0;
+      if(cells >= 4294967295.0) return 0xffffffff;
+      return static_cast<uint32_t>(cells);
+    }
+
+    uint32_t pack_input(Input const& input) noexcept
+    {
+      bool const bits[INPUT_BITS] = {
+        input.forward, input.backward, input.strafe_left, input.strafe_right,
+        input.jump, input.crouch, input.primary_attack,
+        input.secondary_attack, input.tertiary_attack
+      };
+
+      uint32_t ret = 0;
+      for(unsigned int i = 0; i < INPUT_BITS; ++i)
+      {
+        if(bits[i]) ret |= 1u << i;
+      }
+      return ret;
+    }
+    Input unpack_input(uint32_t packed) noexcept
+    {
+      Input input;
+      bool* fields[INPUT_BITS] = {
+        &input.forward, &input.backward, &input.strafe_left,
+        &input.strafe_right, &input.jump, &input.crouch,
+        &input.primary_attack, &input.secondary_attack,
+        &input.tertiary_attack
+      };
+      for(unsigned int i = 0; i < INPUT_BITS; ++i)
+      {
+        *fields[i] = (packed >> i) & 1;
+      }
+      return input;
+    }
+
+    bool operator==(Input const& lhs, Input const& rhs) noexcept
+    {
+      return pack_input(lhs) == pack_input(rhs);
+    }
+
+    bool id_less(Player_Snapshot const& lhs, Player_Snapshot const& rhs)
+    {
+      return lhs.id < rhs.id;
+    }
+
+    void write_position(Bit_Writer& writer, Quantized_Pos const& pos,
+                        std::array<unsigned int, 3> const& bits) noexcept
+    {
+      for(int i = 0; i < 3; ++i) writer.write(pos[i], bits[i]);
+    }
+    Quantized_Pos read_position(Bit_Reader& reader,
+                                std::array<unsigned int, 3> const& bits)
+    {
+      Quantized_Pos pos;
+      for(int i = 0; i < 3; ++i) pos[i] = reader.read(bits[i]);
+      return pos;
+    }
+  }
+
+  std::array<unsigned int, 3> grid_bits(Quantize_Grid const& grid) noexcept
+  {
+    return {{bits_needed(max_cell(grid.min.x, grid.max.x, grid.resolution)),
+             bits_needed(max_cell(grid.min.y, grid.max.y, grid.resolution)),
+             bits_needed(max_cell(grid.min.z, grid.max.z, grid.resolution))}};
+  }
+
+  Quantized_Pos quantize(Quantize_Grid const& grid, glm::vec3 pos) noexcept
+  {
+    float const p[3] = {pos.x, pos.y, pos.z};
+    float const min[3] = {grid.min.x, grid.min.y, grid.min.z};
+    float const max[3] = {grid.max.x, grid.max.y, grid.max.z};
+
+    Quantized_Pos ret;
+    for(int i = 0; i < 3; ++i)
+    {
+      double cell = std::floor((p[i] - min[i]) / (double) grid.resolution +
+                               0.5);
+      double top = max_cell(min[i], max[i], grid.resolution);
+      ret[i] = static_cast<uint32_t>(std::min(std::max(cell, 0.0), top));
+    }
+    return ret;
+  }
+  glm::vec3 dequantize(Quantize_Grid const& grid, Quantized_Pos pos) noexcept
+  {
+    return glm::vec3(grid.min.x + pos[0] * (double) grid.resolution,
+                     grid.min.y + pos[1] * (double) grid.resolution,
+                     grid.min.z + pos[2] * (double) grid.resolution);
+  }
+
+  void encode_snapshot(Snapshot const& snap, Snapshot const* baseline,
+                       Quantize_Grid const& grid, std::vector<uint8_t>& out)
+  {
+    REDC_ASSERT_MSG(std::is_sorted(snap.players.begin(), snap.players.end(),
+                                   id_less),
+                    "Snapshot players must be sorted by id");
+
+    auto bits = grid_bits(grid);
+
+    // Figure out what went away and what changed by walking both at once.
+    std::vector<player_id> removed;
+    struct Changed
+    {
+      Player_Snapshot const* player;
+      bool input;
+      bool position;
+    };
+    std::vector<Changed> changed;
+
+    auto cur = snap.players.begin();
+    auto cur_end = snap.players.end();
+    auto base = baseline ? baseline->players.begin() : cur_end;
+    auto base_end = baseline ? baseline->players.end() : cur_end;
+    while(cur != cur_end || base != base_end)
+    {
+      if(base == base_end || (cur != cur_end && cur->id < base->id))
+      {
+        // New since the baseline, send the whole thing.
+        changed.push_back({&*cur, true, true});
+        ++cur;
+      }
+      else if(cur == cur_end || base->id < cur->id)
+      {
+        removed.push_back(base->id);
+        ++base;
+      }
+      else
+      {
+        bool input = !(cur->input == base->input);
+        bool position = quantize(grid, cur->position) !=
+                        quantize(grid, base->position);
+        if(input || position) changed.push_back({&*cur, input, position});
+        ++cur;
+        ++base;
+      }
+    }
+
+    out.clear();
+    out.push_back(SNAPSHOT_PACKET_TAG);
+
+    Bit_Writer writer(std::move(out));
+    writer.write(snap.tick, TICK_BITS);
+    writer.write(baseline ? baseline->tick : NO_BASELINE, TICK_BITS);
+
+    writer.write_bool(snap.has_input_ack);
+    if(snap.has_input_ack) writer.write(snap.input_ack, INPUT_INDEX_BITS);
+
+    writer.write(removed.size(), COUNT_BITS);
+    for(player_id id : removed) writer.write(id, ID_BITS);
+
+    writer.write(changed.size(), COUNT_BITS);
+    for(Changed const& change : changed)
+    {
+      writer.write(change.player->id, ID_BITS);
+
+      writer.write_bool(change.input);
+      if(change.input)
+      {
+        writer.write(pack_input(change.player->input), INPUT_BITS);
+      }
+
+      writer.write_bool(change.position);
+      if(change.position)
+      {
+        write_position(writer, quantize(grid, change.player->position), bits);
+      }
+    }
+
+    out = writer.take();
+  }
+
+  std::vector<uint8_t> encode_snapshot(Snapshot const& snap,
+                                       Snapshot const* baseline,
+                                       Quantize_Grid const& grid)
+  {
+    std::vector<uint8_t> ret;
+    encode_snapshot(snap, baseline, grid, ret);
+    return ret;
+  }
+
+  std::size_t player_delta_bits(Player_Snapshot const& player,
+                                Player_Snapshot const* baseline,
+                                Quantize_Grid const& grid) noexcept
+  {
+    bool input = true;
+    bool position = true;
+    if(baseline)
+    {
+      input = !(player.input == baseline->input);
+      position = quantize(grid, player.position) !=
+                 quantize(grid, baseline->position);
+      if(!input && !position) return 0;
+    }
+
+    std::size_t bits = ID_BITS + 2;
+    if(input) bits += INPUT_BITS;
+    if(position)
+    {
+      auto axis_bits = grid_bits(grid);
+      bits += axis_bits[0] + axis_bits[1] + axis_bits[2];
+    }
+    return bits;
+  }
+  std::size_t snapshot_overhead_bits(std::size_t num_removed) noexcept
+  {
+    // The tag byte, both ticks, the input ack, both counts and the removed
+    // ids.
+    return 8 + TICK_BITS * 2 + 1 + INPUT_INDEX_BITS + COUNT_BITS * 2 +
+           ID_BITS * num_removed;
+  }
+
+  uint32_t snapshot_baseline_tick(uint8_t const* data,
+                                  std::size_t size) noexcept
+  {
+    if(size < 1 || data[0] != SNAPSHOT_PACKET_TAG) return NO_BASELINE;
+
+    Bit_Reader reader(data + 1, size - 1);
+    reader.read(TICK_BITS);
+    uint32_t baseline = reader.read(TICK_BITS);
+    if(!reader.good()) return NO_BASELINE;
+    return baseline;
+  }
+
+  bool decode_snapshot(uint8_t const* data, std::size_t size,
+                       Snapshot const* baseline, Quantize_Grid const& grid,
+                       Snapshot& snap)
+  {
+    if(size < 1 || data[0] != SNAPSHOT_PACKET_TAG) return false;
+
+    Bit_Reader reader(data + 1, size - 1);
+
+    Snapshot ret;
+    ret.tick = reader.read(TICK_BITS);
+
+    uint32_t baseline_tick = reader.read(TICK_BITS);
+    if(baseline_tick != NO_BASELINE)
+    {
+      if(!baseline || baseline->tick != baseline_tick) return false;
+      ret.players = baseline->players;
+    }
+
+    ret.has_input_ack = reader.read_bool();
+    if(ret.has_input_ack) ret.input_ack = reader.read(INPUT_INDEX_BITS);
+
+    uint32_t num_removed = reader.read(COUNT_BITS);
+    for(uint32_t i = 0; i < num_removed && reader.good(); ++i)
+    {
+      Player_Snapshot key;
+      key.id = reader.read(ID_BITS);
+
+      auto it = std::lower_bound(ret.players.begin(), ret.players.end(), key,
+                                 id_less);
+      if(it == ret.players.end() || it->id != key.id) return false;
+      ret.players.erase(it);
+    }
+
+    auto bits = grid_bits(grid);
+
+    uint32_t num_changed = reader.read(COUNT_BITS);
+    for(uint32_t i = 0; i < num_changed && reader.good(); ++i)
+    {
+      Player_Snapshot key;
+      key.id = reader.read(ID_BITS);
+
+      auto it = std::lower_bound(ret.players.begin(), ret.players.end(), key,
+                                 id_less);
+      bool is_new = it == ret.players.end() || it->id != key.id;
+
+      bool has_input = reader.read_bool();
+      Input input = {};
+      if(has_input) input = unpack_input(reader.read(INPUT_BITS));
+
+      bool has_position = reader.read_bool();
+      Quantized_Pos position = {};
+      if(has_position) position = read_position(reader, bits);
+
+      if(is_new)
+      {
+        // There is nothing to take the rest from.
+        if(!has_input || !has_position) return false;
+        it = ret.players.insert(it, key);
+      }
+      if(has_input) it->input = input;
+      if(has_position) it->position = dequantize(grid, position);
+    }
+
+    if(!reader.good()) return false;
+
+    snap = std::move(ret);
+    return true;
+  }
+
+  Snapshot_History::Snapshot_History(std::size_t size) : ring_(size)
+  {
+    REDC_ASSERT(size > 0);
+    for(Snapshot& snap : ring_) snap.tick = NO_BASELINE;
+  }
+
+  void Snapshot_History::push(Snapshot snap)
+  {
+    ring_[snap.tick % ring_.size()] = std::move(snap);
+  }
+  Snapshot const* Snapshot_History::find(uint32_t tick) const noexcept
+  {
+    if(tick == NO_BASELINE) return nullptr;
+
+    Snapshot const& snap = ring_[tick % ring_.size()];
+    if(snap.tick != tick) return nullptr;
+    return &snap;
+  }
+} }
@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2017 Luke San Antonio
+ * All rights reserved.
+ */
+#pragma once
+#include <array>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include "common.h"
+namespace redc { namespace net
+{
+  // Snapshot packets start with this, it's well clear of every Message_Type
+  // so they can't be mistaken for anything else.
+  constexpr uint8_t SNAPSHOT_PACKET_TAG = 0xc1;
+
+  // Default size of a grid cell, in meters.
+  constexpr float DEFAULT_POSITION_RESOLUTION = 1.0f / 64.0f;
+
+  /*!
+   * \brief Positions are sent as grid cells within the map bounds.
+   *
+   * Each axis gets just enough bits for the map's extent at the given
+   * resolution. Anything outside of the bounds is clamped to them.
+   */
+  struct Quantize_Grid
+  {
+    glm::vec3 min;
+    glm::vec3 max;
+    float resolution = DEFAULT_POSITION_RESOLUTION;
+
+    REDC_SERIALIZE(min, max, resolution);
+  };
+
+  using Quantized_Pos = std::array<uint32_t, 3>;
+
+  std::array<unsigned int, 3> grid_bits(Quantize_Grid const& grid) noexcept;
+  Quantized_Pos quantize(Quantize_Grid const& grid, glm::vec3 pos) noexcept;
+  glm::vec3 dequantize(Quantize_Grid const& grid, Quantized_Pos pos) noexcept;
+
+  struct Player_Snapshot
+  {
+    player_id id;
+    Input input;
+    glm::vec3 position;
+  };
+
+  struct Snapshot
+  {
+    uint32_t tick = 0;
+
+    // The newest Input_Update::index of the receiving client's that went
+    // into this tick, they predict from there.
+    bool has_input_ack = false;
+    uint8_t input_ack = 0;
+
+    // Sorted by id.
+    std::vector<Player_Snapshot> players;
+  };
+
+  /*!
+   * \brief Bit-packs a snapshot, leaving out whatever the baseline has.
+   *
+   * Players that are in the baseline are only sent if their input or
+   * quantized position changed, and then only the field that changed.
+   * Players that went away are sent as just an id. Without a baseline the
+   * whole snapshot is sent. The result starts with SNAPSHOT_PACKET_TAG.
+   */
+  std::vector<uint8_t> encode_snapshot(Snapshot const& snap,
+                                       Snapshot const* baseline,
+                                       Quantize_Grid const& grid);
+  // The same but into out, which is cleared first and keeps its capacity.
+  void encode_snapshot(Snapshot const& snap, Snapshot const* baseline,
+                       Quantize_Grid const& grid, std::vector<uint8_t>& out);
+
+  // What encode_snapshot spends on a player, zero if nothing changed since
+  // the baseline so it isn't sent at all.
+  std::size_t player_delta_bits(Player_Snapshot const& player,
+                                Player_Snapshot const* baseline,
+                                Quantize_Grid const& grid) noexcept;
+  // Everything else in a snapshot, given how many players were removed.
+  std::size_t snapshot_overhead_bits(std::size_t num_removed) noexcept;
+
+  // The baseline tick a snapshot was encoded against, or NO_BASELINE. Tells
+  // the receiver which baseline to pass to decode_snapshot.
+  uint32_t snapshot_baseline_tick(uint8_t const* data,
+                                  std::size_t size) noexcept;
+
+  // Returns false if the data is bad or it needs a baseline that wasn't
+  // given. Decoded positions are snapped to the grid.
+  bool decode_snapshot(uint8_t const* data, std::size_t size,
+                       Snapshot const* baseline, Quantize_Grid const& grid,
+                       Snapshot& snap);
+
+  // The last few snapshots, by tick. The server keeps these so it can delta
+  // against whatever each client acknowledged last, clients keep them since
+  // that's what the server will be sending deltas against.
+  struct Snapshot_History
+  {
+    explicit Snapshot_History(std::size_t size = 32);
+
+    void push(Snapshot snap);
+    // Null if we don't have it anymore (or never did).
+    Snapshot const* find(uint32_t tick) const noexcept;
+
+  private:
+    // Empty slots have the tick NO_BASELINE.
+    std::vector<Snapshot> ring_;
+  };
+} }
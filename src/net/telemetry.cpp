@@ -0,0 +1,256 @@
+/*
+ * Copyright (C) 2017 Luke San Antonio
+ * All rights reserved.
+ */
+#include "telemetry.h"
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include "../common/log.h"
+namespace redc { namespace net
+{
+  namespace
+  {
+    // A peer is saturated past any of these.
+    constexpr float SATURATED_LOSS = 0.05f;
+    constexpr float SATURATED_RTT_MS = 250.0f;
+    // ENet stops sending reliable data once a window's worth is in flight,
+    // which is 64KB unless it's throttled down.
+    constexpr uint32_t SATURATED_RELIABLE_IN_TRANSIT = 32 * 1024;
+
+    char const* const MESSAGE_TYPE_NAMES[MESSAGE_TYPE_COUNT] = {
+      "version_info",
+      "version_okay",
+      "server_info",
+      "player_info",
+      "roster_update",
+      "spawn",
+      "input_update",
+      "snapshot",
+      "other",
+    };
+
+    std::string to_string(ENetAddress const& address)
+    {
+      char host[64];
+      if(enet_address_get_host_ip(&address, host, sizeof(host)) != 0)
+      {
+        return "unknown";
+      }
+      return std::string(host) + ":" + std::to_string(address.port);
+    }
+
+    // The type that took the most bandwidth either way.
+    Message_Type busiest_type(Telemetry_Summary const& summary) noexcept
+    {
+      std::size_t busiest = 0;
+      float busiest_bytes = 0.0f;
+      for(std::size_t i = 0; i < MESSAGE_TYPE_COUNT; ++i)
+      {
+        float bytes = summary.type_bytes_in[i] + summary.type_bytes_out[i];
+        if(bytes > busiest_bytes)
+        {
+          busiest = i;
+          busiest_bytes = bytes;
+        }
+      }
+      return static_cast<Message_Type>(busiest);
+    }
+  }
+
+  char const* to_string(Message_Type type) noexcept
+  {
+    return MESSAGE_TYPE_NAMES[static_cast<std::size_t>(type)];
+  }
+  Message_Type message_type_from_string(char const* name) noexcept
+  {
+    for(std::size_t i = 0; i < MESSAGE_TYPE_COUNT; ++i)
+    {
+      if(std::strcmp(name, MESSAGE_TYPE_NAMES[i]) == 0)
+      {
+        return static_cast<Message_Type>(i);
+      }
+    }
+    return Message_Type::Other;
+  }
+
+  bool Telemetry_Summary::saturated() const noexcept
+  {
+    return packet_loss > SATURATED_LOSS || rtt_ms > SATURATED_RTT_MS ||
+           reliable_in_transit_max > SATURATED_RELIABLE_IN_TRANSIT;
+  }
+
+  void Net_Telemetry::count_sent(ENetPeer* peer, Message_Type type,
+                                 std::size_t bytes) noexcept
+  {
+    if(!peer) return;
+    peers_[peer].bytes_out[static_cast<std::size_t>(type)] += bytes;
+  }
+  void Net_Telemetry::count_received(ENetPeer* peer, Message_Type type,
+                                     std::size_t bytes) noexcept
+  {
+    if(!peer) return;
+    peers_[peer].bytes_in[static_cast<std::size_t>(type)] += bytes;
+  }
+
+  void Net_Telemetry::sample(ENetHost* host,
+                             tick_clock_t::time_point now) noexcept
+  {
+    using namespace std::chrono;
+
+    auto last = last_sample_.find(host);
+    if(last == last_sample_.end())
+    {
+      // Nothing to compare the first one to, start counting from here.
+      last_sample_.emplace(host, now);
+      return;
+    }
+
+    float seconds = duration<float>(now - last->second).count();
+    if(seconds < TELEMETRY_SAMPLE_SECONDS) return;
+    last->second = now;
+
+    for(auto it = peers_.begin(); it != peers_.end();)
+    {
+      ENetPeer* enet_peer = it->first;
+      if(enet_peer->host == host &&
+         enet_peer->state != ENET_PEER_STATE_CONNECTED)
+      {
+        it = peers_.erase(it);
+      }
+      else ++it;
+    }
+
+    for(std::size_t i = 0; i < host->peerCount; ++i)
+    {
+      ENetPeer* enet_peer = &host->peers[i];
+      if(enet_peer->state != ENET_PEER_STATE_CONNECTED) continue;
+
+      Peer& peer = peers_[enet_peer];
+      peer.address = enet_peer->address;
+
+      Telemetry_Sample& sample = peer.samples[peer.next_sample];
+      sample.seconds = seconds;
+      sample.rtt_ms = enet_peer->roundTripTime;
+      sample.rtt_variance_ms = enet_peer->roundTripTimeVariance;
+      sample.packet_loss = enet_peer->packetLoss /
+                           (float) ENET_PEER_PACKET_LOSS_SCALE;
+      sample.reliable_in_transit = enet_peer->reliableDataInTransit;
+      sample.bytes_in = peer.bytes_in;
+      sample.bytes_out = peer.bytes_out;
+
+      peer.bytes_in.fill(0);
+      peer.bytes_out.fill(0);
+
+      peer.next_sample = (peer.next_sample + 1) % TELEMETRY_WINDOW;
+      peer.num_samples = std::min(peer.num_samples + 1, TELEMETRY_WINDOW);
+    }
+
+    order_.clear();
+    for(auto const& peer_pair : peers_)
+    {
+      if(peer_pair.second.num_samples) order_.push_back(peer_pair.first);
+    }
+  }
+
+  void Net_Telemetry::forget(ENetPeer* peer) noexcept
+  {
+    peers_.erase(peer);
+    order_.erase(std::remove(order_.begin(), order_.end(), peer),
+                 order_.end());
+  }
+
+  Telemetry_Summary Net_Telemetry::summary(std::size_t index) const noexcept
+  {
+    Telemetry_Summary ret;
+    if(index >= order_.size()) return ret;
+
+    Peer const& peer = peers_.at(order_[index]);
+    ret.address = peer.address;
+
+    for(std::size_t i = 0; i < peer.num_samples; ++i)
+    {
+      Telemetry_Sample const& sample = peer.samples[i];
+      ret.seconds += sample.seconds;
+
+      ret.rtt_ms += sample.rtt_ms;
+      ret.rtt_max_ms = std::max(ret.rtt_max_ms, sample.rtt_ms);
+      ret.jitter_ms += sample.rtt_variance_ms;
+      ret.packet_loss += sample.packet_loss;
+      ret.reliable_in_transit_max = std::max(ret.reliable_in_transit_max,
+                                             sample.reliable_in_transit);
+
+      for(std::size_t type = 0; type < MESSAGE_TYPE_COUNT; ++type)
+      {
+        ret.type_bytes_in[type] += sample.bytes_in[type];
+        ret.type_bytes_out[type] += sample.bytes_out[type];
+      }
+    }
+
+    if(peer.num_samples)
+    {
+      ret.rtt_ms /= peer.num_samples;
+      ret.jitter_ms /= peer.num_samples;
+      ret.packet_loss /= peer.num_samples;
+    }
+    if(ret.seconds > 0.0f)
+    {
+      for(std::size_t type = 0; type < MESSAGE_TYPE_COUNT; ++type)
+      {
+        ret.type_bytes_in[type] /= ret.seconds;
+        ret.type_bytes_out[type] /= ret.seconds;
+        ret.bytes_in += ret.type_bytes_in[type];
+        ret.bytes_out += ret.type_bytes_out[type];
+      }
+    }
+    return ret;
+  }
+
+  void Net_Telemetry::log_summary(char const* name,
+                                  ENetHost* host) const noexcept
+  {
+    float rtt = 0.0f, loss = 0.0f, bytes_in = 0.0f, bytes_out = 0.0f;
+    uint32_t rtt_max = 0;
+    std::size_t peers = 0;
+    std::vector<Telemetry_Summary> saturated;
+    for(std::size_t i = 0; i < order_.size(); ++i)
+    {
+      if(host && order_[i]->host != host) continue;
+
+      Telemetry_Summary summary = this->summary(i);
+      rtt += summary.rtt_ms;
+      rtt_max = std::max(rtt_max, summary.rtt_max_ms);
+      loss += summary.packet_loss;
+      bytes_in += summary.bytes_in;
+      bytes_out += summary.bytes_out;
+      ++peers;
+
+      if(summary.saturated()) saturated.push_back(summary);
+    }
+    if(!peers) return;
+
+    log_i("%: % peers, rtt %ms avg, %ms max, loss % percent, % KB/s in, "
+          "% KB/s out, % saturated", name, peers, rtt / peers, rtt_max,
+          loss * 100.0f / peers, bytes_in / 1024.0f, bytes_out / 1024.0f,
+          saturated.size());
+
+    for(auto const& summary : saturated)
+    {
+      log_w("%: % is saturated, rtt %ms (jitter %ms), loss % percent, "
+            "% KB reliable in flight, % KB/s in, % KB/s out, mostly %", name,
+            to_string(summary.address), summary.rtt_ms, summary.jitter_ms,
+            summary.packet_loss * 100.0f,
+            summary.reliable_in_transit_max / 1024.0f,
+            summary.bytes_in / 1024.0f, summary.bytes_out / 1024.0f,
+            to_string(busiest_type(summary)));
+    }
+  }
+
+  Net_Telemetry& net_telemetry() noexcept
+  {
+    // Not trivial enough for REDC_THREAD_LOCAL, this one gets destroyed
+    // along with the thread.
+    static thread_local Net_Telemetry telemetry;
+    return telemetry;
+  }
+} }
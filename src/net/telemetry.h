@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2017 Luke San Antonio
+ * All rights reserved.
+ */
+#pragma once
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include <enet/enet.h>
+#include "../common/fixed_tick.h"
+#include "message.h"
+namespace redc { namespace net
+{
+  char const* to_string(Message_Type type) noexcept;
+  // Other if the name isn't one of ours.
+  Message_Type message_type_from_string(char const* name) noexcept;
+
+  // Peers are sampled this often, and we keep this many samples of each.
+  constexpr float TELEMETRY_SAMPLE_SECONDS = 1.0f;
+  constexpr std::size_t TELEMETRY_WINDOW = 10;
+
+  // One sample period of a peer.
+  struct Telemetry_Sample
+  {
+    float seconds = 0.0f;
+
+    // From ENet, as of the end of the period.
+    uint32_t rtt_ms = 0;
+    uint32_t rtt_variance_ms = 0;
+    float packet_loss = 0.0f;
+    uint32_t reliable_in_transit = 0;
+
+    // Message bytes over the period.
+    std::array<uint32_t, MESSAGE_TYPE_COUNT> bytes_in = {};
+    std::array<uint32_t, MESSAGE_TYPE_COUNT> bytes_out = {};
+  };
+
+  // Everything we know about a peer over the whole window.
+  struct Telemetry_Summary
+  {
+    ENetAddress address;
+    float seconds = 0.0f;
+
+    float rtt_ms = 0.0f;
+    uint32_t rtt_max_ms = 0;
+    float jitter_ms = 0.0f;
+    float packet_loss = 0.0f;
+    uint32_t reliable_in_transit_max = 0;
+
+    // Bytes per second.
+    float bytes_in = 0.0f;
+    float bytes_out = 0.0f;
+    std::array<float, MESSAGE_TYPE_COUNT> type_bytes_in = {};
+    std::array<float, MESSAGE_TYPE_COUNT> type_bytes_out = {};
+
+    // Whether this peer looks like it's falling behind.
+    bool saturated() const noexcept;
+  };
+
+  /*!
+   * \brief Keeps rolling windows of network stats for every peer.
+   *
+   * Messages are counted by send_data, receive_data and the snapshot code.
+   * Sampling reads the rest from ENet and moves the counts into the window,
+   * call it as often as you like, it only does anything once a sample is
+   * due. Like the packet pool there's one of these for each thread.
+   */
+  struct Net_Telemetry
+  {
+    void count_sent(ENetPeer* peer, Message_Type type,
+                    std::size_t bytes) noexcept;
+    void count_received(ENetPeer* peer, Message_Type type,
+                        std::size_t bytes) noexcept;
+
+    // Samples every connected peer of the host once a sample is due, and
+    // forgets about its peers that went away.
+    void sample(ENetHost* host, tick_clock_t::time_point now) noexcept;
+
+    // Call when a peer disconnects, ENet reuses them for new connections.
+    void forget(ENetPeer* peer) noexcept;
+
+    // Peers as of the last sample, in the order they were sampled.
+    std::size_t num_peers() const noexcept { return order_.size(); }
+    Telemetry_Summary summary(std::size_t index) const noexcept;
+
+    // One line for everybody, another for each peer that looks saturated.
+    // Only the host's peers if there is one.
+    void log_summary(char const* name,
+                     ENetHost* host = nullptr) const noexcept;
+
+  private:
+    struct Peer
+    {
+      ENetAddress address;
+
+      std::array<uint32_t, MESSAGE_TYPE_COUNT> bytes_in = {};
+      std::array<uint32_t, MESSAGE_TYPE_COUNT> bytes_out = {};
+
+      std::array<Telemetry_Sample, TELEMETRY_WINDOW> samples;
+      std::size_t next_sample = 0;
+      std::size_t num_samples = 0;
+    };
+
+    std::unordered_map<ENetPeer*, Peer> peers_;
+    std::vector<ENetPeer*> order_;
+
+    std::unordered_map<ENetHost*, tick_clock_t::time_point> last_sample_;
+  };
+
+  Net_Telemetry& net_telemetry() noexcept;
+} }
@@ -4,9 +4,6 @@
  */
 #include "player.h"
 
-// For Server
-#include "cwrap/redcrane.hpp"
-
 #include "common/log.h"
 
 // All of this is in meters
@@ -51,8 +48,6 @@ namespace redc
     : inited_(false), ghost_(), shape_(PLAYER_RADIUS, PLAYER_CAPSULE_HEIGHT),
       crouch_shape_(PLAYER_RADIUS, CROUCHED_CAPSULE_HEIGHT), jump_velocity_()
   {
-    server = nullptr;
-
     // Initialize velocity and impulse to zero
     jump_velocity_.setZero();
 
@@ -141,6 +136,14 @@ namespace redc
   }
   // They are expected to add the action to the dynamics world and then this
   // will be called, then we init then we start
+  void Player_Controller::remove_ghost(btCollisionWorld* world)
+  {
+    if(!inited_) return;
+
+    world->removeCollisionObject(&ghost_);
+    inited_ = false;
+  }
+
   void Player_Controller::updateAction(btCollisionWorld* world, btScalar dt)
   {
     if(!inited_)
@@ -383,7 +386,7 @@ namespace redc
 
         auto walk_time = walk_timer_.has_been<std::chrono::milliseconds>();
         auto walk_s = walk_time.count() / 1000.0f;
-        if(walk_s > props.step_rate)
+        if(walk_s > props.step_rate && !replaying_)
         {
           Player_Event event;
           event.type = Player_Event::Footstep;
@@ -428,7 +431,7 @@ namespace redc
     // Clicking on objects
     // ===
     {
-      if(input_ref_->primary_attack)
+      if(input_ref_->primary_attack && !replaying_)
       {
         // Cast a ray in the direction of the player.
         auto ray_rot = xform.getRotation();
@@ -460,9 +463,9 @@ namespace redc
           // If we just hit ourselves,
           // Check the object and give it to the server so the event can be
           // processed.
-          if(server)
+          if(on_click)
           {
-            server->on_physics_click(click_ray.m_collisionObject);
+            on_click(click_ray.m_collisionObject);
           }
         }
       }
@@ -617,6 +620,86 @@ namespace redc
     pitch_ *= btQuaternion(0.0f, -pitch, 0.0f);
   }
 
+  Player_Controller_State Player_Controller::save_state() const
+  {
+    Player_Controller_State ret;
+    ret.position = get_player_pos();
+    ret.rotation = ghost_.getWorldTransform().getRotation();
+    ret.jump_velocity = jump_velocity_;
+    ret.last_normal = last_normal_;
+    ret.state = state;
+    ret.crouched = player_props_.is_crouched;
+    return ret;
+  }
+  void Player_Controller::restore_state(Player_Controller_State const& saved)
+  {
+    if(saved.crouched)
+    {
+      ghost_.setCollisionShape(&crouch_shape_);
+      set_crouch_props();
+    }
+    else
+    {
+      ghost_.setCollisionShape(&shape_);
+      set_normal_props();
+    }
+
+    // The position is where the player stands, go back to the middle of the
+    // capsule.
+    float center_y = saved.position.y + player_props_.capsule_height / 2.0f +
+                     player_props_.radius + player_props_.shoe_size;
+
+    btTransform xform;
+    xform.setRotation(saved.rotation);
+    xform.setOrigin(btVector3(saved.position.x, center_y, saved.position.z));
+    ghost_.setWorldTransform(xform);
+
+    jump_velocity_ = saved.jump_velocity;
+    last_normal_ = saved.last_normal;
+    state = saved.state;
+  }
+
+  void Player_Controller::predict(btCollisionWorld* world, Input const& input,
+                                  btScalar dt, bool replay)
+  {
+    Input* old_input = input_ref_;
+    Input cur_input = input;
+
+    input_ref_ = &cur_input;
+    replaying_ = replay;
+
+    updateAction(world, dt);
+
+    replaying_ = false;
+    input_ref_ = old_input;
+  }
+
+  Player_Controller_State predict_player(Player_Controller& controller,
+                                         btCollisionWorld* world, btScalar dt,
+                                         Player_Controller_State const& from,
+                                         Input const& input,
+                                         Player_Controller_State const& last,
+                                         bool replay)
+  {
+    btQuaternion facing = controller.save_state().rotation;
+
+    Player_Controller_State start = from;
+    start.rotation = replay ? last.rotation : facing;
+    controller.restore_state(start);
+
+    controller.predict(world, input, dt, replay);
+    Player_Controller_State ret = controller.save_state();
+
+    // Don't lose whatever the mouse did since the newest input.
+    if(replay)
+    {
+      Player_Controller_State cur = ret;
+      cur.rotation = facing;
+      controller.restore_state(cur);
+    }
+    return ret;
+  }
+
   glm::vec3 Player_Controller::get_player_pos() const
   {
     btTransform trans;
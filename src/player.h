@@ -3,13 +3,13 @@
  * All rights reserved.
  */
 #pragma once
+#include <functional>
 #include <glm/glm.hpp>
 #include <LinearMath/btMotionState.h>
 #include <BulletDynamics/btBulletDynamicsCommon.h>
 #include <BulletCollision/CollisionDispatch/btGhostObject.h>
-#include "SDL.h"
-#include "input/input.h"
-#include "common/reactor.h"
+#include "input/sampled_input.h"
+#include "common/event_channel.h"
 #include "common/timer.hpp"
 namespace redc
 {
@@ -62,18 +62,45 @@ namespace redc
     } type;
   };
 
-  struct Server;
+  // Everything a tick of Player_Controller depends on, so a tick can be
+  // rewound and run again.
+  struct Player_Controller_State
+  {
+    glm::vec3 position;
+    btQuaternion rotation;
+
+    btVector3 jump_velocity;
+    btVector3 last_normal;
+
+    Player_State state;
+    bool crouched;
+  };
+
   struct Player_Controller : public btActionInterface
   {
     Player_Controller();
 
-    Server* server;
+    // Gets whatever the player clicks on, the server hooks this up.
+    std::function<void (btCollisionObject const*)> on_click;
 
     inline void reset() { inited_ = false; }
 
+    // Takes the player's ghost back out of the world, remove the controller
+    // itself as an action too.
+    void remove_ghost(btCollisionWorld* world);
+
     void updateAction(btCollisionWorld* world, btScalar dt) override;
     void debugDraw(btIDebugDraw*) override {}
 
+    Player_Controller_State save_state() const;
+    void restore_state(Player_Controller_State const& state);
+
+    // Runs a tick on the given input right away rather than when the world
+    // steps, clients do this to predict where they'll be. Replayed ticks
+    // don't make any events or click on anything, that already happened.
+    void predict(btCollisionWorld* world, Input const& input, btScalar dt,
+                 bool replay);
+
     inline void set_input_ref(Input* input) { input_ref_ = input; }
     Input* get_input_ref() { return input_ref_; }
 
@@ -106,6 +133,7 @@ namespace redc
     Player_Properties player_props_;
 
     Input* input_ref_;
+    bool replaying_ = false;
 
     btVector3 jump_velocity_;
 
@@ -117,9 +145,21 @@ namespace redc
 
     Timer<> walk_timer_;
 
-    Queue_Event_Source<Player_Event> events_;
+    // Only ever pushed and polled on the main thread, there's at most a few
+    // a frame.
+    SPSC_Channel<Player_Event> events_{64};
   };
 
+  // Runs a tick of prediction for net::Client_Prediction. The player keeps
+  // facing wherever the mouse has it, replays face the way they did the
+  // first time.
+  Player_Controller_State predict_player(Player_Controller& controller,
+                                         btCollisionWorld* world, btScalar dt,
+                                         Player_Controller_State const& from,
+                                         Input const& input,
+                                         Player_Controller_State const& last,
+                                         bool replay);
+
   struct Player
   {
     Player_Controller controller;
@@ -15,6 +15,8 @@ typedef struct
   uint16_t default_port;
   const char* client_entry;
   const char* server_entry;
+  bool compress_textures;
+  uint32_t texture_budget;
 } Redc_Config;
 
 void redc_log_d(const char* str);
@@ -57,6 +59,20 @@ void redc_unload_mesh(void* mesh);
 void* redc_load_texture(void* eng, const char* str);
 void redc_unload_texture(void* tex);
 
+// Packs small textures onto shared pages, objects using the same page can be
+// drawn without rebinding.
+void* redc_load_atlas(void* eng, const char** names, unsigned int count);
+void redc_unload_atlas(void* atlas);
+
+typedef struct {
+  unsigned int page;
+  // Texture uvs become uv * scale + offset on the page.
+  Redc_Vec2 uv_scale;
+  Redc_Vec2 uv_offset;
+} Redc_Atlas_Region;
+
+Redc_Atlas_Region redc_atlas_region(void* atlas, unsigned int index);
+
 // See cwrap/scene.cpp
 
 typedef uint16_t obj_id;
@@ -79,6 +95,8 @@ void redc_scene_camera_set_follow_player(void *sc, obj_id cam, bool en);
 void redc_scene_set_parent(void* sc, obj_id obj, obj_id parent);
 
 void redc_scene_object_set_texture(void *sc, obj_id obj, void *tex);
+void redc_scene_object_set_atlas_texture(void *sc, obj_id obj, void *atlas,
+                                         unsigned int index);
 
 void redc_scene_step(void *sc);
 void redc_scene_render(void *sc);
@@ -156,6 +174,32 @@ typedef struct
 } Redc_Event;
 int redc_server_poll_event(void *eng, Redc_Event *event);
 
+// See cwrap/net.cpp
+
+// Averages over the last few seconds, bytes are per second.
+typedef struct
+{
+  char address[64];
+  uint16_t port;
+
+  float rtt_ms;
+  uint32_t rtt_max_ms;
+  float jitter_ms;
+  float packet_loss;
+  uint32_t reliable_in_transit;
+
+  float bytes_in;
+  float bytes_out;
+
+  bool saturated;
+} Redc_Peer_Stats;
+
+int redc_net_peer_count();
+int redc_net_peer_stats(int index, Redc_Peer_Stats *stats);
+// Type is a message name like "snapshot" or "input_update".
+int redc_net_peer_message_rate(int index, const char *type, float *in,
+                               float *out);
+
 // See cwrap/text.cpp
 
 void redc_text_draw(void *eng, const char *text, float x, float y,
@@ -39,6 +39,51 @@ namespace redc { namespace gfx
     return ret;
   }
 
+  Mesh_Result package_mesh(IDriver& d, Packed_Mesh const& data, bool keep_msh)
+  {
+    std::unique_ptr<IMesh> mesh = d.make_mesh_repr();
+
+    // Same buffer convention as above, but the data is already laid out the
+    // way the buffers want it so we can upload straight from it.
+    std::vector<std::unique_ptr<IBuffer> > buffers(4);
+    d.make_buffers(buffers.size(), &buffers[0]);
+
+    buffers[0]->allocate(Buffer_Target::Array,
+                         data.num_vertices * sizeof(Vertex::position),
+                         data.positions, Usage_Hint::Draw, Upload_Hint::Static);
+    buffers[1]->allocate(Buffer_Target::Array,
+                         data.num_vertices * sizeof(Vertex::normal),
+                         data.normals, Usage_Hint::Draw, Upload_Hint::Static);
+    buffers[2]->allocate(Buffer_Target::Array,
+                         data.num_vertices * sizeof(Vertex::uv),
+                         data.uvs, Usage_Hint::Draw, Upload_Hint::Static);
+    buffers[3]->allocate(Buffer_Target::Element_Array,
+                         data.num_elements * sizeof(unsigned int),
+                         data.elements, Usage_Hint::Draw, Upload_Hint::Static);
+    format_standard_mesh_buffers(*mesh, buffers);
+
+    Mesh_Result ret;
+    ret.chunk.mesh = std::move(mesh);
+    for(auto& buf : buffers)
+    {
+      ret.chunk.buffers.push_back(std::move(buf));
+    }
+    // The coarser lods come after the full detail one in the element array,
+    // the chunk itself only covers the first.
+    ret.chunk.start = 0;
+    ret.chunk.count = data.lods.empty() ? data.num_elements :
+                                          data.lods.front().count;
+    ret.chunk.base_vertex = 0;
+    ret.chunk.type = data.primitive;
+    ret.chunk.lods = data.lods;
+    ret.chunk.center = data.center;
+    ret.chunk.radius = data.radius;
+
+    // Only now do we need the interleaved representation.
+    if(keep_msh) ret.data = unpack_mesh(data);
+    return ret;
+  }
+
   Mesh_Result load_mesh(IDriver& d, Mesh_Load_Params const& params)
   {
     auto split_data = load_wavefront(params.filename);
@@ -50,10 +95,10 @@ namespace redc { namespace gfx
   Mesh_Result load_mesh(IDriver& d, Mesh_Cache& mc,
                         Mesh_Load_Params const& params)
   {
-    // Use the cache to load!
-    auto mesh = mc.load(params.filename);
+    // Use the cache to load! This is usually a view into a mapped file.
+    Packed_Mesh mesh = mc.load(params.filename);
     // Package!
-    return package_mesh(d, std::move(mesh), params.retain_mesh);
+    return package_mesh(d, mesh, params.retain_mesh);
   }
 
   Mesh_Chunk load_chunk(IDriver& driver, Mesh_Cache& mc, std::string const& f)
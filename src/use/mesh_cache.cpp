@@ -7,53 +7,229 @@
 #include "../gfx/mesh_data.h"
 #include "../gfx/extra/load_wavefront.h"
 #include "../gfx/extra/mesh_conversion.h"
-#include "../gfx/extra/allocate.h"
-#include "../gfx/extra/format.h"
-#include "../gfx/extra/write_data_to_mesh.h"
+#include "../gfx/extra/optimize_mesh.h"
+#include "../gfx/extra/simplify_mesh.h"
 
 namespace redc { namespace gfx
 {
-  Mesh_Cache::Mesh_Cache(assets::fs::path source_path,
-                         assets::fs::path cache_dir)
-                         : Fs_Cache{{source_path, "obj", false},
-                                    {cache_dir, "obj.cache", true}} {}
+  // Bump this whenever the importer or the packed layout changes.
+  constexpr uint32_t MESH_IMPORTER_VERSION = 4;
+
+  namespace
+  {
+    struct Packed_Header
+    {
+      uint32_t primitive;
+      uint32_t num_vertices;
+      uint32_t num_elements;
+      uint32_t num_lods;
+
+      float center[3];
+      float radius;
+    };
+
+    struct Packed_Lod
+    {
+      uint32_t start;
+      uint32_t count;
+      float error;
+    };
+
+    std::size_t packed_size(std::size_t vertices, std::size_t elements,
+                            std::size_t lods)
+    {
+      return sizeof(Packed_Header) +
+             vertices * (sizeof(glm::vec3) * 2 + sizeof(glm::vec2)) +
+             elements * sizeof(unsigned int) +
+             lods * sizeof(Packed_Lod);
+    }
+  }
 
-  Indexed_Mesh_Data Mesh_Cache::load_from_source_stream(std::istream& st)
+  Packed_Mesh pack_mesh(Indexed_Mesh_Data const& mesh,
+                        std::vector<Mesh_Lod> const& lods_in)
   {
-    // Load .obj file
-    auto split_mesh = gfx::load_wavefront(st);
-    // Return combined
-    return gfx::to_indexed_mesh_data(split_mesh);
+    std::size_t num_verts = mesh.vertices.size();
+    std::size_t num_elements = mesh.elements.size();
+
+    std::vector<Mesh_Lod> lods = lods_in;
+    if(lods.empty())
+    {
+      lods.push_back({0, static_cast<unsigned int>(num_elements), 0.0f});
+    }
+
+    auto bytes = std::make_shared<std::vector<uint8_t> >(
+      packed_size(num_verts, num_elements, lods.size())
+    );
+
+    Packed_Header header;
+    header.primitive = static_cast<uint32_t>(mesh.primitive);
+    header.num_vertices = num_verts;
+    header.num_elements = num_elements;
+    header.num_lods = lods.size();
+
+    // A box is good enough for a bounding sphere.
+    glm::vec3 min(0.0f), max(0.0f);
+    if(num_verts)
+    {
+      min = max = mesh.vertices[0].position;
+      for(auto const& vert : mesh.vertices)
+      {
+        min = glm::min(min, vert.position);
+        max = glm::max(max, vert.position);
+      }
+    }
+    glm::vec3 center = (min + max) * 0.5f;
+    header.center[0] = center.x;
+    header.center[1] = center.y;
+    header.center[2] = center.z;
+    header.radius = glm::length(max - center);
+    std::memcpy(bytes->data(), &header, sizeof(header));
+
+    // Split up the vertices.
+    uint8_t* pos = bytes->data() + sizeof(header);
+    uint8_t* norm = pos + num_verts * sizeof(glm::vec3);
+    uint8_t* uv = norm + num_verts * sizeof(glm::vec3);
+    uint8_t* elements = uv + num_verts * sizeof(glm::vec2);
+    uint8_t* lod_table = elements + num_elements * sizeof(unsigned int);
+    for(std::size_t i = 0; i < num_verts; ++i)
+    {
+      Vertex const& vert = mesh.vertices[i];
+      std::memcpy(pos + i * sizeof(glm::vec3), &vert.position,
+                  sizeof(glm::vec3));
+      std::memcpy(norm + i * sizeof(glm::vec3), &vert.normal,
+                  sizeof(glm::vec3));
+      std::memcpy(uv + i * sizeof(glm::vec2), &vert.uv, sizeof(glm::vec2));
+    }
+    if(num_elements)
+    {
+      std::memcpy(elements, mesh.elements.data(),
+                  num_elements * sizeof(unsigned int));
+    }
+    for(std::size_t i = 0; i < lods.size(); ++i)
+    {
+      Packed_Lod lod = {lods[i].start, lods[i].count, lods[i].error};
+      std::memcpy(lod_table + i * sizeof(Packed_Lod), &lod, sizeof(lod));
+    }
+
+    Packed_Mesh ret;
+    bool valid = view_packed_mesh(bytes, bytes->data(), bytes->size(), ret);
+    REDC_ASSERT(valid);
+    return ret;
   }
-  Indexed_Mesh_Data Mesh_Cache::load_from_cache_stream(std::istream& st)
+
+  bool view_packed_mesh(std::shared_ptr<void const> storage,
+                        uint8_t const* bytes, std::size_t size,
+                        Packed_Mesh& mesh)
   {
-    // Load it in with msgpack, because that's how we wrote it!
+    if(size < sizeof(Packed_Header)) return false;
+
+    Packed_Header header;
+    std::memcpy(&header, bytes, sizeof(header));
 
-    msgpack::unpacker unpacker;
+    if(header.primitive > static_cast<uint32_t>(Primitive_Type::Triangle_Fan))
+    {
+      return false;
+    }
+    if(header.num_lods == 0) return false;
+
+    std::size_t total_size = packed_size(header.num_vertices,
+                                         header.num_elements, header.num_lods);
+    if(size < total_size) return false;
 
-    constexpr std::size_t read_size = 4096;
-    while(!st.eof())
+    // Everything after the header is four byte aligned as long as the start
+    // is, and mappings are page aligned.
+    uint8_t const* pos = bytes + sizeof(header);
+    uint8_t const* norm = pos + header.num_vertices * sizeof(glm::vec3);
+    uint8_t const* uv = norm + header.num_vertices * sizeof(glm::vec3);
+    uint8_t const* elements = uv + header.num_vertices * sizeof(glm::vec2);
+    uint8_t const* lod_table =
+      elements + header.num_elements * sizeof(unsigned int);
+
+    mesh.lods.clear();
+    for(std::size_t i = 0; i < header.num_lods; ++i)
     {
-      unpacker.reserve_buffer(read_size);
+      Packed_Lod lod;
+      std::memcpy(&lod, lod_table + i * sizeof(Packed_Lod), sizeof(lod));
+      if(lod.start > header.num_elements ||
+         lod.count > header.num_elements - lod.start)
+      {
+        return false;
+      }
+      mesh.lods.push_back({lod.start, lod.count, lod.error});
+    }
+
+    mesh.storage = std::move(storage);
+    mesh.primitive = static_cast<Primitive_Type>(header.primitive);
+    mesh.num_vertices = header.num_vertices;
+    mesh.num_elements = header.num_elements;
+    mesh.positions = reinterpret_cast<glm::vec3 const*>(pos);
+    mesh.normals = reinterpret_cast<glm::vec3 const*>(norm);
+    mesh.uvs = reinterpret_cast<glm::vec2 const*>(uv);
+    mesh.elements = reinterpret_cast<unsigned int const*>(elements);
+    mesh.center = glm::vec3(header.center[0], header.center[1],
+                            header.center[2]);
+    mesh.radius = header.radius;
+    mesh.bytes = bytes;
+    mesh.size = total_size;
+    return true;
+  }
+
+  Indexed_Mesh_Data unpack_mesh(Packed_Mesh const& mesh)
+  {
+    Indexed_Mesh_Data ret;
+    ret.primitive = mesh.primitive;
 
-      st.read(unpacker.buffer(), read_size);
-      unpacker.buffer_consumed(st.gcount());
+    ret.vertices.resize(mesh.num_vertices);
+    for(std::size_t i = 0; i < mesh.num_vertices; ++i)
+    {
+      ret.vertices[i].position = mesh.positions[i];
+      ret.vertices[i].normal = mesh.normals[i];
+      ret.vertices[i].uv = mesh.uvs[i];
     }
+    Mesh_Lod const& full = mesh.lods.front();
+    ret.elements.assign(mesh.elements + full.start,
+                        mesh.elements + full.start + full.count);
+    return ret;
+  }
+
+  Mesh_Cache::Mesh_Cache(assets::fs::path source_path,
+                         assets::fs::path cache_dir, Job_System* jobs)
+                         : Fs_Cache{{source_path, "obj", false},
+                                    {cache_dir, "obj.cache", true},
+                                    MESH_IMPORTER_VERSION}, jobs_(jobs) {}
+
+  bool Mesh_Cache::load_from_source(boost::filesystem::path const&,
+                                    uint8_t const* data, std::size_t size,
+                                    Packed_Mesh& packed)
+  {
+    // Load .obj file, straight out of the mapping.
+    auto obj = reinterpret_cast<char const*>(data);
+    auto split_mesh = gfx::parse_wavefront(obj, obj + size, jobs_);
+    // Combine
+    auto mesh = gfx::to_indexed_mesh_data(split_mesh);
 
-    msgpack::unpacked object;
-    bool found = unpacker.next(object);
-    REDC_ASSERT(found);
+    // This only happens when the cache is cold so it's worth spending some
+    // time on the order of everything.
+    auto stats = optimize_mesh(mesh);
+    log_d("Optimized mesh with % vertices and % triangles, ACMR % -> %",
+          mesh.vertices.size(), mesh.elements.size() / 3, stats.acmr_before,
+          stats.acmr_after);
 
-    Indexed_Mesh_Data mesh;
-    REDC_ASSERT_NO_THROW(mesh = object.get().as<Indexed_Mesh_Data>());
+    // Coarser versions for far away.
+    auto lods = generate_lods(mesh);
 
-    return mesh;
+    packed = pack_mesh(mesh, lods);
+    return true;
+  }
+  bool Mesh_Cache::load_from_cache(assets::Cache_Payload const& payload,
+                                   Packed_Mesh& mesh)
+  {
+    // The payload is already in the packed layout, just point into it.
+    return view_packed_mesh(payload.file, payload.data, payload.size, mesh);
   }
 
-  void Mesh_Cache::write_cache(Indexed_Mesh_Data const& msh,
-                               std::ostream& str)
+  void Mesh_Cache::write_cache(Packed_Mesh const& msh, std::ostream& str)
   {
-    // Write the stuff to the file
-    msgpack::pack(str, msh);
+    str.write(reinterpret_cast<char const*>(msh.bytes), msh.size);
   }
 } }
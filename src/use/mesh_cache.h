@@ -4,20 +4,78 @@
  */
 #pragma once
 #include "../assets/fs_cache.h"
+namespace redc
+{
+  struct Job_System;
+}
 namespace redc { namespace gfx
 {
+  /*!
+   * \brief A mesh laid out the way the standard mesh buffers want it.
+   *
+   * Positions, normals and uvs are each contiguous, followed by the element
+   * array, so each one can be given to IBuffer::allocate directly. The data
+   * either lives in a mapped cache file or in memory we own, storage keeps
+   * whichever one it is alive.
+   *
+   * The element array has every lod one after the other, they all index the
+   * same vertices.
+   */
+  struct Packed_Mesh
+  {
+    std::shared_ptr<void const> storage;
+
+    Primitive_Type primitive = Primitive_Type::Triangles;
+
+    std::size_t num_vertices = 0;
+    std::size_t num_elements = 0;
+
+    glm::vec3 const* positions = nullptr;
+    glm::vec3 const* normals = nullptr;
+    glm::vec2 const* uvs = nullptr;
+    unsigned int const* elements = nullptr;
+
+    // The full detail mesh is always the first one.
+    std::vector<Mesh_Lod> lods;
+
+    // Bounding sphere
+    glm::vec3 center;
+    float radius = 0.0f;
+
+    // The whole packed representation, this is what goes in the cache.
+    uint8_t const* bytes = nullptr;
+    std::size_t size = 0;
+  };
+
+  // With no lods given the whole element array is the only one.
+  Packed_Mesh pack_mesh(Indexed_Mesh_Data const& mesh,
+                        std::vector<Mesh_Lod> const& lods = {});
+  // Returns false if the data isn't a valid packed mesh.
+  bool view_packed_mesh(std::shared_ptr<void const> storage,
+                        uint8_t const* bytes, std::size_t size,
+                        Packed_Mesh& mesh);
+  // Only the full detail elements are unpacked.
+  Indexed_Mesh_Data unpack_mesh(Packed_Mesh const& mesh);
+
   /*!
    * \brief Wraps mesh creation without a need to pass the driver.
    *
    * The driver is really what is cached, so that it doesn't have to be
    * liberally passed around everywhere like things have been.
    */
-  struct Mesh_Cache : public assets::Fs_Cache<Indexed_Mesh_Data>
+  struct Mesh_Cache : public assets::Fs_Cache<Packed_Mesh>
   {
-    Mesh_Cache(assets::fs::path source, assets::fs::path cache);
+    // Big source files are parsed in parallel on the job system, if given.
+    Mesh_Cache(assets::fs::path source, assets::fs::path cache,
+               Job_System* jobs = nullptr);
   private:
-    Indexed_Mesh_Data load_from_source_stream(std::istream& st) override;
-    Indexed_Mesh_Data load_from_cache_stream(std::istream& st) override;
-    void write_cache(Indexed_Mesh_Data const& msh, std::ostream& st) override;
+    bool load_from_source(boost::filesystem::path const& path,
+                          uint8_t const* data, std::size_t size,
+                          Packed_Mesh& mesh) override;
+    bool load_from_cache(assets::Cache_Payload const& payload,
+                         Packed_Mesh& mesh) override;
+    void write_cache(Packed_Mesh const& msh, std::ostream& st) override;
+
+    Job_System* jobs_;
   };
 } }
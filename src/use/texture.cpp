@@ -3,7 +3,11 @@
  * All rights reserved.
  */
 #include "texture.h"
+#include <algorithm>
+#include "texture_cache.h"
+#include "../common/log.h"
 #include "../gfx/extra/texture_load.h"
+#include "../gfx/extra/texture_mips.h"
 namespace redc { namespace gfx
 {
   std::unique_ptr<ITexture> load_texture(gfx::IDriver& d,
@@ -16,6 +20,83 @@ namespace redc { namespace gfx
 
     return tex;
   }
+  std::unique_ptr<ITexture> load_texture(gfx::IDriver& d, Texture_Cache& cache,
+                                         std::string name) noexcept
+  {
+    Packed_Texture packed;
+    if(!cache.load(name, packed))
+    {
+      log_w("Failed to load texture '%'", name);
+      return nullptr;
+    }
+
+    std::unique_ptr<ITexture> tex = d.make_texture_repr();
+    upload_packed_texture(*tex, packed);
+    return tex;
+  }
+  void upload_packed_texture(ITexture& tex, Packed_Texture const& packed)
+  {
+    for(unsigned int i = 0; i < packed.levels.size(); ++i)
+    {
+      auto const& level = packed.levels[i];
+      if(packed.format == Texture_Format::Srgb_Alpha)
+      {
+        tex.blit_tex2d_level(i, level.extents, Texture_Format::Srgb_Alpha,
+                             Texture_Format::Rgba, Data_Type::UByte,
+                             level.data);
+      }
+      else
+      {
+        tex.blit_compressed_tex2d_level(i, level.extents, packed.format,
+                                        level.size, level.data);
+      }
+    }
+
+    tex.set_min_filter(Texture_Filter::Linear_Mipmap_Linear);
+    tex.set_mag_filter(Texture_Filter::Linear);
+    if(!packed.levels.empty()) tex.set_mipmap_level(packed.levels.size() - 1);
+  }
+  Atlas_Textures load_atlas(gfx::IDriver& d, std::string const& dir,
+                            std::vector<std::string> const& names) noexcept
+  {
+    std::vector<Image> images;
+    for(auto const& name : names)
+    {
+      images.push_back(load_png_data(dir + "/" + name + ".png"));
+    }
+
+    auto atlas = build_atlas(images);
+
+    // Past this many levels the padding is gone and neighbors would bleed
+    // into each other.
+    unsigned int max_levels = 1;
+    for(std::size_t pad = ATLAS_PADDING; pad > 1; pad /= 2) ++max_levels;
+
+    Atlas_Textures ret;
+    for(Image& page : atlas.pages)
+    {
+      flip_image_rows(page);
+      auto mips = generate_srgb_mips(page);
+      unsigned int num_levels =
+        std::min<std::size_t>(max_levels, mips.size() + 1);
+
+      std::unique_ptr<ITexture> tex = d.make_texture_repr();
+      for(unsigned int i = 0; i < num_levels; ++i)
+      {
+        Image const& level = i == 0 ? page : mips[i - 1];
+        tex->blit_tex2d_level(i, level.extents, Texture_Format::Srgb_Alpha,
+                              Texture_Format::Rgba, Data_Type::UByte,
+                              &level.data[0]);
+      }
+      tex->set_min_filter(Texture_Filter::Linear_Mipmap_Linear);
+      tex->set_mag_filter(Texture_Filter::Linear);
+      tex->set_mipmap_level(num_levels - 1);
+
+      ret.pages.push_back(std::move(tex));
+    }
+    ret.regions = std::move(atlas.regions);
+    return ret;
+  }
   std::unique_ptr<ITexture> load_cubemap(gfx::IDriver& d, std::string front,
                                         std::string back, std::string right,
                                         std::string left, std::string top,
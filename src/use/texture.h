@@ -7,11 +7,34 @@
 #include <string>
 #include "../gfx/idriver.h"
 #include "../gfx/itexture.h"
+#include "../gfx/extra/texture_atlas.h"
 namespace redc { namespace gfx
 {
+  struct Texture_Cache;
+  struct Packed_Texture;
+
   std::unique_ptr<ITexture> load_texture(gfx::IDriver& d,
                                          std::string filename) noexcept;
 
+  // Name is relative to the cache's source directory without the extension.
+  // The whole mip chain is uploaded with trilinear filtering. Returns null if
+  // the texture couldn't be decoded.
+  std::unique_ptr<ITexture> load_texture(gfx::IDriver& d, Texture_Cache& cache,
+                                         std::string name) noexcept;
+  void upload_packed_texture(ITexture& tex, Packed_Texture const& packed);
+
+  struct Atlas_Textures
+  {
+    std::vector<std::unique_ptr<ITexture> > pages;
+    // One for each texture, in the order they were given.
+    std::vector<Atlas_Region> regions;
+  };
+
+  // Packs small pngs from dir together, names don't have the extension.
+  // Every one of them has to fit on an atlas page.
+  Atlas_Textures load_atlas(gfx::IDriver& d, std::string const& dir,
+                            std::vector<std::string> const& names) noexcept;
+
   std::unique_ptr<ITexture> load_cubemap(gfx::IDriver& d,
                                          std::string front, std::string back,
                                          std::string right, std::string left,
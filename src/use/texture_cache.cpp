@@ -0,0 +1,216 @@
+/*
+ * Copyright (C) 2016 Luke San Antonio
+ * All rights reserved.
+ */
+#include "texture_cache.h"
+#include <algorithm>
+#include <iterator>
+#include "../common/debugging.h"
+#include "../gfx/extra/block_compress.h"
+#include "../gfx/extra/texture_load.h"
+#include "../gfx/extra/texture_mips.h"
+
+namespace redc { namespace gfx
+{
+  // Bump this whenever the importer or the packed layout changes.
+  constexpr uint32_t TEXTURE_IMPORTER_VERSION = 1;
+
+  namespace
+  {
+    struct Packed_Header
+    {
+      uint32_t format;
+      uint32_t width;
+      uint32_t height;
+      uint32_t num_levels;
+    };
+
+    struct Packed_Level
+    {
+      // From the start of the packed texture.
+      uint32_t offset;
+      uint32_t size;
+      uint32_t width;
+      uint32_t height;
+    };
+
+    bool valid_format(uint32_t format)
+    {
+      switch(static_cast<Texture_Format>(format))
+      {
+      case Texture_Format::Srgb_Alpha:
+      case Texture_Format::Bc1_Srgb_Alpha:
+      case Texture_Format::Bc3_Srgb_Alpha:
+        return true;
+      default:
+        return false;
+      }
+    }
+
+    bool is_opaque(Image const& image)
+    {
+      for(Color const& c : image.data)
+      {
+        if(c.a != 0xff) return false;
+      }
+      return true;
+    }
+  }
+
+  Packed_Texture pack_texture(Image image, bool compress)
+  {
+    flip_image_rows(image);
+
+    std::vector<Image> chain;
+    chain.push_back(std::move(image));
+    auto mips = generate_srgb_mips(chain.front());
+    std::move(mips.begin(), mips.end(), std::back_inserter(chain));
+
+    Texture_Format format = Texture_Format::Srgb_Alpha;
+    if(compress)
+    {
+      format = is_opaque(chain.front()) ? Texture_Format::Bc1_Srgb_Alpha :
+                                          Texture_Format::Bc3_Srgb_Alpha;
+    }
+
+    std::vector<std::vector<uint8_t> > compressed;
+    if(format != Texture_Format::Srgb_Alpha)
+    {
+      for(Image const& level : chain)
+      {
+        compressed.push_back(compress_image(level, format));
+      }
+    }
+
+    // Figure out where everything goes. Every level is a multiple of four
+    // bytes so they all stay aligned.
+    std::vector<Packed_Level> table(chain.size());
+    std::size_t offset = sizeof(Packed_Header) +
+                         table.size() * sizeof(Packed_Level);
+    for(std::size_t i = 0; i < chain.size(); ++i)
+    {
+      std::size_t size = compressed.empty() ?
+                         chain[i].data.size() * sizeof(Color) :
+                         compressed[i].size();
+      table[i].offset = offset;
+      table[i].size = size;
+      table[i].width = chain[i].extents.x;
+      table[i].height = chain[i].extents.y;
+      offset += size;
+    }
+
+    auto bytes = std::make_shared<std::vector<uint8_t> >(offset);
+
+    Packed_Header header;
+    header.format = static_cast<uint32_t>(format);
+    header.width = chain.front().extents.x;
+    header.height = chain.front().extents.y;
+    header.num_levels = chain.size();
+    std::memcpy(bytes->data(), &header, sizeof(header));
+    std::memcpy(bytes->data() + sizeof(header), table.data(),
+                table.size() * sizeof(Packed_Level));
+
+    for(std::size_t i = 0; i < chain.size(); ++i)
+    {
+      if(table[i].size == 0) continue;
+
+      void const* src = compressed.empty() ?
+                        static_cast<void const*>(chain[i].data.data()) :
+                        compressed[i].data();
+      std::memcpy(bytes->data() + table[i].offset, src, table[i].size);
+    }
+
+    Packed_Texture ret;
+    bool valid = view_packed_texture(bytes, bytes->data(), bytes->size(),
+                                     ret);
+    REDC_ASSERT(valid);
+    return ret;
+  }
+
+  bool view_packed_texture(std::shared_ptr<void const> storage,
+                           uint8_t const* bytes, std::size_t size,
+                           Packed_Texture& tex)
+  {
+    if(size < sizeof(Packed_Header)) return false;
+
+    Packed_Header header;
+    std::memcpy(&header, bytes, sizeof(header));
+
+    if(!valid_format(header.format)) return false;
+    if(header.num_levels == 0) return false;
+
+    std::size_t table_end = sizeof(Packed_Header) +
+                            header.num_levels * sizeof(Packed_Level);
+    if(size < table_end) return false;
+
+    Texture_Format format = static_cast<Texture_Format>(header.format);
+
+    tex.levels.clear();
+    std::size_t total_size = table_end;
+    for(std::size_t i = 0; i < header.num_levels; ++i)
+    {
+      Packed_Level level;
+      std::memcpy(&level, bytes + sizeof(Packed_Header) +
+                          i * sizeof(Packed_Level), sizeof(level));
+
+      Vec<std::size_t> extents = {level.width, level.height};
+      std::size_t expected = format == Texture_Format::Srgb_Alpha ?
+                             extents.x * extents.y * sizeof(Color) :
+                             compressed_size(extents, format);
+      if(level.size != expected || level.offset < table_end ||
+         level.offset > size || level.size > size - level.offset)
+      {
+        return false;
+      }
+      total_size = std::max<std::size_t>(total_size,
+                                         level.offset + level.size);
+
+      Packed_Texture::Level view;
+      view.extents = extents;
+      view.data = bytes + level.offset;
+      view.size = level.size;
+      tex.levels.push_back(view);
+    }
+
+    tex.storage = std::move(storage);
+    tex.format = format;
+    tex.extents = {header.width, header.height};
+    tex.bytes = bytes;
+    tex.size = total_size;
+    return true;
+  }
+
+  Texture_Cache::Texture_Cache(assets::fs::path source_path,
+                               assets::fs::path cache_dir, bool compress)
+                         : Fs_Cache{{source_path, "png", true},
+                                    {cache_dir,
+                                     compress ? "png.bc.cache" : "png.cache",
+                                     true},
+                                    TEXTURE_IMPORTER_VERSION},
+                           compress_(compress) {}
+
+  bool Texture_Cache::load_from_source(boost::filesystem::path const& path,
+                                       uint8_t const* data, std::size_t size,
+                                       Packed_Texture& tex)
+  {
+    auto image = load_png_data(data, size, path.string());
+    // The decoder has already said why.
+    if(image.data.empty()) return false;
+
+    tex = pack_texture(std::move(image), compress_);
+    log_d("Packed %x% texture with % levels into % bytes", tex.extents.x,
+          tex.extents.y, tex.levels.size(), tex.size);
+    return true;
+  }
+  bool Texture_Cache::load_from_cache(assets::Cache_Payload const& payload,
+                                      Packed_Texture& tex)
+  {
+    // Like meshes, the payload is the packed layout.
+    return view_packed_texture(payload.file, payload.data, payload.size, tex);
+  }
+
+  void Texture_Cache::write_cache(Packed_Texture const& tex, std::ostream& str)
+  {
+    str.write(reinterpret_cast<char const*>(tex.bytes), tex.size);
+  }
+} }
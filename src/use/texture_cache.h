@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2016 Luke San Antonio
+ * All rights reserved.
+ */
+#pragma once
+#include "../assets/fs_cache.h"
+#include "../common/vec.h"
+#include "../gfx/common.h"
+namespace redc { namespace gfx
+{
+  struct Image;
+
+  /*!
+   * \brief A texture with its whole mip chain, ready to upload as is.
+   *
+   * Rows are already bottom to top like GL wants them. The levels point
+   * into storage, which is either a mapped cache file or memory we own.
+   */
+  struct Packed_Texture
+  {
+    struct Level
+    {
+      Vec<std::size_t> extents;
+      uint8_t const* data = nullptr;
+      std::size_t size = 0;
+    };
+
+    std::shared_ptr<void const> storage;
+
+    // Srgb_Alpha for uncompressed rgba, otherwise one of the block
+    // compressed formats.
+    Texture_Format format = Texture_Format::Srgb_Alpha;
+    Vec<std::size_t> extents;
+
+    // The base level is always the first one.
+    std::vector<Level> levels;
+
+    // The whole packed representation, this is what goes in the cache.
+    uint8_t const* bytes = nullptr;
+    std::size_t size = 0;
+  };
+
+  // Flips, generates mips and optionally block compresses the image.
+  Packed_Texture pack_texture(Image image, bool compress);
+  // Returns false if the data isn't a valid packed texture.
+  bool view_packed_texture(std::shared_ptr<void const> storage,
+                           uint8_t const* bytes, std::size_t size,
+                           Packed_Texture& tex);
+
+  /*!
+   * \brief Caches decoded pngs with their mip chains.
+   *
+   * Decoding the png, converting to linear space for the mips and possibly
+   * compressing only happens once, after that the cache file is mapped and
+   * uploaded level by level.
+   */
+  struct Texture_Cache : public assets::Fs_Cache<Packed_Texture>
+  {
+    // With compress the textures are stored as BC1 when they are opaque and
+    // BC3 otherwise.
+    Texture_Cache(assets::fs::path source, assets::fs::path cache,
+                  bool compress = false);
+  private:
+    bool load_from_source(boost::filesystem::path const& path,
+                          uint8_t const* data, std::size_t size,
+                          Packed_Texture& tex) override;
+    bool load_from_cache(assets::Cache_Payload const& payload,
+                         Packed_Texture& tex) override;
+    void write_cache(Packed_Texture const& tex, std::ostream& st) override;
+
+    bool compress_;
+  };
+} }
@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2016 Luke San Antonio
+ * All rights reserved.
+ */
+#include "texture_streamer.h"
+#include "../common/debugging.h"
+#include "../common/log.h"
+namespace redc { namespace gfx
+{
+  Texture_Streamer::Texture_Streamer(IDriver& driver, Texture_Cache& cache,
+                                     std::size_t budget)
+    : driver_(&driver), cache_(&cache), residency_(budget) {}
+
+  void Texture_Streamer::Deleter::operator()(ITexture* tex) const
+  {
+    streamer->remove_(tex);
+    delete tex;
+  }
+
+  Texture_Streamer::Texture_Ptr Texture_Streamer::load(std::string name)
+  {
+    Texture entry;
+    if(!cache_->load(name, entry.packed))
+    {
+      log_w("Failed to load texture '%'", name);
+      return Texture_Ptr(nullptr, Deleter{this});
+    }
+
+    Texture_Ptr tex(driver_->make_texture_repr().release(), Deleter{this});
+    entry.tex = tex.get();
+
+    std::vector<std::size_t> level_sizes;
+    for(auto const& level : entry.packed.levels)
+    {
+      level_sizes.push_back(level.size);
+    }
+    entry.id = residency_.add(entry.packed.extents, std::move(level_sizes));
+
+    // Nothing is resident yet, the first step brings in the smallest levels.
+    unsigned int num_levels = entry.packed.levels.size();
+    tex->allocate_streamed(entry.packed.extents, entry.packed.format);
+    tex->set_min_filter(Texture_Filter::Linear_Mipmap_Linear);
+    tex->set_mag_filter(Texture_Filter::Linear);
+    tex->set_mipmap_level(num_levels - 1);
+    tex->set_base_mipmap_level(num_levels - 1);
+
+    auto& stored = textures_[tex.get()] = std::move(entry);
+    if(by_id_.size() <= stored.id) by_id_.resize(stored.id + 1, nullptr);
+    by_id_[stored.id] = &stored;
+
+    return tex;
+  }
+
+  void Texture_Streamer::remove_(ITexture* tex)
+  {
+    auto it = textures_.find(tex);
+    REDC_ASSERT_MSG(it != textures_.end(), "Texture wasn't streamed");
+
+    residency_.remove(it->second.id);
+    by_id_[it->second.id] = nullptr;
+    textures_.erase(it);
+  }
+
+  void Texture_Streamer::report(ITexture const& tex, float projected_size)
+  {
+    auto it = textures_.find(&tex);
+    if(it == textures_.end()) return;
+    residency_.report(it->second.id, projected_size);
+  }
+
+  std::size_t Texture_Streamer::step(std::size_t upload_budget)
+  {
+    std::size_t uploaded = 0;
+    for(auto const& change : residency_.step(upload_budget))
+    {
+      Texture* entry = by_id_[change.id];
+      REDC_ASSERT(entry);
+
+      ITexture& tex = *entry->tex;
+      auto const& level = entry->packed.levels[change.level];
+      if(change.type == Texture_Residency::Change::Upload)
+      {
+        if(entry->packed.format == Texture_Format::Srgb_Alpha)
+        {
+          tex.blit_tex2d_level(change.level, level.extents,
+                               Texture_Format::Srgb_Alpha,
+                               Texture_Format::Rgba, Data_Type::UByte,
+                               level.data);
+        }
+        else
+        {
+          tex.blit_compressed_tex2d_level(change.level, level.extents,
+                                          entry->packed.format, level.size,
+                                          level.data);
+        }
+        tex.set_base_mipmap_level(change.level);
+        uploaded += level.size;
+      }
+      else
+      {
+        // Stop sampling it before it goes away.
+        tex.set_base_mipmap_level(change.level + 1);
+        tex.release_tex2d_level(change.level);
+      }
+    }
+    return uploaded;
+  }
+} }
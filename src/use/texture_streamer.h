@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2016 Luke San Antonio
+ * All rights reserved.
+ */
+#pragma once
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include "texture_cache.h"
+#include "../gfx/idriver.h"
+#include "../gfx/itexture.h"
+#include "../gfx/extra/texture_residency.h"
+namespace redc { namespace gfx
+{
+  /*!
+   * \brief Loads textures from the cache and streams their mip levels in and
+   * out as needed.
+   *
+   * Textures start out with only their smallest levels, the renderer reports
+   * how big they are on screen every frame and step uploads the bigger levels
+   * that are needed and evicts the ones that aren't, all within a memory
+   * budget. See Texture_Residency for the actual decisions.
+   *
+   * The streamer must outlive every texture it loads.
+   */
+  struct Texture_Streamer
+  {
+    Texture_Streamer(IDriver& driver, Texture_Cache& cache,
+                     std::size_t budget);
+
+    // Stops the texture from being streamed when it's deleted.
+    struct Deleter
+    {
+      Texture_Streamer* streamer;
+      void operator()(ITexture* tex) const;
+    };
+    using Texture_Ptr = std::unique_ptr<ITexture, Deleter>;
+
+    // Null if the texture couldn't be decoded.
+    Texture_Ptr load(std::string name);
+
+    // Textures that weren't loaded by us are ignored.
+    void report(ITexture const& tex, float projected_size);
+
+    // Once per frame after rendering, returns the bytes uploaded.
+    std::size_t step(std::size_t upload_budget);
+
+    Texture_Residency const& residency() const { return residency_; }
+  private:
+    struct Texture
+    {
+      Texture_Residency::tex_id id;
+      Packed_Texture packed;
+      ITexture* tex;
+    };
+
+    void remove_(ITexture* tex);
+
+    IDriver* driver_;
+    Texture_Cache* cache_;
+
+    Texture_Residency residency_;
+
+    std::unordered_map<ITexture const*, Texture> textures_;
+    // Indexed by residency id.
+    std::vector<Texture*> by_id_;
+  };
+} }
@@ -0,0 +1,151 @@
+/*
+ * Copyright (C) 2016 Luke San Antonio
+ * All rights reserved.
+ */
+#include "catch/catch.hpp"
+#include "assets/file_watcher.h"
+#include "assets/live_file.h"
+
+#include <fstream>
+#include <boost/filesystem.hpp>
+
+namespace
+{
+  namespace fs = boost::filesystem;
+
+  struct Temp_Dir
+  {
+    Temp_Dir() : path(fs::temp_directory_path() / fs::unique_path())
+    {
+      fs::create_directories(path);
+    }
+    ~Temp_Dir()
+    {
+      boost::system::error_code err;
+      fs::remove_all(path, err);
+    }
+
+    std::string file(std::string const& name) const
+    {
+      return (path / name).string();
+    }
+
+    fs::path path;
+  };
+
+  void write_file(std::string const& filename, std::string const& contents)
+  {
+    std::ofstream st(filename);
+    st << contents;
+  }
+
+  // Dispatch until something comes through, or give up after a while.
+  std::size_t wait_for_dispatch(redc::assets::File_Watcher& watcher)
+  {
+    for(int i = 0; i < 300; ++i)
+    {
+      auto called = watcher.dispatch();
+      if(called) return called;
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return 0;
+  }
+}
+
+TEST_CASE("File watcher notices changes", "[File_Watcher]")
+{
+  using namespace redc::assets;
+
+  Temp_Dir dir;
+  write_file(dir.file("a.glsl"), "a");
+  write_file(dir.file("b.glsl"), "b");
+
+  bool polling = false;
+  SECTION("Native") {}
+  SECTION("Polling") { polling = true; }
+
+  File_Watcher watcher(std::chrono::milliseconds(20), polling);
+
+  std::vector<std::string> changed;
+  auto cb = [&changed](std::string const& f) { changed.push_back(f); };
+  auto a = watcher.watch(dir.file("a.glsl"), cb);
+  watcher.watch(dir.file("b.glsl"), cb);
+
+  // Nothing happened yet.
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  REQUIRE(watcher.dispatch() == 0);
+
+  // Files we don't watch in the same directory don't matter.
+  write_file(dir.file("c.glsl"), "c");
+  // Writing twice is still one change, and the size changes so polling
+  // notices within the same second.
+  write_file(dir.file("a.glsl"), "aa");
+  write_file(dir.file("a.glsl"), "aaa");
+
+  REQUIRE(wait_for_dispatch(watcher) == 1);
+  REQUIRE(changed.size() == 1);
+  CHECK(changed[0] == dir.file("a.glsl"));
+
+  // Once we stop watching it we don't hear about it.
+  watcher.unwatch(a);
+  changed.clear();
+  write_file(dir.file("a.glsl"), "aaaa");
+  write_file(dir.file("b.glsl"), "bb");
+
+  REQUIRE(wait_for_dispatch(watcher) == 1);
+  REQUIRE(changed.size() == 1);
+  CHECK(changed[0] == dir.file("b.glsl"));
+}
+
+TEST_CASE("Busy directories don't hold back others", "[File_Watcher]")
+{
+  using namespace redc::assets;
+
+  Temp_Dir busy_dir;
+  Temp_Dir quiet_dir;
+  write_file(busy_dir.file("a.glsl"), "a");
+  write_file(quiet_dir.file("b.glsl"), "b");
+
+  File_Watcher watcher(std::chrono::milliseconds(20));
+
+  std::vector<std::string> changed;
+  auto cb = [&changed](std::string const& f) { changed.push_back(f); };
+  watcher.watch(busy_dir.file("a.glsl"), cb);
+  watcher.watch(quiet_dir.file("b.glsl"), cb);
+
+  // Polling doesn't wait for anything to settle down.
+  if(watcher.polling()) return;
+
+  // Keep one directory busy the whole time, faster than it can settle.
+  write_file(quiet_dir.file("b.glsl"), "bb");
+  std::string contents = "a";
+  for(int i = 0; i < 100 && changed.empty(); ++i)
+  {
+    contents += "a";
+    write_file(busy_dir.file("a.glsl"), contents);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    watcher.dispatch();
+  }
+
+  REQUIRE(changed.size() == 1);
+  CHECK(changed[0] == quiet_dir.file("b.glsl"));
+}
+
+TEST_CASE("Live files are changed until opened", "[File_Watcher]")
+{
+  using namespace redc;
+
+  Temp_Dir dir;
+  write_file(dir.file("vs.glsl"), "void main() {}");
+
+  assets::File_Watcher watcher(std::chrono::milliseconds(20));
+  Live_File file(watcher, dir.file("vs.glsl"));
+
+  REQUIRE(file.changed_on_disk());
+  file.open_ifstream();
+  REQUIRE_FALSE(file.changed_on_disk());
+
+  write_file(dir.file("vs.glsl"), "void main() { }");
+  REQUIRE(wait_for_dispatch(watcher) == 1);
+  REQUIRE(file.changed_on_disk());
+}
@@ -0,0 +1,151 @@
+/*
+ * Copyright (C) 2017 Luke San Antonio
+ * All rights reserved.
+ *
+ * Compares the lock-free event channels with a queue behind a mutex, which
+ * is what events used to go through. Every setup moves the same number of
+ * events from some producer threads to one consumer that polls in batches.
+ * Run with the event count as the first argument to change the amount of
+ * work.
+ */
+#include "common/event_channel.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace
+{
+  // Like the old Queue_Event_Source but bounded like the channels, so
+  // everything backs off the same way when the consumer falls behind.
+  template <class T>
+  struct Mutex_Queue
+  {
+    explicit Mutex_Queue(std::size_t capacity) : capacity_(capacity) {}
+
+    bool push(T event)
+    {
+      std::lock_guard<std::mutex> lock(mut_);
+      if(queue_.size() == capacity_) return false;
+      queue_.push(std::move(event));
+      return true;
+    }
+    std::size_t poll_events(T* events, std::size_t max)
+    {
+      std::lock_guard<std::mutex> lock(mut_);
+      std::size_t count = 0;
+      while(count < max && !queue_.empty())
+      {
+        events[count++] = std::move(queue_.front());
+        queue_.pop();
+      }
+      return count;
+    }
+
+  private:
+    std::size_t capacity_;
+    std::mutex mut_;
+    std::queue<T> queue_;
+  };
+
+  constexpr std::size_t CAPACITY = 1024;
+  constexpr std::size_t BATCH = 64;
+
+  // Seconds to move every event through.
+  template <class Channel>
+  double run(Channel& channel, unsigned int producers, std::size_t events)
+  {
+    using clock_t = std::chrono::high_resolution_clock;
+    using sec_t = std::chrono::duration<double, std::chrono::seconds::period>;
+
+    std::size_t per_producer = events / producers;
+
+    auto before = clock_t::now();
+
+    std::vector<std::thread> threads;
+    for(unsigned int p = 0; p < producers; ++p)
+    {
+      threads.emplace_back([&channel, per_producer]()
+      {
+        for(std::size_t i = 0; i < per_producer; ++i)
+        {
+          while(!channel.push(i)) std::this_thread::yield();
+        }
+      });
+    }
+
+    std::size_t batch[BATCH];
+    std::size_t total = 0;
+    std::size_t sum = 0;
+    while(total < per_producer * producers)
+    {
+      std::size_t count = channel.poll_events(batch, BATCH);
+      // Don't starve the producers when there are more threads than cores.
+      if(count == 0) std::this_thread::yield();
+      for(std::size_t i = 0; i < count; ++i) sum += batch[i];
+      total += count;
+    }
+
+    for(auto& thread : threads) thread.join();
+
+    double seconds = sec_t(clock_t::now() - before).count();
+
+    // Make sure nothing got lost or made up.
+    std::size_t expected = producers * (per_producer * (per_producer - 1) / 2);
+    if(sum != expected) std::printf("  (lost events!)\n");
+
+    return seconds;
+  }
+
+  void print_row(char const* name, unsigned int producers, std::size_t events,
+                 double seconds, double baseline)
+  {
+    std::printf("%-8s %9u %9.4f %12.2f %8.2fx\n", name, producers, seconds,
+                events / seconds / 1e6, baseline / seconds);
+  }
+}
+
+int main(int argc, char** argv)
+{
+  using namespace redc;
+
+  std::size_t events = 1 << 22;
+  if(argc > 1) events = std::strtoul(argv[1], nullptr, 10);
+
+  unsigned int max_producers = std::thread::hardware_concurrency();
+  // Leave one for the consumer.
+  if(max_producers > 1) --max_producers;
+  if(max_producers == 0) max_producers = 1;
+
+  std::printf("channel  producers  seconds  Mevents/sec  vs mutex\n");
+
+  double mutex_time;
+  {
+    Mutex_Queue<std::size_t> queue(CAPACITY);
+    mutex_time = run(queue, 1, events);
+    print_row("mutex", 1, events, mutex_time, mutex_time);
+  }
+  {
+    SPSC_Channel<std::size_t> channel(CAPACITY);
+    print_row("spsc", 1, events, run(channel, 1, events), mutex_time);
+  }
+
+  for(unsigned int producers = 1; producers <= max_producers; producers *= 2)
+  {
+    {
+      Mutex_Queue<std::size_t> queue(CAPACITY);
+      mutex_time = run(queue, producers, events);
+      print_row("mutex", producers, events, mutex_time, mutex_time);
+    }
+    {
+      MPSC_Channel<std::size_t> channel(CAPACITY);
+      print_row("mpsc", producers, events, run(channel, producers, events),
+                mutex_time);
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2016 Luke San Antonio
+ * All rights reserved.
+ *
+ * Measures how the job system scales from one worker up to every hardware
+ * thread. Run with the item count as the first argument to change the amount
+ * of work.
+ */
+#include "common/jobs.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace
+{
+  // Something that isn't trivially optimized away and doesn't touch much
+  // memory, so we are measuring the scheduler and not the memory bus.
+  float do_work(std::size_t i)
+  {
+    float val = static_cast<float>(i);
+    for(int j = 0; j < 200; ++j)
+    {
+      val = std::sqrt(val * val + 1.0f) * 0.999f;
+    }
+    return val;
+  }
+}
+
+int main(int argc, char** argv)
+{
+  using namespace redc;
+  using clock_t = std::chrono::high_resolution_clock;
+  using sec_t = std::chrono::duration<double, std::chrono::seconds::period>;
+
+  std::size_t items = 1 << 20;
+  if(argc > 1) items = std::strtoul(argv[1], nullptr, 10);
+
+  unsigned int max_workers = std::thread::hardware_concurrency();
+  if(max_workers == 0) max_workers = 1;
+
+  std::vector<float> out(items);
+
+  double single_time = 0.0;
+  std::printf("workers  seconds  speedup  mean utilisation  stolen\n");
+  for(unsigned int workers = 1; workers <= max_workers; ++workers)
+  {
+    Job_System jobs(workers);
+
+    // Warm up, then measure only the real run.
+    jobs.parallel_for(0, items / 16, 1024, [&out](std::size_t i)
+    {
+      out[i] = do_work(i);
+    });
+    jobs.reset_stats();
+
+    auto before = clock_t::now();
+    jobs.parallel_for(0, items, 1024, [&out](std::size_t i)
+    {
+      out[i] = do_work(i);
+    });
+    double time = sec_t(clock_t::now() - before).count();
+
+    if(workers == 1) single_time = time;
+
+    double utilisation = 0.0;
+    uint64_t stolen = 0;
+    for(auto const& stats : jobs.stats())
+    {
+      utilisation += stats.utilisation();
+      stolen += stats.jobs_stolen;
+    }
+    utilisation /= workers;
+
+    std::printf("%7u  %7.4f  %7.2f  %16.2f  %6lu\n", workers, time,
+                single_time / time, utilisation,
+                static_cast<unsigned long>(stolen));
+  }
+
+  return 0;
+}
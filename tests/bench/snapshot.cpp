@@ -0,0 +1,183 @@
+/*
+ * Copyright (C) 2017 Luke San Antonio
+ * All rights reserved.
+ *
+ * Compares what each client gets every tick when the server sends every
+ * player's State as is against delta compressed snapshots, with and
+ * without area of interest filtering. Run with the number of players and
+ * the width of the square they're spread over, the defaults are 64 and
+ * 400m.
+ */
+#include "net/snapshot.h"
+#include "net/interest.h"
+#include "net/server_protocol.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <deque>
+#include <cmath>
+#include <random>
+
+namespace
+{
+  using namespace redc;
+
+  constexpr unsigned int TICKRATE = 20;
+  constexpr unsigned int SECONDS = 60;
+
+  // Round trip time in ticks and how many packets get lost.
+  constexpr unsigned int ACK_LATENCY = 3;
+  constexpr double PACKET_LOSS = 0.02;
+
+  struct Sim_Player
+  {
+    glm::vec3 velocity;
+    bool idle;
+  };
+
+  struct Sim_Client
+  {
+    uint32_t acked_tick = NO_BASELINE;
+    net::Client_Interest interest;
+    // Snapshots on their way to the client, and the tick their ack arrives.
+    std::deque<std::pair<uint32_t, uint32_t> > in_flight;
+  };
+}
+
+int main(int argc, char** argv)
+{
+  std::size_t num_players = 64;
+  if(argc > 1) num_players = std::strtoul(argv[1], nullptr, 10);
+  float area = 400.0f;
+  if(argc > 2) area = std::strtof(argv[2], nullptr);
+
+  std::mt19937 rand(5);
+  std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+  net::Quantize_Grid grid;
+  grid.min = glm::vec3(-256.0f, -16.0f, -256.0f);
+  grid.max = glm::vec3(256.0f, 48.0f, 256.0f);
+
+  auto bits = net::grid_bits(grid);
+  std::printf("Grid: %u+%u+%u bits per position at %gm\n", bits[0], bits[1],
+              bits[2], grid.resolution);
+
+  net::Snapshot snap;
+  std::vector<Sim_Player> sim(num_players);
+  for(std::size_t i = 0; i < num_players; ++i)
+  {
+    net::Player_Snapshot player = {};
+    player.id = i * 3 + 1;
+    player.position = glm::vec3((unit(rand) - 0.5f) * area, 0.0f,
+                                (unit(rand) - 0.5f) * area);
+    snap.players.push_back(player);
+
+    sim[i].idle = unit(rand) < 0.25f;
+  }
+
+  // What everybody would get without snapshots, it doesn't change tick to
+  // tick.
+  std::vector<net::State> states;
+  for(auto const& player : snap.players)
+  {
+    states.push_back(net::State{player.input, player.position});
+  }
+  std::size_t states_size = serialized_size(states);
+
+  std::vector<Sim_Client> clients(num_players);
+  net::Snapshot_History history;
+
+  net::Interest_Config interest_config;
+  net::Spatial_Grid interest_grid;
+
+  std::size_t delta_bytes = 0;
+  std::size_t interest_bytes = 0;
+  std::size_t max_interest_bytes = 0;
+  std::size_t full_bytes = 0;
+  std::size_t packets = 0;
+
+  float dt = 1.0f / TICKRATE;
+  for(uint32_t tick = 0; tick < TICKRATE * SECONDS; ++tick)
+  {
+    snap.tick = tick;
+    for(std::size_t i = 0; i < num_players; ++i)
+    {
+      auto& player = snap.players[i];
+
+      // Players change what they're doing every couple seconds.
+      if(unit(rand) < 0.025f)
+      {
+        float angle = unit(rand) * 6.2831f;
+        sim[i].velocity = glm::vec3(std::cos(angle), 0.0f, std::sin(angle)) *
+                          5.0f;
+        player.input.forward = !player.input.forward;
+      }
+      player.input.primary_attack = unit(rand) < 0.05f;
+
+      if(!sim[i].idle)
+      {
+        player.position.x += sim[i].velocity.x * dt;
+        player.position.z += sim[i].velocity.z * dt;
+      }
+    }
+    history.push(snap);
+
+    full_bytes += net::encode_snapshot(snap, nullptr, grid).size();
+    interest_grid.build(snap);
+
+    for(std::size_t i = 0; i < num_players; ++i)
+    {
+      auto& client = clients[i];
+
+      // Acks that made it back by now.
+      while(!client.in_flight.empty() &&
+            client.in_flight.front().second <= tick)
+      {
+        client.acked_tick = client.in_flight.front().first;
+        client.in_flight.pop_front();
+      }
+
+      auto data = net::encode_snapshot(snap, history.find(client.acked_tick),
+                                       grid);
+      delta_bytes += data.size();
+      ++packets;
+
+      // Everybody is looking from their own player.
+      auto const& self = snap.players[i];
+      auto baseline = client.interest.sent.find(client.acked_tick);
+      auto view = net::interest_snapshot(snap, interest_grid, client.interest,
+                                         &self.position, self.id, baseline,
+                                         grid, interest_config);
+      auto view_data = net::encode_snapshot(view, baseline, grid);
+      client.interest.sent.push(std::move(view));
+
+      interest_bytes += view_data.size();
+      max_interest_bytes = std::max(max_interest_bytes, view_data.size());
+
+      if(unit(rand) >= PACKET_LOSS)
+      {
+        client.in_flight.emplace_back(tick, tick + ACK_LATENCY);
+      }
+    }
+  }
+
+  double ticks = TICKRATE * SECONDS;
+  double delta_per_tick = delta_bytes / (double) packets;
+  double full_per_tick = full_bytes / ticks;
+  double interest_per_tick = interest_bytes / (double) packets;
+
+  std::printf("%zu players at %u ticks/s, bytes per client:\n", num_players,
+              TICKRATE);
+  std::printf("  all states:       %8.1f/tick %8.2f KB/s\n",
+              (double) states_size, states_size * TICKRATE / 1024.0);
+  std::printf("  full snapshot:    %8.1f/tick %8.2f KB/s\n", full_per_tick,
+              full_per_tick * TICKRATE / 1024.0);
+  std::printf("  delta snapshot:   %8.1f/tick %8.2f KB/s\n", delta_per_tick,
+              delta_per_tick * TICKRATE / 1024.0);
+  std::printf("  interest:         %8.1f/tick %8.2f KB/s (%zu max, %zu "
+              "budget)\n", interest_per_tick,
+              interest_per_tick * TICKRATE / 1024.0, max_interest_bytes,
+              interest_config.budget_bytes);
+  return EXIT_SUCCESS;
+}
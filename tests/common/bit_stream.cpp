@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2017 Luke San Antonio
+ * All rights reserved.
+ */
+#include "catch/catch.hpp"
+#include "common/bit_stream.h"
+
+TEST_CASE("bits_needed", "[bit_stream]")
+{
+  CHECK(redc::bits_needed(0) == 0);
+  CHECK(redc::bits_needed(1) == 1);
+  CHECK(redc::bits_needed(2) == 2);
+  CHECK(redc::bits_needed(255) == 8);
+  CHECK(redc::bits_needed(256) == 9);
+  CHECK(redc::bits_needed(0xffffffff) == 32);
+}
+
+TEST_CASE("Bit streams round trip", "[bit_stream]")
+{
+  redc::Bit_Writer writer;
+  writer.write(5, 3);
+  writer.write_bool(true);
+  writer.write(0xdeadbeef, 32);
+  writer.write(0xf234, 13);
+  writer.write_bool(false);
+  writer.write(0, 0);
+  writer.write(0x7f, 7);
+
+  REQUIRE(writer.bit_size() == 3 + 1 + 32 + 13 + 1 + 7);
+  REQUIRE(writer.bytes().size() == 8);
+
+  redc::Bit_Reader reader(writer.bytes().data(), writer.bytes().size());
+  CHECK(reader.read(3) == 5);
+  CHECK(reader.read_bool());
+  CHECK(reader.read(32) == 0xdeadbeef);
+  // Only the bits that were asked for get written.
+  CHECK(reader.read(13) == 0x1234);
+  CHECK_FALSE(reader.read_bool());
+  CHECK(reader.read(0) == 0);
+  CHECK(reader.read(7) == 0x7f);
+  CHECK(reader.good());
+
+  SECTION("The padding reads as zeros")
+  {
+    CHECK(reader.bits_left() == 7);
+    CHECK(reader.read(7) == 0);
+    CHECK(reader.good());
+  }
+  SECTION("Reading past the end makes the reader bad")
+  {
+    CHECK(reader.read(8) == 0);
+    CHECK_FALSE(reader.good());
+    CHECK(reader.bits_left() == 0);
+    CHECK(reader.read(1) == 0);
+    CHECK_FALSE(reader.good());
+  }
+}
@@ -0,0 +1,164 @@
+/*
+ * Copyright (C) 2017 Luke San Antonio
+ * All rights reserved.
+ */
+#include "catch/catch.hpp"
+#include "common/event_channel.h"
+
+#include <thread>
+#include <vector>
+
+namespace
+{
+  struct Collect_Sink : redc::Event_Sink<int>
+  {
+    void process_event(int const& event) override
+    {
+      events.push_back(event);
+    }
+    std::vector<int> events;
+  };
+}
+
+TEST_CASE("SPSC channel keeps events in order", "[event_channel]")
+{
+  redc::SPSC_Channel<int> channel(5);
+  REQUIRE(channel.capacity() == 8);
+
+  for(int i = 0; i < 8; ++i) CHECK(channel.push(i));
+  // Full, this one is dropped.
+  CHECK_FALSE(channel.push(8));
+
+  int event;
+  for(int i = 0; i < 8; ++i)
+  {
+    REQUIRE(channel.poll_event(event));
+    CHECK(event == i);
+  }
+  CHECK_FALSE(channel.poll_event(event));
+
+  SECTION("Wrapping around")
+  {
+    for(int round = 0; round < 10; ++round)
+    {
+      for(int i = 0; i < 6; ++i) REQUIRE(channel.push(round * 6 + i));
+
+      int events[8];
+      REQUIRE(channel.poll_events(events, 8) == 6);
+      for(int i = 0; i < 6; ++i) CHECK(events[i] == round * 6 + i);
+    }
+  }
+  SECTION("Batches take at most what they're asked for")
+  {
+    for(int i = 0; i < 5; ++i) channel.push(i);
+
+    int events[3];
+    REQUIRE(channel.poll_events(events, 3) == 3);
+    CHECK(events[2] == 2);
+    REQUIRE(channel.poll_events(events, 3) == 2);
+    CHECK(events[0] == 3);
+    CHECK(events[1] == 4);
+    CHECK(channel.poll_events(events, 3) == 0);
+  }
+  SECTION("Polling into a sink")
+  {
+    for(int i = 0; i < 5; ++i) channel.push(i);
+
+    Collect_Sink sink;
+    CHECK(channel.poll_events(sink) == 5);
+    CHECK(sink.events == std::vector<int>({0, 1, 2, 3, 4}));
+    CHECK(channel.poll_events(sink) == 0);
+  }
+}
+
+TEST_CASE("SPSC channel hands events between threads", "[event_channel]")
+{
+  constexpr int COUNT = 100000;
+  redc::SPSC_Channel<int> channel(64);
+
+  std::thread producer([&channel]()
+  {
+    for(int i = 0; i < COUNT; ++i)
+    {
+      while(!channel.push(i)) std::this_thread::yield();
+    }
+  });
+
+  int next = 0;
+  bool in_order = true;
+  int events[16];
+  while(next < COUNT)
+  {
+    std::size_t count = channel.poll_events(events, 16);
+    for(std::size_t i = 0; i < count; ++i)
+    {
+      if(events[i] != next++) in_order = false;
+    }
+  }
+  producer.join();
+
+  CHECK(in_order);
+  CHECK(next == COUNT);
+}
+
+TEST_CASE("MPSC channel keeps events in order", "[event_channel]")
+{
+  redc::MPSC_Channel<int> channel(4);
+  REQUIRE(channel.capacity() == 4);
+
+  for(int round = 0; round < 10; ++round)
+  {
+    for(int i = 0; i < 4; ++i) REQUIRE(channel.push(round * 4 + i));
+    CHECK_FALSE(channel.push(-1));
+
+    int event;
+    REQUIRE(channel.poll_event(event));
+    CHECK(event == round * 4);
+
+    Collect_Sink sink;
+    CHECK(channel.poll_events(sink) == 3);
+    CHECK(sink.events.back() == round * 4 + 3);
+  }
+}
+
+TEST_CASE("MPSC channel takes events from every thread", "[event_channel]")
+{
+  constexpr int PRODUCERS = 4;
+  constexpr int COUNT = 50000;
+  redc::MPSC_Channel<int> channel(128);
+
+  std::vector<std::thread> producers;
+  for(int p = 0; p < PRODUCERS; ++p)
+  {
+    producers.emplace_back([&channel, p]()
+    {
+      for(int i = 0; i < COUNT; ++i)
+      {
+        while(!channel.push(p * COUNT + i)) std::this_thread::yield();
+      }
+    });
+  }
+
+  // Each producer's events have to come out in the order it pushed them.
+  std::vector<int> next(PRODUCERS, 0);
+  bool in_order = true;
+  int total = 0;
+  int events[32];
+  while(total < PRODUCERS * COUNT)
+  {
+    std::size_t count = channel.poll_events(events, 32);
+    for(std::size_t i = 0; i < count; ++i)
+    {
+      int p = events[i] / COUNT;
+      if(events[i] % COUNT != next[p]++) in_order = false;
+    }
+    total += count;
+  }
+  for(auto& producer : producers) producer.join();
+
+  CHECK(in_order);
+  for(int p = 0; p < PRODUCERS; ++p) CHECK(next[p] == COUNT);
+
+  int event;
+  CHECK_FALSE(channel.poll_event(event));
+}
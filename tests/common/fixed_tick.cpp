@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2017 Luke San Antonio
+ * All rights reserved.
+ */
+#include "catch/catch.hpp"
+#include "common/fixed_tick.h"
+
+using namespace std::chrono;
+
+TEST_CASE("Fixed ticks run at their rate", "[fixed_tick]")
+{
+  redc::Fixed_Tick ticker(20);
+  REQUIRE(ticker.interval() == milliseconds(50));
+
+  auto start = redc::tick_clock_t::now();
+
+  // The first tick starts right away.
+  REQUIRE(ticker.begin(start));
+  CHECK(ticker.tick() == 0);
+  ticker.end(start + milliseconds(10));
+  CHECK_FALSE(ticker.begin(start + milliseconds(10)));
+  CHECK(ticker.until_next(start + milliseconds(10)) == milliseconds(40));
+
+  SECTION("On time")
+  {
+    REQUIRE(ticker.begin(start + milliseconds(50)));
+    CHECK(ticker.tick() == 1);
+    ticker.end(start + milliseconds(60));
+
+    auto const& stats = ticker.stats();
+    CHECK(stats.ticks == 2);
+    CHECK(stats.overruns == 0);
+    CHECK(stats.max_jitter == redc::tick_clock_t::duration::zero());
+    CHECK(stats.avg_duration_ms() == Approx(10.0));
+  }
+  SECTION("Late ticks catch up and count jitter")
+  {
+    auto now = start + milliseconds(120);
+    REQUIRE(ticker.begin(now));
+    ticker.end(now);
+    REQUIRE(ticker.begin(now));
+    ticker.end(now);
+    CHECK_FALSE(ticker.begin(now));
+    CHECK(ticker.tick() == 3);
+
+    auto const& stats = ticker.stats();
+    CHECK(stats.max_jitter == milliseconds(70));
+    CHECK(stats.total_jitter == milliseconds(90));
+    CHECK(stats.skipped == 0);
+  }
+  SECTION("Overruns")
+  {
+    REQUIRE(ticker.begin(start + milliseconds(50)));
+    ticker.end(start + milliseconds(101));
+    CHECK(ticker.stats().overruns == 1);
+    CHECK(ticker.stats().max_duration == milliseconds(51));
+  }
+  SECTION("Falling too far behind skips ticks")
+  {
+    auto now = start + seconds(1);
+    REQUIRE(ticker.begin(now));
+    CHECK(ticker.stats().skipped == 19);
+    CHECK(ticker.tick() == 20);
+    ticker.end(now);
+
+    // Back to ticking at the rate from here.
+    CHECK_FALSE(ticker.begin(now + milliseconds(49)));
+    CHECK(ticker.begin(now + milliseconds(50)));
+  }
+}
+
+TEST_CASE("Fixed tick rounding doesn't drift", "[fixed_tick]")
+{
+  // A 60hz interval doesn't fit in whole nanoseconds.
+  redc::Fixed_Tick ticker(60);
+  auto start = redc::tick_clock_t::now();
+
+  auto now = start;
+  for(int i = 0; i < 600; ++i)
+  {
+    now += ticker.until_next(now);
+    REQUIRE(ticker.begin(now));
+    ticker.end(now);
+  }
+  CHECK(ticker.tick() == 600);
+  CHECK(now + ticker.until_next(now) == start + seconds(10));
+  CHECK(ticker.stats().max_jitter == redc::tick_clock_t::duration::zero());
+}
@@ -0,0 +1,45 @@
+/*
+ * Copyright (C) 2016 Luke San Antonio
+ * All rights reserved.
+ */
+#include "catch/catch.hpp"
+#include "common/hash.h"
+
+#include <cstring>
+#include <string>
+
+namespace
+{
+  uint64_t hash_str(std::string const& str, uint64_t seed = 0)
+  {
+    return redc::xxhash64(str.data(), str.size(), seed);
+  }
+}
+
+TEST_CASE("xxhash64 matches the reference implementation", "[hash]")
+{
+  CHECK(hash_str("") == 0xef46db3751d8e999ULL);
+  CHECK(hash_str("a") == 0xd24ec4f1a98c6e5bULL);
+  CHECK(hash_str("abc") == 0x44bc2cf5ad770999ULL);
+
+  // Long enough to go through the four lane loop.
+  CHECK(hash_str("Nobody inspects the spammish repetition") ==
+        0xfbcea83c8a378bf1ULL);
+  CHECK(hash_str("0123456789abcdef0123456789abcdef!") ==
+        0x8afff4daac4e677eULL);
+
+  SECTION("Seed changes the hash")
+  {
+    CHECK(hash_str("abc", 7) == 0x9e755206156676d7ULL);
+  }
+}
+
+TEST_CASE("xxhash64 doesn't care about alignment", "[hash]")
+{
+  char buf[64 + 1];
+  std::string str = "Nobody inspects the spammish repetition";
+
+  // Copy it one byte in so it definitely isn't aligned
+  std::memcpy(buf + 1, str.data(), str.size());
+  CHECK(redc::xxhash64(buf + 1, str.size()) == hash_str(str));
+}
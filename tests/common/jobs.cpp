@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2016 Luke San Antonio
+ * All rights reserved.
+ */
+#include "catch/catch.hpp"
+#include "common/jobs.h"
+
+#include <algorithm>
+#include <numeric>
+
+TEST_CASE("Job system runs every job", "[jobs]")
+{
+  redc::Job_System jobs(4);
+  REQUIRE(jobs.num_workers() == 4);
+
+  std::atomic<int> count(0);
+
+  redc::Job_Counter counter;
+  for(int i = 0; i < 1000; ++i)
+  {
+    jobs.run([&count]() { ++count; }, &counter);
+  }
+  jobs.wait(counter);
+
+  CHECK(counter.done());
+  CHECK(count == 1000);
+}
+
+TEST_CASE("Jobs can queue more jobs and wait on them", "[jobs]")
+{
+  redc::Job_System jobs(3);
+
+  std::atomic<int> count(0);
+
+  redc::Job_Counter outer;
+  for(int i = 0; i < 16; ++i)
+  {
+    jobs.run([&jobs, &count]()
+    {
+      // Waiting from inside a job has to help out instead of deadlocking.
+      redc::Job_Counter inner;
+      for(int j = 0; j < 16; ++j)
+      {
+        jobs.run([&count]() { ++count; }, &inner);
+      }
+      jobs.wait(inner);
+    }, &outer);
+  }
+  jobs.wait(outer);
+
+  CHECK(count == 16 * 16);
+}
+
+TEST_CASE("Dependent jobs run after their dependency", "[jobs]")
+{
+  redc::Job_System jobs(4);
+
+  std::atomic<int> first_done(0);
+  std::atomic<bool> order_ok(true);
+
+  redc::Job_Counter first;
+  redc::Job_Counter second;
+
+  for(int i = 0; i < 64; ++i)
+  {
+    jobs.run([&first_done]() { ++first_done; }, &first);
+  }
+  for(int i = 0; i < 64; ++i)
+  {
+    jobs.run_after(first, [&first_done, &order_ok]()
+    {
+      if(first_done != 64) order_ok = false;
+    }, &second);
+  }
+
+  jobs.wait(second);
+
+  CHECK(first.done());
+  CHECK(order_ok);
+
+  SECTION("A finished dependency doesn't hold anything up")
+  {
+    bool ran = false;
+    redc::Job_Counter third;
+    jobs.run_after(first, [&ran]() { ran = true; }, &third);
+    jobs.wait(third);
+    CHECK(ran);
+  }
+}
+
+TEST_CASE("Parallel for visits every index once", "[jobs]")
+{
+  redc::Job_System jobs(4);
+
+  std::vector<int> visits(10007, 0);
+  jobs.parallel_for(0, visits.size(), 64, [&visits](std::size_t i)
+  {
+    ++visits[i];
+  });
+
+  CHECK(std::accumulate(visits.begin(), visits.end(), 0) == 10007);
+  CHECK(std::all_of(visits.begin(), visits.end(),
+                    [](int v) { return v == 1; }));
+
+  SECTION("Empty ranges do nothing")
+  {
+    bool ran = false;
+    jobs.parallel_for(5, 5, 1, [&ran](std::size_t) { ran = true; });
+    CHECK_FALSE(ran);
+  }
+}
+
+TEST_CASE("Job workers keep stats", "[jobs]")
+{
+  redc::Job_System jobs(2);
+
+  redc::Job_Counter counter;
+  for(int i = 0; i < 100; ++i)
+  {
+    jobs.run([]() {}, &counter);
+  }
+  jobs.wait(counter);
+
+  auto stats = jobs.stats();
+  REQUIRE(stats.size() == 2);
+
+  uint64_t total = 0;
+  for(auto const& worker : stats)
+  {
+    total += worker.jobs_run;
+    CHECK(worker.utilisation() >= 0.0);
+    CHECK(worker.utilisation() <= 1.0);
+  }
+  // The main thread may have run some of them while waiting.
+  CHECK(total <= 100);
+
+  jobs.reset_stats();
+  for(auto const& worker : jobs.stats())
+  {
+    CHECK(worker.jobs_run == 0);
+  }
+}
@@ -0,0 +1,247 @@
+/*
+ * Copyright (C) 2017 Luke San Antonio
+ * All rights reserved.
+ */
+#include "catch/catch.hpp"
+#include "common/serialize.h"
+#include <random>
+
+namespace
+{
+  enum class Color : uint8_t
+  {
+    Red, Green, Blue
+  };
+
+  struct Buttons
+  {
+    bool a;
+    bool b;
+    bool c;
+    bool d;
+    bool e;
+    bool f;
+    bool g;
+    bool h;
+    bool i;
+
+    REDC_SERIALIZE(a, b, c, d, e, f, g, h, i);
+  };
+
+  struct Fixed
+  {
+    uint8_t index;
+    Buttons buttons;
+    uint32_t tick;
+    int16_t offset;
+    uint64_t big;
+    float x;
+    Color color;
+    std::array<uint16_t, 3> pos;
+
+    REDC_SERIALIZE(index, buttons, tick, offset, big, x, color, pos);
+  };
+
+  struct Named
+  {
+    uint16_t id;
+    std::string name;
+
+    REDC_SERIALIZE(id, name);
+  };
+
+  struct Roster
+  {
+    uint8_t version;
+    std::vector<Named> players;
+    std::vector<uint8_t> teams;
+
+    REDC_SERIALIZE(version, players, teams);
+  };
+
+  Fixed make_fixed()
+  {
+    Fixed fixed;
+    fixed.index = 200;
+    fixed.buttons = {true, false, true, true, false, false, true, false, true};
+    fixed.tick = 0xdeadbeef;
+    fixed.offset = -1234;
+    fixed.big = 0x0123456789abcdefull;
+    fixed.x = -3.25f;
+    fixed.color = Color::Blue;
+    fixed.pos = {{1, 0xffff, 300}};
+    return fixed;
+  }
+
+  Roster make_roster()
+  {
+    Roster roster;
+    roster.version = 3;
+    roster.players = {{1, "luke"}, {2, ""}, {65535, "somebody else"}};
+    roster.teams = {4, 5};
+    return roster;
+  }
+
+  template <class T>
+  std::vector<uint8_t> serialize(T const& t)
+  {
+    std::vector<uint8_t> data(redc::serialized_size(t));
+    REQUIRE(redc::serialize(t, data.data(), data.size()));
+    return data;
+  }
+}
+
+TEST_CASE("Serialized structs are packed", "[serialize]")
+{
+  // Nine bools are nine bits.
+  CHECK(redc::serialized_bits(Buttons{}) == 9);
+  CHECK(redc::serialized_size(Buttons{}) == 2);
+
+  CHECK(redc::serialized_bits(Fixed{}) == 8 + 9 + 32 + 16 + 64 + 32 + 8 +
+                                          3 * 16);
+
+  // Lengths are 16 bits, strings are a byte per character.
+  Roster roster = make_roster();
+  CHECK(redc::serialized_bits(roster) == 8 + 16 + (16 + 16 + 4 * 8) +
+                                         (16 + 16) +
+                                         (16 + 16 + 13 * 8) + 16 + 2 * 8);
+}
+
+TEST_CASE("Serialized structs round trip", "[serialize]")
+{
+  SECTION("Fixed size")
+  {
+    Fixed fixed = make_fixed();
+    auto data = serialize(fixed);
+
+    Fixed out;
+    REQUIRE(redc::deserialize(out, data.data(), data.size()));
+    CHECK(out.index == fixed.index);
+    CHECK(out.buttons.a);
+    CHECK_FALSE(out.buttons.b);
+    CHECK(out.buttons.i);
+    CHECK(out.tick == fixed.tick);
+    CHECK(out.offset == fixed.offset);
+    CHECK(out.big == fixed.big);
+    CHECK(out.x == fixed.x);
+    CHECK(out.color == Color::Blue);
+    CHECK(out.pos == fixed.pos);
+  }
+  SECTION("Variable size")
+  {
+    Roster roster = make_roster();
+    auto data = serialize(roster);
+
+    Roster out;
+    REQUIRE(redc::deserialize(out, data.data(), data.size()));
+    CHECK(out.version == roster.version);
+    REQUIRE(out.players.size() == roster.players.size());
+    for(std::size_t i = 0; i < roster.players.size(); ++i)
+    {
+      CHECK(out.players[i].id == roster.players[i].id);
+      CHECK(out.players[i].name == roster.players[i].name);
+    }
+    CHECK(out.teams == roster.teams);
+  }
+}
+
+TEST_CASE("Serializing needs enough room", "[serialize]")
+{
+  Fixed fixed = make_fixed();
+  std::vector<uint8_t> data(redc::serialized_size(fixed) - 1);
+  CHECK_FALSE(redc::serialize(fixed, data.data(), data.size()));
+}
+
+TEST_CASE("Bad serialized data is rejected", "[serialize]")
+{
+  SECTION("Truncated")
+  {
+    auto fixed_data = serialize(make_fixed());
+    for(std::size_t size = 0; size < fixed_data.size(); ++size)
+    {
+      Fixed out;
+      CHECK_FALSE(redc::deserialize(out, fixed_data.data(), size));
+    }
+
+    auto roster_data = serialize(make_roster());
+    for(std::size_t size = 0; size < roster_data.size(); ++size)
+    {
+      Roster out;
+      CHECK_FALSE(redc::deserialize(out, roster_data.data(), size));
+    }
+  }
+  SECTION("Trailing bytes")
+  {
+    auto data = serialize(make_fixed());
+    data.push_back(0);
+
+    Fixed out;
+    CHECK_FALSE(redc::deserialize(out, data.data(), data.size()));
+  }
+  SECTION("Lengths that can't fit")
+  {
+    // A roster claiming 65535 players in four bytes shouldn't make room for
+    // all of them first.
+    uint8_t data[] = {3, 0xff, 0xff, 0};
+    Roster out;
+    CHECK_FALSE(redc::deserialize(out, data, sizeof(data)));
+    CHECK(out.players.capacity() == 0);
+
+    uint8_t name[] = {1, 0, 0xff, 0x7f, 'a'};
+    Named named;
+    CHECK_FALSE(redc::deserialize(named, name, sizeof(name)));
+    CHECK(named.name.empty());
+  }
+}
+
+TEST_CASE("Serialized data survives fuzzing", "[serialize]")
+{
+  std::mt19937 rand(0x5eed);
+  std::uniform_int_distribution<int> byte(0, 255);
+
+  auto roster_data = serialize(make_roster());
+  auto fixed_data = serialize(make_fixed());
+
+  for(int i = 0; i < 2000; ++i)
+  {
+    // Flip some bits, chop some off or add garbage.
+    std::vector<uint8_t> data = i % 2 ? roster_data : fixed_data;
+    std::uniform_int_distribution<std::size_t> pos(0, data.size() - 1);
+    int flips = 1 + i % 4;
+    for(int flip = 0; flip < flips; ++flip)
+    {
+      data[pos(rand)] ^= 1 << (byte(rand) % 8);
+    }
+    if(i % 5 == 0) data.resize(pos(rand));
+    if(i % 7 == 0) data.push_back(byte(rand));
+
+    // Whatever comes out of a successful read has to serialize back to
+    // exactly what went in.
+    if(i % 2)
+    {
+      Roster out;
+      if(redc::deserialize(out, data.data(), data.size()))
+      {
+        CHECK(serialize(out) == data);
+      }
+    }
+    else
+    {
+      Fixed out;
+      if(redc::deserialize(out, data.data(), data.size()))
+      {
+        CHECK(serialize(out) == data);
+      }
+    }
+  }
+
+  // Pure garbage.
+  for(int i = 0; i < 2000; ++i)
+  {
+    std::vector<uint8_t> data(i % 64);
+    for(auto& b : data) b = byte(rand);
+
+    Roster out;
+    redc::deserialize(out, data.data(), data.size());
+  }
+}
@@ -5,6 +5,7 @@
 
 #include "gfx/imesh.h"
 #include "gfx/extra/load_wavefront.h"
+#include "common/jobs.h"
 
 #include <sstream>
 
@@ -71,3 +72,121 @@ TEST_CASE(".obj mesh is properly parsed", "[struct Mesh]")
   REQUIRE(mesh_data.indices[0] == mesh_data.indices[4]);
   REQUIRE(mesh_data.indices[2] == mesh_data.indices[5]);
 }
+
+TEST_CASE(".obj polygons are triangulated", "[struct Mesh]")
+{
+  using namespace redc;
+
+  // No newline at the end on purpose.
+  std::string data =
+  "# A quad and a pentagon\r\n"
+  "v 0 0 0\r\n"
+  "v 1 0 0\r\n"
+  "v 1 1 0\r\n"
+  "v 0 1 0\r\n"
+  "v 0.5 2 0\r\n"
+  "f 1 2 3 4\r\n"
+  "f 1 2 3 5 4";
+
+  auto mesh_data = gfx::parse_wavefront(&data[0], &data[0] + data.size());
+
+  REQUIRE(mesh_data.positions.size() == 5);
+  REQUIRE(mesh_data.indices.size() == 15);
+
+  unsigned int expected[] = {0, 1, 2, 0, 2, 3,
+                             0, 1, 2, 0, 2, 4, 0, 4, 3};
+  for(int i = 0; i < 15; ++i)
+  {
+    REQUIRE(mesh_data.indices[i].position.value() == expected[i]);
+  }
+}
+
+TEST_CASE(".obj relative indices and floats are parsed", "[struct Mesh]")
+{
+  using namespace redc;
+
+  std::string data =
+  "v 1e2 -2.5E-1 .5\n"
+  "v -0 +3 1.0e+1\n"
+  "v 1 1 1\n"
+  "vt 0.25 1\n"
+  "vn 0 0 1\n"
+  "f -3/-1/-1 -2/-1/-1 -1/-1/-1\n";
+
+  auto mesh_data = gfx::parse_wavefront(&data[0], &data[0] + data.size());
+
+  REQUIRE(mesh_data.positions.size() == 3);
+  glm::vec3 pt = {100.0f, -0.25f, 0.5f};
+  REQUIRE(mesh_data.positions[0] == pt);
+  pt = {0.0f, 3.0f, 10.0f};
+  REQUIRE(mesh_data.positions[1] == pt);
+
+  REQUIRE(mesh_data.indices.size() == 3);
+  for(unsigned int i = 0; i < 3; ++i)
+  {
+    REQUIRE(mesh_data.indices[i].position.value() == i);
+    REQUIRE(mesh_data.indices[i].tex_coord.value() == 0);
+    REQUIRE(mesh_data.indices[i].normal.value() == 0);
+  }
+}
+
+TEST_CASE(".obj indices that are too big are skipped", "[struct Mesh]")
+{
+  using namespace redc;
+
+  auto f = gfx::parse_wavefront_vert_ref("99999999999999999999999/1/1");
+  REQUIRE_FALSE(f.position);
+  REQUIRE_FALSE(f.tex_coord);
+  REQUIRE_FALSE(f.normal);
+
+  f = gfx::parse_wavefront_vert_ref("2147483647");
+  REQUIRE(f.position.value() == 2147483646u);
+
+  std::string data =
+  "v 0 0 0\n"
+  "v 1 0 0\n"
+  "v 1 1 0\n"
+  "v 0 1 0\n"
+  "f 1 2 3 99999999999999999999999 4\n"
+  "f 1 2 -2147483648\n";
+
+  auto mesh_data = gfx::parse_wavefront(&data[0], &data[0] + data.size());
+
+  // The bad one is left out like any other broken vertex, which leaves the
+  // second face with nothing to make a triangle out of.
+  REQUIRE(mesh_data.indices.size() == 6);
+  unsigned int expected[] = {0, 1, 2, 0, 2, 3};
+  for(int i = 0; i < 6; ++i)
+  {
+    REQUIRE(mesh_data.indices[i].position.value() == expected[i]);
+  }
+}
+
+TEST_CASE("Big .obj files parse the same in parallel", "[struct Mesh]")
+{
+  using namespace redc;
+
+  // Big enough to be split up, with relative indices that cross chunks.
+  std::ostringstream stream;
+  for(int i = 1; i <= 150000; ++i)
+  {
+    stream << "v " << i << ".5 -" << i << " 0.125\n";
+    if(i >= 4) stream << "f -4 -3 " << i - 1 << " -1\n";
+  }
+  std::string data = stream.str();
+  REQUIRE(data.size() > 4 * 1024 * 1024);
+
+  auto serial = gfx::parse_wavefront(&data[0], &data[0] + data.size());
+
+  Job_System jobs(4);
+  auto parallel = gfx::parse_wavefront(&data[0], &data[0] + data.size(),
+                                       &jobs);
+
+  REQUIRE(serial.positions.size() == 150000);
+  REQUIRE(serial.positions == parallel.positions);
+  REQUIRE(serial.indices.size() == parallel.indices.size());
+  for(std::size_t i = 0; i < serial.indices.size(); ++i)
+  {
+    REQUIRE(serial.indices[i] == parallel.indices[i]);
+  }
+}
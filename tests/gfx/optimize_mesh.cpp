@@ -0,0 +1,177 @@
+/*
+ * Copyright (C) 2016 Luke San Antonio
+ * All rights reserved.
+ */
+
+#include "gfx/extra/mesh_conversion.h"
+#include "gfx/extra/optimize_mesh.h"
+
+#include <algorithm>
+#include <array>
+#include <random>
+
+#include "catch/catch.hpp"
+
+namespace
+{
+  using namespace redc;
+
+  // A size x size grid of quads, with the triangles shuffled.
+  gfx::Indexed_Mesh_Data make_grid(unsigned int size)
+  {
+    gfx::Indexed_Mesh_Data mesh;
+    for(unsigned int y = 0; y <= size; ++y)
+    {
+      for(unsigned int x = 0; x <= size; ++x)
+      {
+        gfx::Vertex vert;
+        vert.position = glm::vec3(x, y, 0.0f);
+        vert.normal = glm::vec3(0.0f, 0.0f, 1.0f);
+        vert.uv = glm::vec2(x, y);
+        mesh.vertices.push_back(vert);
+      }
+    }
+
+    std::vector<std::array<unsigned int, 3> > tris;
+    for(unsigned int y = 0; y < size; ++y)
+    {
+      for(unsigned int x = 0; x < size; ++x)
+      {
+        unsigned int i = y * (size + 1) + x;
+        tris.push_back({{i, i + 1, i + size + 2}});
+        tris.push_back({{i, i + size + 2, i + size + 1}});
+      }
+    }
+    std::shuffle(tris.begin(), tris.end(), std::mt19937(5));
+
+    for(auto const& tri : tris)
+    {
+      mesh.elements.insert(mesh.elements.end(), tri.begin(), tri.end());
+    }
+    return mesh;
+  }
+
+  // Every triangle by its positions, rotated so the winding can be compared
+  // without caring where it starts.
+  std::vector<std::array<float, 9> > triangles(gfx::Indexed_Mesh_Data const& m)
+  {
+    std::vector<std::array<float, 9> > ret;
+    for(std::size_t i = 0; i < m.elements.size(); i += 3)
+    {
+      std::array<std::array<float, 3>, 3> tri;
+      for(int j = 0; j < 3; ++j)
+      {
+        auto const& pos = m.vertices[m.elements[i + j]].position;
+        tri[j] = {{pos.x, pos.y, pos.z}};
+      }
+      std::rotate(tri.begin(), std::min_element(tri.begin(), tri.end()),
+                  tri.end());
+
+      std::array<float, 9> flat;
+      for(int j = 0; j < 9; ++j) flat[j] = tri[j / 3][j % 3];
+      ret.push_back(flat);
+    }
+    std::sort(ret.begin(), ret.end());
+    return ret;
+  }
+}
+
+TEST_CASE("Split mesh data is welded", "[struct Mesh]")
+{
+  using namespace redc;
+
+  gfx::Indexed_Split_Mesh_Data data;
+  data.positions = {{0, 0, 0}, {1, 0, 0}, {1, 1, 0}, {0, 1, 0}};
+  data.normals = {{0, 0, 1}};
+
+  auto ref = [](unsigned int pos)
+  {
+    gfx::Vert_Ref ret;
+    ret.position = pos;
+    ret.normal = 0;
+    return ret;
+  };
+  data.indices = {ref(0), ref(1), ref(2), ref(0), ref(2), ref(3)};
+  // Same position, different normal so it needs its own vertex.
+  data.indices.push_back(ref(3));
+  data.indices.back().normal = boost::none;
+
+  auto mesh = gfx::to_indexed_mesh_data(data);
+
+  REQUIRE(mesh.vertices.size() == 5);
+  std::vector<unsigned int> expected = {0, 1, 2, 0, 2, 3, 4};
+  REQUIRE(mesh.elements == expected);
+
+  glm::vec3 pt = {0.0f, 1.0f, 0.0f};
+  REQUIRE(mesh.vertices[3].position == pt);
+  REQUIRE(mesh.vertices[4].position == pt);
+  pt = {0.0f, 0.0f, 1.0f};
+  REQUIRE(mesh.vertices[3].normal == pt);
+}
+
+TEST_CASE("ACMR is computed", "[struct Mesh]")
+{
+  using namespace redc;
+
+  // Two triangles sharing an edge, four vertices for two triangles.
+  std::vector<unsigned int> elements = {0, 1, 2, 2, 1, 3};
+  REQUIRE(gfx::compute_acmr(elements, 4) == Approx(2.0f));
+
+  // With a tiny cache nothing gets reused.
+  elements = {0, 1, 2, 3, 4, 5, 0, 1, 2};
+  REQUIRE(gfx::compute_acmr(elements, 6, 3) == Approx(3.0f));
+}
+
+TEST_CASE("Optimized meshes draw the same triangles", "[struct Mesh]")
+{
+  using namespace redc;
+
+  auto mesh = make_grid(40);
+  auto before = triangles(mesh);
+
+  auto stats = gfx::optimize_mesh(mesh);
+
+  REQUIRE(mesh.vertices.size() == 41 * 41);
+  REQUIRE(triangles(mesh) == before);
+
+  REQUIRE(stats.acmr_before == Approx(gfx::compute_acmr(make_grid(40).elements,
+                                                        41 * 41)));
+  REQUIRE(stats.acmr_after == Approx(gfx::compute_acmr(mesh.elements,
+                                                       41 * 41)));
+  REQUIRE(stats.acmr_after < stats.acmr_before * 0.5f);
+
+  // Vertices should be in the order they are first used.
+  unsigned int next = 0;
+  for(unsigned int v : mesh.elements)
+  {
+    REQUIRE(v <= next);
+    if(v == next) ++next;
+  }
+}
+
+TEST_CASE("Leftover elements stay at the end", "[struct Mesh]")
+{
+  using namespace redc;
+
+  auto mesh = make_grid(8);
+  std::size_t num_elements = mesh.elements.size();
+
+  // Not a whole triangle, using vertices the triangles use as well.
+  mesh.elements.push_back(0);
+  mesh.elements.push_back(10);
+
+  auto clusters = gfx::optimize_vertex_cache(mesh.elements,
+                                             mesh.vertices.size());
+  REQUIRE(mesh.elements.size() == num_elements + 2);
+  CHECK(mesh.elements[num_elements] == 0);
+  CHECK(mesh.elements[num_elements + 1] == 10);
+
+  gfx::optimize_overdraw(mesh.elements, clusters, mesh.vertices);
+  REQUIRE(mesh.elements.size() == num_elements + 2);
+  CHECK(mesh.elements[num_elements] == 0);
+  CHECK(mesh.elements[num_elements + 1] == 10);
+
+  mesh.elements.resize(num_elements);
+  auto before = make_grid(8);
+  CHECK(triangles(mesh) == triangles(before));
+}
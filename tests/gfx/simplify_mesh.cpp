@@ -0,0 +1,338 @@
+/*
+ * Copyright (C) 2016 Luke San Antonio
+ * All rights reserved.
+ */
+
+#include "gfx/extra/simplify_mesh.h"
+#include "gfx/mesh_chunk.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+#include "catch/catch.hpp"
+
+namespace
+{
+  using namespace redc;
+
+  // A closed torus, no borders or seams so everything can be simplified.
+  gfx::Indexed_Mesh_Data make_torus(unsigned int rings, unsigned int sides)
+  {
+    gfx::Indexed_Mesh_Data mesh;
+    for(unsigned int i = 0; i < rings; ++i)
+    {
+      for(unsigned int j = 0; j < sides; ++j)
+      {
+        float u = i * 6.2831853f / rings;
+        float v = j * 6.2831853f / sides;
+
+        gfx::Vertex vert;
+        vert.position = glm::vec3((3.0f + std::cos(v)) * std::cos(u),
+                                  (3.0f + std::cos(v)) * std::sin(u),
+                                  std::sin(v));
+        mesh.vertices.push_back(vert);
+      }
+    }
+    for(unsigned int i = 0; i < rings; ++i)
+    {
+      for(unsigned int j = 0; j < sides; ++j)
+      {
+        unsigned int a = i * sides + j;
+        unsigned int b = ((i + 1) % rings) * sides + j;
+        unsigned int c = ((i + 1) % rings) * sides + (j + 1) % sides;
+        unsigned int d = i * sides + (j + 1) % sides;
+        mesh.elements.insert(mesh.elements.end(), {a, b, c, a, c, d});
+      }
+    }
+    return mesh;
+  }
+
+  // Every triangle gets its own vertices with the face normal, so no vertex
+  // is shared with another triangle.
+  gfx::Indexed_Mesh_Data make_flat_shaded(gfx::Indexed_Mesh_Data const& m)
+  {
+    gfx::Indexed_Mesh_Data mesh;
+    for(std::size_t i = 0; i < m.elements.size(); i += 3)
+    {
+      glm::vec3 p[3];
+      for(int j = 0; j < 3; ++j) p[j] = m.vertices[m.elements[i + j]].position;
+      glm::vec3 normal = glm::normalize(glm::cross(p[1] - p[0], p[2] - p[0]));
+
+      for(int j = 0; j < 3; ++j)
+      {
+        gfx::Vertex vert;
+        vert.position = p[j];
+        vert.normal = normal;
+        mesh.elements.push_back(mesh.vertices.size());
+        mesh.vertices.push_back(vert);
+      }
+    }
+    return mesh;
+  }
+
+  // Remembers what it was asked to draw.
+  struct Draw_Recorder : gfx::IMesh
+  {
+    void reinitialize() override {}
+
+    void format_buffer(gfx::IBuffer&, gfx::Attrib_Bind, gfx::Attrib_Type,
+                       gfx::Data_Type, std::size_t, std::size_t) override {}
+    void enable_attrib_bind(gfx::Attrib_Bind) override {}
+    void disable_attrib_bind(gfx::Attrib_Bind) override {}
+
+    void set_primitive_type(gfx::Primitive_Type) override {}
+    gfx::Primitive_Type get_primitive_type() override
+    { return gfx::Primitive_Type::Triangles; }
+
+    void use_element_buffer(gfx::IBuffer&, gfx::Data_Type) override {}
+
+    void draw_arrays(unsigned int, unsigned int) override {}
+    void draw_elements(unsigned int start, unsigned int count) override
+    { draws.emplace_back(start, count); }
+    void draw_elements_base_vertex(unsigned int start, unsigned int count,
+                                   unsigned int) override
+    { draws.emplace_back(start, count); }
+
+    std::vector<std::pair<unsigned int, unsigned int> > draws;
+  };
+}
+
+TEST_CASE("Flat meshes simplify without error", "[struct Mesh]")
+{
+  using namespace redc;
+
+  // A flat grid, only the border should have to stay.
+  gfx::Indexed_Mesh_Data mesh;
+  unsigned int size = 10;
+  for(unsigned int y = 0; y <= size; ++y)
+  {
+    for(unsigned int x = 0; x <= size; ++x)
+    {
+      gfx::Vertex vert;
+      vert.position = glm::vec3(x, y, 0.0f);
+      mesh.vertices.push_back(vert);
+    }
+  }
+  for(unsigned int y = 0; y < size; ++y)
+  {
+    for(unsigned int x = 0; x < size; ++x)
+    {
+      unsigned int i = y * (size + 1) + x;
+      mesh.elements.insert(mesh.elements.end(),
+                           {i, i + 1, i + size + 2, i, i + size + 2,
+                            i + size + 1});
+    }
+  }
+
+  float error = 1.0f;
+  auto elements = gfx::simplify_mesh(mesh.elements, mesh.vertices, 0, error);
+
+  REQUIRE(error == Approx(0.0f));
+  REQUIRE(elements.size() < mesh.elements.size() / 4);
+
+  // It should still cover the same area.
+  float area = 0.0f;
+  for(std::size_t i = 0; i < elements.size(); i += 3)
+  {
+    auto const& p0 = mesh.vertices[elements[i]].position;
+    auto const& p1 = mesh.vertices[elements[i + 1]].position;
+    auto const& p2 = mesh.vertices[elements[i + 2]].position;
+    glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+    REQUIRE(normal.z > 0.0f);
+    area += normal.z * 0.5f;
+  }
+  REQUIRE(area == Approx(size * size));
+}
+
+TEST_CASE("Flat shaded meshes simplify", "[struct Mesh]")
+{
+  using namespace redc;
+
+  auto mesh = make_flat_shaded(make_torus(32, 16));
+  std::size_t full_size = mesh.elements.size();
+
+  float error = 1.0f;
+  auto elements = gfx::simplify_mesh(mesh.elements, mesh.vertices,
+                                     full_size / 2, error);
+  REQUIRE(elements.size() <= full_size / 2);
+  REQUIRE(error < 0.5f);
+
+  // Every corner still has the normal of a face that was around there.
+  for(unsigned int element : elements)
+  {
+    REQUIRE(element < mesh.vertices.size());
+    REQUIRE(glm::length(mesh.vertices[element].normal) == Approx(1.0f));
+  }
+}
+
+TEST_CASE("Uv seams only slide along themselves", "[struct Mesh]")
+{
+  using namespace redc;
+
+  // A flat grid split down the middle into two uv islands. The vertices on
+  // the split are there twice, once for each side.
+  unsigned int size = 10;
+  unsigned int split = 5;
+  gfx::Indexed_Mesh_Data mesh;
+  std::vector<unsigned int> left(size + 1), right(size + 1);
+  auto add_vertex = [&](unsigned int x, unsigned int y, bool right_side)
+  {
+    gfx::Vertex vert;
+    vert.position = glm::vec3(x, y, 0.0f);
+    vert.normal = glm::vec3(0.0f, 0.0f, 1.0f);
+    vert.uv = glm::vec2(x + (right_side ? 100.0f : 0.0f), y);
+    mesh.vertices.push_back(vert);
+    return static_cast<unsigned int>(mesh.vertices.size() - 1);
+  };
+  std::vector<unsigned int> grid((size + 1) * (size + 1));
+  std::vector<unsigned int> seam(size + 1);
+  for(unsigned int y = 0; y <= size; ++y)
+  {
+    for(unsigned int x = 0; x <= size; ++x)
+    {
+      grid[y * (size + 1) + x] = add_vertex(x, y, x > split);
+    }
+    seam[y] = add_vertex(split, y, true);
+  }
+  auto vertex = [&](unsigned int x, unsigned int y, bool right_side)
+  {
+    if(x == split && right_side) return seam[y];
+    return grid[y * (size + 1) + x];
+  };
+  for(unsigned int y = 0; y < size; ++y)
+  {
+    for(unsigned int x = 0; x < size; ++x)
+    {
+      bool right_side = x >= split;
+      unsigned int a = vertex(x, y, right_side);
+      unsigned int b = vertex(x + 1, y, right_side);
+      unsigned int c = vertex(x + 1, y + 1, right_side);
+      unsigned int d = vertex(x, y + 1, right_side);
+      mesh.elements.insert(mesh.elements.end(), {a, b, c, a, c, d});
+    }
+  }
+
+  float error = 1.0f;
+  auto elements = gfx::simplify_mesh(mesh.elements, mesh.vertices, 0, error);
+  REQUIRE(error == Approx(0.0f));
+  REQUIRE(elements.size() < mesh.elements.size() / 4);
+
+  std::vector<bool> seam_used(size + 1, false);
+  float area = 0.0f;
+  for(std::size_t i = 0; i < elements.size(); i += 3)
+  {
+    glm::vec3 p[3];
+    bool right_side = mesh.vertices[elements[i]].uv.x >= 100.0f;
+    for(int j = 0; j < 3; ++j)
+    {
+      auto const& vert = mesh.vertices[elements[i + j]];
+      p[j] = vert.position;
+
+      // Nothing gets stretched across the seam, each triangle stays on its
+      // own island and its own side of the split.
+      REQUIRE((vert.uv.x >= 100.0f) == right_side);
+      if(right_side) REQUIRE(p[j].x >= split);
+      else REQUIRE(p[j].x <= split);
+
+      if(p[j].x == split) seam_used[static_cast<unsigned int>(p[j].y)] = true;
+    }
+
+    glm::vec3 normal = glm::cross(p[1] - p[0], p[2] - p[0]);
+    REQUIRE(normal.z > 0.0f);
+    area += normal.z * 0.5f;
+  }
+  REQUIRE(area == Approx(size * size));
+
+  // The ends are on the border, but the rest of the seam could go.
+  REQUIRE(seam_used.front());
+  REQUIRE(seam_used.back());
+  REQUIRE(std::count(seam_used.begin(), seam_used.end(), true) < 4);
+}
+
+TEST_CASE("Lods get coarser", "[struct Mesh]")
+{
+  using namespace redc;
+
+  auto mesh = make_torus(64, 32);
+  std::size_t full_size = mesh.elements.size();
+
+  auto lods = gfx::generate_lods(mesh, 4);
+
+  REQUIRE(lods.size() == 4);
+  REQUIRE(lods[0].start == 0);
+  REQUIRE(lods[0].count == full_size);
+  REQUIRE(lods[0].error == 0.0f);
+
+  for(std::size_t i = 1; i < lods.size(); ++i)
+  {
+    REQUIRE(lods[i].start == lods[i - 1].start + lods[i - 1].count);
+    REQUIRE(lods[i].count <= lods[i - 1].count * 0.6f);
+    REQUIRE(lods[i].count % 3 == 0);
+    REQUIRE(lods[i].error >= lods[i - 1].error);
+    // Nowhere near the size of the thing.
+    REQUIRE(lods[i].error < 0.5f);
+  }
+  REQUIRE(mesh.elements.size() == lods.back().start + lods.back().count);
+  for(unsigned int element : mesh.elements)
+  {
+    REQUIRE(element < mesh.vertices.size());
+  }
+}
+
+TEST_CASE("Lod selection has hysteresis", "[struct Mesh_Chunk]")
+{
+  using namespace redc;
+
+  gfx::Mesh_Chunk chunk;
+  chunk.lods = {{0, 300, 0.0f}, {300, 150, 0.01f}, {450, 75, 0.1f}};
+
+  // Close up everything is visible.
+  REQUIRE(gfx::select_lod(chunk, 1000.0f, 2) == 0);
+  // Far away the coarsest is fine.
+  REQUIRE(gfx::select_lod(chunk, 1.0f, 0) == 2);
+
+  // Right at the edge of lod 1 being good enough, stay wherever we were.
+  REQUIRE(gfx::select_lod(chunk, 90.0f, 0) == 0);
+  REQUIRE(gfx::select_lod(chunk, 90.0f, 1) == 1);
+  // Then far enough away to go coarser anyway.
+  REQUIRE(gfx::select_lod(chunk, 70.0f, 0) == 1);
+
+  // Chunks without lods are always drawn as is.
+  chunk.lods.clear();
+  REQUIRE(gfx::select_lod(chunk, 1.0f, 3) == 0);
+}
+
+TEST_CASE("Each lod draws only its own elements", "[struct Mesh_Chunk]")
+{
+  using namespace redc;
+
+  Draw_Recorder recorder;
+
+  gfx::Mesh_Chunk chunk;
+  chunk.mesh.set_pointer(&recorder);
+  chunk.start = 30;
+  chunk.count = 300;
+  chunk.lods = {{0, 300, 0.0f}, {300, 150, 0.01f}, {450, 75, 0.1f}};
+
+  gfx::render_chunk(chunk);
+  gfx::render_chunk(chunk, 0);
+  gfx::render_chunk(chunk, 2);
+  // Out of range lods fall back to the full detail one.
+  gfx::render_chunk(chunk, 7);
+
+  using draw_t = std::pair<unsigned int, unsigned int>;
+  REQUIRE(recorder.draws.size() == 4);
+  CHECK(recorder.draws[0] == draw_t(30, 300));
+  CHECK(recorder.draws[1] == draw_t(30, 300));
+  CHECK(recorder.draws[2] == draw_t(480, 75));
+  CHECK(recorder.draws[3] == draw_t(30, 300));
+
+  // Even if the chunk's count covers every lod.
+  recorder.draws.clear();
+  chunk.count = 525;
+  gfx::render_chunk(chunk);
+  REQUIRE(recorder.draws.size() == 1);
+  CHECK(recorder.draws[0] == draw_t(30, 300));
+}
@@ -0,0 +1,190 @@
+/*
+ * Copyright (C) 2016 Luke San Antonio
+ * All rights reserved.
+ */
+
+#include "gfx/extra/texture_mips.h"
+#include "gfx/extra/block_compress.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <random>
+
+#include "catch/catch.hpp"
+
+namespace
+{
+  using namespace redc;
+
+  gfx::Image make_image(std::size_t width, std::size_t height)
+  {
+    gfx::Image image;
+    image.extents = {width, height};
+    image.data.resize(width * height);
+    return image;
+  }
+
+  // Smooth gradients with a bit of noise, about what real textures look like.
+  gfx::Image make_gradient(std::size_t width, std::size_t height, bool alpha)
+  {
+    std::mt19937 rand(5);
+    std::uniform_int_distribution<int> noise(-4, 4);
+
+    auto image = make_image(width, height);
+    for(std::size_t y = 0; y < height; ++y)
+    {
+      for(std::size_t x = 0; x < width; ++x)
+      {
+        auto clamp = [](int c) { return std::min(std::max(c, 0), 255); };
+        int base = static_cast<int>(x * 255 / width);
+        image.data[y * width + x] = Color(
+          clamp(base + noise(rand)),
+          clamp(static_cast<int>(y * 255 / height) + noise(rand)),
+          clamp(255 - base + noise(rand)),
+          alpha ? clamp(static_cast<int>((x + y) * 255 / (width + height))) :
+                  255
+        );
+      }
+    }
+    return image;
+  }
+
+  double rms_error(gfx::Image const& lhs, gfx::Image const& rhs, bool alpha)
+  {
+    double sum = 0.0;
+    for(std::size_t i = 0; i < lhs.data.size(); ++i)
+    {
+      Color const& a = lhs.data[i];
+      Color const& b = rhs.data[i];
+      double dr = a.r - b.r, dg = a.g - b.g, db = a.b - b.b, da = a.a - b.a;
+      sum += dr * dr + dg * dg + db * db;
+      if(alpha) sum += da * da;
+    }
+    return std::sqrt(sum / (lhs.data.size() * (alpha ? 4 : 3)));
+  }
+}
+
+TEST_CASE("Mip chains go down to one pixel", "[struct Image]")
+{
+  using namespace redc;
+
+  REQUIRE(gfx::num_mip_levels({1, 1}) == 1);
+  REQUIRE(gfx::num_mip_levels({256, 256}) == 9);
+  REQUIRE(gfx::num_mip_levels({300, 20}) == 9);
+
+  auto mips = gfx::generate_srgb_mips(make_image(12, 5));
+  REQUIRE(mips.size() == gfx::num_mip_levels({12, 5}) - 1);
+  REQUIRE(mips[0].extents.x == 6);
+  REQUIRE(mips[0].extents.y == 2);
+  REQUIRE(mips[1].extents.x == 3);
+  REQUIRE(mips[1].extents.y == 1);
+  REQUIRE(mips.back().extents.x == 1);
+  REQUIRE(mips.back().extents.y == 1);
+  for(auto const& mip : mips)
+  {
+    REQUIRE(mip.data.size() == mip.extents.x * mip.extents.y);
+  }
+}
+
+TEST_CASE("Mips are filtered in linear space", "[struct Image]")
+{
+  using namespace redc;
+
+  // A checkerboard of black and white should average to half the light,
+  // which is a lot brighter than 128 in sRGB.
+  auto image = make_image(2, 2);
+  image.data = {Color(0, 0, 0), Color(255, 255, 255),
+                Color(255, 255, 255), Color(0, 0, 0)};
+  auto mips = gfx::generate_srgb_mips(image);
+  REQUIRE(mips.size() == 1);
+  REQUIRE(std::abs(mips[0].data[0].r - 188) <= 1);
+  REQUIRE(mips[0].data[0].a == 255);
+
+  // Transparent pixels don't get to change the color.
+  image.data = {Color(255, 0, 0, 255), Color(0, 255, 0, 0),
+                Color(0, 255, 0, 0), Color(0, 255, 0, 0)};
+  mips = gfx::generate_srgb_mips(image);
+  REQUIRE(mips[0].data[0].r == 255);
+  REQUIRE(mips[0].data[0].g == 0);
+  REQUIRE(std::abs(mips[0].data[0].a - 64) <= 1);
+}
+
+TEST_CASE("Flipping images", "[struct Image]")
+{
+  using namespace redc;
+
+  auto image = make_image(2, 3);
+  for(std::size_t i = 0; i < image.data.size(); ++i)
+  {
+    image.data[i].r = i;
+  }
+  gfx::flip_image_rows(image);
+  REQUIRE(image.data[0].r == 4);
+  REQUIRE(image.data[1].r == 5);
+  REQUIRE(image.data[2].r == 2);
+  REQUIRE(image.data[5].r == 1);
+}
+
+TEST_CASE("Block compression round trips", "[struct Image]")
+{
+  using namespace redc;
+
+  auto bc1 = gfx::Texture_Format::Bc1_Srgb_Alpha;
+  auto bc3 = gfx::Texture_Format::Bc3_Srgb_Alpha;
+
+  REQUIRE(gfx::compressed_size({1, 1}, bc1) == 8);
+  REQUIRE(gfx::compressed_size({5, 4}, bc1) == 16);
+  REQUIRE(gfx::compressed_size({8, 8}, bc3) == 64);
+
+  SECTION("Opaque BC1")
+  {
+    auto image = make_gradient(64, 37, false);
+    auto data = gfx::compress_image(image, bc1);
+    REQUIRE(data.size() == gfx::compressed_size(image.extents, bc1));
+
+    auto result = gfx::decompress_image(data.data(), image.extents, bc1);
+    REQUIRE(rms_error(image, result, false) < 8.0);
+    for(Color const& c : result.data) REQUIRE(c.a == 255);
+  }
+  SECTION("BC1 cuts out alpha")
+  {
+    auto image = make_gradient(16, 16, false);
+    for(std::size_t i = 0; i < image.data.size(); i += 3)
+    {
+      image.data[i].a = 0;
+    }
+    auto data = gfx::compress_image(image, bc1);
+    auto result = gfx::decompress_image(data.data(), image.extents, bc1);
+    for(std::size_t i = 0; i < image.data.size(); ++i)
+    {
+      REQUIRE((result.data[i].a == 0) == (image.data[i].a == 0));
+    }
+  }
+  SECTION("BC3 keeps alpha")
+  {
+    auto image = make_gradient(33, 64, true);
+    auto data = gfx::compress_image(image, bc3);
+    REQUIRE(data.size() == gfx::compressed_size(image.extents, bc3));
+
+    auto result = gfx::decompress_image(data.data(), image.extents, bc3);
+    REQUIRE(rms_error(image, result, true) < 8.0);
+    for(std::size_t i = 0; i < image.data.size(); ++i)
+    {
+      REQUIRE(std::abs(result.data[i].a - image.data[i].a) <= 4);
+    }
+  }
+  SECTION("Solid colors are exact-ish")
+  {
+    auto image = make_image(4, 4);
+    for(Color& c : image.data) c = Color(200, 100, 50);
+    auto data = gfx::compress_image(image, bc1);
+    auto result = gfx::decompress_image(data.data(), image.extents, bc1);
+    for(Color const& c : result.data)
+    {
+      REQUIRE(std::abs(c.r - 200) <= 4);
+      REQUIRE(std::abs(c.g - 100) <= 2);
+      REQUIRE(std::abs(c.b - 50) <= 4);
+    }
+  }
+}
@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2016 Luke San Antonio
+ * All rights reserved.
+ */
+
+#include "gfx/extra/texture_atlas.h"
+
+#include <algorithm>
+#include <random>
+
+#include "catch/catch.hpp"
+
+namespace
+{
+  using namespace redc;
+
+  // Every pixel says which image it came from and where.
+  gfx::Image make_image(unsigned int id, std::size_t width, std::size_t height)
+  {
+    gfx::Image image;
+    image.extents = {width, height};
+    for(std::size_t y = 0; y < height; ++y)
+    {
+      for(std::size_t x = 0; x < width; ++x)
+      {
+        image.data.push_back(Color(id, x, y, 0xff));
+      }
+    }
+    return image;
+  }
+}
+
+TEST_CASE("Atlases keep every image intact", "[Texture_Atlas]")
+{
+  using namespace redc;
+
+  std::mt19937 rand(12);
+  std::uniform_int_distribution<std::size_t> size(1, 60);
+
+  std::vector<gfx::Image> images;
+  for(unsigned int i = 0; i < 60; ++i)
+  {
+    images.push_back(make_image(i, size(rand), size(rand)));
+  }
+
+  Vec<std::size_t> page_extents = {256, 256};
+  auto atlas = gfx::build_atlas(images, page_extents, 2);
+
+  // That's more than fits on one page.
+  REQUIRE(atlas.pages.size() > 1);
+  REQUIRE(atlas.regions.size() == images.size());
+
+  for(auto const& page : atlas.pages)
+  {
+    REQUIRE(page.extents.x == 256);
+    REQUIRE(page.extents.y <= 256);
+    REQUIRE(page.data.size() == page.extents.x * page.extents.y);
+  }
+
+  for(unsigned int i = 0; i < images.size(); ++i)
+  {
+    auto const& region = atlas.regions[i];
+    REQUIRE(region.page < atlas.pages.size());
+    REQUIRE(region.extents.x == images[i].extents.x);
+    REQUIRE(region.extents.y == images[i].extents.y);
+
+    auto const& page = atlas.pages[region.page];
+    REQUIRE(region.pos.x >= 2);
+    REQUIRE(region.pos.y >= 2);
+    REQUIRE(region.pos.x + region.extents.x + 2 <= page.extents.x);
+    REQUIRE(region.pos.y + region.extents.y + 2 <= page.extents.y);
+
+    // Nobody else wrote over it, including the padding.
+    for(long y = -2; y < (long) region.extents.y + 2; ++y)
+    {
+      for(long x = -2; x < (long) region.extents.x + 2; ++x)
+      {
+        Color c = page.data[(region.pos.y + y) * page.extents.x +
+                            region.pos.x + x];
+        REQUIRE(c.r == i);
+        long src_x = std::min(std::max(x, 0L), (long) region.extents.x - 1);
+        long src_y = std::min(std::max(y, 0L), (long) region.extents.y - 1);
+        REQUIRE(c.g == src_x);
+        REQUIRE(c.b == src_y);
+      }
+    }
+  }
+}
+
+TEST_CASE("Atlas uv transforms", "[Texture_Atlas]")
+{
+  using namespace redc;
+
+  std::vector<gfx::Image> images = {make_image(0, 16, 8), make_image(1, 30, 4)};
+  auto atlas = gfx::build_atlas(images, {64, 64}, 1);
+
+  REQUIRE(atlas.pages.size() == 1);
+  // Everything fits in the top half.
+  REQUIRE(atlas.pages[0].extents.y == 16);
+
+  for(unsigned int i = 0; i < images.size(); ++i)
+  {
+    auto const& region = atlas.regions[i];
+    auto const& page = atlas.pages[0];
+    glm::vec4 const& t = region.uv_transform;
+
+    // In GL the bottom left corner of the texture is the start of its last
+    // row, as loaded.
+    float u = t.z * page.extents.x;
+    float v = t.w * page.extents.y;
+    REQUIRE(u == Approx(region.pos.x));
+    REQUIRE(page.extents.y - v == Approx(region.pos.y + region.extents.y));
+
+    REQUIRE(t.x * page.extents.x == Approx(region.extents.x));
+    REQUIRE(t.y * page.extents.y == Approx(region.extents.y));
+  }
+}
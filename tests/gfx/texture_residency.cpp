@@ -0,0 +1,143 @@
+/*
+ * Copyright (C) 2016 Luke San Antonio
+ * All rights reserved.
+ */
+
+#include "gfx/extra/texture_residency.h"
+
+#include "catch/catch.hpp"
+
+namespace
+{
+  using namespace redc;
+
+  // Uncompressed rgba levels of a square power of two texture.
+  std::vector<std::size_t> level_sizes(std::size_t size)
+  {
+    std::vector<std::size_t> ret;
+    while(true)
+    {
+      ret.push_back(size * size * 4);
+      if(size == 1) break;
+      size /= 2;
+    }
+    return ret;
+  }
+
+  using Change = gfx::Texture_Residency::Change;
+}
+
+TEST_CASE("Streamed textures start with their tail", "[Texture_Residency]")
+{
+  using namespace redc;
+
+  gfx::Texture_Residency res(1024 * 1024 * 1024);
+  auto id = res.add({256, 256}, level_sizes(256));
+
+  // 256, 128, 64, then 32 is the first level in the tail.
+  REQUIRE(res.tail_level(id) == 3);
+  REQUIRE(res.resident_level(id) == 9);
+
+  auto changes = res.step(0);
+  REQUIRE(changes.size() == 6);
+  for(std::size_t i = 0; i < changes.size(); ++i)
+  {
+    REQUIRE(changes[i].type == Change::Upload);
+    REQUIRE(changes[i].id == id);
+    // Smallest first.
+    REQUIRE(changes[i].level == 8 - i);
+  }
+  REQUIRE(res.resident_level(id) == 3);
+
+  // Small textures are all tail.
+  auto small = res.add({16, 8}, {512, 128, 32, 8, 4});
+  REQUIRE(res.tail_level(small) == 0);
+  res.step(0);
+  REQUIRE(res.resident_level(small) == 0);
+}
+
+TEST_CASE("Residency follows texel density", "[Texture_Residency]")
+{
+  using namespace redc;
+
+  gfx::Texture_Residency res(1024 * 1024 * 1024);
+  auto id = res.add({1024, 1024}, level_sizes(1024));
+  res.step(0);
+  REQUIRE(res.resident_level(id) == 5);
+
+  // About 256 pixels on screen wants the 256x256 level.
+  res.report(id, 200.0f);
+  res.report(id, 300.0f);
+  auto changes = res.step(1024 * 1024 * 1024);
+  REQUIRE(res.wanted_level(id) == 1);
+  REQUIRE(res.resident_level(id) == 1);
+  REQUIRE(changes.size() == 4);
+  REQUIRE(changes.back().level == 1);
+
+  // The upload budget limits how much comes in at once, but there is always
+  // at least one level.
+  res.report(id, 2048.0f);
+  changes = res.step(1);
+  REQUIRE(changes.size() == 1);
+  REQUIRE(res.resident_level(id) == 0);
+
+  // Going away doesn't evict anything without pressure.
+  changes = res.step(1024 * 1024 * 1024);
+  REQUIRE(changes.empty());
+  REQUIRE(res.resident_level(id) == 0);
+  REQUIRE(res.wanted_level(id) == res.tail_level(id));
+}
+
+TEST_CASE("Residency stays under the budget", "[Texture_Residency]")
+{
+  using namespace redc;
+
+  auto sizes = level_sizes(512);
+  std::size_t tail_size = 0;
+  for(std::size_t i = 4; i < sizes.size(); ++i) tail_size += sizes[i];
+
+  // Room for every tail plus one full texture.
+  std::size_t full_size = tail_size + sizes[0] + sizes[1] + sizes[2] +
+                          sizes[3];
+  gfx::Texture_Residency res(tail_size * 2 + full_size);
+
+  auto a = res.add({512, 512}, sizes);
+  auto b = res.add({512, 512}, sizes);
+  auto c = res.add({512, 512}, sizes);
+  res.step(0);
+  REQUIRE(res.resident_bytes() == tail_size * 3);
+
+  res.report(a, 512.0f);
+  res.step(-1);
+  REQUIRE(res.resident_level(a) == 0);
+  REQUIRE(res.resident_bytes() == full_size + tail_size * 2);
+
+  // B is used now and a isn't, so a gives up its top levels.
+  res.report(b, 512.0f);
+  auto changes = res.step(-1);
+  REQUIRE(res.resident_level(b) == 0);
+  REQUIRE(res.resident_level(a) == res.tail_level(a));
+  REQUIRE(res.resident_bytes() <= res.budget());
+  REQUIRE(changes.front().type == Change::Evict);
+  REQUIRE(changes.front().id == a);
+  REQUIRE(changes.front().level == 0);
+
+  // When both are in use neither can take from the other, the one that
+  // didn't make it stays where it is.
+  res.report(b, 512.0f);
+  res.report(c, 512.0f);
+  changes = res.step(-1);
+  REQUIRE(res.resident_level(b) == 0);
+  REQUIRE(res.resident_level(c) == res.tail_level(c));
+  REQUIRE(res.resident_bytes() <= res.budget());
+
+  // Least recently used goes first.
+  res.report(c, 512.0f);
+  res.step(-1);
+  REQUIRE(res.resident_level(c) == 0);
+  REQUIRE(res.resident_level(b) == res.tail_level(b));
+
+  // Removing frees its levels right away.
+  res.remove(c);
+  REQUIRE(res.resident_bytes() == tail_size * 2);
+}
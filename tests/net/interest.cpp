@@ -0,0 +1,206 @@
+/*
+ * Copyright (C) 2017 Luke San Antonio
+ * All rights reserved.
+ */
+#include <algorithm>
+#include <set>
+#include "catch/catch.hpp"
+#include "net/interest.h"
+
+using namespace redc;
+using namespace redc::net;
+
+namespace
+{
+  Quantize_Grid test_grid()
+  {
+    Quantize_Grid grid;
+    grid.min = glm::vec3(-256.0f, -8.0f, -256.0f);
+    grid.max = glm::vec3(256.0f, 56.0f, 256.0f);
+    return grid;
+  }
+
+  Player_Snapshot make_player(player_id id, glm::vec3 pos)
+  {
+    Player_Snapshot player;
+    player.id = id;
+    player.position = pos;
+    return player;
+  }
+
+  std::vector<std::size_t> query(Spatial_Grid const& grid, glm::vec3 center,
+                                 float radius)
+  {
+    std::vector<std::size_t> ret;
+    grid.query(center, radius, [&](std::size_t index)
+    {
+      ret.push_back(index);
+    });
+    std::sort(ret.begin(), ret.end());
+    return ret;
+  }
+
+  std::vector<player_id> ids(Snapshot const& snap)
+  {
+    std::vector<player_id> ret;
+    for(auto const& player : snap.players) ret.push_back(player.id);
+    return ret;
+  }
+
+  using index_list = std::vector<std::size_t>;
+  using id_list = std::vector<player_id>;
+}
+
+TEST_CASE("Spatial grids bucket players by cell", "[interest]")
+{
+  Snapshot snap;
+  snap.players.push_back(make_player(1, {0.0f, 0.0f, 0.0f}));
+  snap.players.push_back(make_player(2, {31.0f, 40.0f, 31.0f}));
+  snap.players.push_back(make_player(3, {32.0f, 0.0f, 0.0f}));
+  snap.players.push_back(make_player(4, {-1.0f, -5.0f, -1.0f}));
+  snap.players.push_back(make_player(5, {100.0f, 0.0f, 100.0f}));
+
+  Spatial_Grid grid(32.0f);
+  grid.build(snap);
+
+  // Height doesn't matter.
+  CHECK(query(grid, {16.0f, 0.0f, 16.0f}, 1.0f) == (index_list{0, 1}));
+  CHECK(query(grid, {16.0f, 1000.0f, 16.0f}, 1.0f) == (index_list{0, 1}));
+
+  // Negative coordinates get cells of their own, the circle touches four.
+  CHECK(query(grid, {0.0f, 0.0f, 0.0f}, 1.0f) == (index_list{0, 1, 3}));
+
+  // The whole cell comes along even if only a corner is in the circle.
+  CHECK(query(grid, {40.0f, 0.0f, 20.0f}, 1.0f) == (index_list{2}));
+  CHECK(query(grid, {96.0f, 0.0f, 96.0f}, 1.0f) == (index_list{4}));
+  CHECK(query(grid, {200.0f, 0.0f, 200.0f}, 10.0f).empty());
+
+  // Rebuilding forgets where everybody was.
+  snap.players.resize(1);
+  snap.players[0].position = glm::vec3(100.0f, 0.0f, 100.0f);
+  grid.build(snap);
+  CHECK(query(grid, {16.0f, 0.0f, 16.0f}, 1.0f).empty());
+  CHECK(query(grid, {96.0f, 0.0f, 96.0f}, 1.0f) == (index_list{0}));
+}
+
+TEST_CASE("Interest culls by radius with hysteresis", "[interest]")
+{
+  auto qgrid = test_grid();
+  Interest_Config config;
+  config.enter_radius = 96.0f;
+  config.leave_radius = 128.0f;
+  config.budget_bytes = 4096;
+
+  Snapshot world;
+  world.tick = 1;
+  world.players.push_back(make_player(1, {0.0f, 0.0f, 0.0f}));
+  world.players.push_back(make_player(2, {50.0f, 0.0f, 0.0f}));
+  // Between the two radii, not relevant yet.
+  world.players.push_back(make_player(3, {0.0f, 0.0f, 110.0f}));
+  world.players.push_back(make_player(4, {0.0f, 0.0f, -200.0f}));
+
+  Spatial_Grid grid(32.0f);
+  grid.build(world);
+
+  Client_Interest interest;
+  glm::vec3 viewer = world.players[0].position;
+  auto snap = interest_snapshot(world, grid, interest, &viewer, 1, nullptr,
+                                qgrid, config);
+  CHECK(ids(snap) == (id_list{1, 2}));
+
+  // Player 2 moves out to where 3 is, they stay because they were already
+  // relevant. 3 comes inside of the enter radius.
+  world.tick = 2;
+  world.players[1].position = glm::vec3(110.0f, 0.0f, 0.0f);
+  world.players[2].position = glm::vec3(0.0f, 0.0f, 90.0f);
+  grid.build(world);
+  snap = interest_snapshot(world, grid, interest, &viewer, 1, &snap, qgrid,
+                           config);
+  CHECK(ids(snap) == (id_list{1, 2, 3}));
+
+  // Past the leave radius they're gone.
+  world.tick = 3;
+  world.players[1].position = glm::vec3(130.0f, 0.0f, 0.0f);
+  grid.build(world);
+  snap = interest_snapshot(world, grid, interest, &viewer, 1, &snap, qgrid,
+                           config);
+  CHECK(ids(snap) == (id_list{1, 3}));
+  CHECK(interest.priority.count(2) == 0);
+
+  // Coming back has to get inside the enter radius again.
+  world.tick = 4;
+  world.players[1].position = glm::vec3(110.0f, 0.0f, 0.0f);
+  grid.build(world);
+  snap = interest_snapshot(world, grid, interest, &viewer, 1, &snap, qgrid,
+                           config);
+  CHECK(ids(snap) == (id_list{1, 3}));
+
+  // Without a viewer everybody is relevant.
+  Client_Interest everything;
+  snap = interest_snapshot(world, grid, everything, nullptr, 1, nullptr,
+                           qgrid, config);
+  CHECK(ids(snap) == (id_list{1, 2, 3, 4}));
+}
+
+TEST_CASE("Interest budgets go by priority without starving", "[interest]")
+{
+  auto qgrid = test_grid();
+  Interest_Config config;
+  config.enter_radius = 200.0f;
+  config.leave_radius = 250.0f;
+
+  // Ten players in a line going away from the viewer, who is 0.
+  Snapshot world;
+  world.tick = 1;
+  for(player_id id = 0; id < 10; ++id)
+  {
+    world.players.push_back(make_player(id, {id * 20.0f, 0.0f, 0.0f}));
+  }
+
+  // Room for three new players and no more.
+  std::size_t player_bits = player_delta_bits(world.players[0], nullptr,
+                                              qgrid);
+  config.budget_bytes = (snapshot_overhead_bits(0) + player_bits * 3 + 7) / 8;
+  REQUIRE(config.budget_bytes * 8 >=
+          snapshot_overhead_bits(0) + player_bits * 3);
+  REQUIRE(config.budget_bytes * 8 <
+          snapshot_overhead_bits(0) + player_bits * 4);
+
+  Spatial_Grid grid(32.0f);
+  grid.build(world);
+
+  Client_Interest interest;
+  glm::vec3 viewer = world.players[0].position;
+  auto snap = interest_snapshot(world, grid, interest, &viewer, 0, nullptr,
+                                qgrid, config);
+
+  // Ourselves and then whoever is closest.
+  CHECK(ids(snap) == (id_list{0, 1, 2}));
+
+  // Everybody keeps moving so there's always something to send. Whoever is
+  // left out gets more important every tick until they get their turn.
+  auto first = ids(snap);
+  std::set<player_id> sent(first.begin(), first.end());
+  for(uint32_t tick = 2; tick < 12; ++tick)
+  {
+    world.tick = tick;
+    for(auto& player : world.players) player.position.z += 1.0f;
+    grid.build(world);
+
+    auto next = interest_snapshot(world, grid, interest, &viewer, 0, &snap,
+                                  qgrid, config);
+
+    // The ones that didn't fit keep their old state.
+    for(std::size_t i = 0; i < next.players.size(); ++i)
+    {
+      auto const& player = next.players[i];
+      auto const& now = world.players[player.id];
+      if(player.position == now.position) sent.insert(player.id);
+    }
+    snap = std::move(next);
+  }
+
+  CHECK(sent.size() == world.players.size());
+  // Once everybody is known they're all in every snapshot.
+  CHECK(snap.players.size() == world.players.size());
+}
@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2017 Luke San Antonio
+ * All rights reserved.
+ */
+#include "catch/catch.hpp"
+#include "net/prediction.h"
+
+using namespace redc;
+using namespace redc::net;
+
+namespace
+{
+  struct Test_State
+  {
+    glm::vec3 position;
+    // Comes from the client, replays should carry it over.
+    int facing = 0;
+  };
+
+  // Forward moves a meter along x, every input is recorded.
+  struct Test_Sim
+  {
+    unsigned int steps = 0;
+    unsigned int replayed = 0;
+
+    Client_Prediction<Test_State>::step_fn step_fn()
+    {
+      return [this](Test_State const& from, Input const& input,
+                    Test_State const& last, bool replay)
+      {
+        ++steps;
+        if(replay) ++replayed;
+
+        Test_State ret = from;
+        if(input.forward) ret.position.x += 1.0f;
+        ret.facing = replay ? last.facing : from.facing + 1;
+        return ret;
+      };
+    }
+  };
+
+  Input forward()
+  {
+    Input input;
+    input.forward = true;
+    return input;
+  }
+}
+
+TEST_CASE("Corrections replay inputs the server hasn't seen", "[prediction]")
+{
+  Test_Sim sim;
+  Client_Prediction<Test_State> prediction(sim.step_fn(), Test_State{});
+
+  for(uint8_t i = 0; i < 5; ++i) prediction.predict(i, forward());
+  REQUIRE(prediction.state().position.x == Approx(5.0f));
+  REQUIRE(prediction.state().facing == 5);
+
+  // The server agrees up to 1, nothing happens.
+  prediction.reconcile(1, glm::vec3(2.0f, 0.0f, 0.0f));
+  CHECK(prediction.replays() == 0);
+  CHECK(sim.replayed == 0);
+
+  // At 2 we were half a meter off, 3 and 4 are run again from there.
+  prediction.reconcile(2, glm::vec3(3.5f, 0.0f, 0.0f));
+  CHECK(prediction.replays() == 1);
+  CHECK(sim.replayed == 2);
+  CHECK(prediction.state().position.x == Approx(5.5f));
+  CHECK(prediction.state().facing == 5);
+
+  // It's still drawn where it was, then eased over.
+  CHECK(prediction.correction().x == Approx(-0.5f));
+  CHECK(prediction.smooth(0.0f).x == Approx(5.0f));
+  CHECK(prediction.smooth(10.0f).x == Approx(5.5f).epsilon(0.001));
+
+  // Teleports aren't smoothed.
+  prediction.reconcile(3, glm::vec3(40.0f, 0.0f, 0.0f));
+  CHECK(prediction.state().position.x == Approx(41.0f));
+  CHECK(prediction.correction() == glm::vec3(0.0f));
+}
+
+TEST_CASE("Acknowledged inputs are dropped", "[prediction]")
+{
+  Test_Sim sim;
+  Client_Prediction<Test_State> prediction(sim.step_fn(), Test_State{});
+
+  for(uint8_t i = 0; i < 6; ++i) prediction.predict(i, forward());
+
+  // This one acknowledges 0 through 3.
+  prediction.reconcile(3, glm::vec3(4.0f, 0.0f, 0.0f));
+  CHECK(prediction.replays() == 0);
+
+  // Late snapshots about those don't do anything anymore.
+  prediction.reconcile(1, glm::vec3(-20.0f, 0.0f, 0.0f));
+  prediction.reconcile(3, glm::vec3(-20.0f, 0.0f, 0.0f));
+  CHECK(prediction.replays() == 0);
+  CHECK(prediction.state().position.x == Approx(6.0f));
+
+  // The next one only replays what came after it.
+  prediction.reconcile(4, glm::vec3(5.25f, 0.0f, 0.0f));
+  CHECK(prediction.replays() == 1);
+  CHECK(sim.replayed == 1);
+  CHECK(prediction.state().position.x == Approx(6.25f));
+
+  // And the same snapshot again is ignored as well.
+  prediction.reconcile(4, glm::vec3(0.0f));
+  CHECK(prediction.replays() == 1);
+}
+
+TEST_CASE("Prediction indices wrap around", "[prediction]")
+{
+  Test_Sim sim;
+  Client_Prediction<Test_State> prediction(sim.step_fn(), Test_State{});
+
+  // 250 through 255 and then 0 through 4.
+  uint8_t index = 250;
+  for(int i = 0; i < 11; ++i) prediction.predict(index++, forward());
+  REQUIRE(prediction.state().position.x == Approx(11.0f));
+
+  // 253 is the fourth, 254 through 4 get replayed.
+  prediction.reconcile(253, glm::vec3(4.5f, 0.0f, 0.0f));
+  CHECK(sim.replayed == 7);
+  CHECK(prediction.state().position.x == Approx(11.5f));
+
+  // Past the wrap as well.
+  prediction.reconcile(1, glm::vec3(9.0f, 0.0f, 0.0f));
+  CHECK(sim.replayed == 10);
+  CHECK(prediction.state().position.x == Approx(12.0f));
+
+  // Anything from the other half of the ring is too old to mean anything.
+  prediction.reconcile(200, glm::vec3(0.0f));
+  CHECK(prediction.replays() == 2);
+}
@@ -0,0 +1,266 @@
+/*
+ * Copyright (C) 2017 Luke San Antonio
+ * All rights reserved.
+ */
+#include "catch/catch.hpp"
+#include "net/snapshot.h"
+
+using namespace redc;
+using namespace redc::net;
+
+namespace
+{
+  Quantize_Grid test_grid()
+  {
+    Quantize_Grid grid;
+    grid.min = glm::vec3(-64.0f, -8.0f, -64.0f);
+    grid.max = glm::vec3(64.0f, 56.0f, 64.0f);
+    grid.resolution = 1.0f / 64.0f;
+    return grid;
+  }
+
+  Player_Snapshot make_player(player_id id, glm::vec3 pos, bool forward)
+  {
+    Player_Snapshot player;
+    player.id = id;
+    player.input.forward = forward;
+    player.input.jump = id % 2 == 0;
+    player.position = pos;
+    return player;
+  }
+
+  Snapshot make_snapshot(uint32_t tick)
+  {
+    Snapshot snap;
+    snap.tick = tick;
+    snap.has_input_ack = true;
+    snap.input_ack = 250;
+    snap.players.push_back(make_player(1, {1.0f, 2.0f, 3.0f}, true));
+    snap.players.push_back(make_player(4, {-10.5f, 0.25f, 40.0f}, false));
+    snap.players.push_back(make_player(9, {63.0f, 55.0f, -63.0f}, true));
+    return snap;
+  }
+
+  bool same_input(Input const& lhs, Input const& rhs)
+  {
+    return lhs.forward == rhs.forward && lhs.backward == rhs.backward &&
+           lhs.strafe_left == rhs.strafe_left &&
+           lhs.strafe_right == rhs.strafe_right && lhs.jump == rhs.jump &&
+           lhs.crouch == rhs.crouch &&
+           lhs.primary_attack == rhs.primary_attack &&
+           lhs.secondary_attack == rhs.secondary_attack &&
+           lhs.tertiary_attack == rhs.tertiary_attack;
+  }
+
+  // Decoded positions are snapped to the grid so compare against that.
+  void check_same(Snapshot const& expected, Snapshot const& actual,
+                  Quantize_Grid const& grid)
+  {
+    CHECK(actual.tick == expected.tick);
+    CHECK(actual.has_input_ack == expected.has_input_ack);
+    if(expected.has_input_ack) CHECK(actual.input_ack == expected.input_ack);
+
+    REQUIRE(actual.players.size() == expected.players.size());
+    for(std::size_t i = 0; i < expected.players.size(); ++i)
+    {
+      Player_Snapshot const& want = expected.players[i];
+      Player_Snapshot const& got = actual.players[i];
+      CHECK(got.id == want.id);
+      CHECK(same_input(got.input, want.input));
+      CHECK(quantize(grid, got.position) == quantize(grid, want.position));
+    }
+  }
+}
+
+TEST_CASE("Full snapshots round trip", "[snapshot]")
+{
+  auto grid = test_grid();
+  auto snap = make_snapshot(100);
+
+  auto data = encode_snapshot(snap, nullptr, grid);
+  REQUIRE(data.size() > 1);
+  CHECK(data[0] == SNAPSHOT_PACKET_TAG);
+  CHECK(snapshot_baseline_tick(data.data(), data.size()) == NO_BASELINE);
+
+  Snapshot decoded;
+  REQUIRE(decode_snapshot(data.data(), data.size(), nullptr, grid, decoded));
+  check_same(snap, decoded, grid);
+
+  // Without an input ack there's nothing more than a flag.
+  snap.has_input_ack = false;
+  data = encode_snapshot(snap, nullptr, grid);
+  REQUIRE(decode_snapshot(data.data(), data.size(), nullptr, grid, decoded));
+  check_same(snap, decoded, grid);
+}
+
+TEST_CASE("Delta snapshots only send what changed", "[snapshot]")
+{
+  auto grid = test_grid();
+  auto baseline = make_snapshot(100);
+
+  auto snap = baseline;
+  snap.tick = 101;
+  snap.players[1].position.x += 1.0f;
+  snap.players[2].input.crouch = true;
+
+  auto full = encode_snapshot(snap, nullptr, grid);
+  auto delta = encode_snapshot(snap, &baseline, grid);
+  CHECK(delta.size() < full.size());
+  CHECK(snapshot_baseline_tick(delta.data(), delta.size()) == 100);
+
+  Snapshot decoded;
+  REQUIRE(decode_snapshot(delta.data(), delta.size(), &baseline, grid,
+                          decoded));
+  check_same(snap, decoded, grid);
+
+  // Moving less than half a cell isn't a change at all.
+  auto same = baseline;
+  same.tick = 102;
+  same.players[0].position.x += grid.resolution * 0.25f;
+  auto empty = encode_snapshot(same, &baseline, grid);
+  auto unchanged = encode_snapshot(baseline, &baseline, grid);
+  CHECK(empty.size() == unchanged.size());
+  CHECK(player_delta_bits(same.players[0], &baseline.players[0], grid) == 0);
+
+  REQUIRE(decode_snapshot(empty.data(), empty.size(), &baseline, grid,
+                          decoded));
+  check_same(same, decoded, grid);
+}
+
+TEST_CASE("Delta snapshots add players", "[snapshot]")
+{
+  auto grid = test_grid();
+  auto baseline = make_snapshot(100);
+
+  auto snap = baseline;
+  snap.tick = 101;
+  // In the middle and at the end, the list stays sorted.
+  snap.players.insert(snap.players.begin() + 1,
+                      make_player(2, {5.0f, 5.0f, 5.0f}, false));
+  snap.players.push_back(make_player(30, {-5.0f, 1.0f, 2.0f}, true));
+
+  auto delta = encode_snapshot(snap, &baseline, grid);
+  Snapshot decoded;
+  REQUIRE(decode_snapshot(delta.data(), delta.size(), &baseline, grid,
+                          decoded));
+  check_same(snap, decoded, grid);
+}
+
+TEST_CASE("Delta snapshots remove players", "[snapshot]")
+{
+  auto grid = test_grid();
+  auto baseline = make_snapshot(100);
+
+  auto snap = baseline;
+  snap.tick = 101;
+  snap.players.erase(snap.players.begin());
+  snap.players.pop_back();
+
+  auto delta = encode_snapshot(snap, &baseline, grid);
+  Snapshot decoded;
+  REQUIRE(decode_snapshot(delta.data(), delta.size(), &baseline, grid,
+                          decoded));
+  check_same(snap, decoded, grid);
+
+  // Everyone leaving works too.
+  snap.players.clear();
+  delta = encode_snapshot(snap, &baseline, grid);
+  REQUIRE(decode_snapshot(delta.data(), delta.size(), &baseline, grid,
+                          decoded));
+  CHECK(decoded.players.empty());
+}
+
+TEST_CASE("Deltas need their baseline", "[snapshot]")
+{
+  auto grid = test_grid();
+  auto baseline = make_snapshot(100);
+  auto snap = make_snapshot(101);
+  snap.players[0].position.y += 2.0f;
+
+  auto delta = encode_snapshot(snap, &baseline, grid);
+
+  Snapshot decoded;
+  decoded.tick = 7;
+  SECTION("Missing")
+  {
+    CHECK_FALSE(decode_snapshot(delta.data(), delta.size(), nullptr, grid,
+                                decoded));
+  }
+  SECTION("The wrong one")
+  {
+    auto other = make_snapshot(99);
+    CHECK_FALSE(decode_snapshot(delta.data(), delta.size(), &other, grid,
+                                decoded));
+  }
+  SECTION("Too old for the history")
+  {
+    Snapshot_History history(4);
+    history.push(baseline);
+    REQUIRE(history.find(100) != nullptr);
+
+    // The ring wraps around over it.
+    for(uint32_t tick = 101; tick <= 104; ++tick)
+    {
+      history.push(make_snapshot(tick));
+    }
+    CHECK(history.find(100) == nullptr);
+    CHECK(history.find(104) != nullptr);
+    CHECK(history.find(NO_BASELINE) == nullptr);
+
+    uint32_t wanted = snapshot_baseline_tick(delta.data(), delta.size());
+    CHECK_FALSE(decode_snapshot(delta.data(), delta.size(),
+                                history.find(wanted), grid, decoded));
+  }
+  SECTION("Truncated")
+  {
+    CHECK_FALSE(decode_snapshot(delta.data(), delta.size() / 2, &baseline,
+                                grid, decoded));
+  }
+
+  // Failing leaves the output alone.
+  CHECK(decoded.tick == 7);
+}
+
+TEST_CASE("Positions quantize within the grid", "[snapshot]")
+{
+  auto grid = test_grid();
+
+  // 128m at 1/64m is 8192 cells, 64m is 4096.
+  auto bits = grid_bits(grid);
+  CHECK(bits[0] == 14);
+  CHECK(bits[1] == 13);
+  CHECK(bits[2] == 14);
+
+  // Inside the bounds we're never off by more than half a cell.
+  glm::vec3 const inside[] = {
+    {0.0f, 0.0f, 0.0f}, {-64.0f, -8.0f, -64.0f}, {64.0f, 56.0f, 64.0f},
+    {12.3456f, -7.999f, 63.9921f}, {-0.0078f, 0.0079f, 31.337f}
+  };
+  for(glm::vec3 pos : inside)
+  {
+    glm::vec3 snapped = dequantize(grid, quantize(grid, pos));
+    CHECK(std::abs(snapped.x - pos.x) <= grid.resolution * 0.5f + 1e-5f);
+    CHECK(std::abs(snapped.y - pos.y) <= grid.resolution * 0.5f + 1e-5f);
+    CHECK(std::abs(snapped.z - pos.z) <= grid.resolution * 0.5f + 1e-5f);
+  }
+
+  // Outside they're clamped to the edges.
+  auto low = quantize(grid, {-1000.0f, -9.0f, -64.5f});
+  CHECK(low == (Quantized_Pos{{0, 0, 0}}));
+  auto high = quantize(grid, {1000.0f, 57.0f, 64.5f});
+  CHECK(high == (Quantized_Pos{{8192, 4096, 8192}}));
+  CHECK(dequantize(grid, high) == grid.max);
+
+  // And the edges survive the trip through a snapshot.
+  Snapshot snap;
+  snap.tick = 5;
+  snap.players.push_back(make_player(1, {-1000.0f, -9.0f, -64.5f}, true));
+  snap.players.push_back(make_player(2, {1000.0f, 57.0f, 64.5f}, false));
+
+  auto data = encode_snapshot(snap, nullptr, grid);
+  Snapshot decoded;
+  REQUIRE(decode_snapshot(data.data(), data.size(), nullptr, grid, decoded));
+  REQUIRE(decoded.players.size() == 2);
+  CHECK(decoded.players[0].position == grid.min);
+  CHECK(decoded.players[1].position == grid.max);
+}